@@ -19,11 +19,13 @@
  *
  */
 
+#include "common/atomic.h"
 #include "common/debug.h"
 #include "common/file.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/queue.h"
+#include "common/ringbuffer.h"
 #include "common/util.h"
 
 #include "audio/audiostream.h"
@@ -294,11 +296,16 @@ private:
 	struct StreamHolder {
 		AudioStream *_stream;
 		DisposeAfterUse::Flag _disposeAfterUse;
+		StreamHolder() : _stream(nullptr), _disposeAfterUse(DisposeAfterUse::NO) {}
 		StreamHolder(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse)
 		    : _stream(stream),
 		      _disposeAfterUse(disposeAfterUse) {}
 	};
 
+	enum {
+		kIncomingStreamsSize = 64
+	};
+
 	/**
 	 * The sampling rate of this audio stream.
 	 */
@@ -312,22 +319,42 @@ private:
 	/**
 	 * This flag is set by the finish() method only. See there for more details.
 	 */
-	bool _finished;
+	Common::Atomic<bool> _finished;
+
+	/**
+	 * The number of streams queued, both in _incoming and in _queue.
+	 */
+	Common::Atomic<uint32> _numQueued;
+
+	/**
+	 * Streams passed to queueAudioStream() which have not been moved to
+	 * _queue yet. This way queueing a stream does not have to wait for the
+	 * mixer thread to finish reading from the current one.
+	 */
+	mutable Common::MPSCRingBuffer<StreamHolder> _incoming;
 
 	/**
 	 * A mutex to avoid access problems (causing e.g. corruption of
-	 * the linked list) in thread aware environments.
+	 * the linked list) in thread aware environments. It protects _queue
+	 * and reading from _incoming.
 	 */
 	Common::Mutex _mutex;
 
 	/**
 	 * The queue of audio streams.
 	 */
-	Common::Queue<StreamHolder> _queue;
+	mutable Common::Queue<StreamHolder> _queue;
+
+	/** Move the streams from _incoming to _queue. Must be called with _mutex held. */
+	void moveIncomingStreams() const {
+		StreamHolder holder;
+		while (_incoming.pop(holder))
+			_queue.push(holder);
+	}
 
 public:
 	QueuingAudioStreamImpl(int rate, bool stereo)
-	    : _rate(rate), _stereo(stereo), _finished(false) {}
+	    : _rate(rate), _stereo(stereo), _finished(false), _numQueued(0), _incoming(kIncomingStreamsSize) {}
 	~QueuingAudioStreamImpl();
 
 	// Implement the AudioStream API
@@ -337,29 +364,28 @@ public:
 
 	bool endOfData() const override {
 		Common::StackLock lock(_mutex);
+		moveIncomingStreams();
 		return _queue.empty() || _queue.front()._stream->endOfData();
 	}
 
 	bool endOfStream() const override {
-		Common::StackLock lock(_mutex);
-		return _finished && _queue.empty();
+		return _finished && _numQueued == 0;
 	}
 
 	// Implement the QueuingAudioStream API
 	void queueAudioStream(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse) override;
 
 	void finish() override {
-		Common::StackLock lock(_mutex);
 		_finished = true;
 	}
 
 	uint32 numQueuedStreams() const override {
-		Common::StackLock lock(_mutex);
-		return _queue.size();
+		return _numQueued;
 	}
 };
 
 QueuingAudioStreamImpl::~QueuingAudioStreamImpl() {
+	moveIncomingStreams();
 	while (!_queue.empty()) {
 		StreamHolder tmp = _queue.pop();
 		if (tmp._disposeAfterUse == DisposeAfterUse::YES)
@@ -372,12 +398,19 @@ void QueuingAudioStreamImpl::queueAudioStream(AudioStream *stream, DisposeAfterU
 	if ((stream->getRate() != getRate()) || (stream->isStereo() != isStereo()))
 		error("QueuingAudioStreamImpl::queueAudioStream: stream has mismatched parameters");
 
+	_numQueued++;
+	if (_incoming.push(StreamHolder(stream, disposeAfterUse)))
+		return;
+
+	// Too many streams are waiting to be moved, do it here
 	Common::StackLock lock(_mutex);
+	moveIncomingStreams();
 	_queue.push(StreamHolder(stream, disposeAfterUse));
 }
 
 int QueuingAudioStreamImpl::readBuffer(int16 *buffer, const int numSamples) {
 	Common::StackLock lock(_mutex);
+	moveIncomingStreams();
 	int samplesDecoded = 0;
 
 	while (samplesDecoded < numSamples && !_queue.empty()) {
@@ -389,6 +422,7 @@ int QueuingAudioStreamImpl::readBuffer(int16 *buffer, const int numSamples) {
 			StreamHolder tmp = _queue.pop();
 			if (tmp._disposeAfterUse == DisposeAfterUse::YES)
 				delete stream;
+			_numQueued--;
 			continue;
 		}
 
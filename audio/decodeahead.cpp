@@ -0,0 +1,298 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audio/decodeahead.h"
+#include "audio/audiostream.h"
+
+#include "common/atomic.h"
+#include "common/ptr.h"
+#include "common/ringbuffer.h"
+#include "common/system.h"
+#include "common/taskpool.h"
+
+namespace Audio {
+
+namespace {
+
+/**
+ * Decodes the samples of a stream ahead into a ring buffer.
+ *
+ * Only one decoding task runs at a time, so the ring buffer has a single
+ * producer, the task, and a single consumer, the thread reading the
+ * stream. The consumer starts the tasks. Before seeking or destroying the
+ * stream, it cancels the queued task and waits for a running one, which
+ * stops after its current chunk.
+ *
+ * readBuffer() is called from the mixer callback, so it never waits for
+ * the pool. It only schedules new tasks with trySubmit(). When nothing is
+ * left in the ring buffer and no task is decoding, it reads from the
+ * parent stream itself. A task which is still queued is claimed by the
+ * reader first, and then returns without decoding once it runs.
+ */
+template<class Parent>
+class DecodeAheadStream : public Parent {
+public:
+	DecodeAheadStream(Parent *parent, DisposeAfterUse::Flag disposeAfterUse, uint leadTime, Common::TaskPool *pool);
+	~DecodeAheadStream();
+
+	int readBuffer(int16 *buffer, const int numSamples) override;
+
+	bool isStereo() const override { return _isStereo; }
+	int getRate() const override { return _rate; }
+
+	bool endOfData() const override;
+	bool endOfStream() const override;
+
+protected:
+	enum {
+		/** Number of samples decoded at once. This is even, to keep stereo frames whole. */
+		kChunkSize = 1024
+	};
+
+	/**
+	 * Start a decoding task, unless there is one already or there is not
+	 * much to do. If @p fromReader is set, this is called by readBuffer()
+	 * and must not wait for the pool.
+	 */
+	void startDecoding(bool fromReader);
+	/** Cancel the queued decoding, and wait until a running one stops. */
+	void stopDecoding();
+	/**
+	 * Check whether the parent may be read by the reader, claiming the
+	 * task if it did not start yet.
+	 */
+	bool claimParent();
+	/** Drop the samples decoded ahead. The decoding must be stopped. */
+	void flush();
+
+	Common::DisposablePtr<Parent> _parent;
+	/** The samples decoded ahead, or nullptr when reading directly from _parent. */
+	Common::ScopedPtr<Common::SPSCRingBuffer<int16> > _ring;
+
+private:
+	static void decodeTask(void *param);
+	void decode();
+
+	enum TaskState {
+		kTaskIdle,		///< No decoding task is queued or running
+		kTaskQueued,	///< A task is queued, and did not start yet
+		kTaskRunning,	///< A task is decoding
+		kTaskClaimed	///< A task is queued, but the reader took over the parent
+	};
+
+	const bool _isStereo;
+	const int _rate;
+
+	Common::TaskPool *_pool;
+	Common::TaskPool::TaskGroup _group;
+
+	Common::Atomic<int> _taskState;
+	Common::Atomic<bool> _stopRequested;
+	Common::Atomic<bool> _parentEndOfData;
+	Common::Atomic<bool> _parentEndOfStream;
+};
+
+template<class Parent>
+DecodeAheadStream<Parent>::DecodeAheadStream(Parent *parent, DisposeAfterUse::Flag disposeAfterUse, uint leadTime, Common::TaskPool *pool)
+	: _parent(parent, disposeAfterUse), _isStereo(parent->isStereo()), _rate(parent->getRate()),
+	  _pool(pool ? pool : g_system->getTaskPool()),
+	  _taskState(kTaskIdle), _stopRequested(false), _parentEndOfData(false), _parentEndOfStream(false) {
+
+	// Without worker threads, decoding ahead would only make the mixer
+	// callback do more work at once
+	if (_pool->getNumThreads() <= 1)
+		return;
+
+	const uint capacity = (uint)((uint64)_rate * (_isStereo ? 2 : 1) * leadTime / 1000);
+	_ring.reset(new Common::SPSCRingBuffer<int16>(MAX<uint>(capacity, kChunkSize * 2)));
+
+	// Have some samples ready by the time the stream is played
+	startDecoding(false);
+}
+
+template<class Parent>
+DecodeAheadStream<Parent>::~DecodeAheadStream() {
+	if (_ring)
+		stopDecoding();
+}
+
+template<class Parent>
+int DecodeAheadStream<Parent>::readBuffer(int16 *buffer, const int numSamples) {
+	if (!_ring)
+		return _parent->readBuffer(buffer, numSamples);
+
+	int numRead = _ring->pop(buffer, numSamples);
+	if (numRead < numSamples) {
+		if (_parentEndOfData.load(Common::kMemoryOrderAcquire)) {
+			// The last samples may have been pushed right before the flag
+			// was set, after the ring buffer looked empty
+			numRead += _ring->pop(buffer + numRead, numSamples - numRead);
+		} else if (claimParent()) {
+			// No task is decoding, and only this thread starts them, so the
+			// parent can be read directly. Make sure nothing was pushed by
+			// the last task in the meantime.
+			numRead += _ring->pop(buffer + numRead, numSamples - numRead);
+			if (numRead < numSamples) {
+				const int numDirect = _parent->readBuffer(buffer + numRead, numSamples - numRead);
+				numRead += MAX(numDirect, 0);
+				// The direct read may have taken the last samples exactly
+				if (numRead < numSamples || _parent->endOfData()) {
+					_parentEndOfStream.store(_parent->endOfStream(), Common::kMemoryOrderRelaxed);
+					_parentEndOfData.store(true, Common::kMemoryOrderRelease);
+				}
+			}
+		}
+		// Otherwise the decoding fell behind. Waiting for it could stall
+		// the mixer, so only return what is there.
+	}
+
+	startDecoding(true);
+	return numRead;
+}
+
+template<class Parent>
+bool DecodeAheadStream<Parent>::endOfData() const {
+	if (!_ring)
+		return _parent->endOfData();
+	return _parentEndOfData.load(Common::kMemoryOrderAcquire) && _ring->empty();
+}
+
+template<class Parent>
+bool DecodeAheadStream<Parent>::endOfStream() const {
+	if (!_ring)
+		return _parent->endOfStream();
+	return _parentEndOfStream.load(Common::kMemoryOrderAcquire) && _ring->empty();
+}
+
+template<class Parent>
+bool DecodeAheadStream<Parent>::claimParent() {
+	int state = kTaskQueued;
+	if (_taskState.compareExchange(state, kTaskClaimed, Common::kMemoryOrderAcquire))
+		return true;
+	return state != kTaskRunning;
+}
+
+template<class Parent>
+void DecodeAheadStream<Parent>::startDecoding(bool fromReader) {
+	if (_taskState.load(Common::kMemoryOrderAcquire) != kTaskIdle || _parentEndOfStream.load(Common::kMemoryOrderRelaxed))
+		return;
+
+	// Top up in batches, instead of a chunk after every read
+	const uint space = _ring->capacity() - _ring->size();
+	if (space < kChunkSize || (fromReader && space < _ring->capacity() / 4))
+		return;
+
+	// No task is running, so the flags can be changed safely
+	const bool parentEndOfData = _parentEndOfData.load(Common::kMemoryOrderRelaxed);
+	_parentEndOfData.store(false, Common::kMemoryOrderRelaxed);
+	_taskState.store(kTaskQueued, Common::kMemoryOrderRelaxed);
+
+	if (!fromReader) {
+		_pool->submit(_group, decodeTask, this);
+	} else if (!_pool->trySubmit(_group, decodeTask, this)) {
+		// The pool is busy, try again on the next read
+		_taskState.store(kTaskIdle, Common::kMemoryOrderRelaxed);
+		_parentEndOfData.store(parentEndOfData, Common::kMemoryOrderRelaxed);
+	}
+}
+
+template<class Parent>
+void DecodeAheadStream<Parent>::stopDecoding() {
+	_stopRequested.store(true, Common::kMemoryOrderRelaxed);
+	_pool->cancel(_group);
+	_pool->wait(_group);
+	_taskState.store(kTaskIdle, Common::kMemoryOrderRelaxed);
+	_stopRequested.store(false, Common::kMemoryOrderRelaxed);
+}
+
+template<class Parent>
+void DecodeAheadStream<Parent>::flush() {
+	int16 samples[kChunkSize];
+	while (_ring->pop(samples, kChunkSize))
+		;
+	_parentEndOfData.store(false, Common::kMemoryOrderRelaxed);
+	_parentEndOfStream.store(false, Common::kMemoryOrderRelaxed);
+}
+
+template<class Parent>
+void DecodeAheadStream<Parent>::decodeTask(void *param) {
+	((DecodeAheadStream *)param)->decode();
+}
+
+template<class Parent>
+void DecodeAheadStream<Parent>::decode() {
+	// The reader may have taken over while the task was queued
+	int state = kTaskQueued;
+	if (!_taskState.compareExchange(state, kTaskRunning, Common::kMemoryOrderAcquire)) {
+		_taskState.store(kTaskIdle, Common::kMemoryOrderRelease);
+		return;
+	}
+
+	int16 chunk[kChunkSize];
+
+	while (!_stopRequested.load(Common::kMemoryOrderRelaxed) && _ring->capacity() - _ring->size() >= kChunkSize) {
+		const int numRead = _parent->readBuffer(chunk, kChunkSize);
+		if (numRead <= 0) {
+			_parentEndOfStream.store(_parent->endOfStream(), Common::kMemoryOrderRelaxed);
+			_parentEndOfData.store(true, Common::kMemoryOrderRelease);
+			break;
+		}
+
+		_ring->push(chunk, numRead);
+	}
+
+	_taskState.store(kTaskIdle, Common::kMemoryOrderRelease);
+}
+
+class SeekableDecodeAheadStream : public DecodeAheadStream<SeekableAudioStream> {
+public:
+	SeekableDecodeAheadStream(SeekableAudioStream *parent, DisposeAfterUse::Flag disposeAfterUse, uint leadTime, Common::TaskPool *pool)
+		: DecodeAheadStream<SeekableAudioStream>(parent, disposeAfterUse, leadTime, pool), _length(parent->getLength()) {}
+
+	bool seek(const Timestamp &where) override;
+	Timestamp getLength() const override { return _length; }
+
+private:
+	const Timestamp _length;
+};
+
+bool SeekableDecodeAheadStream::seek(const Timestamp &where) {
+	if (!_ring)
+		return _parent->seek(where);
+
+	stopDecoding();
+	flush();
+	const bool result = _parent->seek(where);
+	startDecoding(false);
+	return result;
+}
+
+} // End of anonymous namespace
+
+AudioStream *makeDecodeAheadStream(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint leadTime, Common::TaskPool *pool) {
+	return new DecodeAheadStream<AudioStream>(stream, disposeAfterUse, leadTime, pool);
+}
+
+SeekableAudioStream *makeDecodeAheadStream(SeekableAudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, uint leadTime, Common::TaskPool *pool) {
+	return new SeekableDecodeAheadStream(stream, disposeAfterUse, leadTime, pool);
+}
+
+} // End of namespace Audio
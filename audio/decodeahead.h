@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_DECODEAHEAD_H
+#define AUDIO_DECODEAHEAD_H
+
+#include "common/scummsys.h"
+#include "common/types.h"
+
+namespace Common {
+class TaskPool;
+}
+
+namespace Audio {
+
+/**
+ * @defgroup audio_decodeahead Decode-ahead streams
+ * @ingroup audio
+ *
+ * @brief Wrappers which decode audio streams ahead of playback on a worker thread.
+ * @{
+ */
+
+class AudioStream;
+class SeekableAudioStream;
+
+enum {
+	/** Default amount of audio decoded ahead of playback, in milliseconds. */
+	kDefaultDecodeAheadTime = 500
+};
+
+/**
+ * Wrap @p stream so that it is decoded ahead of playback.
+ *
+ * The samples are decoded by tasks of a Common::TaskPool into a ring buffer
+ * holding @p leadTime milliseconds of audio, from which readBuffer() only
+ * copies. This keeps expensive decoders, like MP3 or Vorbis, out of the
+ * mixer callback, which never waits for the pool. If the decoding falls
+ * behind, readBuffer() returns the samples decoded so far, and when no
+ * decoding is running, or the task did not start yet, it reads from
+ * @p stream directly. Either way, the samples are the same as the ones of
+ * @p stream. Destroying the wrapper does not wait for queued decoding.
+ *
+ * When the pool does not have any worker thread, the wrapper simply reads
+ * from @p stream, so it can be used on all ports.
+ *
+ * Once wrapped, @p stream must not be used directly anymore.
+ *
+ * @param stream           The stream to decode ahead.
+ * @param disposeAfterUse  Whether to delete @p stream with the wrapper.
+ * @param leadTime         How much audio to decode ahead, in milliseconds.
+ * @param pool             The pool running the decoding, g_system->getTaskPool() by default.
+ *
+ * @return A new AudioStream with the samples of @p stream.
+ */
+AudioStream *makeDecodeAheadStream(AudioStream *stream,
+                                   DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES,
+                                   uint leadTime = kDefaultDecodeAheadTime,
+                                   Common::TaskPool *pool = nullptr);
+
+/**
+ * Wrap a seekable @p stream so that it is decoded ahead of playback.
+ *
+ * Seeking and rewinding the wrapper wait for the running decoding, drop the
+ * samples decoded ahead and seek @p stream, so they should be called from
+ * the thread reading the stream, or while it is not played.
+ *
+ * @see makeDecodeAheadStream(AudioStream *, DisposeAfterUse::Flag, uint, Common::TaskPool *)
+ */
+SeekableAudioStream *makeDecodeAheadStream(SeekableAudioStream *stream,
+                                           DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES,
+                                           uint leadTime = kDefaultDecodeAheadTime,
+                                           Common::TaskPool *pool = nullptr);
+
+/** @} */
+
+} // End of namespace Audio
+
+#endif
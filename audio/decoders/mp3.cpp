@@ -23,7 +23,9 @@
 
 #ifdef USE_MAD
 
+#include "common/array.h"
 #include "common/debug.h"
+#include "common/endian.h"
 #include "common/mutex.h"
 #include "common/ptr.h"
 #include "common/queue.h"
@@ -107,6 +109,50 @@ protected:
 	Timestamp _length;
 
 private:
+	enum {
+		/** Number of frames between two entries of the frame index. */
+		INDEX_INTERVAL = 16,
+		/**
+		 * Seeks further than this many seconds past the indexed frames use
+		 * the table of contents of the Xing or VBRI header, if any.
+		 */
+		TOC_SEEK_THRESHOLD = 30
+	};
+
+	struct FrameIndexEntry {
+		uint32 offset;
+		mad_timer_t time;
+	};
+
+	struct TocEntry {
+		uint32 offset;
+		uint32 msecs;
+	};
+
+	/**
+	 * Start time and offset of every INDEX_INTERVAL-th frame, from the start
+	 * of the stream up to _scanOffset. The frames are indexed lazily, with a
+	 * separate decoder, so seeking jumps close to its destination instead of
+	 * going through all frame headers from the start.
+	 */
+	Common::Array<FrameIndexEntry> _index;
+	uint32 _scanOffset;
+	mad_timer_t _scanTime;
+	uint32 _scanFrame;
+	bool _indexComplete;
+	bool _indexError;
+
+	/**
+	 * Approximate offsets for times spread over the stream, from the first
+	 * frame of a VBR file.
+	 */
+	Common::Array<TocEntry> _toc;
+
+	void extendIndex(const mad_timer_t *until);
+	bool readVBRHeader();
+	void parseXingTOC(const byte *toc, uint32 frameOffset, uint32 numBytes);
+	void parseVBRITOC(const byte *header, uint32 frameOffset);
+
 	static Common::SeekableReadStream *skipID3(Common::SeekableReadStream *stream, DisposeAfterUse::Flag dispose);
 };
 
@@ -328,7 +374,12 @@ int BaseMP3Stream::fillBuffer(Common::ReadStream &stream, int16 *buffer, const i
 MP3Stream::MP3Stream(Common::SeekableReadStream *inStream, DisposeAfterUse::Flag dispose) :
 		BaseMP3Stream(),
 		_inStream(skipID3(inStream, dispose)),
-		_length(0, 1000) {
+		_length(0, 1000),
+		_scanOffset(0),
+		_scanTime(mad_timer_zero),
+		_scanFrame(0),
+		_indexComplete(false),
+		_indexError(false) {
 
 	// Initialize the stream with some data and set the channels and rate
 	// variables
@@ -336,27 +387,18 @@ MP3Stream::MP3Stream(Common::SeekableReadStream *inStream, DisposeAfterUse::Flag
 	_channels = MAD_NCHANNELS(&_frame.header);
 	_rate = _frame.header.samplerate;
 
-	// Calculate the length of the stream
-	while (_state != MP3_STATE_EOS)
-		readHeader(*_inStream);
-
-	// To rule out any invalid sample rate to be encountered here, say in case the
-	// MP3 stream is invalid, we just check the MAD error code here.
-	// We need to assure this, since else we might trigger an assertion in Timestamp
-	// (When getRate() returns 0 or a negative number to be precise).
-	// Note that we allow "MAD_ERROR_BUFLEN" as error code here, since according
-	// to mad.h it is also set on EOF.
-	if ((_stream.error == MAD_ERROR_NONE || _stream.error == MAD_ERROR_BUFLEN) && getRate() > 0)
-		_length = Timestamp(mad_timer_count(_curTime, MAD_UNITS_MILLISECONDS), getRate());
-
-	deinitStream();
-
-	// Reinit stream
-	_state = MP3_STATE_INIT;
-	_inStream->seek(0);
-
-	// Decode the first chunk of data to set up the stream again.
-	decodeMP3Data(*_inStream);
+	// VBR files usually tell their length in their first frame. Otherwise,
+	// calculate the length of the stream by indexing all of its frames.
+	if (_state == MP3_STATE_EOS || !readVBRHeader()) {
+		extendIndex(nullptr);
+
+		// To rule out any invalid sample rate to be encountered here, say in case the
+		// MP3 stream is invalid, we just check whether indexing hit an unrecoverable
+		// error. We need to assure this, since else we might trigger an assertion in
+		// Timestamp (When getRate() returns 0 or a negative number to be precise).
+		if (!_indexError && getRate() > 0)
+			_length = Timestamp(mad_timer_count(_scanTime, MAD_UNITS_MILLISECONDS), getRate());
+	}
 }
 
 int MP3Stream::readBuffer(int16 *buffer, const int numSamples) {
@@ -376,9 +418,41 @@ bool MP3Stream::seek(const Timestamp &where) {
 	mad_timer_t destination;
 	mad_timer_set(&destination, time / 1000, time % 1000, 1000);
 
-	if (_state != MP3_STATE_READY || mad_timer_compare(destination, _curTime) < 0) {
-		_inStream->seek(0);
+	// Find the closest known frame before the destination
+	uint32 offset = 0;
+	mad_timer_t startTime = mad_timer_zero;
+
+	const uint32 indexedTime = mad_timer_count(_scanTime, MAD_UNITS_MILLISECONDS);
+	if (!_toc.empty() && !_indexComplete && time > indexedTime + TOC_SEEK_THRESHOLD * 1000) {
+		// Indexing all the frames up to there would take too long
+		uint entry = 0;
+		while (entry + 1 < _toc.size() && _toc[entry + 1].msecs <= time)
+			entry++;
+		offset = _toc[entry].offset;
+		mad_timer_set(&startTime, _toc[entry].msecs / 1000, _toc[entry].msecs % 1000, 1000);
+	} else {
+		extendIndex(&destination);
+
+		uint low = 0, high = _index.size();
+		while (high - low > 1) {
+			const uint mid = (low + high) / 2;
+			if (mad_timer_compare(_index[mid].time, destination) <= 0)
+				low = mid;
+			else
+				high = mid;
+		}
+		if (!_index.empty()) {
+			offset = _index[low].offset;
+			startTime = _index[low].time;
+		}
+	}
+
+	// Jump there, unless going through the headers from the current position
+	// is shorter
+	if (_state != MP3_STATE_READY || mad_timer_compare(destination, _curTime) < 0 || mad_timer_compare(startTime, _curTime) > 0) {
+		_inStream->seek(offset);
 		initStream(*_inStream);
+		_curTime = startTime;
 	}
 
 	while (mad_timer_compare(destination, _curTime) > 0 && _state != MP3_STATE_EOS)
@@ -389,6 +463,210 @@ bool MP3Stream::seek(const Timestamp &where) {
 	return (_state != MP3_STATE_EOS);
 }
 
+void MP3Stream::extendIndex(const mad_timer_t *until) {
+	if (_indexComplete || (until && mad_timer_compare(_scanTime, *until) > 0))
+		return;
+
+	// The playback decoder is left alone, only the stream position is shared
+	const int64 savedPos = _inStream->pos();
+	_inStream->seek(_scanOffset);
+
+	byte *buf = new byte[BUFFER_SIZE + MAD_BUFFER_GUARD];
+	memset(buf + BUFFER_SIZE, 0, MAD_BUFFER_GUARD);
+	// Stream offset of the start of buf
+	uint32 bufOffset = _scanOffset;
+
+	mad_stream stream;
+	mad_header header;
+	mad_stream_init(&stream);
+	mad_header_init(&header);
+	stream.error = MAD_ERROR_BUFLEN;
+
+	for (;;) {
+		if (stream.error == MAD_ERROR_BUFLEN) {
+			// Keep what is left of the last frame, and read some more
+			uint32 remaining = 0;
+			if (stream.next_frame) {
+				remaining = stream.bufend - stream.next_frame;
+				bufOffset += stream.next_frame - buf;
+				memmove(buf, stream.next_frame, remaining);
+			}
+
+			const uint32 size = _inStream->read(buf + remaining, BUFFER_SIZE - remaining);
+			if (size == 0) {
+				_indexComplete = true;
+
+				// The VBR header may tell more frames than the file holds
+				if (getRate() > 0) {
+					const Timestamp indexedLength(0, mad_timer_count(_scanTime, (enum mad_units)getRate()), getRate());
+					if (indexedLength < _length)
+						_length = indexedLength;
+				}
+				break;
+			}
+			mad_stream_buffer(&stream, buf, size + remaining);
+		}
+
+		stream.error = MAD_ERROR_NONE;
+		if (mad_header_decode(&header, &stream) == -1) {
+			if (stream.error == MAD_ERROR_BUFLEN || MAD_RECOVERABLE(stream.error))
+				continue;
+
+			warning("MP3Stream: Unrecoverable error in mad_header_decode (%s)", mad_stream_errorstr(&stream));
+			_indexComplete = true;
+			_indexError = true;
+			break;
+		}
+
+		if (_scanFrame % INDEX_INTERVAL == 0) {
+			FrameIndexEntry entry;
+			entry.offset = bufOffset + (stream.this_frame - buf);
+			entry.time = _scanTime;
+			_index.push_back(entry);
+		}
+
+		mad_timer_add(&_scanTime, header.duration);
+		_scanFrame++;
+		_scanOffset = bufOffset + (stream.next_frame - buf);
+
+		if (until && mad_timer_compare(_scanTime, *until) > 0)
+			break;
+	}
+
+	mad_header_finish(&header);
+	mad_stream_finish(&stream);
+	delete[] buf;
+
+	_inStream->seek(savedPos);
+}
+
+bool MP3Stream::readVBRHeader() {
+	if (_frame.header.layer != MAD_LAYER_III || getRate() <= 0)
+		return false;
+
+	// Index the first frame, to know where it starts
+	extendIndex(&mad_timer_zero);
+	if (_index.empty())
+		return false;
+
+	const uint32 frameOffset = _index[0].offset;
+	byte data[192];
+	memset(data, 0, sizeof(data));
+
+	const int64 savedPos = _inStream->pos();
+	_inStream->seek(frameOffset);
+	_inStream->read(data, sizeof(data));
+	_inStream->seek(savedPos);
+
+	// The Xing header follows the side information
+	const bool lsf = (_frame.header.flags & MAD_FLAG_LSF_EXT) != 0;
+	const bool mono = _frame.header.mode == MAD_MODE_SINGLE_CHANNEL;
+	uint xingPos = 4 + (lsf ? (mono ? 9 : 17) : (mono ? 17 : 32));
+	if (_frame.header.flags & MAD_FLAG_PROTECTION)
+		xingPos += 2;
+
+	// The header frame itself is decoded as silence, hence the extra frame
+	// when calculating the length
+	const uint32 samplesPerFrame = 32 * MAD_NSBSAMPLES(&_frame.header);
+	uint32 numFrames = 0;
+	uint32 numBytes = _inStream->size() - frameOffset;
+
+	if (!memcmp(data + xingPos, "Xing", 4) || !memcmp(data + xingPos, "Info", 4)) {
+		const uint32 flags = READ_BE_UINT32(data + xingPos + 4);
+		const byte *field = data + xingPos + 8;
+
+		if (flags & 1) {
+			numFrames = READ_BE_UINT32(field);
+			field += 4;
+		}
+		if (flags & 2) {
+			numBytes = READ_BE_UINT32(field);
+			field += 4;
+		}
+		if (numFrames) {
+			_length = Timestamp(0, (numFrames + 1) * samplesPerFrame, getRate());
+			if (flags & 4)
+				parseXingTOC(field, frameOffset, numBytes);
+		}
+	} else if (!memcmp(data + 36, "VBRI", 4)) {
+		numBytes = READ_BE_UINT32(data + 36 + 10);
+		numFrames = READ_BE_UINT32(data + 36 + 14);
+		if (numFrames) {
+			_length = Timestamp(0, (numFrames + 1) * samplesPerFrame, getRate());
+			parseVBRITOC(data + 36, frameOffset);
+		}
+	}
+
+	if (!numFrames)
+		return false;
+
+	// A truncated file holds fewer frames than its header tells, so only
+	// indexing them gives its length
+	if (numBytes > _inStream->size() - frameOffset) {
+		debug(3, "MP3Stream: The file is shorter than its VBR header tells");
+		_toc.clear();
+		return false;
+	}
+
+	debug(3, "MP3Stream: Length of %d ms from the VBR header, %u TOC entries", _length.msecs(), _toc.size());
+	return true;
+}
+
+void MP3Stream::parseXingTOC(const byte *toc, uint32 frameOffset, uint32 numBytes) {
+	// The table gives the position, in 1/256 of the stream, of every percent
+	// of the duration
+	for (uint i = 0; i < 100; i++) {
+		TocEntry entry;
+		entry.offset = frameOffset + (uint32)((uint64)toc[i] * numBytes / 256);
+		entry.msecs = (uint32)((uint64)_length.msecs() * i / 100);
+
+		if (!_toc.empty() && entry.offset < _toc.back().offset) {
+			_toc.clear();
+			return;
+		}
+		// The byte count may be wrong, e.g. in a truncated file. Seeking
+		// must not go past the last frame.
+		if (entry.offset >= _inStream->size())
+			break;
+		_toc.push_back(entry);
+	}
+}
+
+void MP3Stream::parseVBRITOC(const byte *header, uint32 frameOffset) {
+	const uint numEntries = READ_BE_UINT16(header + 18);
+	const uint scale = READ_BE_UINT16(header + 20);
+	const uint entrySize = READ_BE_UINT16(header + 22);
+	const uint framesPerEntry = READ_BE_UINT16(header + 24);
+
+	if (!numEntries || entrySize < 1 || entrySize > 4 || !framesPerEntry)
+		return;
+
+	// Each entry gives the size of the next framesPerEntry frames
+	byte *table = new byte[numEntries * entrySize];
+	const int64 savedPos = _inStream->pos();
+	_inStream->seek(frameOffset + 36 + 26);
+	const bool complete = _inStream->read(table, numEntries * entrySize) == numEntries * entrySize;
+	_inStream->seek(savedPos);
+
+	const uint64 samplesPerEntry = (uint64)framesPerEntry * 32 * MAD_NSBSAMPLES(&_frame.header);
+	uint32 offset = frameOffset;
+
+	// Like for the Xing table, stop at the end of the stream
+	for (uint i = 0; complete && i < numEntries && offset < _inStream->size(); i++) {
+		TocEntry entry;
+		entry.offset = offset;
+		entry.msecs = (uint32)(samplesPerEntry * i * 1000 / getRate());
+		_toc.push_back(entry);
+
+		uint32 size = 0;
+		for (uint j = 0; j < entrySize; j++)
+			size = (size << 8) | table[i * entrySize + j];
+		offset += size * scale;
+	}
+
+	delete[] table;
+}
+
 Common::SeekableReadStream *MP3Stream::skipID3(Common::SeekableReadStream *stream, DisposeAfterUse::Flag dispose) {
 	// Skip ID3 TAG if any
 	// ID3v1 (beginning with with 'TAG') is located at the end of files. So we can ignore those.
@@ -21,6 +21,7 @@
 
 #include "audio/midiparser.h"
 #include "audio/mididrv.h"
+#include "common/algorithm.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
@@ -45,6 +46,8 @@ _centerPitchWheelOnUnload(false),
 _sendSustainOffOnNotesOff(false),
 _disableAllNotesOffMidiEvents(false),
 _disableAutoStartPlayback(false),
+_compileTracks(false),
+_trackCompiled(false),
 _loopStartPoint(0xFFFFFFFF),
 _loopEndPoint(0xFFFFFFFF),
 _loopStartPointMs(0xFFFFFFFF),
@@ -57,6 +60,7 @@ _doParse(true),
 _pause(false) {
 	memset(_activeNotes, 0, sizeof(_activeNotes));
 	memset(_tracks, 0, sizeof(_tracks));
+	memset(_tracksEndPos, 0, sizeof(_tracksEndPos));
 	memset(_numSubtracks, 1, sizeof(_numSubtracks));
 	for (int i = 0; i < MAXIMUM_SUBTRACKS; i++) {
 		_nextSubtrackEvents[i].clear();
@@ -85,6 +89,9 @@ void MidiParser::property(int prop, int value) {
 	case mpDisableAutoStartPlayback:
 		_disableAutoStartPlayback = (value != 0);
 		break;
+	case mpCompileTracks:
+		_compileTracks = (value != 0);
+		break;
 	default:
 		break;
 	}
@@ -289,7 +296,7 @@ void MidiParser::onTimer() {
 			_position._subtracks[subtrack]._lastEventTick = eventTick;
 
 			if (_position.isTracking(subtrack)) {
-				parseNextEvent(_nextSubtrackEvents[subtrack]);
+				readNextEvent(_nextSubtrackEvents[subtrack]);
 			}
 			determineNextEvent();
 		}
@@ -527,9 +534,14 @@ bool MidiParser::setTrack(int track) {
 	onTrackStart(track);
 
 	_activeTrack = track;
+	clearCompiledTrack();
+	if (_compileTracks)
+		compileTrack(track);
+
 	for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
 		_position._subtracks[i]._playPos = _tracks[_activeTrack][i];
-		parseNextEvent(_nextSubtrackEvents[i]);
+		_position._subtracks[i]._eventIndex = 0;
+		readNextEvent(_nextSubtrackEvents[i]);
 	}
 	determineNextEvent();
 
@@ -553,7 +565,8 @@ bool MidiParser::startPlaying() {
 		_nextEvent = &_nextSubtrackEvents[0];
 		for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
 			_position._subtracks[i]._playPos = _tracks[_activeTrack][i];
-			parseNextEvent(_nextSubtrackEvents[i]);
+			_position._subtracks[i]._eventIndex = 0;
+			readNextEvent(_nextSubtrackEvents[i]);
 		}
 		determineNextEvent();
 	}
@@ -589,7 +602,7 @@ void MidiParser::hangAllActiveNotes() {
 			break;
 
 		if (_position.isTracking(_nextEvent->subtrack))
-			parseNextEvent(_nextSubtrackEvents[_nextEvent->subtrack]);
+			readNextEvent(_nextSubtrackEvents[_nextEvent->subtrack]);
 		determineNextEvent();
 
 		uint8 subtrack = _nextEvent->subtrack;
@@ -637,12 +650,27 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 	}
 
 	resetTracking();
-	for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
-		_position._subtracks[i]._playPos = _tracks[_activeTrack][i];
-		parseNextEvent(_nextSubtrackEvents[i]);
+	const bool compiledJump = _trackCompiled && !fireEvents && tick > 0;
+	if (compiledJump) {
+		if (!jumpToCompiledTick(tick)) {
+			// The tick is past the end of the track
+			_position = currentPos;
+			_nextEvent = currentEvent;
+			for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
+				_nextSubtrackEvents[i] = currentSubtrackEvents[i];
+			}
+			_jumpingToTick = false;
+			return false;
+		}
+	} else {
+		for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
+			_position._subtracks[i]._playPos = _tracks[_activeTrack][i];
+			_position._subtracks[i]._eventIndex = 0;
+			readNextEvent(_nextSubtrackEvents[i]);
+		}
+		determineNextEvent();
 	}
-	determineNextEvent();
-	if (tick > 0) {
+	if (tick > 0 && !compiledJump) {
 		while (true) {
 			EventInfo &info = *_nextEvent;
 			uint8 subtrack = info.subtrack;
@@ -684,7 +712,7 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 			_position._subtracks[subtrack]._lastEventTick = eventTick;
 
 			if (_position.isTracking(subtrack)) {
-				parseNextEvent(_nextSubtrackEvents[subtrack]);
+				readNextEvent(_nextSubtrackEvents[subtrack]);
 			}
 			determineNextEvent();
 		}
@@ -721,6 +749,246 @@ bool MidiParser::jumpToTick(uint32 tick, bool fireEvents, bool stopNotes, bool d
 	return true;
 }
 
+void MidiParser::readNextEvent(EventInfo &info) {
+	if (!_trackCompiled) {
+		parseNextEvent(info);
+		return;
+	}
+
+	Tracker::SubtrackStatus &status = _position._subtracks[info.subtrack];
+	const Common::Array<CompiledEvent> &events = _compiledEvents[info.subtrack];
+	if (status._eventIndex >= events.size()) {
+		// Only happens if the subtrack did not stop at its last event
+		status.stopTracking();
+		return;
+	}
+
+	const CompiledEvent &event = events[status._eventIndex];
+	info.start = event.start;
+	info.delta = event.tick - (status._eventIndex > 0 ? events[status._eventIndex - 1].tick : 0);
+	info.event = event.event;
+	info.basic.param1 = event.param1;
+	info.basic.param2 = event.param2;
+	info.ext.data = event.data;
+	info.length = event.length;
+	info.loop = event.loop;
+	info.noop = event.noop;
+
+	// Keep the subtrack tracked, the position itself is not used anymore
+	status._playPos = event.start;
+	status._eventIndex++;
+}
+
+namespace {
+
+struct CompiledTempoEntry {
+	uint32 tick;
+	uint8 subtrack;
+	uint32 index;
+	uint32 tempo;
+};
+
+struct CompiledTempoLess {
+	bool operator()(const CompiledTempoEntry &x, const CompiledTempoEntry &y) const {
+		// Same order as determineNextEvent()
+		if (x.tick != y.tick)
+			return x.tick < y.tick;
+		if (x.subtrack != y.subtrack)
+			return x.subtrack < y.subtrack;
+		return x.index < y.index;
+	}
+};
+
+} // End of anonymous namespace
+
+void MidiParser::compileTrack(uint8 track) {
+	clearCompiledTrack();
+
+	for (int i = 0; i < _numSubtracks[track]; i++) {
+		if (!_tracksEndPos[track][i])
+			return;
+	}
+
+	Tracker currentPos(_position);
+	Common::Array<CompiledTempoEntry> tempos;
+
+	for (int i = 0; i < _numSubtracks[track]; i++) {
+		Common::Array<CompiledEvent> &events = _compiledEvents[i];
+		EventInfo info;
+		info.subtrack = i;
+		_position._subtracks[i].clear();
+		_position._subtracks[i]._playPos = _tracks[track][i];
+
+		// Stop at the end of the data in case the End of Track event is missing
+		uint32 tick = 0;
+		while (_position._subtracks[i]._playPos < _tracksEndPos[track][i]) {
+			parseNextEvent(info);
+			tick += info.delta;
+
+			CompiledEvent event;
+			event.tick = tick;
+			event.start = info.start;
+			event.data = info.ext.data;
+			event.length = info.length;
+			event.event = info.event;
+			event.param1 = info.basic.param1;
+			event.param2 = info.basic.param2;
+			event.loop = info.loop;
+			event.noop = info.noop;
+			events.push_back(event);
+
+			if (info.event < 0x80 || (info.event == 0xFF && info.ext.type == 0x2F))
+				break;
+
+			if (info.event == 0xFF && info.ext.type == 0x51 && info.length >= 3) {
+				CompiledTempoEntry entry;
+				entry.tick = tick;
+				entry.subtrack = i;
+				entry.index = events.size();
+				entry.tempo = info.ext.data[0] << 16 | info.ext.data[1] << 8 | info.ext.data[2];
+				tempos.push_back(entry);
+			}
+		}
+	}
+
+	_position = currentPos;
+
+	Common::sort(tempos.begin(), tempos.end(), CompiledTempoLess());
+	_compiledTempos.resize(tempos.size());
+	for (uint i = 0; i < tempos.size(); i++) {
+		const CompiledTempoEntry &entry = tempos[i];
+
+		// jumpToTick() times the delta before an event with the tick length
+		// set by that event, so the new tempo starts at the tick of the
+		// event played before the tempo change
+		uint32 startTick = 0;
+		for (int j = 0; j < _numSubtracks[track]; j++) {
+			const Common::Array<CompiledEvent> &events = _compiledEvents[j];
+			uint32 count;
+			if (j == entry.subtrack) {
+				count = entry.index - 1;
+			} else {
+				// Events at the same tick are played first if their
+				// subtrack is lower
+				uint32 low = 0, high = events.size();
+				while (low < high) {
+					const uint32 middle = (low + high) / 2;
+					if (events[middle].tick < entry.tick || (j < entry.subtrack && events[middle].tick == entry.tick))
+						low = middle + 1;
+					else
+						high = middle;
+				}
+				count = low;
+			}
+			if (count > 0)
+				startTick = MAX(startTick, events[count - 1].tick);
+		}
+
+		_compiledTempos[i].tick = entry.tick;
+		_compiledTempos[i].startTick = startTick;
+		_compiledTempos[i].tempo = entry.tempo;
+	}
+
+	_trackCompiled = true;
+}
+
+void MidiParser::clearCompiledTrack() {
+	if (!_trackCompiled)
+		return;
+
+	for (int i = 0; i < MAXIMUM_SUBTRACKS; i++)
+		_compiledEvents[i].clear();
+	_compiledTempos.clear();
+	_trackCompiled = false;
+}
+
+bool MidiParser::jumpToCompiledTick(uint32 tick) {
+	// Find the first event at or after the tick in each subtrack. The
+	// events before it would have been processed by jumpToTick().
+	uint32 eventIndex[MAXIMUM_SUBTRACKS];
+	uint32 lastEventTick = 0;
+	bool tracking = false;
+	for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
+		const Common::Array<CompiledEvent> &events = _compiledEvents[i];
+		uint32 low = 0, high = events.size();
+		while (low < high) {
+			const uint32 middle = (low + high) / 2;
+			if (events[middle].tick < tick)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		eventIndex[i] = low;
+		if (low > 0)
+			lastEventTick = MAX(lastEventTick, events[low - 1].tick);
+		// The End of Track event is the last one, so the subtrack is
+		// still playing if there are events left
+		tracking |= (low < events.size());
+	}
+
+	if (!tracking)
+		return false;
+
+	// Process the skipped tempo changes, and keep the resulting tick
+	// lengths, starting with the current one like jumpToTick() does
+	Common::Array<CompiledTempo> segments;
+	CompiledTempo segment;
+	segment.tick = 0;
+	segment.tempo = _psecPerTick;
+	segments.push_back(segment);
+	for (uint i = 0; i < _compiledTempos.size() && _compiledTempos[i].tick < tick; i++) {
+		setTempo(_compiledTempos[i].tempo);
+		segment.tick = _compiledTempos[i].startTick;
+		segment.tempo = _psecPerTick;
+		segments.push_back(segment);
+	}
+
+	// Compute the event times the same way as when processing the events
+	// one by one, where each delta is multiplied by the current tick length
+	uint32 lastEventTime = 0;
+	uint32 subtrackTimes[MAXIMUM_SUBTRACKS];
+	for (int i = -1; i < _numSubtracks[_activeTrack]; i++) {
+		uint32 eventTick;
+		if (i < 0)
+			eventTick = lastEventTick;
+		else if (eventIndex[i] > 0)
+			eventTick = _compiledEvents[i][eventIndex[i] - 1].tick;
+		else
+			eventTick = 0;
+
+		uint32 time = 0;
+		for (uint j = 0; j < segments.size() && segments[j].tick < eventTick; j++) {
+			const uint32 end = (j + 1 < segments.size()) ? MIN(segments[j + 1].tick, eventTick) : eventTick;
+			time += (end - segments[j].tick) * segments[j].tempo;
+		}
+
+		if (i < 0)
+			lastEventTime = time;
+		else
+			subtrackTimes[i] = time;
+	}
+
+	for (int i = 0; i < _numSubtracks[_activeTrack]; i++) {
+		Tracker::SubtrackStatus &status = _position._subtracks[i];
+		if (eventIndex[i] > 0) {
+			status._lastEventTick = _compiledEvents[i][eventIndex[i] - 1].tick;
+			status._lastEventTime = subtrackTimes[i];
+		}
+		if (eventIndex[i] < _compiledEvents[i].size()) {
+			status._eventIndex = eventIndex[i];
+			readNextEvent(_nextSubtrackEvents[i]);
+		}
+	}
+	determineNextEvent();
+
+	_position._lastEventTick = lastEventTick;
+	_position._lastEventTime = lastEventTime;
+	_position._playTick = tick;
+	_position._playTime = lastEventTime + (tick - lastEventTick) * _psecPerTick;
+	return true;
+}
+
 void MidiParser::unloadMusic() {
 	if (_numTracks == 0)
 		// No music data loaded
@@ -731,6 +999,7 @@ void MidiParser::unloadMusic() {
 	_activeTrack = 255;
 	_abortParse = true;
 	memset(_tracks, 0, sizeof(_tracks));
+	memset(_tracksEndPos, 0, sizeof(_tracksEndPos));
 	memset(_numSubtracks, 1, sizeof(_numSubtracks));
 	for (int i = 0; i < MAXIMUM_SUBTRACKS; i++) {
 		_nextSubtrackEvents[i].clear();
@@ -738,6 +1007,7 @@ void MidiParser::unloadMusic() {
 	}
 	_nextEvent = &_nextSubtrackEvents[0];
 	clearLoopSection();
+	clearCompiledTrack();
 
 	if (_centerPitchWheelOnUnload) {
 		// Center the pitch wheels in preparation for the next piece of
@@ -25,6 +25,7 @@
 #define AUDIO_MIDIPARSER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/endian.h"
 #include "common/stream.h"
 
@@ -64,12 +65,14 @@ struct Tracker {
 		uint32 _lastEventTime;  ///< The time, in microseconds, of the last event that was parsed
 		uint32 _lastEventTick;  ///< The tick at which the last parsed event occurs
 		byte   _runningStatus;  ///< Cached MIDI command, for MIDI streams that rely on implied event codes
+		uint32 _eventIndex;     ///< Index of the next event to read, for compiled tracks
 
 		void clear() {
 			_playPos = nullptr;
 			_lastEventTime = 0;
 			_lastEventTick = 0;
 			_runningStatus = 0;
+			_eventIndex = 0;
 		}
 
 		void stopTracking() {
@@ -378,6 +381,7 @@ protected:
 	bool   _disableAllNotesOffMidiEvents;   ///< Don't send All Notes Off MIDI messages
 	bool   _disableAutoStartPlayback;  ///< Do not automatically start playback after parsing MIDI data or setting the track
 	const byte  *_tracks[MAXIMUM_TRACKS][MAXIMUM_SUBTRACKS]; ///< Multi-track MIDI formats are supported, up to 120 tracks with 20 subtracks each.
+	const byte  *_tracksEndPos[MAXIMUM_TRACKS][MAXIMUM_SUBTRACKS]; ///< The end of the data of each subtrack, or nullptr if the parser does not set it.
 	byte   _numTracks;     ///< Count of total tracks for multi-track MIDI formats. 1 for single-track formats.
 	byte   _numSubtracks[MAXIMUM_TRACKS]; ///< The number of subtracks for each track.
 	byte   _activeTrack;   ///< Keeps track of the currently active track, in multi-track formats.
@@ -404,11 +408,59 @@ protected:
 	 */
 	int8   _source;
 
+	/**
+	 * An event of a compiled track, which holds the fields of the EventInfo
+	 * given by parseNextEvent(), with an absolute tick instead of a delta.
+	 */
+	struct CompiledEvent {
+		uint32 tick;        ///< The tick at which the event occurs, from the start of the subtrack.
+		const byte *start;  ///< See EventInfo::start.
+		const byte *data;   ///< See EventInfo::ext.data.
+		uint32 length;      ///< See EventInfo::length.
+		byte   event;       ///< See EventInfo::event.
+		byte   param1;      ///< See EventInfo::basic.param1 and EventInfo::ext.type.
+		byte   param2;      ///< See EventInfo::basic.param2.
+		bool   loop;        ///< See EventInfo::loop.
+		bool   noop;        ///< See EventInfo::noop.
+	};
+
+	/** A tempo change of a compiled track. */
+	struct CompiledTempo {
+		uint32 tick;      ///< The tick at which the tempo changes.
+		uint32 startTick; ///< The tick of the event played before the tempo change, from which jumpToTick() uses the new tempo.
+		uint32 tempo;     ///< The new tempo, or microseconds per tick in jumpToCompiledTick().
+	};
+
+	bool   _compileTracks; ///< Compile the tracks when they are selected.
+	bool   _trackCompiled; ///< True if the events of the active track are read from _compiledEvents.
+	Common::Array<CompiledEvent> _compiledEvents[MAXIMUM_SUBTRACKS]; ///< The events of each subtrack of the active track.
+	Common::Array<CompiledTempo> _compiledTempos; ///< The tempo changes of the active track, in playback order.
+
 protected:
 	static uint32 readVLQ(const byte * &data);
 	virtual void resetTracking();
 	virtual void allNotesOff();
 	virtual void parseNextEvent(EventInfo &info) = 0;
+	/**
+	 * Reads the next event of the subtrack of @p info, from the compiled
+	 * track if there is one, and using parseNextEvent() otherwise.
+	 */
+	void readNextEvent(EventInfo &info);
+	/**
+	 * Parses all the events of the specified track into _compiledEvents.
+	 * The parser state is restored afterwards, but parseNextEvent()
+	 * should only depend on the position in the subtracks. Each subtrack
+	 * stops at its End of Track event, or at the end of its data if it
+	 * has none. Nothing is compiled if the ends are not known.
+	 */
+	void compileTrack(uint8 track);
+	void clearCompiledTrack();
+	/**
+	 * Implements jumpToTick() without firing events for compiled tracks.
+	 * The events before @p tick are found with a binary search, and only
+	 * the tempo changes among them are processed.
+	 */
+	bool jumpToCompiledTick(uint32 tick);
 	/**
 	 * Determines which event in the active track's subtracks
 	 * should be processed next. This is set in _nextEvent.
@@ -510,7 +562,20 @@ public:
 		  * or setting the track. Use startPlaying to start playback.
 		  * Note that not every parser implementation might support this.
 		  */
-		 mpDisableAutoStartPlayback = 7
+		 mpDisableAutoStartPlayback = 7,
+
+		 /**
+		  * Compiles each track into an array of events when it is
+		  * selected, so that playback does not need to parse the MIDI
+		  * data anymore, and jumpToTick without firing events does not
+		  * need to go through every event before the target tick. Such
+		  * jumps only process the tempo changes of the skipped events.
+		  * Set this before loading the music. Only suitable for formats
+		  * whose events only depend on their position in the data, like
+		  * SMF and HMP. Tracks are only compiled if the parser sets the
+		  * end of their data in _tracksEndPos.
+		  */
+		 mpCompileTracks = 8
 	};
 
 public:
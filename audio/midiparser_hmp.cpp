@@ -113,6 +113,7 @@ bool MidiParser_HMP::loadMusic(const byte *data, uint32 size) {
 
 		_tracks[0][currTrack] = pos;
 		pos += chunkSize - 12;
+		_tracksEndPos[0][currTrack] = pos;
 	}
 
 	// TODO Read branching data
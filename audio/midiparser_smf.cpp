@@ -187,6 +187,10 @@ bool MidiParser_SMF::loadMusic(const byte *data, uint32 size) {
 		pos += 4;
 		len = read4high(pos);
 		pos += len;
+		if (midiType == 1)
+			_tracksEndPos[0][tracksRead] = pos;
+		else
+			_tracksEndPos[tracksRead][0] = pos;
 		++tracksRead;
 	}
 	if (midiType == 1) {
@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/mixbus.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Audio {
+
+void MixBus::mixNEON(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR) {
+	if (!stereo)
+		volL = volR = (volL + volR) / 2;
+
+	const int16 volPair[4] = { (int16)volL, (int16)volR, (int16)volL, (int16)volR };
+	const int16x4_t vol = vld1_s16(volPair);
+
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		const int16x8_t samples = vld1q_s16(src + i);
+		const int32x4_t sum0 = vmlal_s16(vld1q_s32(bus + i), vget_low_s16(samples), vol);
+		const int32x4_t sum1 = vmlal_s16(vld1q_s32(bus + i + 4), vget_high_s16(samples), vol);
+		vst1q_s32(bus + i, sum0);
+		vst1q_s32(bus + i + 4, sum1);
+	}
+
+	// numSamples is even for stereo, so the remaining samples start on the
+	// left channel
+	mixGeneric(bus + i, src + i, numSamples - i, stereo, volL, volR);
+}
+
+void MixBus::outputNEON(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos) {
+	const int32 *dither = getDitherTable();
+	uint pos = ditherPos;
+
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		const int32x4_t value0 = vshrq_n_s32(vaddq_s32(vld1q_s32(bus + i), vld1q_s32(dither + pos)), kFracBits);
+		const int32x4_t value1 = vshrq_n_s32(vaddq_s32(vld1q_s32(bus + i + 4), vld1q_s32(dither + pos + 4)), kFracBits);
+
+		// The narrowing saturates, which is the clipping of clipSample()
+		vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(value0), vqmovn_s32(value1)));
+
+		pos = (pos + 8) & (kDitherSize - 1);
+	}
+
+	ditherPos = pos;
+	outputGeneric(dst + i, bus + i, numSamples - i, ditherPos);
+}
+
+} // End of namespace Audio
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
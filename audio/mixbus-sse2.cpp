@@ -0,0 +1,96 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/mixbus.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+void MixBus::mixSSE2(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR) {
+	if (!stereo)
+		volL = volR = (volL + volR) / 2;
+
+	// The volumes fit in 16 bits, so the products are built from the low and
+	// high halves given by the 16-bit multiplications.
+	const __m128i vol = _mm_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		const __m128i samples = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i lo = _mm_mullo_epi16(samples, vol);
+		const __m128i hi = _mm_mulhi_epi16(samples, vol);
+
+		__m128i *out = (__m128i *)(bus + i);
+		_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, hi)));
+		_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, hi)));
+	}
+
+	// numSamples is even for stereo, so the remaining samples start on the
+	// left channel
+	mixGeneric(bus + i, src + i, numSamples - i, stereo, volL, volR);
+}
+
+void MixBus::outputSSE2(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos) {
+	const int32 *dither = getDitherTable();
+	uint pos = ditherPos;
+
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		const __m128i dither0 = _mm_loadu_si128((const __m128i *)(dither + pos));
+		const __m128i dither1 = _mm_loadu_si128((const __m128i *)(dither + pos + 4));
+		const __m128i value0 = _mm_srai_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i *)(bus + i)), dither0), kFracBits);
+		const __m128i value1 = _mm_srai_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i *)(bus + i + 4)), dither1), kFracBits);
+
+		// The pack saturates, which is the clipping of clipSample()
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(value0, value1));
+
+		pos = (pos + 8) & (kDitherSize - 1);
+	}
+
+	ditherPos = pos;
+	outputGeneric(dst + i, bus + i, numSamples - i, ditherPos);
+}
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,108 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audio/mixbus.h"
+#include "common/cpu.h"
+
+namespace Audio {
+
+MixBus::MixFunc MixBus::_mixFunc = MixBus::mixGeneric;
+MixBus::OutputFunc MixBus::_outputFunc = MixBus::outputGeneric;
+
+namespace {
+
+struct DitherTable {
+	int32 values[MixBus::kDitherSize + 8];
+
+	DitherTable() {
+		// A 32-bit Galois LFSR is plenty random for dithering
+		uint32 lfsr = 0xACE1u;
+		for (uint i = 0; i < MixBus::kDitherSize; i++) {
+			for (int bit = 0; bit < 8; bit++)
+				lfsr = (lfsr >> 1) ^ (-(int32)(lfsr & 1) & 0xA3000000u);
+			values[i] = lfsr & ((1 << MixBus::kFracBits) - 1);
+		}
+		for (uint i = 0; i < 8; i++)
+			values[MixBus::kDitherSize + i] = values[i];
+	}
+};
+
+} // End of anonymous namespace
+
+const int32 *MixBus::getDitherTable() {
+	static const DitherTable table;
+	return table.values;
+}
+
+void MixBus::selectKernels() {
+	// Make sure the table is built before the audio thread needs it
+	getDitherTable();
+
+	_mixFunc = mixGeneric;
+	_outputFunc = outputGeneric;
+
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#ifdef SCUMMVM_NEON
+	if (Common::hasNEON()) {
+		_mixFunc = mixNEON;
+		_outputFunc = outputNEON;
+	}
+#endif
+#ifdef SCUMMVM_SSE2
+	if (Common::hasSSE2()) {
+		_mixFunc = mixSSE2;
+		_outputFunc = outputSSE2;
+	}
+#endif
+#endif
+}
+
+void MixBus::mixGeneric(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR) {
+	if (stereo) {
+		assert(numSamples % 2 == 0);
+		for (uint i = 0; i < numSamples; i += 2) {
+			bus[i] += src[i] * volL;
+			bus[i + 1] += src[i + 1] * volR;
+		}
+	} else {
+		const int vol = (volL + volR) / 2;
+		for (uint i = 0; i < numSamples; i++)
+			bus[i] += src[i] * vol;
+	}
+}
+
+void MixBus::outputGeneric(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos) {
+	const int32 *dither = getDitherTable();
+	uint pos = ditherPos;
+
+	for (uint i = 0; i < numSamples; i++) {
+		int16 sample = clipSample((bus[i] + dither[pos]) >> kFracBits);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		sample ^= 0x8000;
+#endif
+		dst[i] = sample;
+		pos = (pos + 1) & (kDitherSize - 1);
+	}
+
+	ditherPos = pos;
+}
+
+} // End of namespace Audio
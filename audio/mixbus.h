@@ -0,0 +1,128 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_MIXBUS_H
+#define AUDIO_MIXBUS_H
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+namespace Audio {
+
+/**
+ * @defgroup audio_mixbus Mixing bus
+ * @ingroup audio
+ *
+ * @brief Kernels used by the default mixer to sum its channels.
+ * @{
+ */
+
+/**
+ * The mixing bus of MixerImpl.
+ *
+ * Channels are added to a 32-bit bus with their volume applied, without
+ * any clipping. Volumes range up to Mixer::kMaxMixerVolume, so the bus
+ * holds 16-bit samples with kFracBits bits of extra precision, and has
+ * room for far more than the 32 channels of the mixer. Only the sum is
+ * turned into 16-bit samples, by output(), which dithers away the extra
+ * precision and clips the samples which do not fit. Channels which cancel
+ * each other out therefore never clip, and a sum which fits in 16 bits is
+ * output unchanged.
+ *
+ * The kernels have SSE2 and NEON versions, which give the same results as
+ * the generic ones. They are selected by selectKernels().
+ */
+class MixBus {
+public:
+	enum {
+		/** Bits of precision below the 16-bit sample value. */
+		kFracBits = 8,
+		/** Size of the dither table, which is cycled through. */
+		kDitherSize = 1024
+	};
+
+	typedef void (*MixFunc)(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR);
+	typedef void (*OutputFunc)(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos);
+
+	/**
+	 * Add @p numSamples samples of @p src to @p bus, scaled by the volume.
+	 *
+	 * @param stereo  Whether the samples are interleaved stereo. In that
+	 *                case @p numSamples must be even, @p volL applies to
+	 *                the even samples and @p volR to the odd ones. Mono
+	 *                samples use the average of both volumes.
+	 */
+	static void mix(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR) {
+		_mixFunc(bus, src, numSamples, stereo, volL, volR);
+	}
+
+	/**
+	 * Convert @p numSamples samples of @p bus to 16-bit samples in @p dst.
+	 *
+	 * @param ditherPos  Position in the dither table, updated by the call.
+	 *                   Callers should keep it between calls.
+	 */
+	static void output(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos) {
+		_outputFunc(dst, bus, numSamples, ditherPos);
+	}
+
+	/**
+	 * Select the fastest kernels supported by the CPU. Until this is called,
+	 * the generic ones are used.
+	 */
+	static void selectKernels();
+
+	/** Generic version of mix(). */
+	static void mixGeneric(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR);
+	/** Generic version of output(). */
+	static void outputGeneric(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos);
+#ifdef SCUMMVM_SSE2
+	static void mixSSE2(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR);
+	static void outputSSE2(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos);
+#endif
+#ifdef SCUMMVM_NEON
+	static void mixNEON(int32 *bus, const int16 *src, uint numSamples, bool stereo, int volL, int volR);
+	static void outputNEON(int16 *dst, const int32 *bus, uint numSamples, uint &ditherPos);
+#endif
+
+	/**
+	 * Dither values added to the bus before dropping the extra precision.
+	 * They range from 0 to (1 << kFracBits) - 1, so samples without any
+	 * extra precision are not changed. The first 8 values are repeated at
+	 * the end, so that SIMD code can read past the end of the cycle.
+	 */
+	static const int32 *getDitherTable();
+
+	/** Clip a bus value, already shifted down to 16-bit range. */
+	static inline int16 clipSample(int32 value) {
+		return (int16)CLIP<int32>(value, -32768, 32767);
+	}
+
+private:
+	static MixFunc _mixFunc;
+	static OutputFunc _outputFunc;
+};
+
+/** @} */
+
+} // End of namespace Audio
+
+#endif
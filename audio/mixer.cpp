@@ -21,9 +21,13 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/system.h"
 #include "common/util.h"
 #include "common/textconsole.h"
 
+#include "audio/mixbus.h"
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
 #include "audio/audiostream.h"
@@ -42,19 +46,20 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality);
 	~Channel();
 
 	/**
-	 * Mixes the channel's samples into the given buffer.
+	 * Mixes the channel's samples into the given mixing bus.
 	 *
-	 * @param data buffer where to mix the data
-	 * @param len  number of sample *pairs*. So a value of
-	 *             10 means that the buffer contains twice 10 sample, each
-	 *             16 bits, for a total of 40 bytes.
-	 * @return number of sample pairs processed (which can still be silence!)
+	 * @param bus     the mixing bus, see MixBus
+	 * @param scratch buffer for kMixScratchSize samples, to convert the
+	 *                stream to the output rate before it is mixed
+	 * @param len     number of sample frames, one sample for mono output
+	 *                and two for stereo output
+	 * @return number of sample frames processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(int32 *bus, int16 *scratch, uint len);
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -195,6 +200,31 @@ public:
 	 */
 	SoundHandle getHandle() const { return _handle; }
 
+	/**
+	 * Accounts for a call to mix() which took @p micros microseconds.
+	 */
+	void addStats(uint32 micros, int frames);
+
+	/**
+	 * Queries the timing statistics of the channel.
+	 */
+	const MixerImpl::ChannelStats &getStats() const { return _stats; }
+
+	/**
+	 * Resets the timing statistics of the channel.
+	 */
+	void resetStats() { _stats = MixerImpl::ChannelStats(); }
+
+	/**
+	 * Describes the format of the channel's stream.
+	 */
+	Common::String getStreamName() const;
+
+	/**
+	 * Describes how the channel's stream is resampled.
+	 */
+	Common::String getConverterName() const;
+
 private:
 	const Mixer::SoundType _type;
 	SoundHandle _handle;
@@ -219,23 +249,62 @@ private:
 	uint32 _pauseTime;
 
 	RateConverter *_converter;
+	RateConverterQuality _quality;
 	Common::DisposablePtr<AudioStream> _stream;
+
+	MixerImpl::ChannelStats _stats;
 };
 
 #pragma mark -
 #pragma mark --- Mixer ---
 #pragma mark -
 
+namespace {
+
+const char *const soundTypeNames[] = { "plain", "music", "sfx", "speech" };
+
+} // End of anonymous namespace
+
+MixerImpl::Stats::Stats() : callbacks(0), underruns(0), overBudget(0), callbackMicros(0), maxCallbackMicros(0) {
+	for (int i = 0; i < kStatsHistogramSize; i++)
+		histogram[i] = 0;
+}
+
 MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize)
-	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _ditherPos(0), _rateConverterQuality(kRateConverterLinear), _profiling(false), _lastCallbackMicros(0), _logStats(false) {
 
 	assert(sampleRate > 0);
 
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = nullptr;
+
+	// Allocate the bus up front, so that the audio callback does not need to
+	_mixBus.resize((outBufSize ? outBufSize : (uint)kMixBusFrames) * (stereo ? 2 : 1));
+
+	MixBus::selectKernels();
+
+	const Common::String &resampler = ConfMan.get("resampler");
+	if (resampler == "sinc_low")
+		_rateConverterQuality = kRateConverterSincLow;
+	else if (resampler == "sinc_medium")
+		_rateConverterQuality = kRateConverterSincMedium;
+	else if (resampler == "sinc_high")
+		_rateConverterQuality = kRateConverterSincHigh;
+	else if (!resampler.empty() && resampler != "linear")
+		warning("Unknown resampler '%s', using linear interpolation", resampler.c_str());
+
+	// Collect the statistics from the start, and log them once done
+	if (ConfMan.hasKey("mixer_stats") && ConfMan.getBool("mixer_stats")) {
+		_profiling = true;
+		_logStats = true;
+	}
 }
 
 MixerImpl::~MixerImpl() {
+	if (_logStats)
+		debug("%s", buildStatsReport().c_str());
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
 }
@@ -246,6 +315,12 @@ void MixerImpl::setReady(bool ready) {
 	_mixerReady = ready;
 }
 
+void MixerImpl::setRateConverterQuality(RateConverterQuality quality) {
+	Common::StackLock lock(_mutex);
+
+	_rateConverterQuality = quality;
+}
+
 uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
@@ -322,7 +397,7 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _rateConverterQuality);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -338,9 +413,6 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
-	//  zero the buf
-	memset(buf, 0, len);
-
 	// we store 16-bit samples
 	if (_stereo) {
 		assert(len % 4 == 0);
@@ -350,24 +422,146 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 		len >>= 1;
 	}
 
-	// mix all channels
-	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = nullptr;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
-
-				if (tmp > res)
-					res = tmp;
+	const uint64 startMicros = _profiling ? g_system->getMicros() : 0;
+
+	// Mix as many frames as the bus holds at a time
+	const uint channels = _stereo ? 2 : 1;
+	int32 *bus = _mixBus.data();
+	int res = 0;
+	for (uint done = 0; done < len; ) {
+		const uint frames = MIN<uint>(len - done, _mixBus.size() / channels);
+
+		// zero the mixing bus
+		memset(bus, 0, frames * channels * sizeof(int32));
+
+		// mix all channels
+		int partRes = 0, tmp;
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_channels[i]) {
+				if (_channels[i]->isFinished()) {
+					delete _channels[i];
+					_channels[i] = nullptr;
+				} else if (!_channels[i]->isPaused()) {
+					if (_profiling) {
+						const uint64 channelStart = g_system->getMicros();
+						tmp = _channels[i]->mix(bus, _mixScratch, frames);
+						_channels[i]->addStats((uint32)(g_system->getMicros() - channelStart), tmp);
+					} else {
+						tmp = _channels[i]->mix(bus, _mixScratch, frames);
+					}
+
+					if (tmp > partRes)
+						partRes = tmp;
+				}
 			}
-		}
+
+		// clip the sum only once, to the output samples
+		MixBus::output(buf + done * channels, bus, frames * channels, _ditherPos);
+
+		res += partRes;
+		done += frames;
+	}
+
+	if (_profiling)
+		recordCallback(startMicros, g_system->getMicros(), len);
 
 	return res;
 }
 
+void MixerImpl::recordCallback(uint64 startMicros, uint64 endMicros, uint frames) {
+	const uint32 micros = (uint32)(endMicros - startMicros);
+	const uint32 budget = (uint32)((uint64)frames * 1000000 / _sampleRate);
+
+	// The backend asks for more audio when the previous buffer is about to
+	// be played out. Allow for some jitter, but if much more time than the
+	// previous buffer lasted went by, the output must have run dry.
+	if (_stats.callbacks > 0 && startMicros - _lastCallbackMicros > (uint64)budget * 3 / 2)
+		_stats.underruns++;
+	_lastCallbackMicros = startMicros;
+
+	_stats.callbacks++;
+	_stats.callbackMicros += micros;
+	_stats.maxCallbackMicros = MAX(_stats.maxCallbackMicros, micros);
+	if (micros > budget)
+		_stats.overBudget++;
+
+	int bucket;
+	if (micros * 8 <= budget)
+		bucket = 0;
+	else if (micros * 4 <= budget)
+		bucket = 1;
+	else if (micros * 2 <= budget)
+		bucket = 2;
+	else if (micros * 4 <= budget * 3)
+		bucket = 3;
+	else if (micros <= budget)
+		bucket = 4;
+	else
+		bucket = 5;
+	_stats.histogram[bucket]++;
+}
+
+void MixerImpl::setProfiling(bool enable) {
+	Common::StackLock lock(_mutex);
+
+	_profiling = enable;
+	_stats = Stats();
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		if (_channels[i])
+			_channels[i]->resetStats();
+}
+
+bool MixerImpl::isProfiling() const {
+	Common::StackLock lock(_mutex);
+	return _profiling;
+}
+
+MixerImpl::Stats MixerImpl::getStats() {
+	Common::StackLock lock(_mutex);
+	return _stats;
+}
+
+bool MixerImpl::getChannelStats(SoundHandle handle, ChannelStats &stats) {
+	Common::StackLock lock(_mutex);
+
+	const int index = handle._val % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+		return false;
+
+	stats = _channels[index]->getStats();
+	return true;
+}
+
+Common::String MixerImpl::getStatsReport() {
+	Common::StackLock lock(_mutex);
+	return buildStatsReport();
+}
+
+Common::String MixerImpl::buildStatsReport() const {
+	if (!_profiling)
+		return "Mixer profiling is disabled";
+
+	Common::String report = Common::String::format("Mixer: %u callbacks, %u underruns, %u over budget, %u us average, %u us max\n",
+		_stats.callbacks, _stats.underruns, _stats.overBudget,
+		_stats.callbacks ? (uint32)(_stats.callbackMicros / _stats.callbacks) : 0, _stats.maxCallbackMicros);
+	report += Common::String::format("Callback time vs. budget: <=1/8: %u, <=1/4: %u, <=1/2: %u, <=3/4: %u, <=1: %u, >1: %u\n",
+		_stats.histogram[0], _stats.histogram[1], _stats.histogram[2], _stats.histogram[3], _stats.histogram[4], _stats.histogram[5]);
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		const Channel *chan = _channels[i];
+		if (!chan)
+			continue;
+
+		const ChannelStats &stats = chan->getStats();
+		const uint32 share = _stats.callbackMicros ? (uint32)(stats.mixMicros * 100 / _stats.callbackMicros) : 0;
+		report += Common::String::format("Channel %d (%s, id %d): %s, %s, %u frames, %u us average, %u us max, %u%% of callback time\n",
+			i, soundTypeNames[chan->getType()], chan->getId(), chan->getStreamName().c_str(), chan->getConverterName().c_str(),
+			(uint32)stats.framesMixed, stats.mixCalls ? (uint32)(stats.mixMicros / stats.mixCalls) : 0, stats.maxMixMicros, share);
+	}
+
+	return report;
+}
+
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
@@ -639,22 +833,56 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality)
 	: _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
 	  _balance(0), _faderL(255), _faderR(255), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-	  _pauseStartTime(0), _pauseTime(0), _converter(nullptr), _volL(0), _volR(0),
+	  _pauseStartTime(0), _pauseTime(0), _converter(nullptr), _quality(quality), _volL(0), _volR(0),
 	  _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo, quality);
+
+	// Remember the actual algorithm, for the statistics
+	if ((uint)_stream->getRate() == mixer->getOutputRate())
+		_quality = kRateConverterLinear;
 }
 
 Channel::~Channel() {
 	delete _converter;
 }
 
+void Channel::addStats(uint32 micros, int frames) {
+	_stats.mixCalls++;
+	_stats.framesMixed += frames;
+	_stats.mixMicros += micros;
+	_stats.maxMixMicros = MAX(_stats.maxMixMicros, micros);
+}
+
+Common::String Channel::getStreamName() const {
+	return Common::String::format("%s stream at %d Hz", _stream->isStereo() ? "stereo" : "mono", _stream->getRate());
+}
+
+Common::String Channel::getConverterName() const {
+	const uint32 inRate = _converter->getInputRate();
+	const uint32 outRate = _converter->getOutputRate();
+
+	const char *name;
+	if (inRate == outRate)
+		name = "copy";
+	else if (_quality == kRateConverterSincLow)
+		name = "sinc_low";
+	else if (_quality == kRateConverterSincMedium)
+		name = "sinc_medium";
+	else if (_quality == kRateConverterSincHigh)
+		name = "sinc_high";
+	else
+		name = "linear";
+
+	return Common::String::format("%s %u Hz -> %u Hz", name, inRate, outRate);
+}
+
 void Channel::setVolume(const byte volume) {
 	_volume = volume;
 	updateChannelVolumes();
@@ -793,7 +1021,7 @@ void Channel::loop() {
 	}
 }
 
-int Channel::mix(int16 *data, uint len) {
+int Channel::mix(int32 *bus, int16 *scratch, uint len) {
 	assert(_stream);
 	assert(_converter);
 
@@ -802,7 +1030,35 @@ int Channel::mix(int16 *data, uint len) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
 		_pauseTime = 0;
-		res = _converter->convert(*_stream, data, len, _volL, _volR);
+
+		// The converter produces the samples at full volume. The volume is
+		// applied when mixing them into the bus, so that the samples are
+		// only clipped once all channels are summed up.
+		const bool stereo = _mixer->getOutputStereo();
+		const uint maxFrames = stereo ? MixerImpl::kMixScratchSize / 2 : MixerImpl::kMixScratchSize;
+		while ((uint)res < len) {
+			const uint frames = MIN(len - res, maxFrames);
+			const uint numSamples = stereo ? frames * 2 : frames;
+#ifdef OUTPUT_UNSIGNED_AUDIO
+			Common::fill(scratch, scratch + numSamples, (int16)0x8000);
+#else
+			memset(scratch, 0, numSamples * sizeof(int16));
+#endif
+			const int converted = _converter->convert(*_stream, scratch, frames, Mixer::kMaxMixerVolume, Mixer::kMaxMixerVolume);
+			if (converted <= 0)
+				break;
+
+			const uint convertedSamples = stereo ? converted * 2 : converted;
+#ifdef OUTPUT_UNSIGNED_AUDIO
+			for (uint i = 0; i < convertedSamples; i++)
+				scratch[i] ^= 0x8000;
+#endif
+			MixBus::mix(bus + (stereo ? res * 2 : res), scratch, convertedSamples, stereo, _volL, _volR);
+
+			res += converted;
+			if ((uint)converted < frames)
+				break;
+		}
 		_samplesDecoded += res;
 	}
 
@@ -23,6 +23,7 @@
 #define AUDIO_MIXER_H
 
 #include "common/mutex.h"
+#include "common/str.h"
 #include "common/types.h"
 #include "common/noncopyable.h"
 
@@ -390,6 +391,26 @@ public:
 	 * @return The number of samples processed at each audio callback.
 	 */
 	virtual uint getOutputBufSize() const = 0;
+
+	/**
+	 * Enable or disable the collection of timing statistics by the mixer.
+	 * Enabling it resets the statistics.
+	 */
+	virtual void setProfiling(bool enable) = 0;
+
+	/**
+	 * Check whether the mixer collects timing statistics.
+	 */
+	virtual bool isProfiling() const = 0;
+
+	/**
+	 * Describe the statistics collected since profiling was enabled: the
+	 * time spent in the audio callback, the underruns, and the share of
+	 * each channel.
+	 *
+	 * @return Human readable lines, separated by newlines.
+	 */
+	virtual Common::String getStatsReport() = 0;
 };
 
 /** @} */
@@ -23,8 +23,10 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -56,6 +58,52 @@ namespace Audio {
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
+public:
+	enum {
+		/** Size, in samples, of the buffer a channel is converted into before mixing. */
+		kMixScratchSize = 1024,
+		/** Size, in sample frames, of the mixing bus when the backend does not give its buffer size. */
+		kMixBusFrames = 2048,
+		/** Number of buckets of Stats::histogram. */
+		kStatsHistogramSize = 6
+	};
+
+	/** Timing statistics of the mixer, see setProfiling(). */
+	struct Stats {
+		Stats();
+
+		/** Number of calls to mixCallback(). */
+		uint32 callbacks;
+		/**
+		 * Number of callbacks which started later than the end of the
+		 * audio produced by the previous one, i.e. after the output ran dry.
+		 */
+		uint32 underruns;
+		/** Number of callbacks which took longer than the audio they produced. */
+		uint32 overBudget;
+		/** Total and longest time spent in mixCallback(), in microseconds. */
+		uint64 callbackMicros;
+		uint32 maxCallbackMicros;
+		/**
+		 * Number of callbacks by the time they took, compared to the
+		 * duration of the audio they produced: up to 1/8, 1/4, 1/2, 3/4,
+		 * all of it, and more than that.
+		 */
+		uint32 histogram[kStatsHistogramSize];
+	};
+
+	/** Timing statistics of a channel, see setProfiling(). */
+	struct ChannelStats {
+		ChannelStats() : mixCalls(0), framesMixed(0), mixMicros(0), maxMixMicros(0) {}
+
+		/** Number of times the channel was mixed, and the frames produced. */
+		uint32 mixCalls;
+		uint64 framesMixed;
+		/** Total and longest time spent mixing the channel, in microseconds. */
+		uint64 mixMicros;
+		uint32 maxMixMicros;
+	};
+
 private:
 	enum {
 		NUM_CHANNELS = 32
@@ -79,6 +127,33 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * The channels are summed up in this buffer, see MixBus. It is allocated
+	 * with the mixer, and larger callbacks are mixed in several parts.
+	 */
+	Common::Array<int32> _mixBus;
+	int16 _mixScratch[kMixScratchSize];
+	uint _ditherPos;
+
+	/** How streams of new channels are resampled to the output rate. */
+	RateConverterQuality _rateConverterQuality;
+
+	bool _profiling;
+	Stats _stats;
+	/** Start of the previous callback, to detect underruns. */
+	uint64 _lastCallbackMicros;
+	/** Whether to log the statistics when the mixer is destroyed. */
+	bool _logStats;
+
+	Common::String buildStatsReport() const;
+
+protected:
+	/**
+	 * Accounts for a call to mixCallback() which produced @p frames frames
+	 * between the times @p startMicros and @p endMicros.
+	 */
+	void recordCallback(uint64 startMicros, uint64 endMicros, uint frames);
+
 
 public:
 
@@ -140,6 +215,20 @@ public:
 	bool getOutputStereo() const override;
 	uint getOutputBufSize() const override;
 
+	void setProfiling(bool enable) override;
+	bool isProfiling() const override;
+	Common::String getStatsReport() override;
+
+	/** Return the statistics collected since profiling was enabled. */
+	Stats getStats();
+
+	/**
+	 * Return the statistics of the channel playing @p handle.
+	 *
+	 * @return false if the sound is not playing anymore.
+	 */
+	bool getChannelStats(SoundHandle handle, ChannelStats &stats);
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
@@ -161,6 +250,13 @@ public:
 	 * their audio system has been completed.
 	 */
 	void setReady(bool ready);
+
+	/**
+	 * Set how the streams of channels started from now on are resampled to
+	 * the output rate. By default, this is taken from the "resampler"
+	 * config key.
+	 */
+	void setRateConverterQuality(RateConverterQuality quality);
 };
 
 /** @} */
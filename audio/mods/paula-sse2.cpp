@@ -0,0 +1,149 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/mods/paula.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+namespace {
+
+/** Add the denormal offset of the generic filter, in double precision like it does. */
+inline __m128 addDenormalOffset(__m128 value) {
+	const __m128d offset = _mm_set1_pd(1E-10);
+	const __m128d lo = _mm_add_pd(_mm_cvtps_pd(value), offset);
+	const __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(value, value)), offset);
+	return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+/** One step of a first order low-pass filter: a0 * input + (1 - a0) * state. */
+inline __m128 lowPass(__m128 input, __m128 state, __m128 a0, __m128 a1) {
+	return _mm_add_ps(_mm_mul_ps(a0, input), _mm_mul_ps(a1, state));
+}
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+} // End of anonymous namespace
+
+void Paula::filterVoicesSSE2(FilterState &state, int32 *samples, const VoiceSpan *spans) {
+	// The four voices are filtered at once, one per lane. The lanes of the
+	// voices which rendered fewer samples are left alone past their end.
+	uint numSamples = 0;
+	for (int voice = 0; voice < NUM_VOICES; voice++)
+		numSamples = MAX(numSamples, spans[voice].count);
+	if (!numSamples)
+		return;
+
+	const __m128i count = _mm_set_epi32(spans[3].count, spans[2].count, spans[1].count, spans[0].count);
+	const __m128i split = _mm_set_epi32(spans[3].split, spans[2].split, spans[1].split, spans[0].split);
+	const __m128i ledBefore = _mm_set_epi32(-spans[3].ledFilter[0], -spans[2].ledFilter[0], -spans[1].ledFilter[0], -spans[0].ledFilter[0]);
+	const __m128i ledAfter = _mm_set_epi32(-spans[3].ledFilter[1], -spans[2].ledFilter[1], -spans[1].ledFilter[1], -spans[0].ledFilter[1]);
+
+	__m128 a0[3], a1[3];
+	for (int i = 0; i < 3; i++) {
+		a0[i] = _mm_set1_ps(state.a0[i]);
+		a1[i] = _mm_set1_ps(1 - state.a0[i]);
+	}
+
+	__m128 rc[5];
+	for (int i = 0; i < 5; i++)
+		rc[i] = _mm_set_ps(state.rc[3][i], state.rc[2][i], state.rc[1][i], state.rc[0][i]);
+
+	const bool a500 = (state.mode == kFilterModeA500);
+	__m128i index = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi32(1);
+
+	for (uint i = 0; i < numSamples; i++) {
+		__m128i *p = (__m128i *)(samples + i * NUM_VOICES);
+		const __m128 input = _mm_cvtepi32_ps(_mm_loadu_si128(p));
+		const __m128 active = _mm_castsi128_ps(_mm_cmplt_epi32(index, count));
+		const __m128 led = _mm_castsi128_ps(_mm_or_si128(
+			_mm_andnot_si128(_mm_cmplt_epi32(index, split), ledAfter),
+			_mm_and_si128(_mm_cmplt_epi32(index, split), ledBefore)));
+
+		__m128 normalOutput, ledOutput;
+		if (a500) {
+			const __m128 rc0 = addDenormalOffset(lowPass(input, rc[0], a0[0], a1[0]));
+			const __m128 rc1 = lowPass(rc0, rc[1], a0[1], a1[1]);
+			const __m128 rc2 = lowPass(rc1, rc[2], a0[2], a1[2]);
+			const __m128 rc3 = lowPass(rc2, rc[3], a0[2], a1[2]);
+			const __m128 rc4 = lowPass(rc3, rc[4], a0[2], a1[2]);
+			rc[0] = select(active, rc0, rc[0]);
+			rc[1] = select(active, rc1, rc[1]);
+			rc[2] = select(active, rc2, rc[2]);
+			rc[3] = select(active, rc3, rc[3]);
+			rc[4] = select(active, rc4, rc[4]);
+			normalOutput = rc1;
+			ledOutput = rc4;
+		} else {
+			const __m128 rc1 = addDenormalOffset(lowPass(input, rc[1], a0[2], a1[2]));
+			const __m128 rc2 = lowPass(rc1, rc[2], a0[2], a1[2]);
+			const __m128 rc3 = lowPass(rc2, rc[3], a0[2], a1[2]);
+			rc[1] = select(active, rc1, rc[1]);
+			rc[2] = select(active, rc2, rc[2]);
+			rc[3] = select(active, rc3, rc[3]);
+			normalOutput = input;
+			ledOutput = rc3;
+		}
+
+		// Truncate and clip to 16 bits, like CLIP<int32>() does
+		const __m128i output = _mm_cvttps_epi32(select(led, ledOutput, normalOutput));
+		const __m128i packed = _mm_packs_epi32(output, output);
+		_mm_storeu_si128(p, _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+
+		index = _mm_add_epi32(index, one);
+	}
+
+	float values[4];
+	for (int i = 0; i < 5; i++) {
+		_mm_storeu_ps(values, rc[i]);
+		for (int voice = 0; voice < NUM_VOICES; voice++)
+			state.rc[voice][i] = values[voice];
+	}
+}
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -33,11 +33,10 @@
 #include <math.h>
 
 #include "common/scummsys.h"
-#include "common/translation.h"
+#include "common/config-manager.h"
 
 #include "audio/mixer.h"
 #include "audio/mods/paula.h"
-#include "audio/null.h"
 
 namespace Audio {
 
@@ -52,6 +51,18 @@ Paula::Paula(bool stereo, int rate, uint interruptFreq, FilterMode filterMode, i
 	_filterState.a0[1] = filterCalculateA0(rate, 20000);
 	_filterState.a0[2] = filterCalculateA0(rate,  7000);
 
+	_filterFunc = filterVoicesGeneric;
+#if defined(SCUMMVM_SSE2) && (defined(__x86_64__) || defined(_M_X64)) && !defined(__FP_FAST_FMAF)
+	// The generic filter only rounds like the SIMD one when it uses SSE too,
+	// and when the compiler cannot fuse its multiplications and additions
+	_filterFunc = filterVoicesSSE2;
+#endif
+
+	_bandLimited = false;
+	bandLimitResetState();
+	if (ConfMan.hasKey("amiga_band_limited") && ConfMan.getBool("amiga_band_limited"))
+		setBandLimited(true);
+
 	clearVoices();
 	_voice[0].panning = PANNING_RIGHT;
 	_voice[1].panning = PANNING_LEFT;
@@ -122,7 +133,7 @@ int Paula::readBuffer(int16 *buffer, const int numSamples) {
  * The current filtering should be accurate to 2 dB with the filter on,
  * and to 1 dB with the filter off.
  */
-inline int32 filter(int32 input, Paula::FilterState &state, int voice) {
+inline int32 filter(int32 input, Paula::FilterState &state, int voice, bool ledFilter) {
 	float normalOutput, ledOutput;
 
 	switch (state.mode) {
@@ -154,33 +165,104 @@ inline int32 filter(int32 input, Paula::FilterState &state, int voice) {
 
 	}
 
-	return CLIP<int32>(state.ledFilter ? ledOutput : normalOutput, -32768, 32767);
+	return CLIP<int32>(ledFilter ? ledOutput : normalOutput, -32768, 32767);
 }
 
-template<bool stereo>
-inline int mixBuffer(int16 *&buf, const int8 *data, Paula::Offset &offset, frac_t rate, int neededSamples, uint bufSize, byte volume, byte panning, Paula::FilterState &filterState, int voice) {
-	int samples;
-	for (samples = 0; samples < neededSamples && offset.int_off < bufSize; ++samples) {
-		const int32 tmp = filter(((int32) data[offset.int_off]) * volume, filterState, voice);
-		if (stereo) {
-			*buf++ += (tmp * (255 - panning)) >> 7;
-			*buf++ += (tmp * (panning)) >> 7;
-		} else
-			*buf++ += tmp;
-
-		// Step to next source sample
-		offset.rem_off += rate;
-		if (offset.rem_off >= (frac_t)FRAC_ONE) {
-			offset.int_off += fracToInt(offset.rem_off);
-			offset.rem_off &= FRAC_LO_MASK;
+void Paula::filterVoicesGeneric(FilterState &state, int32 *samples, const VoiceSpan *spans) {
+	// Work on a copy, which the compiler knows the samples cannot alias
+	FilterState localState = state;
+
+	for (int voice = 0; voice < NUM_VOICES; voice++) {
+		const VoiceSpan &span = spans[voice];
+		int32 *p = samples + voice;
+		for (uint i = 0; i < span.split; i++, p += NUM_VOICES)
+			*p = filter(*p, localState, voice, span.ledFilter[0]);
+		for (uint i = span.split; i < span.count; i++, p += NUM_VOICES)
+			*p = filter(*p, localState, voice, span.ledFilter[1]);
+	}
+
+	state = localState;
+}
+
+uint Paula::renderVoice(int voice, int32 *dst, frac_t rate, uint numSamples) {
+	if (_bandLimited)
+		return renderVoiceBandLimited(voice, dst, rate, numSamples);
+
+	Channel &ch = _voice[voice];
+	if (ch.offset.int_off >= ch.length)
+		return 0;
+
+	// Work out up front how many samples can be taken before the end of the
+	// data, so that the loop does not need to check it
+	uint64 pos = ((uint64)ch.offset.int_off << FRAC_BITS) | ch.offset.rem_off;
+	const uint64 end = (uint64)ch.length << FRAC_BITS;
+	uint count = numSamples;
+	if (rate > 0)
+		count = (uint)MIN<uint64>(numSamples, (end - pos + rate - 1) / rate);
+
+	const int8 *data = ch.data;
+	const int32 volume = ch.volume;
+	for (uint i = 0; i < count; i++) {
+		*dst = data[pos >> FRAC_BITS] * volume;
+		dst += NUM_VOICES;
+		pos += rate;
+	}
+
+	ch.offset.int_off = (uint)(pos >> FRAC_BITS);
+	ch.offset.rem_off = (frac_t)(pos & FRAC_LO_MASK);
+	return count;
+}
+
+uint Paula::renderVoiceBandLimited(int voice, int32 *dst, frac_t rate, uint numSamples) {
+	Channel &ch = _voice[voice];
+	BandLimitState &state = _bandLimit[voice];
+
+	// Add a band-limited step to the voice, which happened the given
+	// fraction of an output sample before the next one
+	const auto addStep = [&](int32 value, int64 elapsed) {
+		const int32 delta = value - state.value;
+		if (!delta)
+			return;
+		state.value = value;
+
+		uint phase = kBlepPhases - 1;
+		if (rate > 0)
+			phase = (uint)MIN<int64>((elapsed * kBlepPhases + rate / 2) / rate, kBlepPhases - 1);
+		const float *blep = &_blepTable[phase * kBlepLength];
+		for (uint j = 0; j < kBlepLength; j++)
+			state.residual[(state.pos + j) % kBlepLength] += delta * blep[j];
+	};
+
+	uint i;
+	for (i = 0; i < numSamples && ch.offset.int_off < ch.length; i++) {
+		// The data, or the volume, may have changed since the last sample
+		if (i == 0)
+			addStep(ch.data[ch.offset.int_off] * ch.volume, ch.offset.rem_off);
+
+		const float output = state.value + state.residual[state.pos];
+		*dst = (int32)(output >= 0 ? output + 0.5f : output - 0.5f);
+		dst += NUM_VOICES;
+		state.residual[state.pos] = 0;
+		state.pos = (state.pos + 1) % kBlepLength;
+
+		// Step to next source sample, through all the ones in between
+		const uint prev = ch.offset.int_off;
+		ch.offset.rem_off += rate;
+		if (ch.offset.rem_off >= (frac_t)FRAC_ONE) {
+			ch.offset.int_off += fracToInt(ch.offset.rem_off);
+			ch.offset.rem_off &= FRAC_LO_MASK;
 		}
+		for (uint k = prev + 1; k <= ch.offset.int_off && k < ch.length; k++)
+			addStep(ch.data[k] * ch.volume, ((int64)(ch.offset.int_off - k) << FRAC_BITS) + ch.offset.rem_off);
 	}
 
-	return samples;
+	return i;
 }
 
 template<bool stereo>
 int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
+	VoiceSpan spans[NUM_VOICES];
+
 	int samples = stereo ? numSamples / 2 : numSamples;
 	while (samples > 0) {
 
@@ -192,14 +274,25 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 		}
 
 		// Compute how many samples to generate: at most the requested number of samples,
-		// of course, but we may stop earlier when an 'interrupt' is expected.
-		const uint nSamples = MIN((uint)samples, _curInt);
+		// of course, but we may stop earlier when an 'interrupt' is expected, or
+		// when the voice buffer is full.
+		const uint nSamples = MIN<uint>(MIN((uint)samples, _curInt), kMaxBlockSize);
+
+		// The voices are rendered first, then filtered and mixed together,
+		// which lets the filter process the four voices at once
+		int32 *voiceSamples = _voiceSamples;
 
 		// Loop over the four channels of the emulated Paula chip
 		for (int voice = 0; voice < NUM_VOICES; voice++) {
+			VoiceSpan &span = spans[voice];
+			span.count = span.split = 0;
+
 			// No data, or paused -> skip channel
-			if (!_voice[voice].data || (_voice[voice].period <= 0))
+			if (!_voice[voice].data || (_voice[voice].period <= 0)) {
+				if (_bandLimited)
+					bandLimitResetVoice(voice);
 				continue;
+			}
 
 			// The Paula chip apparently run at 7.0937892 MHz in the PAL
 			// version and at 7.1590905 MHz in the NTSC version. We divide this
@@ -213,19 +306,24 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 
 
 			Channel &ch = _voice[voice];
-			int16 *p = buffer;
-			int neededSamples = nSamples;
+			int32 *p = voiceSamples + voice;
+			uint rendered = 0;
+
+			// The panning and the filter are applied later, so remember the
+			// values they have now
+			span.panning[0] = ch.panning;
+			span.ledFilter[0] = _filterState.ledFilter;
 
 			// NOTE: A Protracker (or other module format) player might actually
 			// push the offset past the sample length in its interrupt(), in which
-			// case the first mixBuffer() call should not mix anything, and the loop
+			// case the first renderVoice() call should not render anything, and the loop
 			// should be triggered.
 			// Thus, doing an assert(ch.offset.int_off < ch.length) here is wrong.
 			// An example where this happens is a certain Protracker module played
 			// by the OS/2 version of Hopkins FBI.
 
-			// Mix the generated samples into the output buffer
-			neededSamples -= mixBuffer<stereo>(p, ch.data, ch.offset, rate, neededSamples, ch.length, ch.volume, ch.panning, _filterState, voice);
+			// Render the samples of the voice
+			rendered += renderVoice(voice, p, rate, nSamples);
 
 			// Wrap around if necessary
 			if (ch.offset.int_off >= ch.length) {
@@ -251,12 +349,16 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 					interruptChannel(voice);
 			}
 
+			span.split = rendered;
+			span.panning[1] = ch.panning;
+			span.ledFilter[1] = _filterState.ledFilter;
+
 			// If we have not yet generated enough samples, and looping is active: loop!
-			if (neededSamples > 0 && ch.length > 2) {
+			if (rendered < nSamples && ch.length > 2) {
 				// Repeat as long as necessary.
-				while (neededSamples > 0) {
-					// Mix the generated samples into the output buffer
-					neededSamples -= mixBuffer<stereo>(p, ch.data, ch.offset, rate, neededSamples, ch.length, ch.volume, ch.panning, _filterState, voice);
+				while (rendered < nSamples) {
+					// Render the samples of the voice
+					rendered += renderVoice(voice, p + rendered * NUM_VOICES, rate, nSamples - rendered);
 
 					if (ch.offset.int_off >= ch.length) {
 						// Wrap around. See also the note above.
@@ -266,7 +368,34 @@ int Paula::readBufferIntern(int16 *buffer, const int numSamples) {
 				}
 			}
 
+			span.count = rendered;
+			if (_bandLimited && rendered < nSamples)
+				bandLimitResetVoice(voice);
+		}
+
+		if (_filterState.mode != kFilterModeNone)
+			_filterFunc(_filterState, voiceSamples, spans);
+
+		// Mix the voices into the output buffer
+		for (int voice = 0; voice < NUM_VOICES; voice++) {
+			const VoiceSpan &span = spans[voice];
+			const int32 *p = voiceSamples + voice;
+			int16 *buf = buffer;
+
+			for (int part = 0; part < 2; part++) {
+				const uint end = part ? span.count : span.split;
+				const int32 volL = 255 - span.panning[part], volR = span.panning[part];
+				for (uint i = part ? span.split : 0; i < end; i++, p += NUM_VOICES) {
+					const int32 tmp = *p;
+					if (stereo) {
+						*buf++ += (tmp * volL) >> 7;
+						*buf++ += (tmp * volR) >> 7;
+					} else
+						*buf++ += tmp;
+				}
+			}
 		}
+
 		buffer += stereo ? nSamples * 2 : nSamples;
 		_curInt -= nSamples;
 		samples -= nSamples;
@@ -280,6 +409,54 @@ void Paula::filterResetState() {
 			_filterState.rc[i][j] = 0.0f;
 }
 
+void Paula::setBandLimited(bool enable) {
+	Common::StackLock lock(_mutex);
+
+	if (enable && _blepTable.empty()) {
+		// Integrate a Blackman windowed sinc, cut off a bit below the Nyquist
+		// frequency, to get a band-limited step
+		const int kSubSteps = 16;
+		const int points = kBlepLength * kBlepPhases;
+		const double cutoff = 0.9;
+
+		Common::Array<double> integral;
+		integral.resize(points + 1);
+		integral[0] = 0;
+		double sum = 0;
+		for (int i = 0; i < points; i++) {
+			for (int k = 0; k < kSubSteps; k++) {
+				const double x = (i + (k + 0.5) / kSubSteps) / kBlepPhases - kBlepZeroCrossings;
+				const double window = 0.42 + 0.5 * cos(M_PI * x / kBlepZeroCrossings) + 0.08 * cos(2 * M_PI * x / kBlepZeroCrossings);
+				sum += cutoff * window * sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			}
+			integral[i + 1] = sum;
+		}
+
+		// Store the difference with a plain step, at the output sample
+		// positions following it, delayed by kBlepZeroCrossings samples
+		_blepTable.resize(points);
+		for (int phase = 0; phase < kBlepPhases; phase++)
+			for (int j = 0; j < kBlepLength; j++)
+				_blepTable[phase * kBlepLength + j] = (float)(integral[j * kBlepPhases + phase] / sum - 1.0);
+	}
+
+	_bandLimited = enable;
+	bandLimitResetState();
+}
+
+void Paula::bandLimitResetState() {
+	for (int i = 0; i < NUM_VOICES; i++)
+		bandLimitResetVoice(i);
+}
+
+void Paula::bandLimitResetVoice(int voice) {
+	BandLimitState &state = _bandLimit[voice];
+	state.value = 0;
+	state.pos = 0;
+	for (int i = 0; i < kBlepLength; i++)
+		state.residual[i] = 0;
+}
+
 /* Based on UAE.
  * Original comment in UAE:
  *
@@ -301,34 +478,3 @@ float Paula::filterCalculateA0(int rate, int cutoff) {
 }
 
 } // End of namespace Audio
-
-
-//	Plugin interface
-//	(This can only create a null driver since apple II gs support seeems not to be implemented
-//  and also is not part of the midi driver architecture. But we need the plugin for the options
-//  menu in the launcher and for MidiDriver::detectDevice() which is more or less used by all engines.)
-
-class AmigaMusicPlugin : public NullMusicPlugin {
-public:
-	const char *getName() const override {
-		return _s("Amiga Audio emulator");
-	}
-
-	const char *getId() const override {
-		return "amiga";
-	}
-
-	MusicDevices getDevices() const override;
-};
-
-MusicDevices AmigaMusicPlugin::getDevices() const {
-	MusicDevices devices;
-	devices.push_back(MusicDevice(this, "", MT_AMIGA));
-	return devices;
-}
-
-//#if PLUGIN_ENABLED_DYNAMIC(AMIGA)
-	//REGISTER_PLUGIN_DYNAMIC(AMIGA, PLUGIN_TYPE_MUSIC, AmigaMusicPlugin);
-//#else
-	REGISTER_PLUGIN_STATIC(AMIGA, PLUGIN_TYPE_MUSIC, AmigaMusicPlugin);
-//#endif
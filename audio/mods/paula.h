@@ -23,6 +23,7 @@
 #define AUDIO_MODS_PAULA_H
 
 #include "audio/audiostream.h"
+#include "common/array.h"
 #include "common/frac.h"
 #include "common/mutex.h"
 
@@ -94,10 +95,25 @@ public:
 	}
 	void clearVoice(byte voice);
 	void clearVoices() { for (int i = 0; i < NUM_VOICES; ++i) clearVoice(i); }
-	void startPlay() { filterResetState(); _playing = true; }
+	void startPlay() { filterResetState(); bandLimitResetState(); _playing = true; }
 	void stopPlay() { _playing = false; }
 	void pausePlay(bool pause) { _playing = !pause; }
 
+	/**
+	 * Enable or disable the band-limited rendering of the voices.
+	 *
+	 * By default, each output sample takes the value the voice has at that
+	 * time, like the Amiga does at its own much higher rate. This aliases
+	 * the high notes and the sharp edges of the samples. In band-limited
+	 * mode, the changes of the value of each voice are smoothed with band-
+	 * limited steps (BLEPs) instead, at the cost of some CPU time and a
+	 * delay of a few samples.
+	 *
+	 * It is enabled by default when the "amiga_band_limited" setting is on.
+	 */
+	void setBandLimited(bool enable);
+	bool isBandLimited() const { return _bandLimited; }
+
 // AudioStream API
 	int readBuffer(int16 *buffer, const int numSamples);
 	bool isStereo() const { return _stereo; }
@@ -220,6 +236,37 @@ protected:
 	}
 
 private:
+	enum {
+		/** Half the length, in output samples, of the band-limited steps. */
+		kBlepZeroCrossings = 8,
+		kBlepLength = 2 * kBlepZeroCrossings,
+		/** Number of fractional sample positions the steps are tabulated for. */
+		kBlepPhases = 32,
+		/** Maximum number of samples per voice rendered at once. */
+		kMaxBlockSize = 1024
+	};
+
+	/**
+	 * What readBufferIntern() rendered of a voice. The voice may loop in the
+	 * middle, and its interruptChannel() change its panning or the LED
+	 * filter, so these have a value before and after the split.
+	 */
+	struct VoiceSpan {
+		uint count;
+		uint split;
+		byte panning[2];
+		bool ledFilter[2];
+	};
+
+	/** Rendering state of a voice in band-limited mode. */
+	struct BandLimitState {
+		int32 value;
+		uint pos;
+		float residual[kBlepLength];
+	};
+
+	typedef void (*FilterFunc)(FilterState &state, int32 *samples, const VoiceSpan *spans);
+
 	Channel _voice[NUM_VOICES];
 
 	const bool _stereo;
@@ -231,12 +278,39 @@ private:
 	bool _playing;
 
 	FilterState _filterState;
+	FilterFunc _filterFunc;
+
+	/**
+	 * The rendered samples of the voices, interleaved, before filtering.
+	 * It has a fixed size, so that the audio thread never allocates.
+	 */
+	int32 _voiceSamples[kMaxBlockSize * NUM_VOICES];
+
+	bool _bandLimited;
+	BandLimitState _bandLimit[NUM_VOICES];
+	/** The band-limited steps minus a plain step, for each phase. */
+	Common::Array<float> _blepTable;
 
 	template<bool stereo>
 	int readBufferIntern(int16 *buffer, const int numSamples);
 
+	uint renderVoice(int voice, int32 *dst, frac_t rate, uint numSamples);
+	uint renderVoiceBandLimited(int voice, int32 *dst, frac_t rate, uint numSamples);
+
 	void filterResetState();
 	float filterCalculateA0(int rate, int cutoff);
+
+	void bandLimitResetState();
+	void bandLimitResetVoice(int voice);
+
+	/**
+	 * Apply the filter to the rendered samples of all voices. The SIMD
+	 * versions give the same results as the generic one.
+	 */
+	static void filterVoicesGeneric(FilterState &state, int32 *samples, const VoiceSpan *spans);
+#ifdef SCUMMVM_SSE2
+	static void filterVoicesSSE2(FilterState &state, int32 *samples, const VoiceSpan *spans);
+#endif
 };
 
 } // End of namespace Audio
@@ -5,13 +5,16 @@ MODULE_OBJS := \
 	adlib_ctmidi.o \
 	adlib_hmisos.o \
 	adlib_ms.o \
+	amiga_plugin.o \
 	audiostream.o \
 	casio.o \
 	chip.o \
 	cms.o \
+	decodeahead.o \
 	fmopl.o \
 	mac_plugin.o \
 	mididrv.o \
+	mididrv_base.o \
 	mididrv_ms.o \
 	midiparser_hmp.o \
 	midiparser_qt.o \
@@ -21,12 +24,15 @@ MODULE_OBJS := \
 	midiplayer.o \
 	miles_adlib.o \
 	miles_midi.o \
+	mixbus.o \
 	mixer.o \
 	mpu401.o \
 	mt32gm.o \
 	musicplugin.o \
 	null.o \
 	rate.o \
+	rate_sinc.o \
+	samplecache.o \
 	sid.o \
 	timestamp.o \
 	decoders/3do.o \
@@ -124,6 +130,19 @@ MODULE_OBJS += \
 	rwopl3.o
 endif
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	mixbus-neon.o \
+	rate_sinc-neon.o
+endif
+
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	mixbus-sse2.o \
+	mods/paula-sse2.o \
+	rate_sinc-sse2.o
+endif
+
 ifdef USE_VGMTRANS_AUDIO
 MODULE_OBJS += \
 	soundfont/rawfile.o \
@@ -29,6 +29,7 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_sinc.h"
 #include "audio/mixer.h"
 #include "common/util.h"
 
@@ -297,7 +298,10 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream
 	}
 }
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	if (quality != kRateConverterLinear && inRate != outRate)
+		return makeSincRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, quality);
+
 	if (inStereo) {
 		if (outStereo) {
 			if (reverseStereo)
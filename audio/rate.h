@@ -104,7 +104,28 @@ public:
 	virtual bool needsDraining() const = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo);
+/**
+ * Resampling algorithms which can be used by a RateConverter.
+ *
+ * The sinc tiers use a band-limited polyphase filter, which avoids the
+ * aliasing of the linear interpolation when low rate samples are played
+ * at a high output rate, but costs more CPU time. Their names give the
+ * number of filter taps per channel and output sample when upsampling.
+ */
+enum RateConverterQuality {
+	kRateConverterLinear,		///< Linear interpolation, the cheapest one
+	kRateConverterSincLow,		///< Windowed sinc with 8 taps
+	kRateConverterSincMedium,	///< Windowed sinc with 16 taps
+	kRateConverterSincHigh		///< Windowed sinc with 32 taps
+};
+
+/**
+ * Create a RateConverter for the given rates and channel layout.
+ *
+ * When both rates are the same, samples are copied as they are, whatever
+ * the quality is.
+ */
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality = kRateConverterLinear);
 
 /** @} */
 } // End of namespace Audio
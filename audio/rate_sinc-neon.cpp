@@ -0,0 +1,69 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/rate_sinc.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Audio {
+
+int32 PolyphaseFilter::dotProductNEON(const int16 *samples, const int16 *coeffs, uint numTaps) {
+	int32x4_t sum = vdupq_n_s32(0);
+
+	for (uint i = 0; i < numTaps; i += 8) {
+		const int16x8_t s = vld1q_s16(samples + i);
+		const int16x8_t c = vld1q_s16(coeffs + i);
+		sum = vmlal_s16(sum, vget_low_s16(s), vget_low_s16(c));
+		sum = vmlal_s16(sum, vget_high_s16(s), vget_high_s16(c));
+	}
+
+	const int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	return vget_lane_s32(vpadd_s32(half, half), 0);
+}
+
+} // End of namespace Audio
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,70 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_sinc.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+int32 PolyphaseFilter::dotProductSSE2(const int16 *samples, const int16 *coeffs, uint numTaps) {
+	// Two accumulators, to not wait on the previous addition
+	__m128i sum0 = _mm_setzero_si128();
+	__m128i sum1 = _mm_setzero_si128();
+
+	uint i = 0;
+	for (; i + 16 <= numTaps; i += 16) {
+		sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), _mm_loadu_si128((const __m128i *)(coeffs + i))));
+		sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(samples + i + 8)), _mm_loadu_si128((const __m128i *)(coeffs + i + 8))));
+	}
+	if (i < numTaps)
+		sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), _mm_loadu_si128((const __m128i *)(coeffs + i))));
+
+	__m128i sum = _mm_add_epi32(sum0, sum1);
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
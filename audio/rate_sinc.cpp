@@ -0,0 +1,351 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate_sinc.h"
+#include "common/cpu.h"
+
+namespace Audio {
+
+namespace {
+
+struct SincQuality {
+	/** Number of taps when upsampling. */
+	uint numTaps;
+	/** log2 of the number of phases. */
+	uint phaseBits;
+	/** Cutoff frequency, relative to the Nyquist frequency. */
+	double rolloff;
+	/** Kaiser window parameter, larger values trade steepness for stopband attenuation. */
+	double beta;
+};
+
+const SincQuality sincQualities[] = {
+	{  8, 7, 0.80, 4.0 },	// kRateConverterSincLow
+	{ 16, 8, 0.87, 6.0 },	// kRateConverterSincMedium
+	{ 32, 9, 0.92, 8.5 }	// kRateConverterSincHigh
+};
+
+/** Modified Bessel function of the first kind, for the Kaiser window. */
+double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; term > sum * 1e-12; k++) {
+		term *= (x * x) / (4.0 * k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+PolyphaseFilter::DotProductFunc selectDotProduct() {
+#ifdef SCUMMVM_SSE2
+	if (Common::hasSSE2())
+		return PolyphaseFilter::dotProductSSE2;
+#endif
+#ifdef SCUMMVM_NEON
+	if (Common::hasNEON())
+		return PolyphaseFilter::dotProductNEON;
+#endif
+	return PolyphaseFilter::dotProductGeneric;
+}
+
+} // End of anonymous namespace
+
+PolyphaseFilter::PolyphaseFilter(RateConverterQuality quality) : _numTaps(0), _ratio(0.0) {
+	assert(quality >= kRateConverterSincLow && quality <= kRateConverterSincHigh);
+
+	const SincQuality &params = sincQualities[quality - kRateConverterSincLow];
+	_baseTaps = params.numTaps;
+	_phaseBits = params.phaseBits;
+	_rolloff = params.rolloff;
+	_beta = params.beta;
+
+	_dotProduct = selectDotProduct();
+}
+
+void PolyphaseFilter::setRates(st_rate_t inRate, st_rate_t outRate) {
+	const double ratio = (inRate > outRate) ? (double)outRate / inRate : 1.0;
+	const uint numTaps = MIN<uint>(((uint)ceil(_baseTaps / ratio) + 7) & ~7, kMaxTaps);
+
+	// Small rate changes, as done for pitch effects, are not worth the cost
+	// of recomputing the table
+	if (numTaps == _numTaps && fabs(ratio - _ratio) <= _ratio / 64)
+		return;
+
+	_numTaps = numTaps;
+	_ratio = ratio;
+	buildCoeffs();
+}
+
+void PolyphaseFilter::buildCoeffs() {
+	const uint numPhases = getNumPhases();
+	const double cutoff = _rolloff * _ratio;
+	const double halfWidth = _numTaps / 2.0;
+	const double windowScale = 1.0 / besselI0(_beta);
+	double row[kMaxTaps];
+
+	_coeffs.resize(numPhases * _numTaps);
+
+	for (uint phase = 0; phase < numPhases; phase++) {
+		const double frac = (double)phase / numPhases;
+		double sum = 0.0;
+		uint peak = 0;
+
+		for (uint tap = 0; tap < _numTaps; tap++) {
+			// Distance from the output sample, in input samples
+			const double x = tap - (halfWidth - 1.0) - frac;
+			const double u = x / halfWidth;
+			const double window = besselI0(_beta * sqrt(MAX(0.0, 1.0 - u * u))) * windowScale;
+			const double sinc = (x == 0.0) ? cutoff : sin(M_PI * cutoff * x) / (M_PI * x);
+
+			row[tap] = sinc * window;
+			sum += row[tap];
+			if (row[tap] > row[peak])
+				peak = tap;
+		}
+
+		// Normalize the rounded coefficients, so that DC keeps its level
+		int16 *coeffs = &_coeffs[phase * _numTaps];
+		int total = 0;
+		for (uint tap = 0; tap < _numTaps; tap++) {
+			coeffs[tap] = (int16)round(row[tap] * (1 << kCoeffBits) / sum);
+			total += coeffs[tap];
+		}
+		coeffs[peak] += (1 << kCoeffBits) - total;
+	}
+}
+
+int32 PolyphaseFilter::dotProductGeneric(const int16 *samples, const int16 *coeffs, uint numTaps) {
+	int32 sum = 0;
+	for (uint i = 0; i < numTaps; i++)
+		sum += samples[i] * coeffs[i];
+	return sum;
+}
+
+/**
+ * A RateConverter which runs the input through a PolyphaseFilter.
+ *
+ * The input is kept deinterleaved in a history buffer, so that the filter
+ * can read each channel as one contiguous block. The filter window starts
+ * at _pos, and the output sample is located _frac after its middle.
+ */
+template<bool inStereo, bool outStereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+private:
+	enum {
+		kChannels = inStereo ? 2 : 1,
+		/** Number of sample frames read from the input at once. */
+		kChunkSize = 512,
+		kHistorySize = PolyphaseFilter::kMaxTaps + kChunkSize
+	};
+
+	/** Input and output rates */
+	st_rate_t _inRate, _outRate;
+	bool _ratesChanged;
+
+	PolyphaseFilter _filter;
+
+	/** Distance between output samples, in input samples */
+	uint32 _stepInt, _stepFrac;
+
+	/** Position of the filter window in the history */
+	uint _pos;
+	uint32 _frac;
+
+	/** Number of sample frames in the history */
+	uint _historySize;
+
+	/** Whether the end of the stream was padded to let the last samples through */
+	bool _flushed;
+
+	st_sample_t _history[kChannels][kHistorySize];
+	st_sample_t _readBuffer[kChunkSize * kChannels];
+
+	void updateRates();
+	bool fillHistory(AudioStream &input);
+
+public:
+	SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, RateConverterQuality quality);
+
+	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override;
+
+	void setInputRate(st_rate_t inputRate) override { _inRate = inputRate; _ratesChanged = true; }
+	void setOutputRate(st_rate_t outputRate) override { _outRate = outputRate; _ratesChanged = true; }
+
+	st_rate_t getInputRate() const override { return _inRate; }
+	st_rate_t getOutputRate() const override { return _outRate; }
+
+	bool needsDraining() const override {
+		// Until the end is padded, any sample from the middle of the window
+		// onwards has not been output yet
+		return _pos + _filter.getNumTaps() / (_flushed ? 1 : 2) <= _historySize;
+	}
+};
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincRateConverter<inStereo, outStereo, reverseStereo>::SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, RateConverterQuality quality) :
+	_inRate(inputRate),
+	_outRate(outputRate),
+	_ratesChanged(true),
+	_filter(quality),
+	_stepInt(1),
+	_stepFrac(0),
+	_pos(0),
+	_frac(0),
+	_historySize(0),
+	_flushed(false) {
+	updateRates();
+
+	// Start with silence before the first sample, so that the first output
+	// sample is centered on it
+	_historySize = _filter.getNumTaps() / 2 - 1;
+	for (uint channel = 0; channel < kChannels; channel++)
+		memset(_history[channel], 0, _historySize * sizeof(st_sample_t));
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+void SincRateConverter<inStereo, outStereo, reverseStereo>::updateRates() {
+	const uint oldTaps = _filter.getNumTaps();
+	_filter.setRates(_inRate, _outRate);
+
+	const uint64 step = ((uint64)_inRate << 32) / _outRate;
+	_stepInt = (uint32)(step >> 32);
+	_stepFrac = (uint32)step;
+
+	// Keep the window centered on the same sample when its size changes. When
+	// it grows at the very start of the history, a few samples are skipped.
+	const uint numTaps = _filter.getNumTaps();
+	if (oldTaps && numTaps > oldTaps)
+		_pos -= MIN(_pos, (numTaps - oldTaps) / 2);
+	else if (oldTaps)
+		_pos += (oldTaps - numTaps) / 2;
+
+	_ratesChanged = false;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+bool SincRateConverter<inStereo, outStereo, reverseStereo>::fillHistory(AudioStream &input) {
+	// Drop the samples which are behind the window
+	const uint drop = MIN(_pos, _historySize);
+	if (drop) {
+		for (uint channel = 0; channel < kChannels; channel++)
+			memmove(_history[channel], _history[channel] + drop, (_historySize - drop) * sizeof(st_sample_t));
+		_historySize -= drop;
+		_pos -= drop;
+	}
+
+	const uint space = MIN<uint>(kHistorySize - _historySize, kChunkSize);
+	const int numRead = input.readBuffer(_readBuffer, space * kChannels);
+
+	if (numRead <= 0) {
+		if (_flushed || !input.endOfStream())
+			return false;
+
+		// Push the last samples through the window with some silence
+		const uint padding = _filter.getNumTaps() / 2;
+		for (uint channel = 0; channel < kChannels; channel++)
+			memset(_history[channel] + _historySize, 0, padding * sizeof(st_sample_t));
+		_historySize += padding;
+		_flushed = true;
+		return true;
+	}
+
+	const uint numFrames = numRead / kChannels;
+	for (uint i = 0; i < numFrames; i++) {
+		_history[0][_historySize + i] = _readBuffer[i * kChannels];
+		if (inStereo)
+			_history[kChannels - 1][_historySize + i] = _readBuffer[i * kChannels + 1];
+	}
+	_historySize += numFrames;
+	_flushed = false;
+	return true;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+int SincRateConverter<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	assert(input.isStereo() == inStereo);
+
+	if (_ratesChanged)
+		updateRates();
+
+	st_sample_t *outStart, *outEnd;
+	outStart = outBuffer;
+	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
+
+	const uint numTaps = _filter.getNumTaps();
+
+	while (outBuffer < outEnd) {
+		if (_pos + numTaps > _historySize) {
+			if (!fillHistory(input))
+				break;
+			continue;
+		}
+
+		st_sample_t inL, inR;
+		inL = _filter.apply(_history[0] + _pos, _frac);
+		inR = (inStereo ? _filter.apply(_history[kChannels - 1] + _pos, _frac) : inL);
+
+		st_sample_t outL, outR;
+		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
+		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+
+		if (outStereo) {
+			// Output left channel
+			clampedAdd(outBuffer[reverseStereo    ], outL);
+
+			// Output right channel
+			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+
+			outBuffer += 2;
+		} else {
+			// Output mono channel
+			clampedAdd(outBuffer[0], (outL + outR) / 2);
+
+			outBuffer += 1;
+		}
+
+		// Increment output position
+		const uint32 frac = _frac + _stepFrac;
+		_pos += _stepInt + (frac < _frac ? 1 : 0);
+		_frac = frac;
+	}
+
+	return (outBuffer - outStart) / (outStereo ? 2 : 1);
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	if (inStereo) {
+		if (outStereo) {
+			if (reverseStereo)
+				return new SincRateConverter<true, true, true>(inRate, outRate, quality);
+			else
+				return new SincRateConverter<true, true, false>(inRate, outRate, quality);
+		} else
+			return new SincRateConverter<true, false, false>(inRate, outRate, quality);
+	} else {
+		if (outStereo) {
+			return new SincRateConverter<false, true, false>(inRate, outRate, quality);
+		} else
+			return new SincRateConverter<false, false, false>(inRate, outRate, quality);
+	}
+}
+
+} // End of namespace Audio
@@ -0,0 +1,127 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_RATE_SINC_H
+#define AUDIO_RATE_SINC_H
+
+#include "audio/rate.h"
+#include "common/array.h"
+#include "common/util.h"
+
+namespace Audio {
+
+/**
+ * @defgroup audio_rate_sinc Polyphase resampling
+ * @ingroup audio_rate
+ *
+ * @brief Band-limited resampling filter used by the sinc rate converters.
+ * @{
+ */
+
+/**
+ * A Kaiser windowed sinc low-pass filter, precomputed for a number of
+ * fractional positions (phases) between two input samples.
+ *
+ * Each phase is a row of getNumTaps() 16-bit coefficients, with
+ * kCoeffBits bits of precision, which add up to exactly 1.0 so that DC
+ * goes through unchanged. The number of taps is a multiple of 8, which is
+ * what the SIMD versions of the dot product expect.
+ *
+ * When downsampling, the cutoff frequency is lowered to the output Nyquist
+ * frequency, and the filter gets wider to keep the same steepness, up to
+ * kMaxTaps taps.
+ */
+class PolyphaseFilter {
+public:
+	enum {
+		/** Bits of precision of the coefficients. */
+		kCoeffBits = 14,
+		/** Largest number of taps of a filter. */
+		kMaxTaps = 128
+	};
+
+	typedef int32 (*DotProductFunc)(const int16 *samples, const int16 *coeffs, uint numTaps);
+
+	explicit PolyphaseFilter(RateConverterQuality quality);
+
+	/**
+	 * Rebuild the coefficients for the given rates, unless the current
+	 * ones are close enough.
+	 */
+	void setRates(st_rate_t inRate, st_rate_t outRate);
+
+	uint getNumTaps() const { return _numTaps; }
+	uint getNumPhases() const { return 1 << _phaseBits; }
+
+	/**
+	 * Coefficients for an output sample between two input samples.
+	 *
+	 * @param frac  Fractional part of the output position, in units of
+	 *              1/2^32 input samples.
+	 */
+	const int16 *getCoeffs(uint32 frac) const {
+		return &_coeffs[(frac >> (32 - _phaseBits)) * _numTaps];
+	}
+
+	/**
+	 * Filter getNumTaps() input samples starting at @p samples. The output
+	 * sample is located between samples[getNumTaps() / 2 - 1] and the next
+	 * one, at @p frac.
+	 */
+	int16 apply(const int16 *samples, uint32 frac) const {
+		const int32 sum = (_dotProduct(samples, getCoeffs(frac), _numTaps) + (1 << (kCoeffBits - 1))) >> kCoeffBits;
+		return (int16)CLIP<int32>(sum, -32768, 32767);
+	}
+
+	/** Generic version of the dot product used by apply(). */
+	static int32 dotProductGeneric(const int16 *samples, const int16 *coeffs, uint numTaps);
+#ifdef SCUMMVM_SSE2
+	static int32 dotProductSSE2(const int16 *samples, const int16 *coeffs, uint numTaps);
+#endif
+#ifdef SCUMMVM_NEON
+	static int32 dotProductNEON(const int16 *samples, const int16 *coeffs, uint numTaps);
+#endif
+
+private:
+	void buildCoeffs();
+
+	uint _baseTaps;
+	uint _phaseBits;
+	double _rolloff;
+	double _beta;
+
+	uint _numTaps;
+	double _ratio;
+	Common::Array<int16> _coeffs;
+	DotProductFunc _dotProduct;
+};
+
+/**
+ * Create a RateConverter which uses a PolyphaseFilter of the given
+ * quality. Used by makeRateConverter().
+ */
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality);
+
+/** @} */
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,201 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "audio/samplecache.h"
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+#include "common/atomic.h"
+#include "common/memstream.h"
+
+namespace Audio {
+
+/**
+ * Decoded samples of a sound. They are shared by the cache and the streams
+ * reading them, which can be used by the mixer thread, hence the atomic
+ * reference count.
+ */
+struct SampleCache::Buffer {
+	Common::Atomic<int> refCount;
+	int16 *samples;
+	uint32 size;
+	int rate;
+	bool stereo;
+
+	Buffer() : refCount(1), samples(nullptr), size(0), rate(0), stereo(false) {}
+	~Buffer() { free(samples); }
+
+	void ref() { refCount++; }
+	void unref() {
+		if (--refCount == 0)
+			delete this;
+	}
+};
+
+/** A memory stream which keeps its buffer alive. */
+class SampleCache::BufferStream : public Common::MemoryReadStream {
+public:
+	BufferStream(Buffer *buffer) : Common::MemoryReadStream((const byte *)buffer->samples, buffer->size), _buffer(buffer) {
+		_buffer->ref();
+	}
+
+	~BufferStream() override {
+		_buffer->unref();
+	}
+
+private:
+	Buffer *_buffer;
+};
+
+namespace {
+
+enum {
+	kDecodeChunkSize = 4096
+};
+
+} // End of anonymous namespace
+
+SampleCache::SampleCache(uint32 maxSize) : _maxSize(maxSize), _size(0) {
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+SampleCache::~SampleCache() {
+	clear();
+}
+
+SeekableAudioStream *SampleCache::makeStream(Buffer *buffer) {
+	byte flags = FLAG_16BITS;
+#ifdef SCUMM_LITTLE_ENDIAN
+	flags |= FLAG_LITTLE_ENDIAN;
+#endif
+	if (buffer->stereo)
+		flags |= FLAG_STEREO;
+
+	return makeRawStream(new BufferStream(buffer), buffer->rate, flags, DisposeAfterUse::YES);
+}
+
+SeekableAudioStream *SampleCache::get(const Common::Path &member, uint32 offset) {
+	EntryMap::iterator it = _map.find(Key(member, offset));
+	if (it == _map.end()) {
+		_stats.misses++;
+		return nullptr;
+	}
+
+	_stats.hits++;
+
+	// Move the sound to the front of the list
+	const Entry entry = *it->_value;
+	_entries.erase(it->_value);
+	_entries.push_front(entry);
+	it->_value = _entries.begin();
+
+	return makeStream(entry.buffer);
+}
+
+SeekableAudioStream *SampleCache::add(const Common::Path &member, uint32 offset, SeekableAudioStream *stream) {
+	assert(stream);
+
+	const uint32 maxEntrySize = _maxSize / 4;
+	const uint channels = stream->isStereo() ? 2 : 1;
+	const uint64 expectedSize = (uint64)stream->getLength().convertToFramerate(stream->getRate()).totalNumberOfFrames() * channels * sizeof(int16);
+	if (expectedSize > maxEntrySize)
+		return stream;
+
+	Buffer *buffer = new Buffer();
+	buffer->rate = stream->getRate();
+	buffer->stereo = stream->isStereo();
+
+	// The length is only a hint, some streams do not know it
+	uint32 capacity = (uint32)expectedSize / sizeof(int16) + kDecodeChunkSize;
+	uint32 numSamples = 0;
+	buffer->samples = (int16 *)malloc(capacity * sizeof(int16));
+
+	while (!stream->endOfData()) {
+		if (capacity - numSamples < kDecodeChunkSize) {
+			capacity *= 2;
+			buffer->samples = (int16 *)realloc(buffer->samples, capacity * sizeof(int16));
+		}
+
+		const int read = stream->readBuffer(buffer->samples + numSamples, kDecodeChunkSize);
+		if (read <= 0)
+			break;
+		numSamples += read;
+
+		if (numSamples * sizeof(int16) > maxEntrySize) {
+			// The length was wrong, play the sound from the stream instead
+			buffer->unref();
+			stream->rewind();
+			return stream;
+		}
+	}
+
+	delete stream;
+
+	buffer->size = numSamples * sizeof(int16);
+	if (numSamples < capacity)
+		buffer->samples = (int16 *)realloc(buffer->samples, MAX<uint32>(buffer->size, 1));
+
+	remove(member, offset);
+	makeRoom(buffer->size);
+
+	const Key key(member, offset);
+	_entries.push_front(Entry(key, buffer));
+	_map[key] = _entries.begin();
+	_size += buffer->size;
+
+	return makeStream(buffer);
+}
+
+void SampleCache::remove(const Common::Path &member, uint32 offset) {
+	EntryMap::iterator it = _map.find(Key(member, offset));
+	if (it != _map.end())
+		removeEntry(it->_value);
+}
+
+void SampleCache::clear() {
+	while (!_entries.empty())
+		removeEntry(_entries.begin());
+}
+
+void SampleCache::setMaxSize(uint32 maxSize) {
+	_maxSize = maxSize;
+	makeRoom(0);
+}
+
+void SampleCache::makeRoom(uint32 size) {
+	while (!_entries.empty() && _size + size > _maxSize) {
+		EntryList::iterator last = _entries.end();
+		--last;
+		removeEntry(last);
+		_stats.evictions++;
+	}
+}
+
+void SampleCache::removeEntry(EntryList::iterator entry) {
+	_size -= entry->buffer->size;
+	_map.erase(entry->key);
+	entry->buffer->unref();
+	_entries.erase(entry);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,165 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef AUDIO_SAMPLECACHE_H
+#define AUDIO_SAMPLECACHE_H
+
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/noncopyable.h"
+#include "common/path.h"
+
+namespace Audio {
+
+/**
+ * @defgroup audio_samplecache Sample cache
+ * @ingroup audio
+ *
+ * @brief Cache of decoded sounds, for sound effects played over and over.
+ * @{
+ */
+
+class SeekableAudioStream;
+
+/**
+ * A size-bounded cache of decoded sounds.
+ *
+ * Sounds are identified by the archive member they are read from and their
+ * offset in it. The first time a sound is played, add() decodes all of it
+ * to 16-bit PCM samples. Afterwards, get() returns new streams reading these
+ * samples, which costs a small allocation instead of opening and decoding
+ * the resource again.
+ *
+ * When the cache is full, the least recently used sounds are dropped. The
+ * streams returned by the cache keep the samples they read alive, so they
+ * can still be playing when their sound is dropped, or when the cache is
+ * deleted.
+ *
+ * The cache itself is not thread-safe, and should be used by the engine
+ * thread only. The streams it returns can be played by the mixer as usual.
+ */
+class SampleCache : Common::NonCopyable {
+public:
+	enum {
+		/** Default size of the cache, in bytes. */
+		kDefaultMaxSize = 4 * 1024 * 1024
+	};
+
+	/**
+	 * Create a cache holding up to @p maxSize bytes of samples. A single
+	 * sound can use at most a quarter of it, so that playing a long sound
+	 * does not evict all the short ones.
+	 */
+	explicit SampleCache(uint32 maxSize = kDefaultMaxSize);
+	~SampleCache();
+
+	/**
+	 * Look up a sound.
+	 *
+	 * @return A new stream with the samples of the sound, or nullptr if it
+	 *         is not in the cache.
+	 */
+	SeekableAudioStream *get(const Common::Path &member, uint32 offset);
+
+	/**
+	 * Decode @p stream and add it to the cache. The stream should be at its
+	 * start, and is deleted.
+	 *
+	 * Sounds too large for the cache are not kept, and @p stream itself is
+	 * returned instead, rewound.
+	 *
+	 * @return A stream with the samples of @p stream.
+	 */
+	SeekableAudioStream *add(const Common::Path &member, uint32 offset, SeekableAudioStream *stream);
+
+	/** Drop a sound from the cache, if it is there. */
+	void remove(const Common::Path &member, uint32 offset);
+
+	/** Drop all the sounds. */
+	void clear();
+
+	/** Change the maximum size of the cache, dropping sounds if needed. */
+	void setMaxSize(uint32 maxSize);
+	uint32 getMaxSize() const { return _maxSize; }
+
+	/** Return the number of bytes of samples held by the cache. */
+	uint32 getSize() const { return _size; }
+
+	struct Stats {
+		/** Number of calls to get() which found their sound. */
+		uint hits;
+		/** Number of calls to get() which did not. */
+		uint misses;
+		/** Number of sounds dropped to make room for others. */
+		uint evictions;
+	};
+
+	const Stats &getStats() const { return _stats; }
+
+private:
+	struct Buffer;
+	class BufferStream;
+
+	struct Key {
+		Common::Path member;
+		uint32 offset;
+
+		Key(const Common::Path &m, uint32 o) : member(m), offset(o) {}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const { return key.member.hashIgnoreCase() ^ (key.offset * 2654435761u); }
+	};
+
+	struct KeyEqualTo {
+		bool operator()(const Key &x, const Key &y) const { return x.offset == y.offset && x.member.equalsIgnoreCase(y.member); }
+	};
+
+	struct Entry {
+		Key key;
+		Buffer *buffer;
+
+		Entry(const Key &k, Buffer *b) : key(k), buffer(b) {}
+	};
+
+	typedef Common::List<Entry> EntryList;
+	typedef Common::HashMap<Key, EntryList::iterator, KeyHash, KeyEqualTo> EntryMap;
+
+	/** Create a stream reading @p buffer. */
+	static SeekableAudioStream *makeStream(Buffer *buffer);
+	/** Drop the least recently used sounds until @p size more bytes fit. */
+	void makeRoom(uint32 size);
+	void removeEntry(EntryList::iterator entry);
+
+	/** Most recently used sounds first. */
+	EntryList _entries;
+	EntryMap _map;
+	uint32 _maxSize;
+	uint32 _size;
+	Stats _stats;
+};
+
+/** @} */
+
+} // End of namespace Audio
+
+#endif
@@ -43,6 +43,7 @@
 #include "common/osd_message_queue.h"
 #include "common/memstream.h"
 #include "common/rect.h"
+#include "common/ringbuffer.h"
 
 #include "image/bmp.h"
 
@@ -237,6 +238,16 @@ private:
 	byte *_controlData, *_pcmData;
 	Common::Mutex _mutex;
 
+	/**
+	 * Short messages sent since the last call to generateSamples(). This
+	 * spares send() from waiting for the rendering to finish, and the
+	 * messages are played right before rendering the next samples.
+	 */
+	Common::MPSCRingBuffer<uint32> _pendingMessages;
+
+	/** Play all pending short messages. Must be called with _mutex held. */
+	void flushPendingMessages();
+
 	int _outputRate;
 
 protected:
@@ -267,7 +278,7 @@ public:
 //
 ////////////////////////////////////////
 
-MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixer) {
+MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixer), _pendingMessages(1024) {
 	_channelMask = 0xFFFF; // Permit all 16 channels by default
 	uint i;
 	for (i = 0; i < ARRAYSIZE(_midiChannels); ++i) {
@@ -341,6 +352,11 @@ int MidiDriver_MT32::open() {
 
 	MidiDriver_Emulated::open();
 
+	// Drop messages sent while the synth was closed, like playMsg() did
+	uint32 msg;
+	while (_pendingMessages.pop(msg))
+		;
+
 	_mixer->playStream(Audio::Mixer::kPlainSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 
 	return 0;
@@ -349,10 +365,21 @@ int MidiDriver_MT32::open() {
 void MidiDriver_MT32::send(uint32 b) {
 	midiDriverCommonSend(b);
 
+	if (_pendingMessages.push(b))
+		return;
+
+	// The queue is full, play the message right away
 	Common::StackLock lock(_mutex);
+	flushPendingMessages();
 	_service.playMsg(b);
 }
 
+void MidiDriver_MT32::flushPendingMessages() {
+	uint32 msg;
+	while (_pendingMessages.pop(msg))
+		_service.playMsg(msg);
+}
+
 // Indiana Jones and the Fate of Atlantis (including the demo) uses
 // setPitchBendRange, if you need a game for testing purposes
 void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
@@ -361,6 +388,7 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 	}
 	byte benderRangeSysex[4] = { 0, 0, 4, (uint8)range };
 	Common::StackLock lock(_mutex);
+	flushPendingMessages();
 	_service.writeSysex(channel, benderRangeSysex, 4);
 }
 
@@ -368,6 +396,7 @@ void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
 	midiDriverCommonSysEx(msg, length);
 	if (msg[0] == 0xf0) {
 		Common::StackLock lock(_mutex);
+		flushPendingMessages();
 		_service.playSysex(msg, length);
 	} else {
 		enum {
@@ -377,6 +406,7 @@ void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
 
 		if (msg[3] == SYSEX_CMD_DT1 || msg[3] == SYSEX_CMD_DAT) {
 			Common::StackLock lock(_mutex);
+			flushPendingMessages();
 			_service.writeSysex(msg[1], msg + 4, length - 5);
 		} else {
 			warning("Unused sysEx command %d", msg[3]);
@@ -405,6 +435,7 @@ void MidiDriver_MT32::close() {
 
 void MidiDriver_MT32::generateSamples(int16 *data, int len) {
 	Common::StackLock lock(_mutex);
+	flushPendingMessages();
 	_service.renderBit16s(data, len);
 }
 
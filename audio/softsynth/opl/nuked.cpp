@@ -1103,9 +1103,53 @@ static int16_t OPL3_ClipSample(int32_t sample)
     return (int16_t)sample;
 }
 
+/*
+    A released slot with its envelope fully off stays that way until it is
+    keyed on again. OPL3_EnvelopeCalc then only updates the output level,
+    which is too low for any waveform to give more than the sign bit, so
+    the slot outputs 0 or -1.
+*/
+static inline uint8_t OPL3_EnvelopeIsOff(const opl3_slot *slot)
+{
+    return !slot->key && slot->eg_gen == envelope_gen_num_release && slot->eg_rout == 0x1ff;
+}
+
+static void OPL3_ProcessSlotOff(opl3_slot *slot)
+{
+    uint16_t phase;
+    uint16_t neg;
+
+    slot->eg_out = 0x1ff + (slot->reg_tl << 2)
+                 + (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
+    slot->pg_reset = 0;
+    OPL3_PhaseGenerate(slot);
+
+    phase = (slot->pg_phase_out + *slot->mod) & 0x3ff;
+    switch (slot->reg_wf)
+    {
+    case 0:
+    case 6:
+    case 7:
+        neg = (phase & 0x200) ? 0xffff : 0;
+        break;
+    case 4:
+        neg = ((phase & 0x300) == 0x100) ? 0xffff : 0;
+        break;
+    default:
+        neg = 0;
+        break;
+    }
+    slot->out = (int16_t)neg;
+}
+
 static void OPL3_ProcessSlot(opl3_slot *slot)
 {
     OPL3_SlotCalcFB(slot);
+    if (OPL3_EnvelopeIsOff(slot))
+    {
+        OPL3_ProcessSlotOff(slot);
+        return;
+    }
     OPL3_EnvelopeCalc(slot);
     OPL3_PhaseGenerate(slot);
     OPL3_SlotGenerate(slot);
@@ -1504,31 +1548,122 @@ void OPL3_WriteRegBuffered(opl3_chip *chip, uint16_t reg, uint8_t v)
     chip->writebuf_last = (writebuf_last + 1) % OPL_WRITEBUF_SIZE;
 }
 
+/*
+    The streams render the samples at the chip rate in blocks, and resample
+    them afterwards, giving the same output as OPL3_Generate4ChResampled.
+*/
+#define OPL_BLOCK_SIZE 256
+
+static void OPL3_Generate4ChBlock(opl3_chip *chip, int16_t *buf4, uint32_t numsamples)
+{
+    uint_fast32_t i;
+
+    for (i = 0; i < numsamples; i++)
+    {
+        OPL3_Generate4Ch(chip, buf4);
+        buf4 += 4;
+    }
+}
+
+static uint32_t OPL3_Generate4ChResampledBlock(opl3_chip *chip, int16_t *buf4, uint32_t numsamples)
+{
+    int16_t block[OPL_BLOCK_SIZE * 4];
+    const int16_t *next;
+    int32_t samplecnt;
+    uint32_t count, needed, total;
+    uint_fast32_t i;
+
+    /* Find how many output samples the chip samples of one block give */
+    samplecnt = chip->samplecnt;
+    total = 0;
+    for (count = 0; count < numsamples; count++)
+    {
+        needed = 0;
+        while (samplecnt >= chip->rateratio)
+        {
+            samplecnt -= chip->rateratio;
+            needed++;
+        }
+        if (total + needed > OPL_BLOCK_SIZE)
+        {
+            break;
+        }
+        total += needed;
+        samplecnt += 1 << RSM_FRAC;
+    }
+
+    if (count == 0)
+    {
+        /* Very low output rates need more than a block per sample */
+        OPL3_Generate4ChResampled(chip, buf4);
+        return 1;
+    }
+
+    OPL3_Generate4ChBlock(chip, block, total);
+
+    next = block;
+    for (i = 0; i < count; i++)
+    {
+        while (chip->samplecnt >= chip->rateratio)
+        {
+            memcpy(chip->oldsamples, chip->samples, sizeof(chip->samples));
+            memcpy(chip->samples, next, sizeof(chip->samples));
+            next += 4;
+            chip->samplecnt -= chip->rateratio;
+        }
+        buf4[0] = (int16_t)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+        buf4[1] = (int16_t)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+        buf4[2] = (int16_t)((chip->oldsamples[2] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[2] * chip->samplecnt) / chip->rateratio);
+        buf4[3] = (int16_t)((chip->oldsamples[3] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[3] * chip->samplecnt) / chip->rateratio);
+        chip->samplecnt += 1 << RSM_FRAC;
+        buf4 += 4;
+    }
+
+    return count;
+}
+
 void OPL3_Generate4ChStream(opl3_chip *chip, int16_t *sndptr1, int16_t *sndptr2, uint32_t numsamples)
 {
+    int16_t samples[OPL_BLOCK_SIZE * 4];
+    uint32_t count;
     uint_fast32_t i;
-    int16_t samples[4];
 
-    for(i = 0; i < numsamples; i++)
+    while (numsamples > 0)
     {
-        OPL3_Generate4ChResampled(chip, samples);
-        sndptr1[0] = samples[0];
-        sndptr1[1] = samples[1];
-        sndptr2[0] = samples[2];
-        sndptr2[1] = samples[3];
-        sndptr1 += 2;
-        sndptr2 += 2;
+        count = OPL3_Generate4ChResampledBlock(chip, samples, MIN<uint32_t>(numsamples, OPL_BLOCK_SIZE));
+        for (i = 0; i < count; i++)
+        {
+            sndptr1[0] = samples[i * 4];
+            sndptr1[1] = samples[i * 4 + 1];
+            sndptr2[0] = samples[i * 4 + 2];
+            sndptr2[1] = samples[i * 4 + 3];
+            sndptr1 += 2;
+            sndptr2 += 2;
+        }
+        numsamples -= count;
     }
 }
 
 void OPL3_GenerateStream(opl3_chip *chip, int16_t *sndptr, uint32_t numsamples)
 {
+    int16_t samples[OPL_BLOCK_SIZE * 4];
+    uint32_t count;
     uint_fast32_t i;
 
-    for(i = 0; i < numsamples; i++)
+    while (numsamples > 0)
     {
-        OPL3_GenerateResampled(chip, sndptr);
-        sndptr += 2;
+        count = OPL3_Generate4ChResampledBlock(chip, samples, MIN<uint32_t>(numsamples, OPL_BLOCK_SIZE));
+        for (i = 0; i < count; i++)
+        {
+            sndptr[0] = samples[i * 4];
+            sndptr[1] = samples[i * 4 + 1];
+            sndptr += 2;
+        }
+        numsamples -= count;
     }
 }
 
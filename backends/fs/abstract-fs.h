@@ -172,6 +172,14 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and last modification time of the file referred by
+	 * this node without opening it.
+	 *
+	 * @return bool true if the information is available, false otherwise.
+	 */
+	virtual bool getFileInfo(int64 &size, int64 &modificationTime) const;
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -192,6 +200,16 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStreamForAltStream(Common::AltStreamType altStreamType);
 
+	/**
+	 * Creates a SeekableReadStream instance which directly views a memory
+	 * mapping of the file referred by this node, without copying its data.
+	 * Backends which cannot map files return 0, in which case the caller
+	 * should fall back to createReadStream().
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	virtual Common::SeekableReadStream *createMappedReadStream();
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
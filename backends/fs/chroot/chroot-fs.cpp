@@ -73,6 +73,10 @@ bool ChRootFilesystemNode::isWritable() const {
 	return _realNode->isWritable();
 }
 
+bool ChRootFilesystemNode::getFileInfo(int64 &size, int64 &modificationTime) const {
+	return _realNode->getFileInfo(size, modificationTime);
+}
+
 AbstractFSNode *ChRootFilesystemNode::getChild(const Common::String &n) const {
 	return new ChRootFilesystemNode(_root, (POSIXFilesystemNode *)_realNode->getChild(n), _drive);
 }
@@ -100,6 +104,10 @@ Common::SeekableReadStream *ChRootFilesystemNode::createReadStream() {
 	return _realNode->createReadStream();
 }
 
+Common::SeekableReadStream *ChRootFilesystemNode::createMappedReadStream() {
+	return _realNode->createMappedReadStream();
+}
+
 Common::SeekableWriteStream *ChRootFilesystemNode::createWriteStream(bool atomic) {
 	return _realNode->createWriteStream(atomic);
 }
@@ -67,6 +67,16 @@ bool POSIXFilesystemNode::isWritable() const {
 	return access(_path.c_str(), W_OK) == 0;
 }
 
+bool POSIXFilesystemNode::getFileInfo(int64 &size, int64 &modificationTime) const {
+	struct stat st;
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = st.st_size;
+	modificationTime = st.st_mtime;
+	return true;
+}
+
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -290,6 +300,10 @@ Common::SeekableReadStream *POSIXFilesystemNode::createReadStreamForAltStream(Co
 	return nullptr;
 }
 
+Common::SeekableReadStream *POSIXFilesystemNode::createMappedReadStream() {
+	return PosixMmapStream::makeFromPath(getPath());
+}
+
 Common::SeekableWriteStream *POSIXFilesystemNode::createWriteStream(bool atomic) {
 	return PosixIoStream::makeFromPath(getPath(), atomic ?
 			StdioStream::WriteMode_WriteAtomic : StdioStream::WriteMode_Write);
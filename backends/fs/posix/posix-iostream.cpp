@@ -24,6 +24,13 @@
 #include "backends/fs/posix/posix-iostream.h"
 
 #include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <fcntl.h>
+#include <sys/mman.h>
+#define HAVE_POSIX_MMAP
+#endif
 
 PosixIoStream::PosixIoStream(void *handle) :
 		StdioStream(handle) {
@@ -44,3 +51,41 @@ int64 PosixIoStream::size() const {
 
 	return st.st_size;
 }
+
+PosixMmapStream::PosixMmapStream(void *mapping, uint32 size) :
+		Common::MemoryReadStream((const byte *)mapping, size, DisposeAfterUse::NO),
+		_mapping(mapping), _mappingSize(size) {
+}
+
+PosixMmapStream::~PosixMmapStream() {
+#ifdef HAVE_POSIX_MMAP
+	munmap(_mapping, _mappingSize);
+#endif
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+#ifdef HAVE_POSIX_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+	    st.st_size <= 0 || (uint64)st.st_size > 0xFFFFFFFFULL) {
+		close(fd);
+		return nullptr;
+	}
+
+	uint32 size = (uint32)st.st_size;
+	void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return nullptr;
+
+	return new PosixMmapStream(mapping, size);
+#else
+	return nullptr;
+#endif
+}
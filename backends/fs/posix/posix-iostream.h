@@ -23,6 +23,7 @@
 #define BACKENDS_FS_POSIX_POSIXIOSTREAM_H
 
 #include "backends/fs/stdiostream.h"
+#include "common/memstream.h"
 
 /**
  * A file input / output stream using POSIX interfaces
@@ -39,4 +40,30 @@ public:
 	int64 size() const override;
 };
 
+/**
+ * A read-only file stream viewing a memory mapping of the whole file.
+ * No data is copied: pages are faulted in by the OS as they are read.
+ *
+ * The size is fixed when the file is mapped. If the file gets truncated
+ * afterwards, reading the pages past its new end raises SIGBUS, so only
+ * files which do not change while in use must be mapped.
+ */
+class PosixMmapStream final : public Common::MemoryReadStream {
+public:
+	/**
+	 * Map the file at the given path.
+	 *
+	 * @return the stream, or nullptr if the file could not be mapped
+	 *         (e.g. it is empty, too big, or the platform lacks mmap).
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+	~PosixMmapStream() override;
+
+private:
+	PosixMmapStream(void *mapping, uint32 size);
+
+	void *_mapping;
+	uint32 _mappingSize;
+};
+
 #endif
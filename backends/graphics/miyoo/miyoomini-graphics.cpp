@@ -47,7 +47,7 @@ void MiyooMiniGraphicsManager::unloadGFXMode() {
 
 void MiyooMiniGraphicsManager::updateScreen(SDL_Rect *dirtyRectList, int actualDirtyRects) {
 	SDL_BlitSurface(_hwScreen, nullptr, _realHwScreen, nullptr);
-	SDL_UpdateRects(_realHwScreen, actualDirtyRects, _dirtyRectList);
+	SDL_UpdateRects(_realHwScreen, actualDirtyRects, dirtyRectList);
 }
 
 void MiyooMiniGraphicsManager::getDefaultResolution(uint &w, uint &h) {
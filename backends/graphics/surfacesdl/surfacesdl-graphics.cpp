@@ -184,14 +184,14 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_mouseOrigSurface(nullptr), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakeXOffset(0), _currentShakeYOffset(0),
 	_paletteDirtyStart(0), _paletteDirtyEnd(0),
-	_screenIsLocked(false),
+	_screenIsLocked(false), _detectScreenChanges(false),
 	_displayDisabled(false),
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
 #endif
 	_transactionMode(kTransactionNone),
 	_scalerPlugins(ScalerMan.getPlugins()), _scalerPlugin(nullptr), _scaler(nullptr),
-	_needRestoreAfterOverlay(false), _isInOverlayPalette(false), _isDoubleBuf(false), _prevForceRedraw(false), _numPrevDirtyRects(0),
+	_needRestoreAfterOverlay(false), _isInOverlayPalette(false), _isDoubleBuf(false), _prevForceRedraw(false),
 	_prevCursorNeedsRedraw(false),
 	_mouseKeyColor(0), _disableMouseKeyColor(false) {
 
@@ -235,6 +235,8 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_videoMode.vsync = ConfMan.getBool("vsync");
 
+	_detectScreenChanges = ConfMan.getBool("detect_screen_changes");
+
 	_videoMode.scalerIndex = getDefaultScaler();
 	_videoMode.scaleFactor = getDefaultScaleFactor();
 }
@@ -718,6 +720,8 @@ void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 
 		_scalerPlugin = &_scalerPlugins[_videoMode.scalerIndex]->get<ScalerPluginObject>();
 		_scaler = _scalerPlugin->createInstance(format);
+		// Large dirty rects are scaled in row bands on the worker threads
+		_scaler->setTaskPool(g_system->getTaskPool());
 
 		if (_mouseScaler != nullptr) {
 			delete _mouseScaler;
@@ -978,6 +982,10 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 
 	setupHardwareSize();
 
+	// Dirty rects are either in game or in overlay coordinates
+	_dirtyRegion.setSize(MAX(_videoMode.screenWidth, _videoMode.overlayWidth),
+	                     MAX(_videoMode.screenHeight, _videoMode.overlayHeight));
+
 	//
 	// Create the surface that contains the game data
 	//
@@ -1344,7 +1352,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 
 	// In case of double buferring partially good version may be on another page,
 	// so we need to fully redraw
-	if (_isDoubleBuf && _numDirtyRects)
+	if (_isDoubleBuf && !_dirtyRegion.isEmpty())
 		_forceRedraw = true;
 
 #if defined(USE_IMGUI) && (defined(USE_IMGUI_SDLRENDERER2) || defined(USE_IMGUI_SDLRENDERER3))
@@ -1354,16 +1362,25 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 #endif
 
 	bool doRedraw = _forceRedraw || (_prevForceRedraw && _isDoubleBuf);
-	int actualDirtyRects = _numDirtyRects;
-	if (_isDoubleBuf && _numPrevDirtyRects > 0) {
-		memcpy(_dirtyRectList + _numDirtyRects, _prevDirtyRectList, _numPrevDirtyRects * sizeof(_dirtyRectList[0]));
-		actualDirtyRects += _numPrevDirtyRects;
+
+	// Coalesce the dirty areas of this frame
+	_dirtyRegion.getRects(_dirtyRects);
+	_dirtyRectList.resize(_dirtyRects.size());
+	for (uint i = 0; i < _dirtyRects.size(); i++) {
+		_dirtyRectList[i].x = _dirtyRects[i].left;
+		_dirtyRectList[i].y = _dirtyRects[i].top;
+		_dirtyRectList[i].w = _dirtyRects[i].width();
+		_dirtyRectList[i].h = _dirtyRects[i].height();
 	}
 
+	const uint numDirtyRects = _dirtyRectList.size();
+	if (_isDoubleBuf && !_prevDirtyRectList.empty())
+		_dirtyRectList.push_back(_prevDirtyRectList);
+
 	// Force a full redraw if requested.
 	// If _useOldSrc, the scaler will do its own partial updates.
 	if (doRedraw) {
-		actualDirtyRects = 1;
+		_dirtyRectList.resize(1);
 		_dirtyRectList[0].x = 0;
 		_dirtyRectList[0].y = 0;
 		_dirtyRectList[0].w = width;
@@ -1371,22 +1388,20 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	}
 
 	_prevForceRedraw = _forceRedraw;
-	if (!_prevForceRedraw && _numDirtyRects && _isDoubleBuf) {
-		memcpy(_prevDirtyRectList, _dirtyRectList, _numDirtyRects * sizeof(_dirtyRectList[0]));
-		_numPrevDirtyRects = _numDirtyRects;
-	}
+	if (!_prevForceRedraw && numDirtyRects && _isDoubleBuf)
+		_prevDirtyRectList = Common::Array<SDL_Rect>(_dirtyRectList.begin(), numDirtyRects);
 
 	// Only draw anything if necessary
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	bool doPresent = false;
 #endif
-	if (actualDirtyRects > 0 || _cursorNeedsRedraw) {
+	if (!_dirtyRectList.empty() || _cursorNeedsRedraw) {
 		SDL_Rect *r;
 		SDL_Rect dst;
 		uint32 bpp, srcPitch, dstPitch;
-		SDL_Rect *lastRect = _dirtyRectList + actualDirtyRects;
+		SDL_Rect *lastRect = _dirtyRectList.end();
 
-		for (r = _dirtyRectList; r != lastRect; ++r) {
+		for (r = _dirtyRectList.begin(); r != lastRect; ++r) {
 			dst = *r;
 			dst.x += _maxExtraPixels;	// Shift rect since some scalers need to access the data around
 			dst.y += _maxExtraPixels;	// any pixel to scale it, and we want to avoid mem access crashes.
@@ -1409,7 +1424,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwScreen->pitch;
 
-		for (r = _dirtyRectList; r != lastRect; ++r) {
+		for (r = _dirtyRectList.begin(); r != lastRect; ++r) {
 			int src_x = r->x;
 			int src_y = r->y;
 			int dst_x = r->x;
@@ -1576,7 +1591,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 
 		// Finally, blit all our changes to the screen
 		if (!_displayDisabled) {
-			updateScreen(_dirtyRectList, actualDirtyRects);
+			updateScreen(_dirtyRectList.data(), _dirtyRectList.size());
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 			doPresent = true;
 #endif
@@ -1587,7 +1602,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	if (_scaler)
 		_scaler->setFactor(oldScaleFactor);
 
-	_numDirtyRects = 0;
+	_dirtyRegion.clear();
 	_forceRedraw = false;
 	_cursorNeedsRedraw = false;
 
@@ -1730,13 +1745,18 @@ void SurfaceSdlGraphicsManager::copyRectToScreen(const void *buf, int pitch, int
 	assert(h > 0 && y + h <= _videoMode.screenHeight);
 	assert(w > 0 && x + w <= _videoMode.screenWidth);
 
-	addDirtyRect(x, y, w, h, false);
-
 	// Try to lock the screen surface
 	if (!lockSurface(_screen))
 		error("SDL_LockSurface failed: %s", SDL_GetError());
 
 	byte *dst = (byte *)_screen->pixels + y * _screen->pitch + x * _screenFormat.bytesPerPixel;
+
+	// Compare with the current contents before they are overwritten
+	if (_detectScreenChanges && !_forceRedraw)
+		addChangedRects((const byte *)buf, pitch, dst, x, y, w, h);
+	else
+		addDirtyRect(x, y, w, h, false);
+
 	if (_videoMode.screenWidth == w && pitch == _screen->pitch) {
 		memcpy(dst, buf, h*pitch);
 	} else {
@@ -1806,11 +1826,6 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool in
 	if (_forceRedraw)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceRedraw = true;
-		return;
-	}
-
 	int height, width;
 
 	if (!inOverlay && !realCoordinates) {
@@ -1861,13 +1876,41 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool in
 		return;
 	}
 
-	if (w > 0 && h > 0) {
-		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+	if (w > 0 && h > 0)
+		_dirtyRegion.addRect(Common::Rect(x, y, x + w, y + h));
+}
+
+void SurfaceSdlGraphicsManager::addChangedRects(const byte *src, int srcPitch, const byte *dst, int x, int y, int w, int h) {
+	const int tileSize = Graphics::DirtyRegion::kDefaultTileSize;
+	const int bpp = _screenFormat.bytesPerPixel;
+
+	// The tiles are aligned to the screen, and each row of them adds the
+	// runs of changed tiles as dirty rects
+	for (int tileTop = y - y % tileSize; tileTop < y + h; tileTop += tileSize) {
+		const int top = MAX(tileTop, y);
+		const int bottom = MIN(tileTop + tileSize, y + h);
+		int runLeft = -1;
+
+		for (int tileLeft = x - x % tileSize; tileLeft < x + w; tileLeft += tileSize) {
+			const int left = MAX(tileLeft, x);
+			const int right = MIN(tileLeft + tileSize, x + w);
+
+			bool changed = false;
+			for (int row = top; row < bottom && !changed; row++) {
+				changed = memcmp(src + (row - y) * srcPitch + (left - x) * bpp,
+				                 dst + (row - y) * _screen->pitch + (left - x) * bpp, (right - left) * bpp) != 0;
+			}
+
+			if (changed && runLeft < 0) {
+				runLeft = left;
+			} else if (!changed && runLeft >= 0) {
+				addDirtyRect(runLeft, top, left - runLeft, bottom - top, false);
+				runLeft = -1;
+			}
+		}
 
-		r->x = x;
-		r->y = y;
-		r->w = w;
-		r->h = h;
+		if (runLeft >= 0)
+			addDirtyRect(runLeft, top, x + w - runLeft, bottom - top, false);
 	}
 }
 
@@ -24,6 +24,7 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyregion.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "graphics/scalerplugin.h"
@@ -352,19 +353,24 @@ protected:
 	int _screenChangeCount;
 
 	enum {
-		NUM_DIRTY_RECT = 100,
 		MAX_SCALING = 3
 	};
 
 	// Dirty rect management
+	// The dirty areas of the current frame are collected in a region,
+	// which coalesces them into rects when the screen is updated.
 	// When double-buffering we need to redraw both updates from
 	// current frame and previous frame. For convenience we copy
 	// them here before traversing the list.
-	SDL_Rect _dirtyRectList[2 * NUM_DIRTY_RECT];
-	int _numDirtyRects;
+	Graphics::DirtyRegion _dirtyRegion;
+	Common::Array<Common::Rect> _dirtyRects;
+	Common::Array<SDL_Rect> _dirtyRectList;
 
-	SDL_Rect _prevDirtyRectList[NUM_DIRTY_RECT];
-	int _numPrevDirtyRects;
+	Common::Array<SDL_Rect> _prevDirtyRectList;
+
+	// Only mark the tiles of copyRectToScreen() that differ from the
+	// screen contents as dirty
+	bool _detectScreenChanges;
 
 	struct MousePos {
 		// The size and hotspot of the original cursor image.
@@ -429,6 +435,7 @@ protected:
 #endif
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool inOverlay, bool realCoordinates = false);
+	void addChangedRects(const byte *src, int srcPitch, const byte *dst, int x, int y, int w, int h);
 
 	virtual void drawMouse();
 	virtual void undrawMouse();
@@ -20,6 +20,8 @@
  */
 
 #include "backends/mixer/null/null-mixer.h"
+#include "common/endian.h"
+#include "common/file.h"
 #include "common/savefile.h"
 
 NullMixerManager::NullMixerManager() : MixerManager() {
@@ -29,9 +31,14 @@ NullMixerManager::NullMixerManager() : MixerManager() {
 	while (_samples * 16 > _outputRate * 2)
 		_samples >>= 1;
 	_samplesBuf = new uint8[_samples * 4];
+	_renderFile = nullptr;
+	_disposeRenderFile = DisposeAfterUse::YES;
+	_renderedMillis = 0;
+	_renderedFrames = 0;
 }
 
 NullMixerManager::~NullMixerManager() {
+	stopRendering();
 	delete[] _samplesBuf;
 }
 
@@ -58,7 +65,7 @@ bool NullMixerManager::isNullDevice() const {
 }
 
 void NullMixerManager::update(uint8 callbackPeriod) {
-	if (_audioSuspended) {
+	if (_audioSuspended || isRendering()) {
 		return;
 	}
 	_callsCounter++;
@@ -67,3 +74,93 @@ void NullMixerManager::update(uint8 callbackPeriod) {
 		_mixer->mixCallback(_samplesBuf, _samples);
 	}
 }
+
+bool NullMixerManager::startRendering(const Common::Path &path) {
+	stopRendering();
+
+	Common::DumpFile *file = new Common::DumpFile();
+	if (!file->open(path, true)) {
+		warning("NullMixerManager: Could not open '%s' for writing", path.toString(Common::Path::kNativeSeparator).c_str());
+		delete file;
+		return false;
+	}
+
+	startRendering(file, DisposeAfterUse::YES);
+	return true;
+}
+
+void NullMixerManager::startRendering(Common::SeekableWriteStream *stream, DisposeAfterUse::Flag disposeAfterUse) {
+	stopRendering();
+
+	_renderFile = stream;
+	_disposeRenderFile = disposeAfterUse;
+	_renderedMillis = 0;
+	_renderedFrames = 0;
+	// The sizes are filled in by stopRendering()
+	writeWaveHeader();
+}
+
+void NullMixerManager::stopRendering() {
+	if (!_renderFile)
+		return;
+
+	_renderFile->seek(0);
+	writeWaveHeader();
+	_renderFile->finalize();
+	if (_renderFile->err())
+		warning("NullMixerManager: Could not write the rendered audio");
+
+	if (_disposeRenderFile == DisposeAfterUse::YES)
+		delete _renderFile;
+	_renderFile = nullptr;
+}
+
+void NullMixerManager::renderMillis(uint32 msecs) {
+	if (!_renderFile)
+		return;
+
+	// Work out the frames from the total time, so that rounding errors do
+	// not add up over many short calls
+	_renderedMillis += msecs;
+	const uint64 endFrame = (uint64)_renderedMillis * _outputRate / 1000;
+
+	int16 *samples = (int16 *)_samplesBuf;
+	while (_renderedFrames < endFrame) {
+		const uint32 frames = (uint32)MIN<uint64>(endFrame - _renderedFrames, _samples);
+
+		if (_audioSuspended) {
+			memset(_samplesBuf, 0, frames * 4);
+		} else {
+			assert(_mixer);
+			_mixer->mixCallback(_samplesBuf, frames * 4);
+		}
+
+		for (uint32 i = 0; i < frames * 2; i++) {
+#ifdef OUTPUT_UNSIGNED_AUDIO
+			_renderFile->writeSint16LE(samples[i] ^ 0x8000);
+#else
+			_renderFile->writeSint16LE(samples[i]);
+#endif
+		}
+		_renderedFrames += frames;
+	}
+}
+
+void NullMixerManager::writeWaveHeader() {
+	// The output is always 16-bit stereo
+	const uint32 dataSize = (uint32)MIN<uint64>(_renderedFrames * 4, 0xFFFFFFFFu - 36);
+
+	_renderFile->writeUint32BE(MKTAG('R', 'I', 'F', 'F'));
+	_renderFile->writeUint32LE(36 + dataSize);
+	_renderFile->writeUint32BE(MKTAG('W', 'A', 'V', 'E'));
+	_renderFile->writeUint32BE(MKTAG('f', 'm', 't', ' '));
+	_renderFile->writeUint32LE(16);
+	_renderFile->writeUint16LE(1);
+	_renderFile->writeUint16LE(2);
+	_renderFile->writeUint32LE(_outputRate);
+	_renderFile->writeUint32LE(_outputRate * 4);
+	_renderFile->writeUint16LE(4);
+	_renderFile->writeUint16LE(16);
+	_renderFile->writeUint32BE(MKTAG('d', 'a', 't', 'a'));
+	_renderFile->writeUint32LE(dataSize);
+}
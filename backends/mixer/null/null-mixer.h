@@ -24,6 +24,11 @@
 
 #include "backends/mixer/mixer.h"
 
+namespace Common {
+class Path;
+class SeekableWriteStream;
+}
+
 /** Audio mixer which in fact does not output audio.
  *
  *  It is used by events recorder since the recorder is intentionally
@@ -31,6 +36,10 @@
  *
  *  It returns correct output and shoots callbacks, so all OSystem
  *  users could work without modifications.
+ *
+ *  It can also render the output to a WAV file instead. In that case the
+ *  audio is mixed on demand by renderMillis(), as fast as the host allows,
+ *  and the amount of audio rendered serves as a virtual clock.
  */
 
 class NullMixerManager : public MixerManager {
@@ -46,11 +55,38 @@ public:
 
 	bool isNullDevice() const override;
 
+	/**
+	 * Start writing the mixer output to the WAV file @p path. Until
+	 * stopRendering() is called, update() does nothing, and the audio is
+	 * only mixed by renderMillis().
+	 */
+	bool startRendering(const Common::Path &path);
+	/**
+	 * Start writing the mixer output as a WAV file to @p stream, which
+	 * stopRendering() deletes if @p disposeAfterUse is YES.
+	 */
+	void startRendering(Common::SeekableWriteStream *stream, DisposeAfterUse::Flag disposeAfterUse);
+	/** Finish the WAV file started by startRendering(). */
+	void stopRendering();
+	bool isRendering() const { return _renderFile != nullptr; }
+
+	/** Mix the next @p msecs milliseconds of audio into the WAV file. */
+	void renderMillis(uint32 msecs);
+	/** Milliseconds of audio rendered since startRendering(). */
+	uint32 getRenderedMillis() const { return _renderedMillis; }
+
 private:
+	void writeWaveHeader();
+
 	uint32 _outputRate;
 	uint32 _callsCounter;
 	uint32 _samples;
 	uint8 *_samplesBuf;
+
+	Common::SeekableWriteStream *_renderFile;
+	DisposeAfterUse::Flag _disposeRenderFile;
+	uint32 _renderedMillis;
+	uint64 _renderedFrames;
 };
 
 #endif
@@ -215,6 +215,8 @@ MODULE_OBJS += \
 	mixer/sdl/sdl-mixer.o \
 	mixer/null/null-mixer.o \
 	mutex/sdl/sdl-mutex.o \
+	taskpool/threaded-taskpool.o \
+	taskpool/sdl/sdl-taskpool.o \
 	timer/sdl/sdl-timer.o
 
 ifndef USE_SDL3
@@ -347,6 +349,8 @@ MODULE_OBJS += \
 	fs/android/android-saf-fs.o \
 	graphics/android/android-graphics.o \
 	mutex/pthread/pthread-mutex.o \
+	taskpool/threaded-taskpool.o \
+	taskpool/pthread/pthread-taskpool.o \
 	networking/basic/android/jni.o \
 	networking/basic/android/socket.o \
 	networking/basic/android/url.o
@@ -441,6 +445,8 @@ ifdef IPHONE
 MODULE_OBJS += \
 	midi/coremidi.o \
 	mutex/pthread/pthread-mutex.o \
+	taskpool/threaded-taskpool.o \
+	taskpool/pthread/pthread-taskpool.o \
 	graphics/ios/ios-graphics.o \
 	graphics/ios/renderbuffer.o
 
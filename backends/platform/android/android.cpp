@@ -67,6 +67,7 @@
 #include "backends/audiocd/default/default-audiocd.h"
 #include "backends/events/default/default-events.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/taskpool/pthread/pthread-taskpool.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 
@@ -556,6 +557,7 @@ void OSystem_Android::initBackend() {
 	LOGD("Setting Default Icons and Shaders path to: %s", ConfMan.getPath("iconspath").toString(Common::Path::kNativeSeparator).c_str());
 
 	_timerManager = new DefaultTimerManager();
+	_taskPool = createPthreadTaskPool();
 
 	_event_queue_lock = new Common::Mutex();
 
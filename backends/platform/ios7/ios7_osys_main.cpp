@@ -51,6 +51,7 @@
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/taskpool/pthread/pthread-taskpool.h"
 #include "backends/fs/chroot/chroot-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
 #include "backends/text-to-speech/avfaudio/avfaudio-text-to-speech.h"
@@ -156,6 +157,7 @@ void OSystem_iOS7::initBackend() {
 	_savefileManager = new SandboxedSaveFileManager(Common::Path(_chrootBasePath, Common::Path::kNativeSeparator), "/Savegames");
 
 	_timerManager = new DefaultTimerManager();
+	_taskPool = createPthreadTaskPool();
 
 	_startTime = CACurrentMediaTime();
 
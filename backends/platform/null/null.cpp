@@ -49,14 +49,15 @@ typedef void (*sighandler_t)(int);
 #if defined(USE_NULL_DRIVER)
 #include "backends/modular-backend.h"
 #include "backends/mutex/null/null-mutex.h"
+#include "backends/mixer/null/null-mixer.h"
 #include "base/main.h"
 
 #ifndef NULL_DRIVER_USE_FOR_TEST
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "backends/events/default/default-events.h"
-#include "backends/mixer/null/null-mixer.h"
 #include "backends/graphics/null/null-graphics.h"
+#include "common/config-manager.h"
 #include "gui/debugger.h"
 #endif
 
@@ -86,6 +87,7 @@ public:
 
 	virtual Common::MutexInternal *createMutex();
 	virtual uint32 getMillis(bool skipRecord = false);
+	virtual uint64 getMicros();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &td, bool skipRecord = false) const;
 
@@ -96,6 +98,15 @@ public:
 	virtual void addSysArchivesToSearchSet(Common::SearchSet &s, int priority);
 
 private:
+#ifndef NULL_DRIVER_USE_FOR_TEST
+	NullMixerManager *getNullMixerManager() const { return (NullMixerManager *)_mixerManager; }
+	bool isRenderingAudio() const { return _mixerManager && getNullMixerManager()->isRendering(); }
+	void renderAudio(uint msecs);
+
+	uint32 _renderStartTime;
+	bool _renderedSincePoll;
+#endif
+
 #ifdef POSIX
 	timeval _startTime;
 #elif defined(WIN32)
@@ -105,6 +116,10 @@ private:
 };
 
 OSystem_NULL::OSystem_NULL(bool silenceLogs) :
+#ifndef NULL_DRIVER_USE_FOR_TEST
+	_renderStartTime(0),
+	_renderedSincePoll(false),
+#endif
 	_silenceLogs(silenceLogs) {
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
@@ -155,14 +170,33 @@ void OSystem_NULL::initBackend() {
 	// Setup and start mixer
 	_mixerManager->init();
 
+	// When rendering the audio to a file, time only passes as the audio is
+	// rendered, see renderAudio()
+	if (ConfMan.hasKey("render_audio")) {
+		_renderStartTime = getMillis();
+		getNullMixerManager()->startRendering(Common::Path(ConfMan.get("render_audio"), Common::Path::kNativeSeparator));
+	}
+
 	BaseBackend::initBackend();
+#else
+	// The tests only need the mixer for its mutex
+	_mixerManager = new NullMixerManager();
+	_mixerManager->init();
 #endif
 }
 
 bool OSystem_NULL::pollEvent(Common::Event &event) {
 #ifndef NULL_DRIVER_USE_FOR_TEST
-	((DefaultTimerManager *)getTimerManager())->checkTimers();
-	((NullMixerManager *)_mixerManager)->update(1);
+	if (isRenderingAudio()) {
+		// Make sure that time passes for engines which wait for it
+		// without calling delayMillis()
+		if (!_renderedSincePoll)
+			renderAudio(1);
+		_renderedSincePoll = false;
+	} else {
+		((DefaultTimerManager *)getTimerManager())->checkTimers();
+		((NullMixerManager *)_mixerManager)->update(1);
+	}
 
 #ifdef POSIX
 	if (intReceived) {
@@ -191,6 +225,11 @@ Common::MutexInternal *OSystem_NULL::createMutex() {
 }
 
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
+#ifndef NULL_DRIVER_USE_FOR_TEST
+	if (isRenderingAudio())
+		return _renderStartTime + getNullMixerManager()->getRenderedMillis();
+#endif
+
 #ifdef POSIX
 	timeval curTime;
 
@@ -205,7 +244,26 @@ uint32 OSystem_NULL::getMillis(bool skipRecord) {
 #endif
 }
 
+uint64 OSystem_NULL::getMicros() {
+#ifdef POSIX
+	timeval curTime;
+
+	gettimeofday(&curTime, 0);
+
+	return (uint64)(curTime.tv_sec - _startTime.tv_sec) * 1000000 + (curTime.tv_usec - _startTime.tv_usec);
+#else
+	return OSystem::getMicros();
+#endif
+}
+
 void OSystem_NULL::delayMillis(uint msecs) {
+#ifndef NULL_DRIVER_USE_FOR_TEST
+	if (isRenderingAudio()) {
+		renderAudio(msecs);
+		return;
+	}
+#endif
+
 #ifdef POSIX
 	usleep(msecs * 1000);
 #elif defined(WIN32)
@@ -226,7 +284,22 @@ void OSystem_NULL::getTimeAndDate(TimeDate &td, bool skipRecord) const {
 }
 
 #ifndef NULL_DRIVER_USE_FOR_TEST
+void OSystem_NULL::renderAudio(uint msecs) {
+	// Advance one millisecond at a time, which is the resolution of the
+	// timer manager, so that the timer callbacks driving OPL chips and MIDI
+	// drivers are interleaved with the audio as they would be in real time
+	DefaultTimerManager *timerManager = (DefaultTimerManager *)getTimerManager();
+	for (uint i = 0; i < msecs; i++) {
+		getNullMixerManager()->renderMillis(1);
+		timerManager->handler();
+	}
+	_renderedSincePoll = true;
+}
+
 void OSystem_NULL::quit() {
+	// exit() skips the destructors, so the WAV file has to be finished here
+	if (_mixerManager)
+		getNullMixerManager()->stopRendering();
 	exit(0);
 }
 #endif
@@ -46,6 +46,7 @@
 #include "backends/events/default/default-events.h"
 #include "backends/keymapper/hardware-input.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
+#include "backends/taskpool/sdl/sdl-taskpool.h"
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #ifdef USE_OPENGL
@@ -155,6 +156,10 @@ OSystem_SDL::~OSystem_SDL() {
 
 	_timerManager = nullptr;
 
+	// The worker threads need to be stopped before SDL is shut down
+	delete _taskPool;
+	_taskPool = nullptr;
+
 	delete _logger;
 	_logger = nullptr;
 
@@ -378,6 +383,9 @@ void OSystem_SDL::initBackend() {
 		_timerManager = new SdlTimerManager();
 #endif
 
+	if (_taskPool == nullptr)
+		_taskPool = createSdlTaskPool();
+
 	_audiocdManager = createAudioCDManager();
 
 	// Setup a custom program icon.
@@ -876,6 +884,16 @@ uint32 OSystem_SDL::getMillis(bool skipRecord) {
 	return millis;
 }
 
+uint64 OSystem_SDL::getMicros() {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	const uint64 counter = SDL_GetPerformanceCounter();
+	const uint64 frequency = SDL_GetPerformanceFrequency();
+	return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+#else
+	return OSystem::getMicros();
+#endif
+}
+
 void OSystem_SDL::delayMillis(uint msecs) {
 #ifdef ENABLE_EVENTRECORDER
 	if (g_eventRec.processDelayMillis())
@@ -90,6 +90,7 @@ public:
 	void addSysArchivesToSearchSet(Common::SearchSet &s, int priority = 0) override;
 	Common::MutexInternal *createMutex() override;
 	uint32 getMillis(bool skipRecord = false) override;
+	uint64 getMicros() override;
 	void delayMillis(uint msecs) override;
 	void getTimeAndDate(TimeDate &td, bool skipRecord = false) const override;
 	MixerManager *getMixerManager() override;
@@ -0,0 +1,128 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "backends/taskpool/pthread/pthread-taskpool.h"
+#include "backends/taskpool/threaded-taskpool.h"
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#if defined(__ANDROID__)
+#include "backends/platform/android/jni-android.h"
+#endif
+
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * pthreads task pool implementation
+ */
+class PthreadTaskPool final : public ThreadedTaskPool {
+public:
+	PthreadTaskPool(uint numWorkers);
+	~PthreadTaskPool() override;
+
+protected:
+	void lock() override { pthread_mutex_lock(&_mutex); }
+	void unlock() override { pthread_mutex_unlock(&_mutex); }
+	bool tryLock() override { return pthread_mutex_trylock(&_mutex) == 0; }
+	void waitForWork() override { pthread_cond_wait(&_workCond, &_mutex); }
+	void notifyWork(bool all) override {
+		if (all)
+			pthread_cond_broadcast(&_workCond);
+		else
+			pthread_cond_signal(&_workCond);
+	}
+	void waitForDone() override { pthread_cond_wait(&_doneCond, &_mutex); }
+	void notifyDone() override { pthread_cond_broadcast(&_doneCond); }
+
+private:
+	static void *workerProc(void *param);
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _workCond;
+	pthread_cond_t _doneCond;
+	pthread_t _threads[kMaxThreads];
+};
+
+PthreadTaskPool::PthreadTaskPool(uint numWorkers) {
+	pthread_mutex_init(&_mutex, nullptr);
+	pthread_cond_init(&_workCond, nullptr);
+	pthread_cond_init(&_doneCond, nullptr);
+
+	numWorkers = MIN<uint>(numWorkers, kMaxThreads - 1);
+	while (_numWorkers < numWorkers) {
+		if (pthread_create(&_threads[_numWorkers], nullptr, workerProc, this) != 0) {
+			warning("pthread_create() failed, using %u worker threads", _numWorkers);
+			break;
+		}
+		_numWorkers++;
+	}
+}
+
+PthreadTaskPool::~PthreadTaskPool() {
+	requestQuit();
+	for (uint i = 0; i < _numWorkers; i++)
+		pthread_join(_threads[i], nullptr);
+
+	pthread_cond_destroy(&_doneCond);
+	pthread_cond_destroy(&_workCond);
+	pthread_mutex_destroy(&_mutex);
+}
+
+void *PthreadTaskPool::workerProc(void *param) {
+#if defined(__ANDROID__)
+	// Tasks may reach Java, e.g. through the SAF file system, which needs
+	// the thread to be attached to the VM
+	JNI::attachThread();
+#endif
+
+	((PthreadTaskPool *)param)->runWorker();
+
+#if defined(__ANDROID__)
+	JNI::detachThread();
+#endif
+	return nullptr;
+}
+
+Common::TaskPool *createPthreadTaskPool() {
+#ifdef _SC_NPROCESSORS_ONLN
+	uint numWorkers = ThreadedTaskPool::getDefaultNumWorkers(sysconf(_SC_NPROCESSORS_ONLN));
+#else
+	uint numWorkers = 0;
+#endif
+	if (!numWorkers)
+		return nullptr;
+
+	Common::TaskPool *pool = createPthreadTaskPool(numWorkers);
+	if (pool->getNumThreads() == 1) {
+		delete pool;
+		return nullptr;
+	}
+	return pool;
+}
+
+Common::TaskPool *createPthreadTaskPool(uint numWorkers) {
+	return new PthreadTaskPool(numWorkers);
+}
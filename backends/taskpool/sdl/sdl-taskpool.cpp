@@ -0,0 +1,161 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/taskpool/sdl/sdl-taskpool.h"
+#include "backends/taskpool/threaded-taskpool.h"
+#include "backends/platform/sdl/sdl-sys.h"
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+// SDL 1.2 has neither named threads nor a way to query the number of CPUs,
+// so the serial task pool is used there.
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+
+/**
+ * SDL task pool implementation
+ */
+class SdlTaskPool final : public ThreadedTaskPool {
+public:
+	SdlTaskPool(uint numWorkers);
+	~SdlTaskPool() override;
+
+protected:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	void lock() override { SDL_LockMutex(_mutex); }
+	void unlock() override { SDL_UnlockMutex(_mutex); }
+	bool tryLock() override { return SDL_TryLockMutex(_mutex); }
+	void waitForWork() override { SDL_WaitCondition(_workCond, _mutex); }
+	void notifyWork(bool all) override {
+		if (all)
+			SDL_BroadcastCondition(_workCond);
+		else
+			SDL_SignalCondition(_workCond);
+	}
+	void waitForDone() override { SDL_WaitCondition(_doneCond, _mutex); }
+	void notifyDone() override { SDL_BroadcastCondition(_doneCond); }
+#else
+	void lock() override { SDL_LockMutex(_mutex); }
+	void unlock() override { SDL_UnlockMutex(_mutex); }
+	bool tryLock() override { return SDL_TryLockMutex(_mutex) == 0; }
+	void waitForWork() override { SDL_CondWait(_workCond, _mutex); }
+	void notifyWork(bool all) override {
+		if (all)
+			SDL_CondBroadcast(_workCond);
+		else
+			SDL_CondSignal(_workCond);
+	}
+	void waitForDone() override { SDL_CondWait(_doneCond, _mutex); }
+	void notifyDone() override { SDL_CondBroadcast(_doneCond); }
+#endif
+
+private:
+	static int SDLCALL workerProc(void *param);
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	SDL_Mutex *_mutex;
+	SDL_Condition *_workCond;
+	SDL_Condition *_doneCond;
+#else
+	SDL_mutex *_mutex;
+	SDL_cond *_workCond;
+	SDL_cond *_doneCond;
+#endif
+	SDL_Thread *_threads[kMaxThreads];
+};
+
+SdlTaskPool::SdlTaskPool(uint numWorkers) {
+	_mutex = SDL_CreateMutex();
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	_workCond = SDL_CreateCondition();
+	_doneCond = SDL_CreateCondition();
+#else
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+#endif
+	if (!_mutex || !_workCond || !_doneCond) {
+		warning("Could not create the task pool synchronization primitives: %s", SDL_GetError());
+		return;
+	}
+
+	numWorkers = MIN<uint>(numWorkers, kMaxThreads - 1);
+	while (_numWorkers < numWorkers) {
+		_threads[_numWorkers] = SDL_CreateThread(workerProc, "ScummVM worker", this);
+		if (!_threads[_numWorkers]) {
+			warning("SDL_CreateThread() failed, using %u worker threads: %s", _numWorkers, SDL_GetError());
+			break;
+		}
+		_numWorkers++;
+	}
+}
+
+SdlTaskPool::~SdlTaskPool() {
+	if (_numWorkers) {
+		requestQuit();
+		for (uint i = 0; i < _numWorkers; i++)
+			SDL_WaitThread(_threads[i], nullptr);
+	}
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	SDL_DestroyCondition(_doneCond);
+	SDL_DestroyCondition(_workCond);
+#else
+	SDL_DestroyCond(_doneCond);
+	SDL_DestroyCond(_workCond);
+#endif
+	SDL_DestroyMutex(_mutex);
+}
+
+int SDLCALL SdlTaskPool::workerProc(void *param) {
+	((SdlTaskPool *)param)->runWorker();
+	return 0;
+}
+
+Common::TaskPool *createSdlTaskPool() {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	uint numWorkers = ThreadedTaskPool::getDefaultNumWorkers(SDL_GetNumLogicalCPUCores());
+#else
+	uint numWorkers = ThreadedTaskPool::getDefaultNumWorkers(SDL_GetCPUCount());
+#endif
+	if (!numWorkers)
+		return nullptr;
+
+	SdlTaskPool *pool = new SdlTaskPool(numWorkers);
+	if (pool->getNumThreads() == 1) {
+		delete pool;
+		return nullptr;
+	}
+	return pool;
+}
+
+#else
+
+Common::TaskPool *createSdlTaskPool() {
+	return nullptr;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "backends/taskpool/threaded-taskpool.h"
+
+#include "common/config-manager.h"
+#include "common/util.h"
+
+uint ThreadedTaskPool::getDefaultNumWorkers(int numCpus) {
+	if (numCpus <= 1 || !ConfMan.getBool("multithreading"))
+		return 0;
+	return MIN<uint>(numCpus - 1, kMaxThreads - 1);
+}
+
+ThreadedTaskPool::ThreadedTaskPool() : _numWorkers(0), _firstTask(nullptr), _lastTask(nullptr), _freeTasks(nullptr), _quit(false) {
+	for (int i = 0; i < kNumPreallocatedTasks; i++) {
+		_preallocatedTasks[i].allocated = false;
+		_preallocatedTasks[i].next = _freeTasks;
+		_freeTasks = &_preallocatedTasks[i];
+	}
+}
+
+void ThreadedTaskPool::submit(TaskGroup &group, TaskProc proc, void *param) {
+	lock();
+	queueTask(group, proc, param, true);
+	unlock();
+}
+
+bool ThreadedTaskPool::trySubmit(TaskGroup &group, TaskProc proc, void *param) {
+	if (!tryLock())
+		return false;
+
+	const bool queued = queueTask(group, proc, param, false);
+	unlock();
+	return queued;
+}
+
+bool ThreadedTaskPool::queueTask(TaskGroup &group, TaskProc proc, void *param, bool mayAllocate) {
+	Task *task = _freeTasks;
+	if (task) {
+		_freeTasks = task->next;
+	} else if (mayAllocate) {
+		task = new Task();
+		task->allocated = true;
+	} else {
+		return false;
+	}
+
+	task->proc = proc;
+	task->param = param;
+	task->group = &group;
+	task->next = nullptr;
+	if (_lastTask)
+		_lastTask->next = task;
+	else
+		_firstTask = task;
+	_lastTask = task;
+
+	pendingTasks(group)++;
+	notifyWork(false);
+	return true;
+}
+
+void ThreadedTaskPool::wait(TaskGroup &group) {
+	lock();
+	while (pendingTasks(group)) {
+		// Help with the queued tasks of the group instead of idling. Tasks
+		// of other groups are left to the workers, so that waiting never
+		// runs unrelated work, which may take much longer.
+		if (!runQueuedTask(&group))
+			waitForDone();
+	}
+	unlock();
+}
+
+void ThreadedTaskPool::cancel(TaskGroup &group) {
+	lock();
+	Task *prev = nullptr;
+	Task *task = _firstTask;
+	while (task) {
+		Task *next = task->next;
+		if (task->group == &group) {
+			unqueueTask(task, prev);
+			pendingTasks(group)--;
+		} else {
+			prev = task;
+		}
+		task = next;
+	}
+
+	if (pendingTasks(group) == 0)
+		notifyDone();
+	unlock();
+}
+
+void ThreadedTaskPool::runWorker() {
+	lock();
+	for (;;) {
+		if (runQueuedTask())
+			continue;
+		if (_quit)
+			break;
+		waitForWork();
+	}
+	unlock();
+}
+
+void ThreadedTaskPool::requestQuit() {
+	lock();
+	_quit = true;
+	notifyWork(true);
+	unlock();
+}
+
+bool ThreadedTaskPool::runQueuedTask(TaskGroup *group) {
+	Task *prev = nullptr;
+	Task *task = _firstTask;
+	while (task && group && task->group != group) {
+		prev = task;
+		task = task->next;
+	}
+	if (!task)
+		return false;
+
+	const TaskProc proc = task->proc;
+	void *const param = task->param;
+	TaskGroup *const taskGroup = task->group;
+	unqueueTask(task, prev);
+
+	unlock();
+	proc(param);
+	lock();
+
+	if (--pendingTasks(*taskGroup) == 0)
+		notifyDone();
+	return true;
+}
+
+void ThreadedTaskPool::unqueueTask(Task *task, Task *prev) {
+	if (prev)
+		prev->next = task->next;
+	else
+		_firstTask = task->next;
+	if (_lastTask == task)
+		_lastTask = prev;
+
+	if (task->allocated) {
+		delete task;
+	} else {
+		task->next = _freeTasks;
+		_freeTasks = task;
+	}
+}
@@ -0,0 +1,121 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_TASKPOOL_THREADED_H
+#define BACKENDS_TASKPOOL_THREADED_H
+
+#include "common/taskpool.h"
+
+/**
+ * Task pool running tasks on a fixed number of worker threads.
+ *
+ * This implements the queue and the scheduling on top of a mutex and two
+ * condition variables, which are provided by the subclasses.
+ */
+class ThreadedTaskPool : public Common::TaskPool {
+public:
+	uint getNumThreads() const override { return _numWorkers + 1; }
+	void submit(TaskGroup &group, TaskProc proc, void *param) override;
+	bool trySubmit(TaskGroup &group, TaskProc proc, void *param) override;
+	void wait(TaskGroup &group) override;
+	void cancel(TaskGroup &group) override;
+
+	/**
+	 * Return how many worker threads to start on a system with @p numCpus
+	 * CPUs. This is 0 when the "multithreading" setting is off, or when
+	 * there is only one CPU.
+	 */
+	static uint getDefaultNumWorkers(int numCpus);
+
+protected:
+	ThreadedTaskPool();
+
+	/** Body of the worker threads. */
+	void runWorker();
+
+	/** Make the worker threads return once the queue is empty. */
+	void requestQuit();
+
+	/** Lock the mutex protecting the queue. */
+	virtual void lock() = 0;
+	virtual void unlock() = 0;
+	/** Lock the mutex if it is free. @return False if it is locked already. */
+	virtual bool tryLock() = 0;
+
+	/** Wait until notifyWork() is called. Called with the mutex locked. */
+	virtual void waitForWork() = 0;
+	/** Wake up one worker, or all of them if @p all is set. */
+	virtual void notifyWork(bool all) = 0;
+
+	/** Wait until notifyDone() is called. Called with the mutex locked. */
+	virtual void waitForDone() = 0;
+	/** Wake up all threads waiting for a group. */
+	virtual void notifyDone() = 0;
+
+	/** Number of worker threads successfully started by the subclass. */
+	uint _numWorkers;
+
+private:
+	enum {
+		/** Number of tasks which can be queued without allocating memory. */
+		kNumPreallocatedTasks = 64
+	};
+
+	struct Task {
+		TaskProc proc;
+		void *param;
+		TaskGroup *group;
+		Task *next;
+		bool allocated;
+	};
+
+	/**
+	 * Run the oldest queued task, if any. If @p group is set, only tasks of
+	 * that group are considered. Called with the mutex locked, which is
+	 * released while the task runs.
+	 */
+	bool runQueuedTask(TaskGroup *group = nullptr);
+
+	/**
+	 * Add a task to the queue. Called with the mutex locked.
+	 *
+	 * @param mayAllocate  Whether memory may be allocated when all the
+	 *                     preallocated tasks are queued already.
+	 * @return False if the task was not queued.
+	 */
+	bool queueTask(TaskGroup &group, TaskProc proc, void *param, bool mayAllocate);
+
+	/**
+	 * Remove @p task, which follows @p prev, from the queue and free it.
+	 * Called with the mutex locked.
+	 */
+	void unqueueTask(Task *task, Task *prev);
+
+	/** The queued tasks, from the oldest to the newest. */
+	Task *_firstTask;
+	Task *_lastTask;
+	/** Unused preallocated tasks. */
+	Task *_freeTasks;
+	Task _preallocatedTasks[kNumPreallocatedTasks];
+	bool _quit;
+};
+
+#endif
@@ -191,6 +191,10 @@ static const char HELP_STRING4[] =
 																	 ", opl2lpt"
 #endif
 																			  ")\n"
+#ifdef USE_NULL_DRIVER
+	"  --render-audio=FILE      Render the audio to a WAV file, as fast as possible,\n"
+	"                           instead of in real time\n"
+#endif
 	"  --show-fps               Set the turn on display FPS info in 3D games\n"
 	"  --no-show-fps            Set the turn off display FPS info in 3D games\n"
 	"  --random-seed=SEED       Set the random seed used to initialize entropy\n"
@@ -312,6 +316,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("shader", Common::Path("default", Common::Path::kNoSeparator));
 	ConfMan.registerDefault("show_fps", false);
 	ConfMan.registerDefault("dirtyrects", true);
+	ConfMan.registerDefault("detect_screen_changes", false);
 	ConfMan.registerDefault("vsync", true);
 
 	// Sound & Music
@@ -329,6 +334,9 @@ void registerDefaults() {
 	ConfMan.registerDefault("dump_midi", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("resampler", "linear");
+	ConfMan.registerDefault("amiga_band_limited", false);
+	ConfMan.registerDefault("mixer_stats", false);
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
@@ -339,6 +347,8 @@ void registerDefaults() {
 
 	ConfMan.registerDefault("enable_unsupported_game_warning", true);
 	ConfMan.registerDefault("enable_unsupported_addon_warning", true);
+	ConfMan.registerDefault("detection_cache", true);
+	ConfMan.registerDefault("multithreading", true);
 
 #if defined(USE_FLUIDSYNTH) || defined(USE_FLUIDLITE)
 	ConfMan.registerDefault("soundfont", "Roland_SC-55.sf2");
@@ -836,6 +846,11 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("opl-driver")
 			END_OPTION
 
+#ifdef USE_NULL_DRIVER
+			DO_LONG_OPTION("render-audio")
+			END_OPTION
+#endif
+
 			DO_OPTION('g', "gfx-mode")
 			END_OPTION
 
@@ -699,6 +699,9 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist, uint32
 	// Close all archives that were opened during detection
 	ADCacheMan.clearArchives();
 
+	// Save newly hashed files from time to time, in case of mass detection
+	ADCacheMan.flushPersistentCache(false);
+
 	return DetectionResults(candidates);
 }
 
@@ -338,6 +338,39 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	updateIndex();
+}
+
+void SearchSet::updateIndex() {
+	_index.clear();
+	if (!_useIndex)
+		return;
+
+	// _list is sorted by descending priority, so the first archive which
+	// registers a path is the one a linear search would have found.
+	for (const auto &archive : _list) {
+		ArchiveMemberList members;
+		archive._arc->listMembers(members);
+
+		for (const auto &member : members) {
+			Path path = member->getPathInArchive();
+			if (!_index.contains(path))
+				_index[path] = archive._arc;
+		}
+	}
+}
+
+Archive *SearchSet::lookupIndex(const Path &path) const {
+	ArchiveIndex::const_iterator it = _index.find(path);
+	if (it == _index.end())
+		return nullptr;
+
+	return it->_value;
+}
+
+void SearchSet::setUseIndex(bool useIndex) {
+	_useIndex = useIndex;
+	updateIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -434,6 +467,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		updateIndex();
 	}
 }
 
@@ -457,6 +491,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	updateIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -479,6 +514,16 @@ bool SearchSet::hasFile(const Path &path) const {
 	if (path.empty())
 		return false;
 
+	if (_useIndex) {
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return false;
+		if (arc->hasFile(path))
+			return true;
+		// The index matches more loosely than some archives do, so let
+		// the other archives have a go.
+	}
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path))
 			return true;
@@ -559,6 +604,17 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path, Archive **containe
 	if (path.empty())
 		return ArchiveMemberPtr();
 
+	if (_useIndex) {
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return ArchiveMemberPtr();
+		if (arc->hasFile(path)) {
+			if (container)
+				*container = arc;
+			return arc->getMember(path);
+		}
+	}
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path)) {
 			if (container) {
@@ -579,6 +635,15 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const
 	if (path.empty())
 		return nullptr;
 
+	if (_useIndex) {
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return nullptr;
+		SeekableReadStream *stream = arc->createReadStreamForMember(path);
+		if (stream)
+			return stream;
+	}
+
 	for (const auto &archive : _list) {
 		SeekableReadStream *stream = archive._arc->createReadStreamForMember(path);
 		if (stream)
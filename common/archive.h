@@ -347,8 +347,21 @@ class SearchSet : public Archive {
 
 	bool _ignoreClashes;
 
+	/**
+	 * Merged path -> archive index. For each member path, it holds the archive
+	 * with the highest priority which lists it, i.e. the one a linear search
+	 * over _list would pick. It is rebuilt whenever _list changes rather than
+	 * on the next lookup, so that lookups never write to the set.
+	 */
+	typedef HashMap<Path, Archive *, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> ArchiveIndex;
+	ArchiveIndex _index;
+	bool _useIndex;
+
+	void updateIndex();
+	Archive *lookupIndex(const Path &path) const;
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
+	SearchSet() : _ignoreClashes(false), _useIndex(false) { }
 	virtual ~SearchSet() { clear(); }
 
 	char getPathSeparator() const override { return '/'; }
@@ -476,6 +489,27 @@ public:
 	 */
 	void setIgnoreClashes(bool ignoreClashes) { _ignoreClashes = ignoreClashes; }
 
+	/**
+	 * Enable or disable the merged lookup index.
+	 *
+	 * When enabled, hasFile, getMember and createReadStreamForMember resolve
+	 * paths with a single hash lookup instead of querying every archive in turn.
+	 * The index is built from listMembers right away, and rebuilt whenever
+	 * archives are added, removed or reprioritized. Lookups only read it, so
+	 * they may run from several threads as long as the set is not modified.
+	 *
+	 * Only enable this when all the archives in the set list all their members,
+	 * and their contents do not change while they are part of the set.
+	 * Otherwise call rebuildIndex after a change. As every change rebuilds the
+	 * whole index, enabling it after filling the set is cheaper.
+	 */
+	void setUseIndex(bool useIndex);
+
+	/**
+	 * Rebuild the lookup index from the current contents of the archives.
+	 */
+	void rebuildIndex() { updateIndex(); }
+
 	bool getChildren(const Common::Path &path, Common::Array<Common::String> &list, ListMode mode = kListDirectoriesOnly, bool hidden = true) const override;
 };
 
@@ -0,0 +1,163 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/arena.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+namespace {
+
+// The header of a block is padded, so that its data starts aligned
+const size_t kBlockHeaderSize = 4 * sizeof(void *);
+
+} // End of anonymous namespace
+
+byte *Arena::Block::begin() {
+	return (byte *)this + kBlockHeaderSize;
+}
+
+Arena::Arena(size_t blockSize) : _blockSize(blockSize), _first(nullptr), _current(nullptr),
+		_pos(nullptr), _end(nullptr), _finalizers(nullptr) {
+	assert(sizeof(Block) <= kBlockHeaderSize);
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+Arena::~Arena() {
+	reset();
+	freeBlocksAfter(nullptr);
+}
+
+void *Arena::allocateSlow(size_t size, size_t alignment) {
+	assert(alignment && (alignment & (alignment - 1)) == 0);
+	const size_t needed = size + (alignment > kDefaultAlignment ? alignment : 0);
+
+	// Move on to the next block, unless it is too small for this allocation.
+	// In that case, a new block is put in front of it.
+	Block *prev = _current;
+	Block *block = prev ? prev->next : _first;
+	if (!block || block->size < needed) {
+		const size_t blockSize = MAX(_blockSize, needed);
+		Block *newBlock = (Block *)malloc(kBlockHeaderSize + blockSize);
+		if (!newBlock)
+			::error("Common::Arena: failure to allocate %u bytes", (uint)(kBlockHeaderSize + blockSize));
+
+		newBlock->size = blockSize;
+		newBlock->next = block;
+		if (prev)
+			prev->next = newBlock;
+		else
+			_first = newBlock;
+		block = newBlock;
+
+		_stats.bytesReserved += blockSize;
+		_stats.numBlocks++;
+	}
+
+	_current = block;
+	_pos = block->begin();
+	_end = block->end();
+	return allocate(size, alignment);
+}
+
+void Arena::deallocate(void *ptr, size_t size) {
+	if (!ptr || (byte *)ptr + size != _pos)
+		return;
+
+	_pos = (byte *)ptr;
+	_stats.bytesUsed -= size;
+#ifndef RELEASE_BUILD
+	memset(ptr, 0xDD, size);
+#endif
+}
+
+Arena::Marker Arena::getMarker() const {
+	Marker marker;
+	marker._block = _current;
+	marker._pos = _pos;
+	marker._finalizers = _finalizers;
+	marker._bytesUsed = _stats.bytesUsed;
+	return marker;
+}
+
+void Arena::rewind(const Marker &marker) {
+	runFinalizers(marker._finalizers);
+
+#ifndef RELEASE_BUILD
+	// Poison everything after the marker, up to the current position
+	if (_current) {
+		Block *block = marker._block ? marker._block : _first;
+		byte *begin = marker._block ? marker._pos : block->begin();
+		while (block != _current) {
+			memset(begin, 0xDD, block->end() - begin);
+			block = block->next;
+			begin = block->begin();
+		}
+		if (begin < _pos)
+			memset(begin, 0xDD, _pos - begin);
+	}
+#endif
+
+	_current = marker._block;
+	_pos = marker._pos;
+	_end = _current ? _current->end() : nullptr;
+	_stats.bytesUsed = marker._bytesUsed;
+}
+
+void Arena::reset() {
+	Marker start;
+	start._block = nullptr;
+	start._pos = nullptr;
+	start._finalizers = nullptr;
+	start._bytesUsed = 0;
+	rewind(start);
+}
+
+void Arena::freeUnusedBlocks() {
+	freeBlocksAfter(_current);
+}
+
+void Arena::runFinalizers(Finalizer *last) {
+	while (_finalizers != last) {
+		Finalizer *finalizer = _finalizers;
+		_finalizers = finalizer->next;
+		finalizer->destroy(finalizer->object);
+	}
+}
+
+void Arena::freeBlocksAfter(Block *block) {
+	Block *next = block ? block->next : _first;
+	while (next) {
+		Block *toFree = next;
+		next = next->next;
+
+		_stats.bytesReserved -= toFree->size;
+		_stats.numBlocks--;
+		free(toFree);
+	}
+
+	if (block)
+		block->next = nullptr;
+	else
+		_first = nullptr;
+}
+
+} // End of namespace Common
@@ -0,0 +1,267 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_arena Arena allocator
+ * @ingroup common_memory
+ *
+ * @brief Bump allocator for short lived data.
+ * @{
+ */
+
+/**
+ * An arena hands out memory by advancing a pointer through large blocks,
+ * and frees everything at once when it is reset or rewound to a marker.
+ *
+ * This suits data with a common lifetime, like what an engine builds for
+ * one frame or one scene: allocating costs a few instructions, and there is
+ * no per-object bookkeeping. Unlike with MemoryPool, the objects may have
+ * any size. Blocks are kept after a reset and reused, so an arena which is
+ * reset every frame stops calling malloc() once it has grown large enough.
+ *
+ * Memory from allocate() is not initialized and no destructor is run for
+ * it. Objects built with create() get their destructor called, in reverse
+ * order, when the arena is reset or rewound past them.
+ *
+ * In non-release builds, memory is filled with 0xCD when handed out and
+ * with 0xDD when released, to make use of stale pointers obvious.
+ */
+class Arena : NonCopyable {
+	struct Block;
+	struct Finalizer;
+
+public:
+	enum {
+		/** The default block size, in bytes. */
+		kDefaultBlockSize = 64 * 1024,
+		/** The alignment of allocations, unless asked for otherwise. */
+		kDefaultAlignment = 2 * sizeof(void *)
+	};
+
+	/** Usage statistics of an arena. */
+	struct Stats {
+		size_t bytesUsed;       ///< Bytes currently handed out, including alignment padding
+		size_t peakBytesUsed;   ///< The highest value bytesUsed has ever reached
+		size_t bytesReserved;   ///< Bytes held in blocks, used or not
+		uint numBlocks;         ///< Number of blocks held
+		uint numAllocations;    ///< Number of allocations since the arena was created
+	};
+
+	/**
+	 * A position in an arena, see getMarker().
+	 */
+	class Marker {
+	private:
+		friend class Arena;
+		Block *_block;
+		byte *_pos;
+		Finalizer *_finalizers;
+		size_t _bytesUsed;
+	};
+
+	/**
+	 * Create an arena. No memory is allocated until it is first used.
+	 *
+	 * @param blockSize  The size of the blocks the memory is taken from.
+	 *                   Larger allocations get a block of their own.
+	 */
+	explicit Arena(size_t blockSize = kDefaultBlockSize);
+	~Arena();
+
+	/**
+	 * Allocate @p size bytes of uninitialized memory, aligned on
+	 * @p alignment bytes, which must be a power of two. This never
+	 * returns nullptr.
+	 */
+	void *allocate(size_t size, size_t alignment = kDefaultAlignment) {
+		byte *ptr = (byte *)(((uintptr)_pos + alignment - 1) & ~(uintptr)(alignment - 1));
+		if (!_pos || (size_t)(_end - _pos) < size + (size_t)(ptr - _pos))
+			return allocateSlow(size, alignment);
+
+		_stats.bytesUsed += ptr + size - _pos;
+		if (_stats.bytesUsed > _stats.peakBytesUsed)
+			_stats.peakBytesUsed = _stats.bytesUsed;
+		_stats.numAllocations++;
+		_pos = ptr + size;
+#ifndef RELEASE_BUILD
+		memset(ptr, 0xCD, size);
+#endif
+		return ptr;
+	}
+
+	/**
+	 * Give back the memory of an allocation. This only does something if it
+	 * was the most recent one; otherwise the memory stays in use until the
+	 * arena is reset or rewound.
+	 */
+	void deallocate(void *ptr, size_t size);
+
+	/**
+	 * Allocate uninitialized memory for @p count objects of type @p T.
+	 */
+	template<class T>
+	T *allocateArray(size_t count) {
+		return (T *)allocate(sizeof(T) * count, alignof(T));
+	}
+
+	/**
+	 * Construct an object of type @p T in the arena, passing @p args to its
+	 * constructor. The destructor is called when the object is released by
+	 * reset() or rewind().
+	 */
+	template<class T, class... TArgs>
+	T *create(TArgs &&...args) {
+		Finalizer *finalizer = allocateArray<Finalizer>(1);
+		T *object = new (allocate(sizeof(T), alignof(T))) T(Common::forward<TArgs>(args)...);
+
+		finalizer->destroy = &destroyObject<T>;
+		finalizer->object = object;
+		finalizer->next = _finalizers;
+		_finalizers = finalizer;
+		return object;
+	}
+
+	/**
+	 * Return the current position, which can later be passed to rewind().
+	 */
+	Marker getMarker() const;
+
+	/**
+	 * Release everything allocated since @p marker was obtained. Markers
+	 * obtained after that one become invalid.
+	 */
+	void rewind(const Marker &marker);
+
+	/**
+	 * Release everything allocated in the arena. The blocks are kept for
+	 * reuse, see freeUnusedBlocks().
+	 */
+	void reset();
+
+	/**
+	 * Give the blocks not in use at the moment back to the system.
+	 */
+	void freeUnusedBlocks();
+
+	/** Return the usage statistics. */
+	const Stats &getStats() const { return _stats; }
+
+private:
+	struct Block {
+		Block *next;
+		size_t size;
+
+		byte *begin();
+		byte *end() { return begin() + size; }
+	};
+
+	struct Finalizer {
+		void (*destroy)(void *object);
+		void *object;
+		Finalizer *next;
+	};
+
+	template<class T>
+	static void destroyObject(void *object) {
+		((T *)object)->~T();
+	}
+
+	void *allocateSlow(size_t size, size_t alignment);
+	void runFinalizers(Finalizer *last);
+	void freeBlocksAfter(Block *block);
+
+	const size_t _blockSize;
+	Block *_first;    ///< All the blocks, in the order they are used
+	Block *_current;  ///< The block memory is taken from, or nullptr if none is used yet
+	byte *_pos;       ///< The next free byte in _current
+	byte *_end;       ///< The end of _current
+	Finalizer *_finalizers;
+	Stats _stats;
+};
+
+/**
+ * Rewinds an arena to where it was when the scope was entered.
+ *
+ * @code
+ * {
+ *     Common::ArenaScope scope(frameArena);
+ *     // Anything allocated from frameArena here is released at the end of the block
+ * }
+ * @endcode
+ */
+class ArenaScope : NonCopyable {
+public:
+	explicit ArenaScope(Arena &arena) : _arena(arena), _marker(arena.getMarker()) {}
+	~ArenaScope() { _arena.rewind(_marker); }
+
+private:
+	Arena &_arena;
+	Arena::Marker _marker;
+};
+
+/**
+ * An allocator for containers like Common::Array, which takes the memory
+ * from an arena. The container must not outlive the arena, nor be used
+ * after the arena is rewound past its allocations.
+ */
+template<class T>
+class ArenaAllocator {
+public:
+	ArenaAllocator(Arena &arena) : _arena(&arena) {}
+
+	T *allocate(size_t count) {
+		return _arena->allocateArray<T>(count);
+	}
+
+	void deallocate(T *ptr, size_t count) {
+		_arena->deallocate(ptr, sizeof(T) * count);
+	}
+
+	Arena &getArena() const { return *_arena; }
+
+private:
+	Arena *_arena;
+};
+
+/**
+ * An array stored in an arena.
+ *
+ * @code
+ * Common::ArenaArray<RenderItem> items(frameArena);
+ * @endcode
+ */
+template<class T>
+using ArenaArray = Array<T, ArenaAllocator<T> >;
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
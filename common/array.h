@@ -37,6 +37,40 @@ namespace Common {
  * @{
  */
 
+/**
+ * Storage for the allocator of an Array. Arrays using the default
+ * allocator do not need any, so they stay as small as before.
+ */
+template<class Allocator>
+class ArrayAllocatorHolder {
+public:
+	constexpr ArrayAllocatorHolder() : _allocator() {}
+	ArrayAllocatorHolder(const Allocator &allocator) : _allocator(allocator) {}
+
+	/** Return the allocator used for the element storage. */
+	Allocator &getAllocator() { return _allocator; }
+	const Allocator &getAllocator() const { return _allocator; }
+
+protected:
+	void setAllocator(const Allocator &allocator) { _allocator = allocator; }
+
+private:
+	Allocator _allocator;
+};
+
+template<class T>
+class ArrayAllocatorHolder<DefaultAllocator<T> > {
+public:
+	constexpr ArrayAllocatorHolder() {}
+	ArrayAllocatorHolder(const DefaultAllocator<T> &) {}
+
+	/** Return the allocator used for the element storage. */
+	DefaultAllocator<T> getAllocator() const { return DefaultAllocator<T>(); }
+
+protected:
+	void setAllocator(const DefaultAllocator<T> &) {}
+};
+
 /**
  * This class implements a dynamically sized container, which
  * can be accessed similarly to a regular C++ array. Accessing
@@ -47,9 +81,14 @@ namespace Common {
  *
  * The container class closest to this in the C++ standard library is
  * std::vector. However, there are some differences.
+ *
+ * Like with std::vector, the element storage can be obtained from a custom
+ * @p Allocator, see DefaultAllocator for the interface. Copies of an array
+ * use a copy of its allocator, while assigning to an array keeps its own
+ * allocator, except when moving.
  */
-template<class T>
-class Array {
+template<class T, class Allocator = DefaultAllocator<T> >
+class Array : public ArrayAllocatorHolder<Allocator> {
 public:
 	typedef T *iterator; /*!< Array iterator. */
 	typedef const T *const_iterator; /*!< Const-qualified array iterator. */
@@ -69,6 +108,11 @@ protected:
 public:
 	constexpr Array() : _capacity(0), _size(0), _storage(nullptr) {}
 
+	/**
+	 * Construct an empty array, which gets its storage from @p allocator.
+	 */
+	explicit Array(const Allocator &allocator) : ArrayAllocatorHolder<Allocator>(allocator), _capacity(0), _size(0), _storage(nullptr) {}
+
 	/**
 	 * Construct an array with @p count default-inserted instances of @p T. No
 	 * copies are made.
@@ -93,7 +137,7 @@ public:
 	/**
 	 * Construct an array as a copy of the given @p array.
 	 */
-	Array(const Array<T> &array) : _capacity(array._size), _size(array._size), _storage(nullptr) {
+	Array(const Array &array) : ArrayAllocatorHolder<Allocator>(array.getAllocator()), _capacity(array._size), _size(array._size), _storage(nullptr) {
 		if (array._storage) {
 			allocCapacity(_size);
 			uninitialized_copy(array._storage, array._storage + _size, _storage);
@@ -103,7 +147,7 @@ public:
 	/**
 	 * Construct an array as a copy of the given array using the C++11 move semantic.
 	 */
-	Array(Array<T> &&old) : _capacity(old._capacity), _size(old._size), _storage(old._storage) {
+	Array(Array &&old) : ArrayAllocatorHolder<Allocator>(old.getAllocator()), _capacity(old._capacity), _size(old._size), _storage(old._storage) {
 		old._storage = nullptr;
 		old._capacity = 0;
 		old._size = 0;
@@ -134,7 +178,7 @@ public:
 	}
 
 	~Array() {
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_storage = nullptr;
 		_capacity = _size = 0;
 	}
@@ -154,6 +198,7 @@ public:
 			// In the added-in-the-middle case, the copy is required because the parameters
 			// may contain a const ref to the original storage.
 			T *oldStorage = _storage;
+			const size_type oldCapacity = _capacity;
 
 			allocCapacity(roundUpCapacity(_size + 1));
 
@@ -165,7 +210,7 @@ public:
 			uninitialized_move(oldStorage, oldStorage + index, _storage);
 			uninitialized_move(oldStorage + index, oldStorage + _size, _storage + index + 1);
 
-			freeStorage(oldStorage, _size);
+			freeStorage(oldStorage, _size, oldCapacity);
 		}
 
 		_size++;
@@ -188,7 +233,7 @@ public:
 	}
 
 	/** Append an element to the end of the array. */
-	void push_back(const Array<T> &array) {
+	void push_back(const Array &array) {
 		if (_size + array.size() <= _capacity) {
 			uninitialized_copy(array.begin(), array.end(), end());
 			_size += array.size();
@@ -245,7 +290,7 @@ public:
 	}
 
 	/** Insert copies of all the elements from the given array into this array at the given position. */
-	void insert_at(size_type idx, const Array<T> &array) {
+	void insert_at(size_type idx, const Array &array) {
 		assert(idx <= _size);
 		insert_aux(_storage + idx, array.begin(), array.end());
 	}
@@ -283,11 +328,11 @@ public:
 	}
 
 	/** Assign the given @p array to this array. */
-	Array<T> &operator=(const Array<T> &array) {
+	Array &operator=(const Array &array) {
 		if (this == &array)
 			return *this;
 
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_size = array._size;
 		allocCapacity(_size);
 		uninitialized_copy(array._storage, array._storage + _size, _storage);
@@ -296,11 +341,12 @@ public:
 	}
 
 	/** Assign the given array to this array using the C++11 move semantic. */
-	Array &operator=(Array<T> &&old) {
+	Array &operator=(Array &&old) {
 		if (this == &old)
 			return *this;
 
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
+		this->setAllocator(old.getAllocator());
 		_capacity = old._capacity;
 		_size = old._size;
 		_storage = old._storage;
@@ -319,7 +365,7 @@ public:
 
 	/** Clear the array of all its elements. */
 	void clear() {
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_storage = nullptr;
 		_size = 0;
 		_capacity = 0;
@@ -354,7 +400,7 @@ public:
 	}
 
 	/** Check whether two arrays are identical. */
-	bool operator==(const Array<T> &other) const {
+	bool operator==(const Array &other) const {
 		if (this == &other)
 			return true;
 		if (_size != other._size)
@@ -367,7 +413,7 @@ public:
 	}
 
 	/** Check if two arrays are different. */
-	bool operator!=(const Array<T> &other) const {
+	bool operator!=(const Array &other) const {
 		return !(*this == other);
 	}
 
@@ -399,12 +445,13 @@ public:
 			return;
 
 		T *oldStorage = _storage;
+		const size_type oldCapacity = _capacity;
 		allocCapacity(newCapacity);
 
 		if (oldStorage) {
 			// Move old data
 			uninitialized_move(oldStorage, oldStorage + _size, _storage);
-			freeStorage(oldStorage, _size);
+			freeStorage(oldStorage, _size, oldCapacity);
 		}
 	}
 
@@ -448,6 +495,9 @@ public:
 	}
 
 	void swap(Array &arr) {
+		Allocator allocator = this->getAllocator();
+		this->setAllocator(arr.getAllocator());
+		arr.setAllocator(allocator);
 		SWAP(this->_capacity, arr._capacity);
 		SWAP(this->_size, arr._size);
 		SWAP(this->_storage, arr._storage);
@@ -468,7 +518,7 @@ protected:
 	void allocCapacity(size_type capacity) {
 		_capacity = capacity;
 		if (capacity) {
-			_storage = (T *)malloc(sizeof(T) * capacity);
+			_storage = this->getAllocator().allocate(capacity);
 			if (!_storage)
 				::error("Common::Array: failure to allocate %u bytes", capacity * (size_type)sizeof(T));
 		} else {
@@ -477,10 +527,11 @@ protected:
 	}
 
 	/** Free the storage used by the array. */
-	void freeStorage(T *storage, const size_type elements) {
+	void freeStorage(T *storage, const size_type elements, const size_type capacity) {
 		for (size_type i = 0; i < elements; ++i)
 			storage[i].~T();
-		free(storage);
+		if (storage)
+			this->getAllocator().deallocate(storage, capacity);
 	}
 
 	/**
@@ -504,6 +555,7 @@ protected:
 			const size_type idx = pos - _storage;
 			if (_size + n > _capacity || (_storage <= first && first <= _storage + _size)) {
 				T *const oldStorage = _storage;
+				const size_type oldCapacity = _capacity;
 
 				// If there is not enough space, allocate more.
 				// Likewise, if this is a self-insert, we allocate new
@@ -519,7 +571,7 @@ protected:
 				// insert.
 				uninitialized_move(oldStorage + idx, oldStorage + _size, _storage + idx + n);
 
-				freeStorage(oldStorage, _size);
+				freeStorage(oldStorage, _size, oldCapacity);
 			} else if (idx + n <= _size) {
 				// Make room for the new elements by shifting back
 				// existing ones.
@@ -0,0 +1,189 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+#ifndef NO_CXX11_ATOMIC
+#include <atomic>
+#else
+#include "common/mutex.h"
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_atomic Atomic variables
+ * @ingroup common
+ *
+ * @brief Variables which can be shared between threads without a lock.
+ *
+ * @{
+ */
+
+/**
+ * Memory ordering of an atomic operation, as in C++11.
+ */
+enum MemoryOrder {
+	kMemoryOrderRelaxed,
+	kMemoryOrderAcquire,
+	kMemoryOrderRelease,
+	kMemoryOrderAcquireRelease,
+	kMemoryOrderSequential
+};
+
+#ifndef NO_CXX11_ATOMIC
+
+/**
+ * An integer or boolean which may be accessed from several threads.
+ *
+ * This uses std::atomic where the standard library provides it. Otherwise
+ * configure defines NO_CXX11_ATOMIC, and every access takes an OSystem
+ * mutex instead, which is always at least as strong as the requested
+ * memory order. Code which must never block, like the audio callback,
+ * should therefore keep the number of accesses low.
+ */
+template<class T>
+class Atomic : NonCopyable {
+public:
+	Atomic(T value = T()) : _value(value) {}
+
+	T load(MemoryOrder order = kMemoryOrderSequential) const { return _value.load(toStd(order)); }
+	void store(T value, MemoryOrder order = kMemoryOrderSequential) { _value.store(value, toStd(order)); }
+
+	/** Add @p arg and return the previous value. */
+	T fetchAdd(T arg, MemoryOrder order = kMemoryOrderSequential) { return _value.fetch_add(arg, toStd(order)); }
+	/** Subtract @p arg and return the previous value. */
+	T fetchSub(T arg, MemoryOrder order = kMemoryOrderSequential) { return _value.fetch_sub(arg, toStd(order)); }
+
+	/**
+	 * Replace the value by @p desired if it equals @p expected. Otherwise
+	 * store the current value in @p expected.
+	 *
+	 * @return True if the value was replaced.
+	 */
+	bool compareExchange(T &expected, T desired, MemoryOrder order = kMemoryOrderSequential) {
+		return _value.compare_exchange_strong(expected, desired, toStd(order), failureOrder(order));
+	}
+
+	operator T() const { return load(); }
+	T operator=(T value) { store(value); return value; }
+	T operator++() { return fetchAdd(1) + 1; }
+	T operator--() { return fetchSub(1) - 1; }
+	T operator++(int) { return fetchAdd(1); }
+	T operator--(int) { return fetchSub(1); }
+
+private:
+	static std::memory_order toStd(MemoryOrder order) {
+		switch (order) {
+		case kMemoryOrderRelaxed:
+			return std::memory_order_relaxed;
+		case kMemoryOrderAcquire:
+			return std::memory_order_acquire;
+		case kMemoryOrderRelease:
+			return std::memory_order_release;
+		case kMemoryOrderAcquireRelease:
+			return std::memory_order_acq_rel;
+		default:
+			return std::memory_order_seq_cst;
+		}
+	}
+
+	/** The order of the load done by a failed compare-and-swap. */
+	static std::memory_order failureOrder(MemoryOrder order) {
+		switch (order) {
+		case kMemoryOrderRelaxed:
+		case kMemoryOrderRelease:
+			return std::memory_order_relaxed;
+		case kMemoryOrderAcquire:
+		case kMemoryOrderAcquireRelease:
+			return std::memory_order_acquire;
+		default:
+			return std::memory_order_seq_cst;
+		}
+	}
+
+	std::atomic<T> _value;
+};
+
+#else
+
+template<class T>
+class Atomic : NonCopyable {
+public:
+	Atomic(T value = T()) : _value(value) {}
+
+	T load(MemoryOrder order = kMemoryOrderSequential) const {
+		StackLock lock(_mutex);
+		return _value;
+	}
+
+	void store(T value, MemoryOrder order = kMemoryOrderSequential) {
+		StackLock lock(_mutex);
+		_value = value;
+	}
+
+	T fetchAdd(T arg, MemoryOrder order = kMemoryOrderSequential) {
+		StackLock lock(_mutex);
+		const T old = _value;
+		_value += arg;
+		return old;
+	}
+
+	T fetchSub(T arg, MemoryOrder order = kMemoryOrderSequential) {
+		StackLock lock(_mutex);
+		const T old = _value;
+		_value -= arg;
+		return old;
+	}
+
+	bool compareExchange(T &expected, T desired, MemoryOrder order = kMemoryOrderSequential) {
+		StackLock lock(_mutex);
+		if (_value != expected) {
+			expected = _value;
+			return false;
+		}
+		_value = desired;
+		return true;
+	}
+
+	operator T() const { return load(); }
+	T operator=(T value) { store(value); return value; }
+	T operator++() { return fetchAdd(1) + 1; }
+	T operator--() { return fetchSub(1) - 1; }
+	T operator++(int) { return fetchAdd(1); }
+	T operator--(int) { return fetchSub(1); }
+
+private:
+	Mutex _mutex;
+	T _value;
+};
+
+#endif // NO_CXX11_ATOMIC
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -130,11 +130,19 @@ static inline bool inflateClickteam(byte *dst, uint  dstLen, const byte *src, ui
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
  *
+ * Seeking backwards normally restarts decompression from the start of the data.
+ * If checkpointInterval is non-zero, the stream instead records the decompressor
+ * state about every checkpointInterval bytes of output as it goes, at the cost of
+ * 32 KiB of memory per checkpoint, and resumes from the closest checkpoint when
+ * seeking. Checkpoints are only supported when built against zlib 1.2.8 or later.
+ *
  * @param toBeWrapped	the stream to be wrapped (if it is in gzip-format)
  * @param knownSize	a supplied length of the uncompressed data (if not available directly)
+ * @param checkpointInterval	distance between seek checkpoints in the uncompressed data, 0 for none
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped,
-		DisposeAfterUse::Flag disposeParent = DisposeAfterUse::YES, uint64 knownSize = 0);
+		DisposeAfterUse::Flag disposeParent = DisposeAfterUse::YES, uint64 knownSize = 0,
+		uint32 checkpointInterval = 0);
 
 /**
  * Take an arbitrary SeekableReadStream and wrap it in a custom stream which
@@ -144,12 +152,15 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped,
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
  *
+ * See wrapCompressedReadStream for the meaning of checkpointInterval.
+ *
  * @param toBeWrapped	the stream to be wrapped (if it is in gzip-format)
  * @param knownSize	a supplied length of the uncompressed data (if not available directly)
+ * @param checkpointInterval	distance between seek checkpoints in the uncompressed data, 0 for none
  */
 SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped,
 		DisposeAfterUse::Flag disposeParent = DisposeAfterUse::YES, uint64 knownSize = 0,
-		const byte *dict = nullptr, uint dictLen = 0);
+		const byte *dict = nullptr, uint dictLen = 0, uint32 checkpointInterval = 0);
 
 /**
  * Take an arbitrary SeekableReadStream and wrap it in a custom stream which
@@ -1326,7 +1326,9 @@ bool GzioReadStream::seek(int64 offs, int whence) {
 }
 
 #ifndef USE_ZLIB
-SeekableReadStream* wrapCompressedReadStream(Common::SeekableReadStream *parent, DisposeAfterUse::Flag disposeParent, uint64 knownSize) {
+// Gzio does not support seek checkpoints: checkpointInterval is ignored, and
+// seeking back further than the window restarts from the beginning.
+SeekableReadStream* wrapCompressedReadStream(Common::SeekableReadStream *parent, DisposeAfterUse::Flag disposeParent, uint64 knownSize, uint32 checkpointInterval) {
 	if (!parent)
 		return nullptr;
 
@@ -1373,7 +1375,7 @@ SeekableReadStream* wrapCompressedReadStream(Common::SeekableReadStream *parent,
 	return gzio;
 }
 
-SeekableReadStream* wrapDeflateReadStream(Common::SeekableReadStream *parent, DisposeAfterUse::Flag disposeParent, uint64 knownSize, const byte *dict, uint dictLen) {
+SeekableReadStream* wrapDeflateReadStream(Common::SeekableReadStream *parent, DisposeAfterUse::Flag disposeParent, uint64 knownSize, const byte *dict, uint dictLen, uint32 checkpointInterval) {
 	if (!parent)
 		return nullptr;
 
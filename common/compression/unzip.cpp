@@ -95,6 +95,7 @@ typedef Byte Bytef;
 #include "common/compression/deflate.h"
 #include "common/compression/unzip.h"
 #include "common/memstream.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -237,6 +238,11 @@ Common::SharedArchiveContents unzOpenCurrentFile(unzFile file
   If there is no error, the return value is UNZ_OK.
 */
 
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file, uint32 minSize, uint32 checkpointInterval);
+/*
+  Open the current file in the zipfile as a stream decompressing on the fly.
+*/
+
 int unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
@@ -1024,19 +1030,55 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	return Common::SharedArchiveContents(uncompressedBuffer, s->cur_file_info.uncompressed_size);
 }
 
+/*
+  Open the current file in the zipfile as a stream decompressing on the fly,
+  if it is deflated and bigger than minSize. Return nullptr otherwise.
+  The stream reads from the zipfile stream, and does not check the CRC.
+*/
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file, uint32 minSize, uint32 checkpointInterval) {
+	uInt iSizeVar;
+	unz_s *s;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file == nullptr)
+		return nullptr;
+	s = (unz_s *)file;
+	if (!s->current_file_ok)
+		return nullptr;
+
+	if (s->cur_file_info.compression_method != Z_DEFLATED || s->cur_file_info.uncompressed_size <= minSize)
+		return nullptr;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar,
+				&offset_local_extrafield, &size_local_extrafield) != UNZ_OK)
+		return nullptr;
+
+	uint32 begin = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+	Common::SeekableReadStream *compressed = new Common::SafeSeekableSubReadStream(s->_stream,
+			begin, begin + s->cur_file_info.compressed_size, DisposeAfterUse::NO);
+
+	return Common::wrapDeflateReadStream(compressed, DisposeAfterUse::YES,
+			s->cur_file_info.uncompressed_size, nullptr, 0, checkpointInterval);
+}
+
 
 namespace Common {
 
 
+// Distance between seek checkpoints in streamed members
+static const uint32 kZipCheckpointInterval = 1024 * 1024;
+
 class ZipArchive : public MemcachingCaseInsensitiveArchive {
 	unzFile _zipFile;
 #ifndef USE_ZLIB
 	Common::CRC32 _crc;
 #endif
 	bool _flattenTree;
+	uint32 _streamThreshold;
 
 public:
-	ZipArchive(unzFile zipFile, bool flattenTree);
+	ZipArchive(unzFile zipFile, bool flattenTree, uint32 streamThreshold);
 
 
 	~ZipArchive();
@@ -1069,7 +1111,7 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile, bool flattenTree) : _zipFile(zipFile), _flattenTree(flattenTree) {
+ZipArchive::ZipArchive(unzFile zipFile, bool flattenTree, uint32 streamThreshold) : _zipFile(zipFile), _flattenTree(flattenTree), _streamThreshold(streamThreshold) {
 	assert(_zipFile);
 }
 
@@ -1114,6 +1156,13 @@ const ArchiveMemberPtr ZipArchive::getMember(const Path &path) const {
 Common::SharedArchiveContents ZipArchive::readContentsForPath(const Common::Path &path) const {
 	if (unzLocateFile(_zipFile, path, 2) != UNZ_OK)
 		return Common::SharedArchiveContents();
+
+	if (_streamThreshold) {
+		// Big members are not kept in memory, but decompressed as they are read
+		SeekableReadStream *stream = unzOpenCurrentFileStream(_zipFile, _streamThreshold, kZipCheckpointInterval);
+		if (stream)
+			return Common::SharedArchiveContents::bypass(stream);
+	}
 #ifndef USE_ZLIB
 	return unzOpenCurrentFile(_zipFile, _crc);
 #else
@@ -1130,6 +1179,10 @@ Archive *makeZipArchive(const FSNode &node, bool flattenTree) {
 }
 
 Archive *makeZipArchive(SeekableReadStream *stream, bool flattenTree) {
+	return makeZipArchive(stream, flattenTree, 0);
+}
+
+Archive *makeZipArchive(SeekableReadStream *stream, bool flattenTree, uint32 streamThreshold) {
 	if (!stream)
 		return nullptr;
 	unzFile zipFile = unzOpen(stream, flattenTree);
@@ -1138,7 +1191,7 @@ Archive *makeZipArchive(SeekableReadStream *stream, bool flattenTree) {
 		// goes wrong.
 		return nullptr;
 	}
-	return new ZipArchive(zipFile, flattenTree);
+	return new ZipArchive(zipFile, flattenTree, streamThreshold);
 }
 
 } // End of namespace Common
@@ -65,6 +65,19 @@ Archive *makeZipArchive(const FSNode &node, bool flattenTree = false);
  */
 Archive *makeZipArchive(SeekableReadStream *stream, bool flattenTree = false);
 
+/**
+ * Same as above, but deflated members bigger than streamThreshold bytes are not
+ * decompressed into memory as a whole when opened. They are decompressed on the
+ * fly instead, with checkpoints allowing to seek without restarting from the
+ * start of the member. This suits big audio and video files.
+ *
+ * Streams of such members read from the archive stream, so they must not
+ * outlive the archive. Their CRC is not checked.
+ *
+ * May return 0 in case of a failure. In this case stream will still be deleted.
+ */
+Archive *makeZipArchive(SeekableReadStream *stream, bool flattenTree, uint32 streamThreshold);
+
 /** @} */
 
 } // End of namespace Common
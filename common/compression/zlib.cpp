@@ -33,6 +33,7 @@
 
 #include "common/compression/deflate.h"
 
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -89,15 +90,34 @@ bool inflateZlibHeaderless(byte *dst, uint *dstLen, const byte *src, uint srcLen
 static bool _shownBackwardSeekingWarning = false;
 #endif
 
+// inflateGetDictionary, which is used to snapshot the window at a
+// checkpoint, was added in zlib 1.2.8.
+#if ZLIB_VERNUM >= 0x1280
+#define ZLIB_HAS_CHECKPOINTS
+#endif
+
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
  * Assumes the compressed data to be in gzip format.
+ *
+ * If a checkpoint interval is given, the stream remembers the decompressor state
+ * at deflate block boundaries roughly every that many bytes of output. Seeking
+ * then resumes from the nearest checkpoint instead of from the start.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		WINSIZE = 32768			// Size of the deflate window
+	};
+
+	struct Checkpoint {
+		uint32 outPos;			// Position in the uncompressed data
+		uint64 inPos;			// Position of the next input byte in the wrapped stream
+		int bits;				// Unused bits of the byte at inPos - 1, 0 if none
+		uint windowSize;
+		byte *window;			// Last WINSIZE bytes of output, needed to resume
 	};
 
 	byte	_buf[BUFSIZE];
@@ -105,14 +125,18 @@ protected:
 	DisposablePtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
 	int _zlibErr;
+	int _windowBits;
 	uint64 _parentPos;
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
 
+	uint32 _checkpointInterval;
+	Array<Checkpoint> _checkpoints;
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize) : _wrapped(w, disposeParent), _stream() {
+	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize, uint32 checkpointInterval) : _wrapped(w, disposeParent), _stream() {
 		assert(w != nullptr);
 
 		_parentPos = w->pos();
@@ -133,13 +157,15 @@ public:
 		w->seek(_parentPos, SEEK_SET);
 		_pos = 0;
 		_eos = false;
+		setCheckpointInterval(checkpointInterval);
 
 		// Adding 32 to windowBits indicates to zlib that it is supposed to
 		// automatically detect whether gzip or zlib headers are used for
 		// the compressed file. This feature was added in zlib 1.2.0.4,
 		// released 10 August 2003.
 		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_windowBits = MAX_WBITS + 32;
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -148,7 +174,7 @@ public:
 		_stream.avail_in = 0;
 	}
 
-	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize, const byte *dict, uint dictLen) : _wrapped(w, disposeParent), _stream() {
+	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize, const byte *dict, uint dictLen, uint32 checkpointInterval) : _wrapped(w, disposeParent), _stream() {
 		assert(w != nullptr);
 
 		_parentPos = w->pos();
@@ -158,8 +184,10 @@ public:
 		_origSize = knownSize;
 		_pos = 0;
 		_eos = false;
+		setCheckpointInterval(checkpointInterval);
 
-		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		_windowBits = -MAX_WBITS;
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -177,6 +205,9 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+
+		for (auto &checkpoint : _checkpoints)
+			delete[] checkpoint.window;
 	}
 
 	bool err() const override { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -196,7 +227,16 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+
+			if (!_checkpointInterval) {
+				_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+				continue;
+			}
+
+			// Stop at each block boundary to see whether it is time for a checkpoint
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+			if (_zlibErr == Z_OK && (_stream.data_type & 128) && !(_stream.data_type & 64))
+				addCheckpoint(_pos + dataSize - _stream.avail_out);
 		}
 
 		// Update the position counter
@@ -236,7 +276,13 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
+		const Checkpoint *checkpoint = findCheckpoint(newPos);
+		if (checkpoint && (checkpoint->outPos > _pos || (uint32)newPos < _pos)) {
+			// Resume from the closest checkpoint, either because we have to go
+			// back or because it saves decompressing data we would skip anyway.
+			if (!restoreCheckpoint(*checkpoint))
+				return false;
+		} else if ((uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
 			// to avoid it. :/
@@ -253,7 +299,12 @@ public:
 
 			_pos = 0;
 			_wrapped->seek(_parentPos, SEEK_SET);
+#ifdef ZLIB_HAS_CHECKPOINTS
+			// A restored checkpoint may have left the stream in raw deflate mode
+			_zlibErr = inflateReset2(&_stream, _windowBits);
+#else
 			_zlibErr = inflateReset(&_stream);
+#endif
 			if (_zlibErr != Z_OK)
 				return false; // FIXME: STREAM REWRITE
 			_stream.next_in = _buf;
@@ -273,6 +324,86 @@ public:
 		_eos = false;
 		return true; // FIXME: STREAM REWRITE
 	}
+
+private:
+	void setCheckpointInterval(uint32 checkpointInterval) {
+#ifdef ZLIB_HAS_CHECKPOINTS
+		_checkpointInterval = checkpointInterval;
+#else
+		_checkpointInterval = 0;
+#endif
+	}
+
+	void addCheckpoint(uint32 outPos) {
+#ifdef ZLIB_HAS_CHECKPOINTS
+		// Checkpoints are only added past the last one: when decompressing again
+		// after a seek, we are going over already indexed data.
+		if (!_checkpoints.empty() && outPos < _checkpoints.back().outPos + _checkpointInterval)
+			return;
+
+		Checkpoint checkpoint;
+		checkpoint.outPos = outPos;
+		checkpoint.inPos = _wrapped->pos() - _stream.avail_in;
+		checkpoint.bits = _stream.data_type & 7;
+		checkpoint.window = new byte[WINSIZE];
+		checkpoint.windowSize = WINSIZE;
+		if (inflateGetDictionary(&_stream, checkpoint.window, &checkpoint.windowSize) != Z_OK) {
+			delete[] checkpoint.window;
+			return;
+		}
+
+		_checkpoints.push_back(checkpoint);
+#endif
+	}
+
+	/** Return the last checkpoint at or before the given position. */
+	const Checkpoint *findCheckpoint(uint32 outPos) const {
+		if (_checkpoints.empty() || _checkpoints.front().outPos > outPos)
+			return nullptr;
+
+		// Checkpoints are sorted by position, so do a binary search
+		uint lo = 0, hi = _checkpoints.size();
+		while (hi - lo > 1) {
+			uint mid = (lo + hi) / 2;
+			if (_checkpoints[mid].outPos <= outPos)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		return &_checkpoints[lo];
+	}
+
+	bool restoreCheckpoint(const Checkpoint &checkpoint) {
+#ifdef ZLIB_HAS_CHECKPOINTS
+		// Checkpoints are taken at block boundaries past the gzip/zlib header,
+		// so decompression resumes in raw deflate mode.
+		_zlibErr = inflateReset2(&_stream, -MAX_WBITS);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		if (checkpoint.bits) {
+			// The first bits of the block are in the previous byte
+			_wrapped->seek(checkpoint.inPos - 1, SEEK_SET);
+			byte b = _wrapped->readByte();
+			_zlibErr = inflatePrime(&_stream, checkpoint.bits, b >> (8 - checkpoint.bits));
+		} else {
+			_wrapped->seek(checkpoint.inPos, SEEK_SET);
+		}
+
+		if (_zlibErr == Z_OK && checkpoint.windowSize)
+			_zlibErr = inflateSetDictionary(&_stream, checkpoint.window, checkpoint.windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		_pos = checkpoint.outPos;
+		return true;
+#else
+		return false;
+#endif
+	}
 };
 
 /**
@@ -385,7 +516,7 @@ public:
 	int64 pos() const override { return _pos; }
 };
 
-SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, DisposeAfterUse::Flag disposeParent, uint64 knownSize) {
+SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, DisposeAfterUse::Flag disposeParent, uint64 knownSize, uint32 checkpointInterval) {
 	if (!toBeWrapped) {
 		return nullptr;
 	}
@@ -403,12 +534,12 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, Di
 			      header % 31 == 0));
 	toBeWrapped->seek(-2, SEEK_CUR);
 	if (isCompressed) {
-		return new GZipReadStream(toBeWrapped, disposeParent, knownSize);
+		return new GZipReadStream(toBeWrapped, disposeParent, knownSize, checkpointInterval);
 	}
 	return toBeWrapped;
 }
 
-SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, DisposeAfterUse::Flag disposeParent, uint64 knownSize, const byte *dict, uint dictLen) {
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, DisposeAfterUse::Flag disposeParent, uint64 knownSize, const byte *dict, uint dictLen, uint32 checkpointInterval) {
 	if (!toBeWrapped) {
 		return nullptr;
 	}
@@ -419,7 +550,7 @@ SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, Dispo
 		}
 		return nullptr;
 	}
-	return new GZipReadStream(toBeWrapped, disposeParent, knownSize, dict, dictLen);
+	return new GZipReadStream(toBeWrapped, disposeParent, knownSize, dict, dictLen, checkpointInterval);
 }
 
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
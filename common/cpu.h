@@ -0,0 +1,76 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_CPU_H
+#define COMMON_CPU_H
+
+#include "common/scummsys.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_cpu CPU features
+ * @ingroup common
+ *
+ * @brief Functions telling whether optional instruction sets can be used.
+ *
+ * These are meant for choosing between the SIMD and the generic versions
+ * of a function. They are only declared when the code for the instruction
+ * set is built, see the SCUMMVM_NEON, SCUMMVM_SSE2 and SCUMMVM_AVX2 defines.
+ *
+ * Mixers, scalers and the like may pick their functions before the backend
+ * can answer OSystem::hasFeature(), so the backend is only asked when the
+ * instructions are not always there on the target architecture.
+ * @{
+ */
+
+#ifdef SCUMMVM_NEON
+inline bool hasNEON() {
+#if defined(__aarch64__)
+	return true;
+#else
+	return g_system->hasFeature(OSystem::kFeatureCpuNEON);
+#endif
+}
+#endif
+
+#ifdef SCUMMVM_SSE2
+inline bool hasSSE2() {
+#if defined(__x86_64__) || defined(_M_X64)
+	return true;
+#else
+	return g_system->hasFeature(OSystem::kFeatureCpuSSE2);
+#endif
+}
+#endif
+
+#ifdef SCUMMVM_AVX2
+inline bool hasAVX2() {
+	return g_system->hasFeature(OSystem::kFeatureCpuAVX2);
+}
+#endif
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -73,6 +73,21 @@ bool File::open(const FSNode &node) {
 	return open(stream, node.getPath().toString(Common::Path::kNativeSeparator));
 }
 
+bool File::openMapped(const FSNode &node) {
+	assert(!_handle);
+
+	if (!node.exists()) {
+		warning("File::openMapped: node does not exist");
+		return false;
+	} else if (node.isDirectory()) {
+		warning("File::openMapped: '%s' is a directory", node.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return false;
+	}
+
+	SeekableReadStream *stream = node.createMappedReadStream();
+	return open(stream, node.getPath().toString(Common::Path::kNativeSeparator));
+}
+
 bool File::open(SeekableReadStream *stream, const String &name) {
 	assert(!_handle);
 
@@ -95,6 +95,18 @@ public:
 	 */
 	virtual bool open(const FSNode &node);
 
+	/**
+	 * Try to open the file corresponding to the given node through a memory mapping,
+	 * so that reading from it does not copy the data into an intermediate buffer.
+	 * Falls back to a regular stream if the backend cannot map the file.
+	 * @note Must not be called if this file already is open (i.e. if isOpen returns true).
+	 * @note The file must not be truncated while it is open, see FSNode::createMappedReadStream.
+	 *
+	 * @param   node        The node to consider.
+	 * @return	True if the file was opened successfully, false otherwise.
+	 */
+	bool openMapped(const FSNode &node);
+
 	/**
 	 * Try to 'open' the given stream. That is, wrap around it, and if the stream
 	 * is a NULL pointer, gracefully treat this as if opening failed.
@@ -0,0 +1,634 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The flat hash map in this file uses open addressing with linear probing
+// and one control byte per slot, in the spirit of the "Swiss tables" of
+// Abseil. Unlike HashMap, keys and values are stored inline in one array.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/hashmap.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_flathashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on a flat hash table.
+ *
+ * @{
+ */
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val,
+ * with the same interface as HashMap.
+ *
+ * Whereas HashMap allocates one node per entry and stores pointers to
+ * those nodes, FlatHashMap stores its nodes inline in a single array and
+ * keeps a separate array of control bytes, one per slot. Each control byte
+ * either marks the slot as empty or deleted, or holds seven bits of the
+ * hash of the key stored in the slot. Probing mostly touches the control
+ * bytes, and the key comparison is only done when those bits match. This
+ * makes lookups much more cache friendly, especially for misses.
+ *
+ * Differences to HashMap:
+ * - Inserting a new key may move all nodes when the storage grows, which
+ *   invalidates iterators as well as references to keys and values.
+ *   Erasing never moves nodes, so erasing while iterating is fine.
+ * - Val must be copy constructible, not only assignable.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+		Node(const Node &node) : _value(node._value), _key(node._key) {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage may fill up (counting deleted slots) before
+		// being rehashed.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 3,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 4
+	};
+
+	enum {
+		kCtrlEmpty = 0x80,
+		kCtrlDeleted = 0xFE
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	byte *_ctrl;		///< Control bytes, one per slot.
+	Node *_nodes;		///< Uninitialized storage for capacity nodes.
+	size_type _mask;	///< Capacity minus one; the capacity is a power of two
+	size_type _shift;	///< 32 minus log2 of the capacity
+	size_type _size;
+	size_type _deleted;	///< Number of deleted slots
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Spread the bits of the hash with a Fibonacci multiplication, so that
+	 * weak hashes (like the identity for integers) still use all slots.
+	 */
+	static uint32 mixHash(size_type hash) {
+		return (uint32)hash * 0x9E3779B1U;
+	}
+
+	static byte hashTag(uint32 mixed) {
+		return mixed & 0x7F;
+	}
+
+	size_type hashIndex(uint32 mixed) const {
+		return (mixed >> _shift) & _mask;
+	}
+
+	bool isFull(size_type idx) const {
+		return (_ctrl[idx] & 0x80) == 0;
+	}
+
+	void allocStorage(size_type capacity);
+	void destroyNodes();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	size_type insertNew(const Key &key);
+	size_type findFreeSlot(uint32 mixed) const;
+	void rehash(size_type newCapacity);
+	void eraseAt(size_type idx);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->isFull(_idx));
+			return &_hashmap->_nodes[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && !_hashmap->isFull(_idx));
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		destroyNodes();
+		free(_nodes);
+		delete[] _ctrl;
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getOrCreateVal(const Key &key);
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getValOrDefault(const Key &key) const;
+	const Val &getValOrDefault(const Key &key, const Val &defaultVal) const;
+	bool tryGetVal(const Key &key, Val &out) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+	void reserve(size_type count);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) :
+	_defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	destroyNodes();
+	free(_nodes);
+	delete[] _ctrl;
+}
+
+/**
+ * Internal method for allocating empty storage of the given capacity.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= FLATHASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_mask = capacity - 1;
+	_shift = 32;
+	for (size_type c = capacity; c > 1; c >>= 1)
+		_shift--;
+
+	_ctrl = new byte[capacity];
+	memset(_ctrl, kCtrlEmpty, capacity);
+	_nodes = (Node *)malloc(sizeof(Node) * capacity);
+	if (!_nodes)
+		::error("Common::FlatHashMap: failure to allocate %u bytes", capacity * (size_type)sizeof(Node));
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::destroyNodes() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(ctr))
+			_nodes[ctr].~Node();
+	}
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// The hash functions are the same, so the slots can be copied as is.
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(ctr))
+			new ((void *)&_nodes[ctr]) Node(map._nodes[ctr]);
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	destroyNodes();
+
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		free(_nodes);
+		delete[] _ctrl;
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+	} else {
+		memset(_ctrl, kCtrlEmpty, _mask + 1);
+		_size = 0;
+		_deleted = 0;
+	}
+}
+
+/**
+ * Make sure that @p count elements can be stored without rehashing.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::reserve(size_type count) {
+	size_type capacity = _mask + 1;
+	while (count * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+		capacity *= 2;
+	if (capacity > _mask + 1)
+		rehash(capacity);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(uint32 mixed) const {
+	size_type ctr = hashIndex(mixed);
+	while (isFull(ctr))
+		ctr = (ctr + 1) & _mask;
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+#ifndef RELEASE_BUILD
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	byte *old_ctrl = _ctrl;
+	Node *old_nodes = _nodes;
+
+	allocStorage(newCapacity);
+
+	// Move all the old elements into the new storage. Since we know that
+	// no key exists twice in the old table, we don't have to call _equal().
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] & 0x80)
+			continue;
+
+		const uint32 mixed = mixHash(_hash(old_nodes[ctr]._key));
+		const size_type idx = findFreeSlot(mixed);
+		_ctrl[idx] = hashTag(mixed);
+		new ((void *)&_nodes[idx]) Node(old_nodes[ctr]);
+		old_nodes[ctr].~Node();
+		_size++;
+	}
+
+#ifndef RELEASE_BUILD
+	// Perform a sanity check: Old number of elements should match the new one!
+	assert(_size == old_size);
+#endif
+
+	free(old_nodes);
+	delete[] old_ctrl;
+}
+
+/**
+ * Return the slot of @p key, or a value larger than _mask if it is not present.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 mixed = mixHash(_hash(key));
+	const byte tag = hashTag(mixed);
+	size_type ctr = hashIndex(mixed);
+	for (;;) {
+		const byte ctrl = _ctrl[ctr];
+		if (ctrl == tag && _equal(_nodes[ctr]._key, key))
+			return ctr;
+		if (ctrl == kCtrlEmpty)
+			return (size_type)-1;
+		ctr = (ctr + 1) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are
+	// also counted. If most of the used slots are deleted ones, it is
+	// enough to rehash in place.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 > capacity)
+			capacity = capacity < 512 ? (capacity * 4) : (capacity * 2);
+
+		// The key may refer to a value stored in this map, which is moved
+		// by the rehash
+		const Key keyCopy(key);
+		rehash(capacity);
+		return insertNew(keyCopy);
+	}
+
+	return insertNew(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::insertNew(const Key &key) {
+	const uint32 mixed = mixHash(_hash(key));
+	const size_type ctr = findFreeSlot(mixed);
+	if (_ctrl[ctr] == kCtrlDeleted)
+		_deleted--;
+	_ctrl[ctr] = hashTag(mixed);
+	new ((void *)&_nodes[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseAt(size_type ctr) {
+	_nodes[ctr].~Node();
+	_size--;
+
+	// A slot followed by an empty one is not part of any probe sequence
+	// which continues after it, so it can be marked empty right away.
+	if (_ctrl[(ctr + 1) & _mask] == kCtrlEmpty) {
+		_ctrl[ctr] = kCtrlEmpty;
+	} else {
+		_ctrl[ctr] = kCtrlDeleted;
+		_deleted++;
+	}
+}
+
+/**
+ * Check whether the hashmap contains the given key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getOrCreateVal(key);
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+/**
+ * Get a value from the hashmap, creating it if it is not present.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getOrCreateVal(const Key &key) {
+	// The lookup may reallocate the storage, so it has to be done first
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	return _nodes[ctr]._value;
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _nodes[ctr]._value;
+	else
+		// See comment in HashMap::getVal().
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _nodes[ctr]._value;
+	else
+		// See comment in HashMap::getVal().
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key) const {
+	return getValOrDefault(key, _defaultVal);
+}
+
+/**
+ * Get a value from the hashmap. If the key is not present, then return @p defaultVal.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _nodes[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::tryGetVal(const Key &key, Val &out) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask) {
+		out = _nodes[ctr]._value;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * Assign an element specified by @p key to a value @p val.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask) {
+		_nodes[ctr]._value = val;
+		return;
+	}
+
+	// Inserting may move the nodes, and val may refer to one of them
+	const Val valCopy(val);
+	ctr = lookupAndCreateIfMissing(key);
+	_nodes[ctr]._value = valCopy;
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	assert(entry._idx <= _mask);
+	assert(isFull(entry._idx));
+
+	eraseAt(entry._idx);
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		eraseAt(ctr);
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -233,6 +233,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileInfo(int64 &size, int64 &modificationTime) const {
+	return _realNode && _realNode->getFileInfo(size, modificationTime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == nullptr)
 		return nullptr;
@@ -248,6 +252,24 @@ SeekableReadStream *FSNode::createReadStream() const {
 	return _realNode->createReadStream();
 }
 
+SeekableReadStream *FSNode::createMappedReadStream() const {
+	if (_realNode == nullptr)
+		return nullptr;
+
+	if (!_realNode->exists()) {
+		warning("FSNode::createMappedReadStream: '%s' does not exist", getName().c_str());
+		return nullptr;
+	} else if (_realNode->isDirectory()) {
+		warning("FSNode::createMappedReadStream: '%s' is a directory", getName().c_str());
+		return nullptr;
+	}
+
+	SeekableReadStream *stream = _realNode->createMappedReadStream();
+	if (!stream)
+		stream = _realNode->createReadStream();
+	return stream;
+}
+
 SeekableReadStream *FSNode::createReadStreamForAltStream(AltStreamType altStreamType) const {
 	if (_realNode == nullptr)
 		return nullptr;
@@ -293,26 +315,26 @@ bool FSNode::createDirectory() const {
 
 FSDirectory::FSDirectory(const FSNode &node, int depth, bool flat, bool ignoreClashes, bool includeDirectories)
   : _node(node), _cached(false), _depth(depth), _flat(flat), _ignoreClashes(ignoreClashes),
-	_includeDirectories(includeDirectories) {
+	_includeDirectories(includeDirectories), _useMappedStreams(false) {
 }
 
 FSDirectory::FSDirectory(const Path &prefix, const FSNode &node, int depth, bool flat,
 						 bool ignoreClashes, bool includeDirectories)
   : _node(node), _cached(false), _depth(depth), _flat(flat), _ignoreClashes(ignoreClashes),
-	_includeDirectories(includeDirectories) {
+	_includeDirectories(includeDirectories), _useMappedStreams(false) {
 
 	setPrefix(prefix);
 }
 
 FSDirectory::FSDirectory(const Path &name, int depth, bool flat, bool ignoreClashes, bool includeDirectories)
   : _node(name), _cached(false), _depth(depth), _flat(flat), _ignoreClashes(ignoreClashes),
-	_includeDirectories(includeDirectories) {
+	_includeDirectories(includeDirectories), _useMappedStreams(false) {
 }
 
 FSDirectory::FSDirectory(const Path &prefix, const Path &name, int depth, bool flat,
 						 bool ignoreClashes, bool includeDirectories)
   : _node(name), _cached(false), _depth(depth), _flat(flat), _ignoreClashes(ignoreClashes),
-	_includeDirectories(includeDirectories) {
+	_includeDirectories(includeDirectories), _useMappedStreams(false) {
 
 	setPrefix(prefix);
 }
@@ -333,8 +355,9 @@ FSNode *FSDirectory::lookupCache(NodeCache &cache, const Path &name) const {
 	if (!name.empty()) {
 		ensureCached();
 
-		if (cache.contains(name))
-			return &cache[name];
+		NodeCache::iterator it = cache.find(name);
+		if (it != cache.end())
+			return &it->_value;
 	}
 
 	return nullptr;
@@ -383,7 +406,7 @@ SeekableReadStream *FSDirectory::createReadStreamForMember(const Path &path) con
 
 	debug(5, "FSDirectory::createReadStreamForMember('%s') -> '%s'", path.toString(Common::Path::kNativeSeparator).c_str(), node->getPath().toString(Common::Path::kNativeSeparator).c_str());
 
-	SeekableReadStream *stream = node->createReadStream();
+	SeekableReadStream *stream = _useMappedStreams ? node->createMappedReadStream() : node->createReadStream();
 	if (!stream)
 		warning("FSDirectory::createReadStreamForMember: Can't create stream for file '%s'", Common::toPrintable(path.toString(Common::Path::kNativeSeparator)).c_str());
 
@@ -420,7 +443,9 @@ FSDirectory *FSDirectory::getSubDirectory(const Path &prefix, const Path &name,
 	if (!node)
 		return nullptr;
 
-	return new FSDirectory(prefix, *node, depth, flat, ignoreClashes);
+	FSDirectory *dir = new FSDirectory(prefix, *node, depth, flat, ignoreClashes);
+	dir->setUseMappedStreams(_useMappedStreams);
+	return dir;
 }
 
 void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const Path& prefix) const {
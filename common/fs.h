@@ -24,6 +24,7 @@
 
 #include "common/array.h"
 #include "common/archive.h"
+#include "common/flathashmap.h"
 #include "common/hash-str.h"
 #include "common/hashmap.h"
 #include "common/ptr.h"
@@ -252,6 +253,17 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the last modification time of the file referred
+	 * by this node without opening it. Not all backends support this.
+	 *
+	 * @param size              Set to the size of the file in bytes.
+	 * @param modificationTime  Set to a backend specific timestamp, which
+	 *                          changes whenever the file is modified.
+	 * @return True if the information could be retrieved, false otherwise.
+	 */
+	bool getFileInfo(int64 &size, int64 &modificationTime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -271,6 +283,21 @@ public:
 	 */
 	SeekableReadStream *createReadStreamForAltStream(AltStreamType altStreamType) const override;
 
+	/**
+	 * Create a SeekableReadStream instance which views a memory mapping of
+	 * the file referred by this node instead of reading it through a buffer.
+	 * This avoids holding a second copy of large resource files in memory.
+	 * If the backend cannot map the file, a regular read stream is returned.
+	 *
+	 * @note The file must not be truncated while the stream exists. Reading
+	 *       the part of the mapping past the new end of the file raises SIGBUS
+	 *       on most systems, which terminates ScummVM. Only map files which do
+	 *       not change while they are used, such as game data files.
+	 *
+	 * @return Pointer to the stream object, nullptr in case of a failure.
+	 */
+	SeekableReadStream *createMappedReadStream() const;
+
 	/**
 	 * Create a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -344,13 +371,16 @@ class FSDirectory : public Archive {
 	bool _flat;
 	bool _ignoreClashes;
 	bool _includeDirectories;
+	bool _useMappedStreams;
 
 	Path	_prefix; // string that is prepended to each cache item key
 	void setPrefix(const Path &prefix);
 
 	// Caches are case insensitive, clashes are dealt with when creating
 	// Key is stored in lowercase.
-	typedef HashMap<Path, FSNode, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> NodeCache;
+	// The node caches are filled once and then looked up a lot, which is
+	// where the flat storage of FlatHashMap pays off.
+	typedef FlatHashMap<Path, FSNode, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> NodeCache;
 	typedef HashMap<Path, Array<String>, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> NodeMapCache;
 	mutable NodeCache	_fileCache, _subDirCache;
 	mutable NodeMapCache	_fileMapCache, _dirMapCache;
@@ -412,6 +442,14 @@ public:
 	FSDirectory *getSubDirectory(const Path &prefix, const Path &name, int depth = 1,
 	                             bool flat = false, bool ignoreClashes = false);
 
+	/**
+	 * Serve members through memory mapped streams (see FSNode::createMappedReadStream)
+	 * instead of buffered file streams. Subdirectories created by getSubDirectory
+	 * inherit this setting. As mapped files must not be truncated while in use,
+	 * only enable this for directories of game data.
+	 */
+	void setUseMappedStreams(bool useMappedStreams) { _useMappedStreams = useMappedStreams; }
+
 	/**
 	 * Check for the existence of a file in the cache. A full match of relative path and file name
 	 * is needed for success.
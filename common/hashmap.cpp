@@ -51,6 +51,15 @@ uint hashit_lower(const char *p) {
 	return hash ^ size;
 }
 
+// Like hashit_lower, but for the first len chars of a string which doesn't
+// need to be null terminated.
+uint hashit_lower(const char *p, uint len) {
+	uint hash = len ? tolower(*p) << 7 : 0;
+	for (uint i = 0; i < len; i++)
+		hash = (1000003 * hash) ^ tolower((byte)p[i]);
+	return hash ^ len;
+}
+
 
 template<> void unknownKeyError(::Common::String key) {
 	error("Unknown key \"%s\"", key.c_str());
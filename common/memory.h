@@ -96,6 +96,24 @@ void uninitialized_fill_n(Type *dst, size_t n, const Value &x) {
 		new ((void *)dst++) Type(x);
 }
 
+/**
+ * The default allocator of the containers, using malloc() and free().
+ *
+ * An allocator provides uninitialized storage for @p count objects of type
+ * @p T with allocate(), and returns nullptr on failure. deallocate() is
+ * given the same @p count as the matching allocate() call.
+ */
+template<class T>
+struct DefaultAllocator {
+	T *allocate(size_t count) {
+		return (T *)malloc(sizeof(T) * count);
+	}
+
+	void deallocate(T *ptr, size_t count) {
+		free(ptr);
+	}
+};
+
 /** @} */
 
 } // End of namespace Common
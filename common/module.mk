@@ -2,6 +2,7 @@ MODULE := common
 
 MODULE_OBJS := \
 	archive.o \
+	arena.o \
 	base64.o \
 	btea.o \
 	concatstream.o \
@@ -39,6 +40,7 @@ MODULE_OBJS := \
 	str-enc.o \
 	encodings/singlebyte.o \
 	system.o \
+	taskpool.o \
 	textconsole.o \
 	text-to-speech.o \
 	tokenizer.o \
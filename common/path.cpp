@@ -1117,6 +1117,13 @@ static String getIdentifierComponent(const String &in) {
 	return part;
 }
 
+// In unescaped paths, no component contains a separator, so the identifier
+// of a component is the component itself unless it is punycode encoded.
+// This allows hashing and comparing these components in place.
+static inline bool isPunycodeComponent(const char *str, const char *end) {
+	return end - str >= 4 && !strncmp(str, "xn--", 4);
+}
+
 uint Path::hash() const {
 	return hashit(_str.c_str());
 }
@@ -1136,6 +1143,33 @@ struct hasher {
 
 uint Path::hashIgnoreCaseAndMac() const {
 	hasher v = { 0x345678, 1000003 };
+	if (!isEscaped()) {
+		// Fast path used by most lookups: no allocation unless a component
+		// needs to be punycode decoded
+		if (_str.empty())
+			return v.result;
+
+		const char *str = _str.c_str();
+		const char *end = str + _str.size();
+		for (;;) {
+			const char *sep = strchr(str, SEPARATOR);
+			const char *itemEnd = sep ? sep : end;
+
+			uint hash;
+			if (isPunycodeComponent(str, itemEnd))
+				hash = hashit_lower(getIdentifierComponent(String(str, itemEnd)));
+			else
+				hash = hashit_lower(str, itemEnd - str);
+
+			v.result = (v.result + hash) * v.mult;
+			v.mult = (v.mult * 69069);
+
+			if (!sep)
+				return v.result;
+			str = sep + 1;
+		}
+	}
+
 	reduceComponents<hasher &>(
 		[](hasher &value, const String &in, bool last) -> hasher & {
 			uint hash = hashit_lower(getIdentifierComponent(in));
@@ -1159,6 +1193,37 @@ bool Path::equalsIgnoreCase(const Path &other) const {
 }
 
 bool Path::equalsIgnoreCaseAndMac(const Path &other) const {
+	if (!isEscaped() && !other.isEscaped()) {
+		// Fast path, see hashIgnoreCaseAndMac()
+		if (_str.empty() || other._str.empty())
+			return _str.empty() == other._str.empty();
+
+		const char *str = _str.c_str();
+		const char *end = str + _str.size();
+		const char *strOther = other._str.c_str();
+		const char *endOther = strOther + other._str.size();
+		for (;;) {
+			const char *sep = strchr(str, SEPARATOR);
+			const char *sepOther = strchr(strOther, SEPARATOR);
+			const char *itemEnd = sep ? sep : end;
+			const char *itemEndOther = sepOther ? sepOther : endOther;
+
+			if (isPunycodeComponent(str, itemEnd) || isPunycodeComponent(strOther, itemEndOther)) {
+				if (!getIdentifierComponent(String(str, itemEnd)).equalsIgnoreCase(
+				        getIdentifierComponent(String(strOther, itemEndOther))))
+					return false;
+			} else if (itemEnd - str != itemEndOther - strOther ||
+			           scumm_strnicmp(str, strOther, itemEnd - str)) {
+				return false;
+			}
+
+			if (!sep || !sepOther)
+				return sep == sepOther;
+			str = sep + 1;
+			strOther = sepOther + 1;
+		}
+	}
+
 	return compareComponents(
 		[](const String &x, const String &y) {
 			return getIdentifierComponent(x).equalsIgnoreCase(getIdentifierComponent(y));
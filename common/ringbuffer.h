@@ -0,0 +1,383 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_RINGBUFFER_H
+#define COMMON_RINGBUFFER_H
+
+#include "common/scummsys.h"
+#include "common/algorithm.h"
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+
+#ifdef NO_CXX11_ATOMIC
+#include "common/mutex.h"
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_ringbuffer Lock-free ring buffers
+ * @ingroup common
+ *
+ * @brief Bounded lock-free queues for passing data between threads.
+ *
+ * These are meant for handing data over to threads which must not block,
+ * like the audio callback. Both never allocate after construction; push()
+ * fails when the buffer is full, and it is up to the caller to decide how
+ * to handle that.
+ *
+ * Without C++11 atomics (NO_CXX11_ATOMIC), both are implemented with an
+ * OSystem mutex instead, keeping the same interface.
+ * @{
+ */
+
+/**
+ * Round @p capacity up to the next power of two, with a minimum of 2.
+ */
+inline uint ringBufferCapacity(uint capacity) {
+	uint result = 2;
+	while (result < capacity)
+		result <<= 1;
+	return result;
+}
+
+/**
+ * Copy @p count items to the ring @p buffer, starting at position @p pos,
+ * wrapping around at the end.
+ */
+template<class T>
+inline void copyToRingBuffer(T *buffer, uint mask, uint pos, const T *items, uint count) {
+	const uint first = MIN(count, mask + 1 - (pos & mask));
+	copy(items, items + first, buffer + (pos & mask));
+	copy(items + first, items + count, buffer);
+}
+
+/**
+ * Copy @p count items from the ring @p buffer, starting at position
+ * @p pos, wrapping around at the end.
+ */
+template<class T>
+inline void copyFromRingBuffer(const T *buffer, uint mask, uint pos, T *items, uint count) {
+	const uint first = MIN(count, mask + 1 - (pos & mask));
+	copy(buffer + (pos & mask), buffer + (pos & mask) + first, items);
+	copy(buffer, buffer + count - first, items + first);
+}
+
+#ifndef NO_CXX11_ATOMIC
+
+/**
+ * Wait-free ring buffer for exactly one producer thread and one consumer
+ * thread.
+ *
+ * push() must only be called from the producer and pop() only from the
+ * consumer. The release store of the write position in push() makes the
+ * pushed item visible to the consumer once it sees the new position, and
+ * the same goes for the read position and reusing the slot.
+ *
+ * T needs to be default constructible and assignable.
+ */
+template<class T>
+class SPSCRingBuffer : NonCopyable {
+public:
+	/** Create a ring buffer for at least @p capacity items. */
+	explicit SPSCRingBuffer(uint capacity) : _mask(ringBufferCapacity(capacity) - 1), _head(0), _tail(0) {
+		_buffer = new T[_mask + 1];
+	}
+
+	~SPSCRingBuffer() {
+		delete[] _buffer;
+	}
+
+	/**
+	 * Append @p item. Only to be called by the producer.
+	 *
+	 * @return False if the buffer is full.
+	 */
+	bool push(const T &item) {
+		const uint head = _head.load(kMemoryOrderRelaxed);
+		if (head - _tail.load(kMemoryOrderAcquire) > _mask)
+			return false;
+
+		_buffer[head & _mask] = item;
+		_head.store(head + 1, kMemoryOrderRelease);
+		return true;
+	}
+
+	/**
+	 * Remove the oldest item and store it in @p item. Only to be called by
+	 * the consumer.
+	 *
+	 * @return False if the buffer is empty.
+	 */
+	bool pop(T &item) {
+		const uint tail = _tail.load(kMemoryOrderRelaxed);
+		if (tail == _head.load(kMemoryOrderAcquire))
+			return false;
+
+		item = _buffer[tail & _mask];
+		_tail.store(tail + 1, kMemoryOrderRelease);
+		return true;
+	}
+
+	/**
+	 * Append up to @p count items at once. Only to be called by the
+	 * producer.
+	 *
+	 * @return The number of items appended, less than @p count if the
+	 *         buffer became full.
+	 */
+	uint push(const T *items, uint count) {
+		const uint head = _head.load(kMemoryOrderRelaxed);
+		count = MIN(count, _mask + 1 - (head - _tail.load(kMemoryOrderAcquire)));
+
+		copyToRingBuffer(_buffer, _mask, head, items, count);
+		_head.store(head + count, kMemoryOrderRelease);
+		return count;
+	}
+
+	/**
+	 * Remove up to @p count of the oldest items at once and store them in
+	 * @p items. Only to be called by the consumer.
+	 *
+	 * @return The number of items removed, less than @p count if the
+	 *         buffer became empty.
+	 */
+	uint pop(T *items, uint count) {
+		const uint tail = _tail.load(kMemoryOrderRelaxed);
+		count = MIN(count, _head.load(kMemoryOrderAcquire) - tail);
+
+		copyFromRingBuffer(_buffer, _mask, tail, items, count);
+		_tail.store(tail + count, kMemoryOrderRelease);
+		return count;
+	}
+
+	/**
+	 * Return the number of items in the buffer. When called while the other
+	 * thread is active, the result may already be outdated.
+	 */
+	uint size() const {
+		return _head.load(kMemoryOrderAcquire) - _tail.load(kMemoryOrderAcquire);
+	}
+
+	bool empty() const { return size() == 0; }
+
+	uint capacity() const { return _mask + 1; }
+
+private:
+	T *_buffer;
+	const uint _mask;
+
+	// Keep both positions on separate cache lines, so that the producer
+	// and the consumer do not invalidate each other's cache all the time.
+	byte _pad0[64];
+	Atomic<uint> _head; ///< Next position to write to, owned by the producer
+	byte _pad1[64];
+	Atomic<uint> _tail; ///< Next position to read from, owned by the consumer
+	byte _pad2[64];
+};
+
+/**
+ * Lock-free ring buffer for any number of producer threads and exactly one
+ * consumer thread.
+ *
+ * Each slot carries a sequence number telling whether it is ready to be
+ * written or read, so producers only contend on the write position, with
+ * a compare-and-swap. This is the bounded queue of Dmitry Vyukov, reduced
+ * to a single consumer.
+ *
+ * T needs to be default constructible and assignable.
+ */
+template<class T>
+class MPSCRingBuffer : NonCopyable {
+public:
+	/** Create a ring buffer for at least @p capacity items. */
+	explicit MPSCRingBuffer(uint capacity) : _mask(ringBufferCapacity(capacity) - 1), _head(0), _tail(0) {
+		_cells = new Cell[_mask + 1];
+		for (uint i = 0; i <= _mask; i++)
+			_cells[i].sequence.store(i, kMemoryOrderRelaxed);
+	}
+
+	~MPSCRingBuffer() {
+		delete[] _cells;
+	}
+
+	/**
+	 * Append @p item. May be called by any thread.
+	 *
+	 * @return False if the buffer is full.
+	 */
+	bool push(const T &item) {
+		Cell *cell;
+		uint pos = _head.load(kMemoryOrderRelaxed);
+		for (;;) {
+			cell = &_cells[pos & _mask];
+			const int32 diff = (int32)(cell->sequence.load(kMemoryOrderAcquire) - pos);
+			if (diff == 0) {
+				// The slot is free, try to claim it
+				if (_head.compareExchange(pos, pos + 1, kMemoryOrderRelaxed))
+					break;
+			} else if (diff < 0) {
+				// The slot still holds an item from the previous round
+				return false;
+			} else {
+				// Another producer claimed the slot
+				pos = _head.load(kMemoryOrderRelaxed);
+			}
+		}
+
+		cell->data = item;
+		cell->sequence.store(pos + 1, kMemoryOrderRelease);
+		return true;
+	}
+
+	/**
+	 * Remove the oldest item and store it in @p item. Only to be called by
+	 * the consumer.
+	 *
+	 * @return False if the buffer is empty, or if the oldest item is still
+	 *         being written by a producer.
+	 */
+	bool pop(T &item) {
+		const uint tail = _tail.load(kMemoryOrderRelaxed);
+		Cell &cell = _cells[tail & _mask];
+		if ((int32)(cell.sequence.load(kMemoryOrderAcquire) - (tail + 1)) < 0)
+			return false;
+
+		item = cell.data;
+		// Hand the slot over to the producers of the next round
+		cell.sequence.store(tail + _mask + 1, kMemoryOrderRelease);
+		_tail.store(tail + 1, kMemoryOrderRelaxed);
+		return true;
+	}
+
+	/**
+	 * Return true if there is no item ready for the consumer. Only to be
+	 * called by the consumer.
+	 */
+	bool empty() const {
+		const uint tail = _tail.load(kMemoryOrderRelaxed);
+		return (int32)(_cells[tail & _mask].sequence.load(kMemoryOrderAcquire) - (tail + 1)) < 0;
+	}
+
+	uint capacity() const { return _mask + 1; }
+
+private:
+	struct Cell {
+		Atomic<uint> sequence;
+		T data;
+	};
+
+	Cell *_cells;
+	const uint _mask;
+
+	byte _pad0[64];
+	Atomic<uint> _head; ///< Next position to write to, shared by the producers
+	byte _pad1[64];
+	Atomic<uint> _tail; ///< Next position to read from, owned by the consumer
+	byte _pad2[64];
+};
+
+#else
+
+template<class T>
+class SPSCRingBuffer : NonCopyable {
+public:
+	explicit SPSCRingBuffer(uint capacity) : _mask(ringBufferCapacity(capacity) - 1), _head(0), _tail(0) {
+		_buffer = new T[_mask + 1];
+	}
+
+	~SPSCRingBuffer() {
+		delete[] _buffer;
+	}
+
+	bool push(const T &item) {
+		StackLock lock(_mutex);
+		if (_head - _tail > _mask)
+			return false;
+
+		_buffer[_head & _mask] = item;
+		_head++;
+		return true;
+	}
+
+	bool pop(T &item) {
+		StackLock lock(_mutex);
+		if (_tail == _head)
+			return false;
+
+		item = _buffer[_tail & _mask];
+		_tail++;
+		return true;
+	}
+
+	uint push(const T *items, uint count) {
+		StackLock lock(_mutex);
+		count = MIN(count, _mask + 1 - (_head - _tail));
+
+		copyToRingBuffer(_buffer, _mask, _head, items, count);
+		_head += count;
+		return count;
+	}
+
+	uint pop(T *items, uint count) {
+		StackLock lock(_mutex);
+		count = MIN(count, _head - _tail);
+
+		copyFromRingBuffer(_buffer, _mask, _tail, items, count);
+		_tail += count;
+		return count;
+	}
+
+	uint size() const {
+		StackLock lock(_mutex);
+		return _head - _tail;
+	}
+
+	bool empty() const { return size() == 0; }
+
+	uint capacity() const { return _mask + 1; }
+
+private:
+	T *_buffer;
+	const uint _mask;
+	Mutex _mutex;
+	uint _head;
+	uint _tail;
+};
+
+/**
+ * With the mutex, there is no difference between one and several
+ * producers. The slot is written before the write position is advanced,
+ * both while holding the mutex.
+ */
+template<class T>
+class MPSCRingBuffer : public SPSCRingBuffer<T> {
+public:
+	explicit MPSCRingBuffer(uint capacity) : SPSCRingBuffer<T>(capacity) {}
+};
+
+#endif // NO_CXX11_ATOMIC
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
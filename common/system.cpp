@@ -29,6 +29,7 @@
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/taskbar.h"
+#include "common/taskpool.h"
 #include "common/updates.h"
 #include "common/dialogs.h"
 #include "common/rotationmode.h"
@@ -47,6 +48,7 @@ OSystem::OSystem() {
 	_audiocdManager = nullptr;
 	_eventManager = nullptr;
 	_timerManager = nullptr;
+	_taskPool = nullptr;
 	_savefileManager = nullptr;
 	_printingManager = nullptr;
 #if defined(USE_TASKBAR)
@@ -74,6 +76,9 @@ OSystem::~OSystem() {
 	delete _timerManager;
 	_timerManager = nullptr;
 
+	delete _taskPool;
+	_taskPool = nullptr;
+
 	delete _printingManager;
 	_printingManager = nullptr;
 
@@ -279,10 +284,20 @@ bool OSystem::isConnectionLimited() {
 	return false;
 }
 
+uint64 OSystem::getMicros() {
+	return (uint64)getMillis(true) * 1000;
+}
+
 Common::TimerManager *OSystem::getTimerManager() {
 	return _timerManager;
 }
 
+Common::TaskPool *OSystem::getTaskPool() {
+	if (!_taskPool)
+		_taskPool = new Common::TaskPool();
+	return _taskPool;
+}
+
 Common::SaveFileManager *OSystem::getSavefileManager() {
 	return _savefileManager;
 }
@@ -70,6 +70,7 @@ class TextToSpeechManager;
 class DialogManager;
 #endif
 class PrintingManager;
+class TaskPool;
 class TimerManager;
 class SeekableReadStream;
 class WriteStream;
@@ -213,6 +214,15 @@ protected:
 	 */
 	Common::TimerManager *_timerManager;
 
+	/**
+	 * No default value is provided for _taskPool by OSystem. Backends
+	 * supporting threads may set it; otherwise getTaskPool() creates a
+	 * serial one when first called.
+	 *
+	 * @note _taskPool is deleted by the OSystem destructor.
+	 */
+	Common::TaskPool *_taskPool;
+
 	/**
 	 * No default value is provided for _savefileManager by OSystem.
 	 *
@@ -1570,6 +1580,15 @@ public:
 	 */
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get a monotonic time in microseconds, to measure short durations.
+	 *
+	 * Unlike getMillis(), this is not recorded by the event recorder, so it
+	 * must not affect the game. The default implementation is based on
+	 * getMillis(), ports with a more precise clock should override it.
+	 */
+	virtual uint64 getMicros();
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1588,6 +1607,17 @@ public:
 	 */
 	virtual Common::TimerManager *getTimerManager();
 
+	/**
+	 * Return the task pool, for running CPU heavy work on worker threads.
+	 *
+	 * This never returns nullptr: on ports without threads, or when the
+	 * "multithreading" setting is off, the pool runs all tasks serially
+	 * on the calling thread.
+	 *
+	 * For more information, see @ref TaskPool.
+	 */
+	Common::TaskPool *getTaskPool();
+
 	/**
 	 * Return the event manager singleton.
 	 *
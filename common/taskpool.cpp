@@ -0,0 +1,74 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/taskpool.h"
+#include "common/util.h"
+
+namespace Common {
+
+namespace {
+
+struct RangeTask {
+	TaskPool::RangeProc proc;
+	void *param;
+	uint begin;
+	uint end;
+};
+
+void runRangeTask(void *param) {
+	RangeTask *task = (RangeTask *)param;
+	task->proc(task->begin, task->end, task->param);
+}
+
+} // End of anonymous namespace
+
+void TaskPool::parallelFor(uint count, RangeProc proc, void *param, uint minRangeSize) {
+	if (count == 0)
+		return;
+	if (minRangeSize == 0)
+		minRangeSize = 1;
+
+	const uint maxRanges = count / minRangeSize;
+	const uint numRanges = MIN<uint>(MIN<uint>(getNumThreads(), kMaxThreads), maxRanges);
+	if (numRanges <= 1) {
+		proc(0, count, param);
+		return;
+	}
+
+	RangeTask ranges[kMaxThreads];
+	uint begin = 0;
+	for (uint i = 0; i < numRanges; i++) {
+		const uint end = (uint)((uint64)count * (i + 1) / numRanges);
+		ranges[i].proc = proc;
+		ranges[i].param = param;
+		ranges[i].begin = begin;
+		ranges[i].end = end;
+		begin = end;
+	}
+
+	TaskGroup group;
+	for (uint i = 1; i < numRanges; i++)
+		submit(group, runRangeTask, &ranges[i]);
+	runRangeTask(&ranges[0]);
+	wait(group);
+}
+
+} // End of namespace Common
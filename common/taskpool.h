@@ -0,0 +1,129 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_TASKPOOL_H
+#define COMMON_TASKPOOL_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_taskpool Task pool
+ * @ingroup common
+ *
+ * @brief API for running CPU heavy work on worker threads.
+ *
+ * @{
+ */
+
+/**
+ * A pool of worker threads, returned by OSystem::getTaskPool().
+ *
+ * This base class is the serial fallback used on ports without threads, or
+ * when the "multithreading" setting is off: submit() runs the task right
+ * away on the calling thread. Code using the pool therefore works the same
+ * everywhere, without any platform specific #ifdef. Use getNumThreads() to
+ * find out whether splitting work is worth it.
+ *
+ * Tasks may run on any thread. They must not call OSystem or engine code
+ * which is not thread safe, and they must not wait for their own group.
+ */
+class TaskPool : NonCopyable {
+public:
+	typedef void (*TaskProc)(void *param);
+	typedef void (*RangeProc)(uint begin, uint end, void *param);
+
+	enum {
+		/** The maximum number of threads, including the waiting one, used by a pool. */
+		kMaxThreads = 32
+	};
+
+	/**
+	 * A set of tasks which can be waited for together. wait() must be
+	 * called for the group before it is destroyed.
+	 */
+	class TaskGroup : NonCopyable {
+	public:
+		TaskGroup() : _pending(0) {}
+		~TaskGroup() { assert(_pending == 0); }
+
+	private:
+		friend class TaskPool;
+		uint _pending;
+	};
+
+	virtual ~TaskPool() {}
+
+	/**
+	 * Return the number of threads running tasks, including the thread
+	 * calling wait(). A value of 1 means that tasks are run serially.
+	 */
+	virtual uint getNumThreads() const { return 1; }
+
+	/**
+	 * Schedule a call to @p proc with @p param, as part of @p group.
+	 */
+	virtual void submit(TaskGroup &group, TaskProc proc, void *param) { proc(param); }
+
+	/**
+	 * Like submit(), but give up instead of waiting while another thread
+	 * uses the pool, or instead of allocating memory when too many tasks
+	 * are queued. This is meant for threads which must not block, like
+	 * the audio callback. The serial pool runs the task right away.
+	 *
+	 * @return False if the task was not scheduled.
+	 */
+	virtual bool trySubmit(TaskGroup &group, TaskProc proc, void *param) { proc(param); return true; }
+
+	/**
+	 * Wait until all tasks of @p group are done. The calling thread runs
+	 * queued tasks of @p group itself while waiting, but never tasks of
+	 * other groups.
+	 */
+	virtual void wait(TaskGroup &group) {}
+
+	/**
+	 * Remove the tasks of @p group which did not start yet from the queue,
+	 * without running them. Tasks which are running are not affected, so
+	 * wait() must still be called before destroying the group.
+	 */
+	virtual void cancel(TaskGroup &group) {}
+
+	/**
+	 * Split [0, @p count) into consecutive ranges, call @p proc for each of
+	 * them on the pool and wait until all are done. Unless @p count itself
+	 * is smaller, the ranges are at least @p minRangeSize long. One of them
+	 * is run on the calling thread.
+	 */
+	void parallelFor(uint count, RangeProc proc, void *param, uint minRangeSize = 1);
+
+protected:
+	/** Access the number of pending tasks of a group, for subclasses. */
+	static uint &pendingTasks(TaskGroup &group) { return group._pending; }
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
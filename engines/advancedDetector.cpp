@@ -21,14 +21,17 @@
 
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
+#include "common/algorithm.h"
 #include "common/debug.h"
 #include "common/util.h"
 #include "common/file.h"
 #include "common/macresman.h"
 #include "common/md5.h"
 #include "common/config-manager.h"
+#include "common/ptr.h"
 #include "common/punycode.h"
 #include "common/system.h"
+#include "common/taskpool.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
 #include "common/translation.h"
@@ -253,8 +256,6 @@ bool AdvancedMetaEngineDetectionBase::cleanupPirated(ADDetectedGames &matched) c
 }
 
 DetectedGames AdvancedMetaEngineDetectionBase::detectGames(const Common::FSList &fslist, uint32 skipADFlags, bool skipIncomplete) {
-	FileMap allFiles;
-
 	if (fslist.empty())
 		return DetectedGames();
 
@@ -263,7 +264,8 @@ DetectedGames AdvancedMetaEngineDetectionBase::detectGames(const Common::FSList
 	preprocessDescriptions();
 
 	// Compose a hashmap of all files in fslist.
-	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
+	FileMap ownFiles;
+	const FileMap &allFiles = composeSharedFileHashMap(ownFiles, fslist);
 
 	// Run the detector on this
 	ADDetectedGames matches = detectGame(fslist.begin()->getParent(), allFiles, Common::UNK_LANG, Common::kPlatformUnknown, "", skipADFlags, skipIncomplete);
@@ -434,6 +436,29 @@ Common::Error AdvancedMetaEngineDetectionBase::identifyGame(DetectedGame &game,
 	return Common::kNoError;
 }
 
+/**
+ * Record @p file, whose encoded name is @p efname, in @p allFiles. Any trailing
+ * dot is removed from @p efname first.
+ *
+ * @return The path the file is recorded under.
+ */
+static Common::Path addFileToMap(AdvancedDetectorCacheManager::FileMap &allFiles, const Common::FSNode &file, Common::String &efname, const Common::Path &parentName, bool fullPaths) {
+	// Strip any trailing dot
+	if (efname.lastChar() == '.')
+		efname.deleteLastChar();
+
+	Common::Path tstr = fullPaths ? parentName.appendComponent(efname) : Common::Path(efname, Common::Path::kNoSeparator);
+
+	allFiles[tstr] = file;		// Record the presence of this file
+	allFiles[Common::Path(efname, Common::Path::kNoSeparator)] = file;	// ...and its file name
+	return tstr;
+}
+
+static Common::String sharedFileMapKey(bool fullPaths, const Common::FSList &fslist) {
+	return Common::String::format("%c%u:%s", fullPaths ? 'F' : 'N', fslist.size(),
+		fslist.front().getParent().getPath().toString(Common::Path::kNativeSeparator).c_str());
+}
+
 void AdvancedMetaEngineDetectionBase::composeFileHashMap(FileMap &allFiles, const Common::FSList &fslist, int depth, const Common::Path &parentName) const {
 	if (depth <= 0)
 		return;
@@ -457,17 +482,27 @@ void AdvancedMetaEngineDetectionBase::composeFileHashMap(FileMap &allFiles, cons
 			continue;
 		}
 
-		// Strip any trailing dot
-		if (efname.lastChar() == '.') {
-			efname.deleteLastChar();
-			tstr = (_flags & kADFlagMatchFullPaths) ? parentName.appendComponent(efname) : Common::Path(efname, Common::Path::kNoSeparator);
-		}
+		tstr = addFileToMap(allFiles, file, efname, parentName, (_flags & kADFlagMatchFullPaths) != 0);
 
 		debugC(9, kDebugGlobalDetection, "$$ ['%s'] ['%s'] in '%s", tstr.toString().c_str(), efname.c_str(), firstPathComponents(fslist.front().getPath().toString(), '/').c_str());
+	}
+}
 
-		allFiles[tstr] = file;		// Record the presence of this file
-		allFiles[Common::Path(efname, Common::Path::kNoSeparator)] = file;	// ...and its file name
+const AdvancedMetaEngineDetectionBase::FileMap &AdvancedMetaEngineDetectionBase::composeSharedFileHashMap(FileMap &ownFiles, const Common::FSList &fslist) const {
+	// Subdirectories are only scanned if they match a glob, so without globs
+	// the map only depends on the listing and on the way paths are matched.
+	if (!fslist.empty() && (_maxScanDepth <= 1 || _globsMap.empty())) {
+		Common::String key = sharedFileMapKey((_flags & kADFlagMatchFullPaths) != 0, fslist);
+
+		bool isNew;
+		FileMap &sharedFiles = ADCacheMan.getSharedFileMap(key, isNew);
+		if (isNew)
+			composeFileHashMap(sharedFiles, fslist, 1);
+		return sharedFiles;
 	}
+
+	composeFileHashMap(ownFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
+	return ownFiles;
 }
 
 /* Singleton Cache Storage for MD5 */
@@ -476,6 +511,179 @@ namespace Common {
 	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
 }
 
+namespace {
+
+struct DirectoryScan {
+	AdvancedDetectorCacheManager::ScannedDirectory *dir;
+	AdvancedDetectorCacheManager::FileMap fileMaps[2];	///< Indexed by whether full paths are matched
+};
+
+/** List directories and compose their file maps, on a worker thread. */
+void scanDirectoryRange(uint begin, uint end, void *param) {
+	Common::Array<DirectoryScan> &scans = *(Common::Array<DirectoryScan> *)param;
+
+	for (uint i = begin; i < end; i++) {
+		AdvancedDetectorCacheManager::ScannedDirectory &dir = *scans[i].dir;
+		dir.listed = dir.dir.getChildren(dir.files, Common::FSNode::kListAll);
+		if (!dir.listed)
+			continue;
+
+		// Like composeFileHashMap() with a depth of 1, which skips directories
+		for (const auto &file : dir.files) {
+			if (file.isDirectory())
+				continue;
+
+			const Common::String name = Common::punycode_encodefilename(file.getName());
+			for (int fullPaths = 0; fullPaths < 2; fullPaths++) {
+				Common::String efname = name;
+				addFileToMap(scans[i].fileMaps[fullPaths], file, efname, Common::Path(), fullPaths != 0);
+			}
+		}
+	}
+}
+
+} // End of anonymous namespace
+
+void AdvancedDetectorCacheManager::scanDirectories(const Common::Array<ScannedDirectory *> &dirs) {
+	Common::Array<DirectoryScan> scans(dirs.size());
+	for (uint i = 0; i < dirs.size(); i++)
+		scans[i].dir = dirs[i];
+
+	g_system->getTaskPool()->parallelFor(scans.size(), scanDirectoryRange, &scans);
+
+	// Store the maps on this thread, in a fixed order
+	for (auto &scan : scans) {
+		scan.dir->scanned = true;
+		if (!scan.dir->listed || scan.dir->files.empty())
+			continue;
+
+		for (int fullPaths = 0; fullPaths < 2; fullPaths++)
+			scannedFileMapHashMap.setVal(sharedFileMapKey(fullPaths != 0, scan.dir->files), scan.fileMaps[fullPaths]);
+	}
+}
+
+void AdvancedDetectorCacheManager::releaseScannedDirectory(const ScannedDirectory &dir) {
+	if (!dir.listed || dir.files.empty())
+		return;
+
+	for (int fullPaths = 0; fullPaths < 2; fullPaths++)
+		scannedFileMapHashMap.erase(sharedFileMapKey(fullPaths != 0, dir.files));
+}
+
+AdvancedDetectorCacheManager::FileMap &AdvancedDetectorCacheManager::getSharedFileMap(const Common::String &key, bool &isNew) {
+	isNew = !fileMapHashMap.contains(key);
+	FileMap &fileMap = fileMapHashMap.getOrCreateVal(key);
+
+	if (isNew && scannedFileMapHashMap.contains(key)) {
+		fileMap = scannedFileMapHashMap.getVal(key);
+		scannedFileMapHashMap.erase(key);
+		isNew = false;
+	}
+
+	return fileMap;
+}
+
+#define DETECTION_CACHE_FILENAME "scummvm-detection-cache.txt"
+
+// Keep the persistent cache file at a reasonable size. When there are more
+// entries, the ones which have not been used for the most runs are dropped.
+static const uint kDetectionCacheMaxEntries = 20000;
+// Number of new entries after which flushPersistentCache(false) writes the file
+static const uint kDetectionCacheFlushThreshold = 256;
+
+bool AdvancedDetectorCacheManager::isPersistentCacheEnabled() const {
+	return ConfMan.getBool("detection_cache");
+}
+
+Common::Path AdvancedDetectorCacheManager::getPersistentCachePath() {
+	// The file lives next to the configuration file, where it is not
+	// uploaded along with the saved games by the cloud storage sync
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+
+	return configFile.getParent().appendComponent(DETECTION_CACHE_FILENAME);
+}
+
+Common::String AdvancedDetectorCacheManager::persistentKey(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes) {
+	return Common::String::format("%s:%d:%s", md5PropToCachePrefix((MD5Properties)(md5prop & kMD5Tail)).c_str(),
+		md5Bytes, node.getPath().toString(Common::Path::kNativeSeparator).c_str());
+}
+
+void AdvancedDetectorCacheManager::loadPersistentCache() {
+	_persistentLoaded = true;
+
+	Common::FSNode node(getPersistentCachePath());
+	Common::ScopedPtr<Common::SeekableReadStream> file(node.exists() ? node.createReadStream() : nullptr);
+	if (!file)
+		return;
+
+	if (!_persistentCache.load(*file)) {
+		warning("Ignoring detection cache with unknown format");
+		return;
+	}
+
+	debugC(2, kDebugGlobalDetection, "Loaded %u entries from the detection cache", _persistentCache.size());
+}
+
+bool AdvancedDetectorCacheManager::getPersistentProperties(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes, FileProperties &fileProps) {
+	if (!isPersistentCacheEnabled())
+		return false;
+
+	if (!_persistentLoaded)
+		loadPersistentCache();
+
+	int64 size, modificationTime;
+	if (!node.getFileInfo(size, modificationTime) ||
+	    !_persistentCache.lookup(persistentKey(node, md5prop, md5Bytes), size, modificationTime, fileProps.md5))
+		return false;
+
+	fileProps.size = size;
+	fileProps.md5prop = (MD5Properties)(md5prop & kMD5Tail);
+	return true;
+}
+
+void AdvancedDetectorCacheManager::setPersistentProperties(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes, const FileProperties &fileProps) {
+	if (!isPersistentCacheEnabled())
+		return;
+
+	if (!_persistentLoaded)
+		loadPersistentCache();
+
+	int64 size, modificationTime;
+	if (!node.getFileInfo(size, modificationTime) || size != fileProps.size)
+		return;
+
+	_persistentCache.store(persistentKey(node, md5prop, md5Bytes), size, modificationTime, fileProps.md5);
+}
+
+void AdvancedDetectorCacheManager::flushPersistentCache(bool force) {
+	const uint numChanges = _persistentCache.getNumChanges();
+	if (!numChanges || (!force && numChanges < kDetectionCacheFlushThreshold))
+		return;
+
+	if (!isPersistentCacheEnabled())
+		return;
+
+	// Drop the least recently used entries if there are too many
+	_persistentCache.prune(kDetectionCacheMaxEntries);
+
+	Common::FSNode node(getPersistentCachePath());
+	Common::ScopedPtr<Common::SeekableWriteStream> file(node.createWriteStream());
+	if (!file) {
+		warning("Failed to open " DETECTION_CACHE_FILENAME " for writing");
+		return;
+	}
+
+	_persistentCache.save(*file);
+	file->finalize();
+
+	if (file->err())
+		warning("Failed to write " DETECTION_CACHE_FILENAME);
+	else
+		_persistentCache.clearChanges();
+}
+
 
 static MD5Properties gameFileToMD5Props(const ADGameFileDescription *fileEntry, uint32 gameFlags) {
 	MD5Properties ret = kMD5Head;
@@ -535,13 +743,101 @@ Common::String md5PropToGameFile(MD5Properties flags) {
 }
 
 static bool getFilePropertiesIntern(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps);
+static void getStreamProperties(Common::SeekableReadStream &stream, uint md5Bytes, MD5Properties md5prop, FileProperties &fileProps);
 
-bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
+static Common::String md5CacheKey(MD5Properties md5prop, const Common::Path &fname, uint md5Bytes) {
 	Common::String hashname = md5PropToCachePrefix(md5prop);
-		hashname += ':';
-		hashname += fname.toString('/');
-		hashname += ':';
-		hashname += Common::String::format("%d", _md5Bytes);
+	hashname += ':';
+	hashname += fname.toString('/');
+	hashname += ':';
+	hashname += Common::String::format("%d", md5Bytes);
+	return hashname;
+}
+
+namespace {
+
+struct FilePropertiesJob {
+	Common::FSNode node;
+	MD5Properties md5prop;
+	Common::String hashname;
+	FileProperties fileProps;
+	bool found;
+};
+
+struct FilePropertiesJobs {
+	Common::Array<FilePropertiesJob> jobs;
+	uint md5Bytes;
+};
+
+/** Hash plain files, on a worker thread. */
+void computeFilePropertiesRange(uint begin, uint end, void *param) {
+	FilePropertiesJobs &jobs = *(FilePropertiesJobs *)param;
+
+	for (uint i = begin; i < end; i++) {
+		FilePropertiesJob &job = jobs.jobs[i];
+		Common::ScopedPtr<Common::SeekableReadStream> stream(job.node.createReadStream());
+		job.found = stream != nullptr;
+		if (job.found)
+			getStreamProperties(*stream, jobs.md5Bytes, job.md5prop, job.fileProps);
+	}
+}
+
+} // End of anonymous namespace
+
+void AdvancedMetaEngineDetectionBase::prefetchFileProperties(const FileMap &allFiles) const {
+	Common::TaskPool *taskPool = g_system->getTaskPool();
+	if (taskPool->getNumThreads() < 2)
+		return;
+
+	FilePropertiesJobs jobs;
+	jobs.md5Bytes = _md5Bytes;
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> queued;
+
+	for (const byte *descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			// Only plain files are read on the workers, the others need
+			// archives and resource forks, which are not thread safe
+			MD5Properties md5prop = gameFileToMD5Props(fileDesc, g->flags);
+			Common::Path fname(fileDesc->fileName);
+			if ((md5prop & (kMD5MacResFork | kMD5MacDataFork | kMD5Archive)) || !allFiles.contains(fname))
+				continue;
+
+			Common::String hashname = md5CacheKey(md5prop, fname, _md5Bytes);
+			if (queued.contains(hashname) || ADCacheMan.containsMD5(hashname))
+				continue;
+			queued[hashname] = true;
+
+			FilePropertiesJob job;
+			job.node = allFiles[fname];
+			job.md5prop = md5prop;
+			job.hashname = hashname;
+			job.found = false;
+			if (!ADCacheMan.getPersistentProperties(job.node, md5prop, _md5Bytes, job.fileProps))
+				jobs.jobs.push_back(job);
+		}
+	}
+
+	// A single file is hashed by getFileProperties() just as fast
+	if (jobs.jobs.size() < 2)
+		return;
+
+	taskPool->parallelFor(jobs.jobs.size(), computeFilePropertiesRange, &jobs);
+
+	// Store the results on this thread, in a fixed order
+	for (const auto &job : jobs.jobs) {
+		if (!job.found)
+			continue;
+
+		ADCacheMan.setPersistentProperties(job.node, job.md5prop, _md5Bytes, job.fileProps);
+		ADCacheMan.setMD5(job.hashname, job.fileProps.md5);
+		ADCacheMan.setSize(job.hashname, job.fileProps.size);
+	}
+}
+
+bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
+	Common::String hashname = md5CacheKey(md5prop, fname, _md5Bytes);
 
 	if (ADCacheMan.containsMD5(hashname)) {
 		fileProps.md5 = ADCacheMan.getMD5(hashname);
@@ -549,7 +845,21 @@ bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles,
 		return true;
 	}
 
-	bool res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
+	// Plain files can be looked up in the persistent cache, which avoids
+	// reading them again when they have not changed since the last run.
+	const Common::FSNode *node = nullptr;
+	if (!(md5prop & (kMD5MacResFork | kMD5MacDataFork | kMD5Archive)) && allFiles.contains(fname))
+		node = &allFiles[fname];
+
+	bool res = false;
+	if (node && ADCacheMan.getPersistentProperties(*node, md5prop, _md5Bytes, fileProps)) {
+		res = true;
+	} else {
+		res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
+
+		if (res && node)
+			ADCacheMan.setPersistentProperties(*node, md5prop, _md5Bytes, fileProps);
+	}
 
 	if (res) {
 		ADCacheMan.setMD5(hashname, fileProps.md5);
@@ -659,15 +969,19 @@ static bool getFilePropertiesIntern(uint md5Bytes, const AdvancedMetaEngineBase:
 			return false;
 	}
 
+	getStreamProperties(*testFile.get(), md5Bytes, md5prop, fileProps);
+	return true;
+}
+
+static void getStreamProperties(Common::SeekableReadStream &stream, uint md5Bytes, MD5Properties md5prop, FileProperties &fileProps) {
 	if (md5prop & kMD5Tail) {
-		if (testFile->size() > md5Bytes)
-			testFile->seek(-(int64)md5Bytes, SEEK_END);
+		if (stream.size() > md5Bytes)
+			stream.seek(-(int64)md5Bytes, SEEK_END);
 	}
 
-	fileProps.size = testFile->size();
-	fileProps.md5 = Common::computeStreamMD5AsString(*testFile.get(), md5Bytes);
+	fileProps.size = stream.size();
+	fileProps.md5 = Common::computeStreamMD5AsString(stream, md5Bytes);
 	fileProps.md5prop = (MD5Properties) (md5prop & kMD5Tail);
-	return true;
 }
 
 void AdvancedMetaEngineDetectionBase::dumpDetectionEntries() const {
@@ -718,6 +1032,10 @@ ADDetectedGames AdvancedMetaEngineDetectionBase::detectGame(const Common::FSNode
 
 	preprocessDescriptions();
 
+	// Hash the plain files on the task pool first, the loop below then
+	// finds them in the cache
+	prefetchFileProperties(allFiles);
+
 	// Check which files are included in some ADGameDescription *and* whether
 	// they are present. Compute MD5s and file sizes for the available files.
 	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
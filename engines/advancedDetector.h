@@ -24,7 +24,9 @@
 
 #include "engines/metaengine.h"
 #include "engines/engine.h"
+#include "engines/detectionCache.h"
 
+#include "common/fs.h"
 #include "common/hash-str.h"
 
 #include "common/gui_options.h" // Keep it here, so detection tables can refer to them
@@ -595,9 +597,28 @@ protected:
 	 */
 	void composeFileHashMap(FileMap &allFiles, const Common::FSList &fslist, int depth, const Common::Path &parentName = Common::Path()) const;
 
+	/**
+	 * Same as @ref composeFileHashMap, but for engines which do not look into
+	 * subdirectories, the result is shared with all other such engines through
+	 * the @ref AdvancedDetectorCacheManager, until it is cleared. This avoids
+	 * every engine listing and encoding the same directory again.
+	 *
+	 * @param ownFiles  Storage for the map, if it cannot be shared.
+	 * @return The map of all files in @p fslist.
+	 */
+	const FileMap &composeSharedFileHashMap(FileMap &ownFiles, const Common::FSList &fslist) const;
+
 	/** Get the properties (size and MD5) of this file. */
 	bool getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const;
 
+	/**
+	 * Compute the properties of the plain files of the game descriptions
+	 * found in @p allFiles on the task pool, and store them in the
+	 * @ref AdvancedDetectorCacheManager, so that getFileProperties() finds
+	 * them. This does nothing if the task pool has no worker threads.
+	 */
+	void prefetchFileProperties(const FileMap &allFiles) const;
+
 	/** Convert an AD game description into the shared game description format. */
 	virtual DetectedGame toDetectedGame(const ADDetectedGame &adGame, ADDetectedGameExtraInfo *extraInfo = nullptr) const;
 
@@ -778,7 +799,67 @@ public:
 		return archiveHashMap.getValOrDefault(node.getPath(), nullptr);
 	}
 
-	AdvancedDetectorCacheManager() {
+	/**
+	 * Look up the properties of a file in the persistent cache, which is kept
+	 * across runs. The entry is only used if the size and modification time
+	 * of the file did not change since it was stored.
+	 */
+	bool getPersistentProperties(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes, FileProperties &fileProps);
+
+	/**
+	 * Store the properties of a file in the persistent cache.
+	 */
+	void setPersistentProperties(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes, const FileProperties &fileProps);
+
+	/**
+	 * Write the persistent cache to disk if it changed.
+	 *
+	 * @param force  If false, the cache is only written once enough new
+	 *               entries were added, to keep mass detection cheap.
+	 */
+	void flushPersistentCache(bool force = true);
+
+	typedef Common::HashMap<Common::Path, Common::FSNode, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> FileMap;
+
+	/**
+	 * Get the file map stored under the given key, see
+	 * @ref AdvancedMetaEngineDetectionBase::composeSharedFileHashMap.
+	 *
+	 * @param isNew  Set to true if the map did not exist yet, and must be filled.
+	 */
+	FileMap &getSharedFileMap(const Common::String &key, bool &isNew);
+
+	/** A directory listed by scanDirectories(). */
+	struct ScannedDirectory {
+		Common::FSNode dir;
+		Common::FSList files;	///< The children of @ref dir
+		bool scanned;			///< True once scanDirectories() went through @ref dir
+		bool listed;			///< False if @ref dir could not be listed
+
+		ScannedDirectory() : scanned(false), listed(false) {}
+		ScannedDirectory(const Common::FSNode &node) : dir(node), scanned(false), listed(false) {}
+	};
+
+	/**
+	 * List the directories in @p dirs, and compose their shared file maps,
+	 * on the task pool. The maps are stored on the calling thread in the
+	 * order of @p dirs, and are kept across clear() until an engine uses
+	 * them, releaseScannedDirectory() or clearScannedDirectories() is called.
+	 *
+	 * This lets mass detection list many directories at once, before
+	 * running the detection of each of them with its listing.
+	 */
+	void scanDirectories(const Common::Array<ScannedDirectory *> &dirs);
+
+	/** Forget the file maps of a directory from scanDirectories(), once it has been detected. */
+	void releaseScannedDirectory(const ScannedDirectory &dir);
+
+	/** Forget the file maps of scanDirectories() not used by any engine. */
+	void clearScannedDirectories() {
+		scannedFileMapHashMap.clear(true);
+	}
+
+	AdvancedDetectorCacheManager() : _persistentLoaded(false) {
 		clear();
 	}
 
@@ -792,6 +873,7 @@ public:
 	void clear() {
 		md5HashMap.clear(true);
 		sizeHashMap.clear(true);
+		fileMapHashMap.clear(true);
 		clearArchives();
 	}
 
@@ -804,6 +886,16 @@ private:
 	FileHashMap md5HashMap;
 	SizeHashMap sizeHashMap;
 	ArchiveHashMap archiveHashMap;
+	Common::HashMap<Common::String, FileMap> fileMapHashMap;
+	Common::HashMap<Common::String, FileMap> scannedFileMapHashMap;
+
+	DetectionCache _persistentCache;
+	bool _persistentLoaded;
+
+	bool isPersistentCacheEnabled() const;
+	static Common::Path getPersistentCachePath();
+	void loadPersistentCache();
+	static Common::String persistentKey(const Common::FSNode &node, MD5Properties md5prop, uint md5Bytes);
 };
 
 /** Convenience shortcut for accessing the MD5CacheManager. */
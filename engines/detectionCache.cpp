@@ -0,0 +1,181 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/stream.h"
+
+#include "engines/detectionCache.h"
+
+#define DETECTION_CACHE_HEADER "SCUMMVM_DETECTION_CACHE 2"
+
+// Keys are paths, which may contain any character: escape the ones which
+// separate the fields and the lines of the file.
+static Common::String escapeKey(const Common::String &key) {
+	Common::String escaped;
+	for (const char c : key) {
+		switch (c) {
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\r':
+			escaped += "\\r";
+			break;
+		default:
+			escaped += c;
+			break;
+		}
+	}
+	return escaped;
+}
+
+static bool unescapeKey(const char *escaped, Common::String &key) {
+	key.clear();
+	for (const char *c = escaped; *c; c++) {
+		if (*c != '\\') {
+			key += *c;
+			continue;
+		}
+
+		switch (*++c) {
+		case '\\':
+			key += '\\';
+			break;
+		case 't':
+			key += '\t';
+			break;
+		case 'n':
+			key += '\n';
+			break;
+		case 'r':
+			key += '\r';
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DetectionCache::load(Common::SeekableReadStream &stream) {
+	_entries.clear();
+	_generation = 0;
+
+	if (stream.readLine() != DETECTION_CACHE_HEADER)
+		return false;
+
+	// Each run which uses the cache gets a new generation
+	_generation = strtoul(stream.readLine().c_str(), nullptr, 10) + 1;
+
+	// Entries are: generation, size, modification time, md5, key; separated by tabs.
+	while (!stream.eos() && !stream.err()) {
+		Common::String line = stream.readLine();
+		if (line.empty())
+			continue;
+
+		const char *fields[5];
+		fields[0] = line.c_str();
+		int i;
+		for (i = 1; i < 5; i++) {
+			const char *tab = strchr(fields[i - 1], '\t');
+			if (!tab)
+				break;
+			fields[i] = tab + 1;
+		}
+		Common::String key;
+		if (i < 5 || !unescapeKey(fields[4], key))
+			continue;
+
+		Entry entry;
+		entry.generation = strtoul(fields[0], nullptr, 10);
+		entry.size = strtoll(fields[1], nullptr, 10);
+		entry.modificationTime = strtoll(fields[2], nullptr, 10);
+		entry.md5 = Common::String(fields[3], fields[4] - 1);
+		_entries.setVal(key, entry);
+	}
+
+	return true;
+}
+
+void DetectionCache::save(Common::WriteStream &stream) const {
+	stream.writeString(DETECTION_CACHE_HEADER "\n");
+	stream.writeString(Common::String::format("%u\n", _generation));
+	for (const auto &entry : _entries) {
+		stream.writeString(Common::String::format("%u\t%lld\t%lld\t%s\t%s\n", entry._value.generation,
+			(long long)entry._value.size, (long long)entry._value.modificationTime,
+			entry._value.md5.c_str(), escapeKey(entry._key).c_str()));
+	}
+}
+
+bool DetectionCache::lookup(const Common::String &key, int64 size, int64 modificationTime, Common::String &md5) {
+	EntryMap::iterator it = _entries.find(key);
+	if (it == _entries.end())
+		return false;
+
+	if (size != it->_value.size || modificationTime != it->_value.modificationTime) {
+		// The file changed, the entry will get replaced
+		return false;
+	}
+
+	if (it->_value.generation != _generation) {
+		it->_value.generation = _generation;
+		_numChanges++;
+	}
+
+	md5 = it->_value.md5;
+	return true;
+}
+
+void DetectionCache::store(const Common::String &key, int64 size, int64 modificationTime, const Common::String &md5) {
+	Entry entry;
+	entry.size = size;
+	entry.modificationTime = modificationTime;
+	entry.md5 = md5;
+	entry.generation = _generation;
+	_entries.setVal(key, entry);
+	_numChanges++;
+}
+
+void DetectionCache::prune(uint maxEntries) {
+	if (_entries.size() <= maxEntries)
+		return;
+
+	Common::Array<uint32> generations;
+	generations.reserve(_entries.size());
+	for (const auto &entry : _entries)
+		generations.push_back(entry._value.generation);
+	Common::sort(generations.begin(), generations.end());
+
+	uint32 oldest = generations[generations.size() - maxEntries];
+	for (EntryMap::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+		if (it->_value.generation < oldest) {
+			_entries.erase(it);
+			_numChanges++;
+		}
+	}
+}
@@ -0,0 +1,96 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/hash-str.h"
+
+namespace Common {
+class SeekableReadStream;
+class WriteStream;
+}
+
+/**
+ * The MD5s of files computed during detection, kept across runs so that
+ * detecting a known collection again only needs to look at file metadata.
+ *
+ * Entries are keyed by strings built from the native path of the file, and
+ * are only used while the size and modification time of the file are the
+ * ones it had when it was hashed.
+ */
+class DetectionCache {
+public:
+	DetectionCache() : _generation(0), _numChanges(0) {}
+
+	/**
+	 * Replace the entries with the ones read from @p stream, and start a new
+	 * generation of uses.
+	 *
+	 * @return false if the stream is not a detection cache, which leaves the
+	 *         cache empty
+	 */
+	bool load(Common::SeekableReadStream &stream);
+
+	/** Write the entries to @p stream, in the format load() reads. */
+	void save(Common::WriteStream &stream) const;
+
+	/**
+	 * Look up the MD5 of a file.
+	 *
+	 * @return false if there is no entry for @p key, or if the file changed
+	 *         since the entry was stored
+	 */
+	bool lookup(const Common::String &key, int64 size, int64 modificationTime, Common::String &md5);
+
+	/** Store the MD5 of a file, replacing any older entry for @p key. */
+	void store(const Common::String &key, int64 size, int64 modificationTime, const Common::String &md5);
+
+	/**
+	 * Drop the entries which have not been used for the most generations,
+	 * until at most @p maxEntries are left.
+	 */
+	void prune(uint maxEntries);
+
+	uint size() const { return _entries.size(); }
+
+	/** Number of changes since the last call to clearChanges(). */
+	uint getNumChanges() const { return _numChanges; }
+	/** Call after saving the cache. */
+	void clearChanges() { _numChanges = 0; }
+
+private:
+	struct Entry {
+		int64 size;
+		int64 modificationTime;
+		Common::String md5;
+		uint32 generation;	///< Value of _generation when the entry was last used
+	};
+
+	// Keys are native paths, which may be case sensitive
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+	EntryMap _entries;
+	uint32 _generation;
+	uint _numChanges;
+};
+
+#endif
@@ -30,6 +30,7 @@ struct Point;
 }
 
 class BlendBlitUnfilteredTestSuite;
+class CrossBlitTestSuite;
 
 namespace Graphics {
 
@@ -461,6 +462,121 @@ public:
 
 }; // End of class BlendBlit
 
+// This is a class so that we can declare certain things as private
+class CrossBlit {
+private:
+	/**
+	 * Shifts and masks to convert colors to or from a 32bpp format.
+	 *
+	 * Each component is expanded to 8 bits by repeating its bits, which
+	 * matches what PixelFormat::colorToARGB() does, or reduced by dropping
+	 * its low bits, like PixelFormat::ARGBToColor() does. Components which
+	 * are 8 bits on both sides and only move by the same amount are
+	 * handled at once.
+	 */
+	struct Channels {
+		int count;
+		uint32 fill;
+		uint32 srcMask[4];
+		int srcShift[4];
+		int expandShift[4];
+		int repeats[4];
+		int bits[4];
+		int dstShift[4];
+
+		Channels(const PixelFormat &dstFmt, const PixelFormat &srcFmt);
+
+		static bool isSupported(const PixelFormat &dstFmt, const PixelFormat &srcFmt);
+
+		inline uint32 convert(uint32 color) const {
+			uint32 out = fill;
+			for (int i = 0; i < count; i++) {
+				uint32 x = ((color >> srcShift[i]) & srcMask[i]) << expandShift[i];
+				for (int j = 0; j < repeats[i]; j++)
+					x |= x >> (bits[i] << j);
+				out |= x << dstShift[i];
+			}
+			return out;
+		}
+	};
+
+	// The conversion functions to larger pixels handle one line from right
+	// to left, and the ones to smaller pixels from left to right, so that
+	// converting in place does not overwrite pixels before they are read.
+	typedef void (*ConvertFunc)(byte *dst, const byte *src, const uint w, const Channels &channels);
+	typedef void (*MapFunc)(byte *dst, const byte *src, const uint w, const uint32 *map);
+
+#ifdef SCUMMVM_NEON
+	static void convert16To32NEON(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert24To32NEON(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To16NEON(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To24NEON(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void map8To16NEON(byte *dst, const byte *src, const uint w, const uint32 *map);
+	static void map8To32NEON(byte *dst, const byte *src, const uint w, const uint32 *map);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void convert16To32SSE2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert24To32SSE2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To16SSE2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To24SSE2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void map8To16SSE2(byte *dst, const byte *src, const uint w, const uint32 *map);
+	static void map8To32SSE2(byte *dst, const byte *src, const uint w, const uint32 *map);
+#endif
+#ifdef SCUMMVM_AVX2
+	static void convert16To32AVX2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert24To32AVX2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To16AVX2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To24AVX2(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void map8To16AVX2(byte *dst, const byte *src, const uint w, const uint32 *map);
+	static void map8To32AVX2(byte *dst, const byte *src, const uint w, const uint32 *map);
+#endif
+	static void convert16To32Generic(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert24To32Generic(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To16Generic(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void convert32To24Generic(byte *dst, const byte *src, const uint w, const Channels &channels);
+	static void map8To16Generic(byte *dst, const byte *src, const uint w, const uint32 *map);
+	static void map8To32Generic(byte *dst, const byte *src, const uint w, const uint32 *map);
+
+	static ConvertFunc convert16To32Func;
+	static ConvertFunc convert24To32Func;
+	static ConvertFunc convert32To16Func;
+	static ConvertFunc convert32To24Func;
+	static MapFunc map8To16Func;
+	static MapFunc map8To32Func;
+
+	static void selectFuncs();
+
+	friend class ::CrossBlitTestSuite;
+	friend class CrossBlitImpl_NEON;
+	friend class CrossBlitImpl_SSE2;
+	friend class CrossBlitImpl_AVX2;
+
+public:
+	/**
+	 * Optimized version of crossBlit() for converting 16bpp and 24bpp
+	 * surfaces to 32bpp, and 32bpp surfaces to 16bpp and 24bpp.
+	 *
+	 * @return false if the formats are not handled here, in which case
+	 *         nothing is drawn.
+	 */
+	static bool convert(byte *dst, const byte *src,
+						const uint dstPitch, const uint srcPitch,
+						const uint w, const uint h,
+						const PixelFormat &dstFmt, const PixelFormat &srcFmt);
+
+	/**
+	 * Optimized version of crossBlitMap() for converting 8bpp surfaces
+	 * to 16bpp and 32bpp.
+	 *
+	 * @return false if the format is not handled here, in which case
+	 *         nothing is drawn.
+	 */
+	static bool convertMap(byte *dst, const byte *src,
+						   const uint dstPitch, const uint srcPitch,
+						   const uint w, const uint h,
+						   const uint bytesPerPixel, const uint32 *map);
+}; // End of class CrossBlit
+
 /** @} */
 } // End of namespace Graphics
 
@@ -321,6 +321,145 @@ void BlendBlit::blitAVX2(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_AVX2>(args, blendMode, alphaType);
 }
 
+class CrossBlitImpl_AVX2 {
+	friend class CrossBlit;
+
+struct Channels {
+	int count;
+	int repeats[4];
+	__m256i fill;
+	__m256i srcMask[4];
+	__m128i srcShift[4];
+	__m128i expandShift[4];
+	__m128i repeatShift[4][3];
+	__m128i dstShift[4];
+
+	Channels(const CrossBlit::Channels &channels) : count(channels.count), fill(_mm256_set1_epi32(channels.fill)) {
+		for (int i = 0; i < count; i++) {
+			repeats[i] = channels.repeats[i];
+			srcMask[i] = _mm256_set1_epi32(channels.srcMask[i]);
+			srcShift[i] = _mm_cvtsi32_si128(channels.srcShift[i]);
+			expandShift[i] = _mm_cvtsi32_si128(channels.expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				repeatShift[i][j] = _mm_cvtsi32_si128(channels.bits[i] << j);
+			dstShift[i] = _mm_cvtsi32_si128(channels.dstShift[i]);
+		}
+	}
+
+	inline __m256i convert(__m256i color) const {
+		__m256i out = fill;
+		for (int i = 0; i < count; i++) {
+			__m256i x = _mm256_and_si256(_mm256_srl_epi32(color, srcShift[i]), srcMask[i]);
+			x = _mm256_sll_epi32(x, expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				x = _mm256_or_si256(x, _mm256_srl_epi32(x, repeatShift[i][j]));
+			out = _mm256_or_si256(out, _mm256_sll_epi32(x, dstShift[i]));
+		}
+		return out;
+	}
+};
+
+static inline __m256i lookup8(const byte *in, const uint32 *map) {
+	const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)in));
+	return _mm256_i32gather_epi32((const int *)map, index, 4);
+}
+
+}; // End of class CrossBlitImpl_AVX2
+
+// The lines are converted backwards, so the pixels which do not fill a whole
+// vector are done first.
+
+void CrossBlit::convert16To32AVX2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_AVX2::Channels simd(channels);
+
+	uint x = w & ~7;
+	convert16To32Generic(dst + x * 4, src + x * 2, w - x, channels);
+
+	while (x > 0) {
+		x -= 8;
+		const __m256i color = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + x * 2)));
+		_mm256_storeu_si256((__m256i *)(dst + x * 4), simd.convert(color));
+	}
+}
+
+void CrossBlit::convert24To32AVX2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_AVX2::Channels simd(channels);
+	// The upper half is loaded from the 8th byte, so that the load does not
+	// go past the last pixel
+	const __m256i unpack = _mm256_setr_epi8(
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+
+	uint x = w & ~7;
+	convert24To32Generic(dst + x * 4, src + x * 3, w - x, channels);
+
+	while (x > 0) {
+		x -= 8;
+		const byte *in = src + x * 3;
+		const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)in)),
+			_mm_loadu_si128((const __m128i *)(in + 8)), 1);
+		_mm256_storeu_si256((__m256i *)(dst + x * 4), simd.convert(_mm256_shuffle_epi8(bytes, unpack)));
+	}
+}
+
+// The lines are converted forwards to smaller pixels, so the pixels which do
+// not fill a whole vector are done last.
+
+void CrossBlit::convert32To16AVX2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_AVX2::Channels simd(channels);
+
+	const uint end = w & ~7;
+	for (uint x = 0; x < end; x += 8) {
+		const __m256i color = simd.convert(_mm256_loadu_si256((const __m256i *)(src + x * 4)));
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(color, color), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)(dst + x * 2), _mm256_castsi256_si128(packed));
+	}
+
+	convert32To16Generic(dst + end * 2, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::convert32To24AVX2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_AVX2::Channels simd(channels);
+	// Drop the upper byte of each pixel within the halves, then move the
+	// 12 bytes left in each half together
+	const __m256i pack = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+	const uint end = w & ~7;
+	for (uint x = 0; x < end; x += 8) {
+		const __m256i color = simd.convert(_mm256_loadu_si256((const __m256i *)(src + x * 4)));
+		const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(color, pack), join);
+		_mm_storeu_si128((__m128i *)(dst + x * 3), _mm256_castsi256_si128(packed));
+		_mm_storel_epi64((__m128i *)(dst + x * 3 + 16), _mm256_extracti128_si256(packed, 1));
+	}
+
+	convert32To24Generic(dst + end * 3, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::map8To16AVX2(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~7;
+	map8To16Generic(dst + x * 2, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 8;
+		const __m256i color = _mm256_and_si256(CrossBlitImpl_AVX2::lookup8(src + x, map), _mm256_set1_epi32(0xFFFF));
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(color, color), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)(dst + x * 2), _mm256_castsi256_si128(packed));
+	}
+}
+
+void CrossBlit::map8To32AVX2(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~7;
+	map8To32Generic(dst + x * 4, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 8;
+		_mm256_storeu_si256((__m256i *)(dst + x * 4), CrossBlitImpl_AVX2::lookup8(src + x, map));
+	}
+}
+
 } // End of namespace Graphics
 
 #if defined(__clang__)
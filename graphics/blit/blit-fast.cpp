@@ -57,7 +57,6 @@ static void swapBlit(byte *dst, const byte *src,
 
 } // End of anonymous namespace
 
-// TODO: Add fast 24<->32bpp conversion
 // TODO: Add fast 16<->16bpp conversion
 struct FastBlitLookup {
 	FastBlitFunc func;
@@ -324,6 +324,152 @@ void BlendBlit::blitNEON(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_NEON>(args, blendMode, alphaType);
 }
 
+class CrossBlitImpl_NEON {
+	friend class CrossBlit;
+
+struct Channels {
+	int count;
+	int repeats[4];
+	uint32x4_t fill;
+	uint32x4_t srcMask[4];
+	int32x4_t srcShift[4];
+	int32x4_t expandShift[4];
+	int32x4_t repeatShift[4][3];
+	int32x4_t dstShift[4];
+
+	// Negative shifts go to the right
+	Channels(const CrossBlit::Channels &channels) : count(channels.count), fill(vdupq_n_u32(channels.fill)) {
+		for (int i = 0; i < count; i++) {
+			repeats[i] = channels.repeats[i];
+			srcMask[i] = vdupq_n_u32(channels.srcMask[i]);
+			srcShift[i] = vdupq_n_s32(-channels.srcShift[i]);
+			expandShift[i] = vdupq_n_s32(channels.expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				repeatShift[i][j] = vdupq_n_s32(-(channels.bits[i] << j));
+			dstShift[i] = vdupq_n_s32(channels.dstShift[i]);
+		}
+	}
+
+	inline uint32x4_t convert(uint32x4_t color) const {
+		uint32x4_t out = fill;
+		for (int i = 0; i < count; i++) {
+			uint32x4_t x = vandq_u32(vshlq_u32(color, srcShift[i]), srcMask[i]);
+			x = vshlq_u32(x, expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				x = vorrq_u32(x, vshlq_u32(x, repeatShift[i][j]));
+			out = vorrq_u32(out, vshlq_u32(x, dstShift[i]));
+		}
+		return out;
+	}
+};
+
+static inline uint32x4_t lookup4(const byte *in, const uint32 *map) {
+	uint32x4_t color = vdupq_n_u32(map[in[0]]);
+	color = vsetq_lane_u32(map[in[1]], color, 1);
+	color = vsetq_lane_u32(map[in[2]], color, 2);
+	color = vsetq_lane_u32(map[in[3]], color, 3);
+	return color;
+}
+
+}; // end of class CrossBlitImpl_NEON
+
+// The lines are converted backwards, so the pixels which do not fill a whole
+// vector are done first.
+
+void CrossBlit::convert16To32NEON(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_NEON::Channels simd(channels);
+
+	uint x = w & ~7;
+	convert16To32Generic(dst + x * 4, src + x * 2, w - x, channels);
+
+	while (x > 0) {
+		x -= 8;
+		const uint16x8_t color = vld1q_u16((const uint16 *)(src + x * 2));
+		const uint32x4_t lo = simd.convert(vmovl_u16(vget_low_u16(color)));
+		const uint32x4_t hi = simd.convert(vmovl_u16(vget_high_u16(color)));
+		vst1q_u32((uint32 *)(dst + x * 4), lo);
+		vst1q_u32((uint32 *)(dst + x * 4 + 16), hi);
+	}
+}
+
+void CrossBlit::convert24To32NEON(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_NEON::Channels simd(channels);
+
+	uint x = w & ~7;
+	convert24To32Generic(dst + x * 4, src + x * 3, w - x, channels);
+
+	while (x > 0) {
+		x -= 8;
+		const uint8x8x3_t bytes = vld3_u8(src + x * 3);
+		const uint16x8_t byte0 = vmovl_u8(bytes.val[0]);
+		const uint16x8_t byte1 = vmovl_u8(bytes.val[1]);
+		const uint16x8_t byte2 = vmovl_u8(bytes.val[2]);
+		const uint32x4_t lo = vorrq_u32(vmovl_u16(vget_low_u16(byte0)),
+			vorrq_u32(vshll_n_u16(vget_low_u16(byte1), 8), vshll_n_u16(vget_low_u16(byte2), 16)));
+		const uint32x4_t hi = vorrq_u32(vmovl_u16(vget_high_u16(byte0)),
+			vorrq_u32(vshll_n_u16(vget_high_u16(byte1), 8), vshll_n_u16(vget_high_u16(byte2), 16)));
+		vst1q_u32((uint32 *)(dst + x * 4), simd.convert(lo));
+		vst1q_u32((uint32 *)(dst + x * 4 + 16), simd.convert(hi));
+	}
+}
+
+// The lines are converted forwards to smaller pixels, so the pixels which do
+// not fill a whole vector are done last.
+
+void CrossBlit::convert32To16NEON(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_NEON::Channels simd(channels);
+
+	const uint end = w & ~7;
+	for (uint x = 0; x < end; x += 8) {
+		const uint32x4_t lo = simd.convert(vld1q_u32((const uint32 *)(src + x * 4)));
+		const uint32x4_t hi = simd.convert(vld1q_u32((const uint32 *)(src + x * 4 + 16)));
+		vst1q_u16((uint16 *)(dst + x * 2), vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+	}
+
+	convert32To16Generic(dst + end * 2, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::convert32To24NEON(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_NEON::Channels simd(channels);
+
+	const uint end = w & ~7;
+	for (uint x = 0; x < end; x += 8) {
+		const uint32x4_t lo = simd.convert(vld1q_u32((const uint32 *)(src + x * 4)));
+		const uint32x4_t hi = simd.convert(vld1q_u32((const uint32 *)(src + x * 4 + 16)));
+		const uint16x8_t low = vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+		const uint16x8_t high = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+		uint8x8x3_t bytes;
+		bytes.val[0] = vmovn_u16(low);
+		bytes.val[1] = vshrn_n_u16(low, 8);
+		bytes.val[2] = vmovn_u16(high);
+		vst3_u8(dst + x * 3, bytes);
+	}
+
+	convert32To24Generic(dst + end * 3, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::map8To16NEON(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~7;
+	map8To16Generic(dst + x * 2, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 8;
+		const uint32x4_t lo = CrossBlitImpl_NEON::lookup4(src + x, map);
+		const uint32x4_t hi = CrossBlitImpl_NEON::lookup4(src + x + 4, map);
+		vst1q_u16((uint16 *)(dst + x * 2), vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+	}
+}
+
+void CrossBlit::map8To32NEON(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~3;
+	map8To32Generic(dst + x * 4, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 4;
+		vst1q_u32((uint32 *)(dst + x * 4), CrossBlitImpl_NEON::lookup4(src + x, map));
+	}
+}
+
 void fastBlitNEON_XRGB1555_RGB565(byte *dst, const byte *src,
                   const uint dstPitch, const uint srcPitch,
                   const uint w, const uint h) {
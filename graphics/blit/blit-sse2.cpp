@@ -20,6 +20,7 @@
  */
 
 #include "common/scummsys.h"
+#include "common/endian.h"
 
 #include "graphics/blit/blit-alpha.h"
 #include "graphics/pixelformat.h"
@@ -326,6 +327,148 @@ void BlendBlit::blitSSE2(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_SSE2>(args, blendMode, alphaType);
 }
 
+class CrossBlitImpl_SSE2 {
+	friend class CrossBlit;
+
+struct Channels {
+	int count;
+	int repeats[4];
+	__m128i fill;
+	__m128i srcMask[4];
+	__m128i srcShift[4];
+	__m128i expandShift[4];
+	__m128i repeatShift[4][3];
+	__m128i dstShift[4];
+
+	Channels(const CrossBlit::Channels &channels) : count(channels.count), fill(_mm_set1_epi32(channels.fill)) {
+		for (int i = 0; i < count; i++) {
+			repeats[i] = channels.repeats[i];
+			srcMask[i] = _mm_set1_epi32(channels.srcMask[i]);
+			srcShift[i] = _mm_cvtsi32_si128(channels.srcShift[i]);
+			expandShift[i] = _mm_cvtsi32_si128(channels.expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				repeatShift[i][j] = _mm_cvtsi32_si128(channels.bits[i] << j);
+			dstShift[i] = _mm_cvtsi32_si128(channels.dstShift[i]);
+		}
+	}
+
+	inline __m128i convert(__m128i color) const {
+		__m128i out = fill;
+		for (int i = 0; i < count; i++) {
+			__m128i x = _mm_and_si128(_mm_srl_epi32(color, srcShift[i]), srcMask[i]);
+			x = _mm_sll_epi32(x, expandShift[i]);
+			for (int j = 0; j < repeats[i]; j++)
+				x = _mm_or_si128(x, _mm_srl_epi32(x, repeatShift[i][j]));
+			out = _mm_or_si128(out, _mm_sll_epi32(x, dstShift[i]));
+		}
+		return out;
+	}
+};
+
+static inline __m128i lookup4(const byte *in, const uint32 *map) {
+	return _mm_set_epi32(map[in[3]], map[in[2]], map[in[1]], map[in[0]]);
+}
+
+}; // End of class CrossBlitImpl_SSE2
+
+// The lines are converted backwards, so the pixels which do not fill a whole
+// vector are done first.
+
+void CrossBlit::convert16To32SSE2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_SSE2::Channels simd(channels);
+
+	uint x = w & ~7;
+	convert16To32Generic(dst + x * 4, src + x * 2, w - x, channels);
+
+	while (x > 0) {
+		x -= 8;
+		const __m128i color = _mm_loadu_si128((const __m128i *)(src + x * 2));
+		const __m128i lo = simd.convert(_mm_unpacklo_epi16(color, _mm_setzero_si128()));
+		const __m128i hi = simd.convert(_mm_unpackhi_epi16(color, _mm_setzero_si128()));
+		_mm_storeu_si128((__m128i *)(dst + x * 4), lo);
+		_mm_storeu_si128((__m128i *)(dst + x * 4 + 16), hi);
+	}
+}
+
+void CrossBlit::convert24To32SSE2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_SSE2::Channels simd(channels);
+	const __m128i evenMask = _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+	const __m128i oddMask = _mm_set_epi32(0xFFFFFF, 0, 0xFFFFFF, 0);
+
+	uint x = w & ~3;
+	convert24To32Generic(dst + x * 4, src + x * 3, w - x, channels);
+
+	while (x > 0) {
+		x -= 4;
+		const byte *in = src + x * 3;
+		// Get pixels 0 and 1 into the low half and pixels 2 and 3 into the
+		// high half, without reading past the last pixel
+		const __m128i pairs = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)in),
+			_mm_srli_epi64(_mm_loadl_epi64((const __m128i *)(in + 4)), 16));
+		const __m128i color = _mm_or_si128(_mm_and_si128(pairs, evenMask), _mm_and_si128(_mm_slli_epi64(pairs, 8), oddMask));
+		_mm_storeu_si128((__m128i *)(dst + x * 4), simd.convert(color));
+	}
+}
+
+// The lines are converted forwards to smaller pixels, so the pixels which do
+// not fill a whole vector are done last.
+
+void CrossBlit::convert32To16SSE2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_SSE2::Channels simd(channels);
+
+	const uint end = w & ~7;
+	for (uint x = 0; x < end; x += 8) {
+		// Sign extend the low halves, so that packing does not saturate them
+		const __m128i lo = _mm_srai_epi32(_mm_slli_epi32(simd.convert(_mm_loadu_si128((const __m128i *)(src + x * 4))), 16), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_slli_epi32(simd.convert(_mm_loadu_si128((const __m128i *)(src + x * 4 + 16))), 16), 16);
+		_mm_storeu_si128((__m128i *)(dst + x * 2), _mm_packs_epi32(lo, hi));
+	}
+
+	convert32To16Generic(dst + end * 2, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::convert32To24SSE2(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	const CrossBlitImpl_SSE2::Channels simd(channels);
+	const __m128i evenMask = _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+	const __m128i oddMask = _mm_set_epi32(0xFFFF, (int)0xFF000000, 0xFFFF, (int)0xFF000000);
+
+	const uint end = w & ~3;
+	for (uint x = 0; x < end; x += 4) {
+		const __m128i color = simd.convert(_mm_loadu_si128((const __m128i *)(src + x * 4)));
+		// Join pixels 0 and 1 into the low 6 bytes of the low half, and
+		// pixels 2 and 3 into the low 6 bytes of the high half
+		const __m128i pairs = _mm_or_si128(_mm_and_si128(color, evenMask), _mm_and_si128(_mm_srli_epi64(color, 8), oddMask));
+		const __m128i packed = _mm_or_si128(_mm_move_epi64(pairs), _mm_slli_si128(_mm_srli_si128(pairs, 8), 6));
+		_mm_storel_epi64((__m128i *)(dst + x * 3), packed);
+		WRITE_UINT32(dst + x * 3 + 8, _mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+	}
+
+	convert32To24Generic(dst + end * 3, src + end * 4, w - end, channels);
+}
+
+void CrossBlit::map8To16SSE2(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~7;
+	map8To16Generic(dst + x * 2, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 8;
+		// Sign extend the low halves, so that packing does not saturate them
+		const __m128i lo = _mm_srai_epi32(_mm_slli_epi32(CrossBlitImpl_SSE2::lookup4(src + x, map), 16), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_slli_epi32(CrossBlitImpl_SSE2::lookup4(src + x + 4, map), 16), 16);
+		_mm_storeu_si128((__m128i *)(dst + x * 2), _mm_packs_epi32(lo, hi));
+	}
+}
+
+void CrossBlit::map8To32SSE2(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	uint x = w & ~3;
+	map8To32Generic(dst + x * 4, src + x, w - x, map);
+
+	while (x > 0) {
+		x -= 4;
+		_mm_storeu_si128((__m128i *)(dst + x * 4), CrossBlitImpl_SSE2::lookup4(src + x, map));
+	}
+}
+
 } // End of namespace Graphics
 
 #if !defined(__x86_64__)
@@ -22,6 +22,7 @@
 #include "graphics/blit.h"
 #include "graphics/pixelformat.h"
 #include "common/endian.h"
+#include "common/cpu.h"
 
 namespace Graphics {
 
@@ -305,6 +306,226 @@ inline bool crossBlitHelper(byte *dst, const byte *src, const byte *mask, const
 
 } // End of anonymous namespace
 
+CrossBlit::ConvertFunc CrossBlit::convert16To32Func = nullptr;
+CrossBlit::ConvertFunc CrossBlit::convert24To32Func = nullptr;
+CrossBlit::ConvertFunc CrossBlit::convert32To16Func = nullptr;
+CrossBlit::ConvertFunc CrossBlit::convert32To24Func = nullptr;
+CrossBlit::MapFunc CrossBlit::map8To16Func = nullptr;
+CrossBlit::MapFunc CrossBlit::map8To32Func = nullptr;
+
+CrossBlit::Channels::Channels(const PixelFormat &dstFmt, const PixelFormat &srcFmt) : count(0), fill(0) {
+	const int srcBits[4]   = { srcFmt.aBits(), srcFmt.rBits(), srcFmt.gBits(), srcFmt.bBits() };
+	const int srcShifts[4] = { srcFmt.aShift, srcFmt.rShift, srcFmt.gShift, srcFmt.bShift };
+	const int dstBits[4]   = { dstFmt.aBits(), dstFmt.rBits(), dstFmt.gBits(), dstFmt.bBits() };
+	const int dstShifts[4] = { dstFmt.aShift, dstFmt.rShift, dstFmt.gShift, dstFmt.bShift };
+
+	// Colors without alpha are opaque
+	if (srcBits[0] == 0 && dstBits[0] != 0)
+		fill = ((1u << dstBits[0]) - 1) << dstShifts[0];
+
+	for (int i = 0; i < 4; i++) {
+		if (srcBits[i] == 0 || dstBits[i] == 0)
+			continue;
+
+		if (srcBits[i] == 8 && dstBits[i] == 8) {
+			const int delta = dstShifts[i] - srcShifts[i];
+			const int shiftDown = (delta < 0) ? -delta : 0;
+			const int shiftUp = (delta > 0) ? delta : 0;
+
+			int j = 0;
+			while (j < count && (bits[j] != 8 || srcShift[j] != shiftDown || dstShift[j] != shiftUp))
+				j++;
+
+			if (j == count) {
+				srcMask[j] = 0;
+				srcShift[j] = shiftDown;
+				expandShift[j] = 0;
+				repeats[j] = 0;
+				bits[j] = 8;
+				dstShift[j] = shiftUp;
+				count++;
+			}
+			srcMask[j] |= 0xFFu << (srcShifts[i] - shiftDown);
+		} else if (srcBits[i] == 8) {
+			srcMask[count] = (1u << dstBits[i]) - 1;
+			srcShift[count] = srcShifts[i] + 8 - dstBits[i];
+			expandShift[count] = 0;
+			repeats[count] = 0;
+			bits[count] = dstBits[i];
+			dstShift[count] = dstShifts[i];
+			count++;
+		} else {
+			srcMask[count] = (1u << srcBits[i]) - 1;
+			srcShift[count] = srcShifts[i];
+			expandShift[count] = 8 - srcBits[i];
+			repeats[count] = 0;
+			while ((srcBits[i] << repeats[count]) < 8)
+				repeats[count]++;
+			bits[count] = srcBits[i];
+			dstShift[count] = dstShifts[i];
+			count++;
+		}
+	}
+}
+
+static bool hasWholeBytes(const PixelFormat &fmt) {
+	if ((fmt.aLoss != 0 && fmt.aLoss != 8) || (fmt.rLoss != 0 && fmt.rLoss != 8) ||
+		(fmt.gLoss != 0 && fmt.gLoss != 8) || (fmt.bLoss != 0 && fmt.bLoss != 8))
+		return false;
+
+	return fmt.aShift <= 24 && fmt.rShift <= 24 && fmt.gShift <= 24 && fmt.bShift <= 24;
+}
+
+static bool fitsInPixel(const PixelFormat &fmt) {
+	const uint size = fmt.bytesPerPixel * 8;
+	return fmt.aLoss <= 8 && fmt.rLoss <= 8 && fmt.gLoss <= 8 && fmt.bLoss <= 8 &&
+		fmt.aShift + fmt.aBits() <= size && fmt.rShift + fmt.rBits() <= size &&
+		fmt.gShift + fmt.gBits() <= size && fmt.bShift + fmt.bBits() <= size;
+}
+
+bool CrossBlit::Channels::isSupported(const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	// From 16bpp and 24bpp to 32bpp with 8-bit components
+	if (dstFmt.bytesPerPixel == 4 && (srcFmt.bytesPerPixel == 2 || srcFmt.bytesPerPixel == 3))
+		return hasWholeBytes(dstFmt) && fitsInPixel(srcFmt);
+
+	// From 32bpp with 8-bit components to 16bpp and 24bpp
+	if (srcFmt.bytesPerPixel == 4 && (dstFmt.bytesPerPixel == 2 || dstFmt.bytesPerPixel == 3))
+		return hasWholeBytes(srcFmt) && fitsInPixel(dstFmt);
+
+	return false;
+}
+
+void CrossBlit::convert16To32Generic(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	for (uint x = w; x-- > 0;)
+		*(uint32 *)(dst + x * 4) = channels.convert(*(const uint16 *)(src + x * 2));
+}
+
+void CrossBlit::convert24To32Generic(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	for (uint x = w; x-- > 0;)
+		*(uint32 *)(dst + x * 4) = channels.convert(READ_UINT24(src + x * 3));
+}
+
+void CrossBlit::convert32To16Generic(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	for (uint x = 0; x < w; x++)
+		*(uint16 *)(dst + x * 2) = channels.convert(*(const uint32 *)(src + x * 4));
+}
+
+void CrossBlit::convert32To24Generic(byte *dst, const byte *src, const uint w, const Channels &channels) {
+	for (uint x = 0; x < w; x++)
+		WRITE_UINT24(dst + x * 3, channels.convert(*(const uint32 *)(src + x * 4)));
+}
+
+void CrossBlit::map8To16Generic(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	for (uint x = w; x-- > 0;)
+		*(uint16 *)(dst + x * 2) = map[src[x]];
+}
+
+void CrossBlit::map8To32Generic(byte *dst, const byte *src, const uint w, const uint32 *map) {
+	for (uint x = w; x-- > 0;)
+		*(uint32 *)(dst + x * 4) = map[src[x]];
+}
+
+void CrossBlit::selectFuncs() {
+	ConvertFunc convert16To32 = convert16To32Generic;
+	ConvertFunc convert24To32 = convert24To32Generic;
+	ConvertFunc convert32To16 = convert32To16Generic;
+	ConvertFunc convert32To24 = convert32To24Generic;
+	MapFunc map8To16 = map8To16Generic;
+	MapFunc map8To32 = map8To32Generic;
+
+#ifdef SCUMMVM_NEON
+	if (Common::hasNEON()) {
+		convert16To32 = convert16To32NEON;
+		convert32To16 = convert32To16NEON;
+#ifdef SCUMM_LITTLE_ENDIAN
+		convert24To32 = convert24To32NEON;
+		convert32To24 = convert32To24NEON;
+#endif
+		map8To16 = map8To16NEON;
+		map8To32 = map8To32NEON;
+	}
+#endif
+#ifdef SCUMMVM_SSE2
+	if (Common::hasSSE2()) {
+		convert16To32 = convert16To32SSE2;
+		convert24To32 = convert24To32SSE2;
+		convert32To16 = convert32To16SSE2;
+		convert32To24 = convert32To24SSE2;
+		map8To16 = map8To16SSE2;
+		map8To32 = map8To32SSE2;
+	}
+#endif
+#ifdef SCUMMVM_AVX2
+	if (Common::hasAVX2()) {
+		convert16To32 = convert16To32AVX2;
+		convert24To32 = convert24To32AVX2;
+		convert32To16 = convert32To16AVX2;
+		convert32To24 = convert32To24AVX2;
+		map8To16 = map8To16AVX2;
+		map8To32 = map8To32AVX2;
+	}
+#endif
+
+	convert24To32Func = convert24To32;
+	convert32To16Func = convert32To16;
+	convert32To24Func = convert32To24;
+	map8To16Func = map8To16;
+	map8To32Func = map8To32;
+	// This one is checked to see whether the functions were selected
+	convert16To32Func = convert16To32;
+}
+
+bool CrossBlit::convert(byte *dst, const byte *src,
+						const uint dstPitch, const uint srcPitch,
+						const uint w, const uint h,
+						const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	if (!Channels::isSupported(dstFmt, srcFmt))
+		return false;
+
+	// If no function has been selected yet, detect and select
+	if (!convert16To32Func)
+		selectFuncs();
+
+	const Channels channels(dstFmt, srcFmt);
+
+	if (dstFmt.bytesPerPixel == 4) {
+		const ConvertFunc func = (srcFmt.bytesPerPixel == 2) ? convert16To32Func : convert24To32Func;
+
+		// Like the lines, the surface is converted backwards so that it can
+		// be done in place
+		for (uint y = h; y-- > 0;)
+			func(dst + y * dstPitch, src + y * srcPitch, w, channels);
+	} else {
+		const ConvertFunc func = (dstFmt.bytesPerPixel == 2) ? convert32To16Func : convert32To24Func;
+
+		for (uint y = 0; y < h; y++)
+			func(dst + y * dstPitch, src + y * srcPitch, w, channels);
+	}
+
+	return true;
+}
+
+bool CrossBlit::convertMap(byte *dst, const byte *src,
+						   const uint dstPitch, const uint srcPitch,
+						   const uint w, const uint h,
+						   const uint bytesPerPixel, const uint32 *map) {
+	if (bytesPerPixel != 2 && bytesPerPixel != 4)
+		return false;
+
+	// If no function has been selected yet, detect and select
+	if (!convert16To32Func)
+		selectFuncs();
+
+	const MapFunc func = (bytesPerPixel == 2) ? map8To16Func : map8To32Func;
+
+	// Like the lines, the surface is converted backwards so that it can be
+	// done in place
+	for (uint y = h; y-- > 0;)
+		func(dst + y * dstPitch, src + y * srcPitch, w, map);
+
+	return true;
+}
+
 // Function to blit a rect from one color format to another
 bool crossBlit(byte *dst, const byte *src,
 				const uint dstPitch, const uint srcPitch,
@@ -328,6 +549,10 @@ bool crossBlit(byte *dst, const byte *src,
 		return true;
 	}
 
+	// Use the SIMD routines for the common conversions to and from 32bpp
+	if (CrossBlit::convert(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt))
+		return true;
+
 	return crossBlitHelper<false, false>(dst, src, nullptr, w, h, srcFmt, dstFmt, srcPitch, dstPitch, 0, 0);
 }
 
@@ -471,6 +696,10 @@ bool crossBlitMap(byte *dst, const byte *src,
 	if (!bytesPerPixel)
 		return false;
 
+	// Use the SIMD routines for the common conversions
+	if (CrossBlit::convertMap(dst, src, dstPitch, srcPitch, w, h, bytesPerPixel, map))
+		return true;
+
 	return crossBlitMapHelperLogic<false, false>(dst, src, nullptr, w, h, bytesPerPixel, map, srcPitch, dstPitch, 0, 0);
 }
 
@@ -0,0 +1,191 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphics/dirtyregion.h"
+
+namespace Graphics {
+
+DirtyRegion::DirtyRegion(int tileSize) :
+		_width(0), _height(0), _tileSize(tileSize), _columns(0), _rows(0),
+		_wordsPerRow(0), _useTiles(false) {
+	assert(tileSize > 0);
+}
+
+DirtyRegion::DirtyRegion(int16 width, int16 height, int tileSize) :
+		_width(0), _height(0), _tileSize(tileSize), _columns(0), _rows(0),
+		_wordsPerRow(0), _useTiles(false) {
+	assert(tileSize > 0);
+	setSize(width, height);
+}
+
+void DirtyRegion::setSize(int16 width, int16 height) {
+	if (width == _width && height == _height)
+		return;
+
+	Common::Array<Common::Rect> rects;
+	getRects(rects);
+
+	_width = width;
+	_height = height;
+	_columns = (width + _tileSize - 1) / _tileSize;
+	_rows = (height + _tileSize - 1) / _tileSize;
+	_wordsPerRow = (_columns + 31) / 32;
+	clear();
+
+	for (uint i = 0; i < rects.size(); i++)
+		addRect(rects[i]);
+}
+
+void DirtyRegion::addRect(const Common::Rect &r) {
+	Common::Rect rect = r;
+	rect.clip(Common::Rect(_width, _height));
+	if (rect.isEmpty())
+		return;
+
+	if (_bounds.isEmpty())
+		_bounds = rect;
+	else
+		_bounds.extend(rect);
+
+	if (_useTiles) {
+		addTiles(rect);
+		return;
+	}
+
+	// Merge the new rect with the ones it overlaps, until none is left
+	for (uint i = 0; i < _rects.size();) {
+		if (_rects[i].contains(rect))
+			return;
+
+		if (_rects[i].intersects(rect)) {
+			rect.extend(_rects[i]);
+			_rects.remove_at(i);
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	_rects.push_back(rect);
+	if (_rects.size() > kMaxRects)
+		switchToTiles();
+}
+
+void DirtyRegion::addAll() {
+	clear();
+	addRect(Common::Rect(_width, _height));
+}
+
+void DirtyRegion::clear() {
+	_bounds = Common::Rect();
+	_rects.clear();
+	_tiles.clear();
+	_useTiles = false;
+}
+
+void DirtyRegion::switchToTiles() {
+	_tiles.resize(_rows * _wordsPerRow, 0);
+	_useTiles = true;
+
+	for (uint i = 0; i < _rects.size(); i++)
+		addTiles(_rects[i]);
+	_rects.clear();
+}
+
+void DirtyRegion::addTiles(const Common::Rect &r) {
+	const int left = r.left / _tileSize;
+	const int right = (r.right - 1) / _tileSize;
+	const int top = r.top / _tileSize;
+	const int bottom = (r.bottom - 1) / _tileSize;
+
+	for (int row = top; row <= bottom; row++) {
+		uint32 *words = &_tiles[row * _wordsPerRow];
+		for (int col = left; col <= right; col++)
+			words[col / 32] |= 1U << (col % 32);
+	}
+}
+
+bool DirtyRegion::isTileDirty(int col, int row) const {
+	return (_tiles[row * _wordsPerRow + col / 32] >> (col % 32)) & 1;
+}
+
+int DirtyRegion::findTile(int col, int row, bool dirty) const {
+	const uint32 *words = &_tiles[row * _wordsPerRow];
+	while (col < _columns) {
+		// Skip whole words that cannot contain what we look for
+		const uint32 skip = dirty ? 0 : 0xFFFFFFFF;
+		if ((col % 32) == 0 && words[col / 32] == skip) {
+			col += 32;
+			continue;
+		}
+
+		if (isTileDirty(col, row) == dirty)
+			return col;
+		col++;
+	}
+
+	return _columns;
+}
+
+void DirtyRegion::getRects(Common::Array<Common::Rect> &rects) const {
+	rects.clear();
+
+	if (!_useTiles) {
+		rects = _rects;
+		return;
+	}
+
+	// Each row of tiles is split into runs of dirty tiles. A run with the
+	// same columns as one ending on the previous row extends it downwards.
+	Common::Array<uint> open, nextOpen;
+	for (int row = 0; row < _rows; row++) {
+		const int16 top = row * _tileSize;
+		const int16 bottom = top + _tileSize;
+		uint prev = 0;
+
+		nextOpen.clear();
+		for (int col = findTile(0, row, true); col < _columns; col = findTile(col, row, true)) {
+			const int end = findTile(col, row, false);
+			const int16 left = col * _tileSize;
+			const int16 right = end * _tileSize;
+			col = end;
+
+			while (prev < open.size() && rects[open[prev]].left < left)
+				prev++;
+
+			if (prev < open.size() && rects[open[prev]].left == left && rects[open[prev]].right == right) {
+				rects[open[prev]].bottom = bottom;
+				nextOpen.push_back(open[prev]);
+			} else {
+				nextOpen.push_back(rects.size());
+				rects.push_back(Common::Rect(left, top, right, bottom));
+			}
+		}
+
+		open.swap(nextOpen);
+	}
+
+	// The tiles may cover more than what was marked at the edges
+	for (uint i = 0; i < rects.size(); i++)
+		rects[i].clip(_bounds);
+}
+
+} // End of namespace Graphics
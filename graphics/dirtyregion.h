@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_DIRTYREGION_H
+#define GRAPHICS_DIRTYREGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * @defgroup graphics_dirtyregion Dirty region
+ * @ingroup graphics
+ *
+ * @brief DirtyRegion class for tracking the modified areas of a screen.
+ *
+ * @{
+ */
+
+/**
+ * Collects the areas of a surface that were modified during a frame and
+ * returns them as a small set of non-overlapping rectangles.
+ *
+ * As long as there are only a few areas, their exact rectangles are kept,
+ * merging the ones that overlap. Once there are more than kMaxRects of them,
+ * the region switches to a bitmap of tiles, so that busy frames are still
+ * described by the changed tiles rather than by a single full redraw.
+ * Runs of dirty tiles are then merged into rectangles spanning several
+ * tiles horizontally and vertically.
+ */
+class DirtyRegion {
+public:
+	enum {
+		/** Default size of the tiles in pixels. */
+		kDefaultTileSize = 16,
+		/** Number of exact rectangles kept before switching to tiles. */
+		kMaxRects = 16
+	};
+
+	DirtyRegion(int tileSize = kDefaultTileSize);
+	DirtyRegion(int16 width, int16 height, int tileSize = kDefaultTileSize);
+
+	/**
+	 * Change the size of the tracked area. The dirty areas that are
+	 * still inside of it are kept.
+	 */
+	void setSize(int16 width, int16 height);
+
+	int16 getWidth() const { return _width; }
+	int16 getHeight() const { return _height; }
+	int getTileSize() const { return _tileSize; }
+
+	/**
+	 * Mark a rectangle as dirty. It is clipped to the tracked area.
+	 */
+	void addRect(const Common::Rect &r);
+
+	/**
+	 * Mark the whole tracked area as dirty.
+	 */
+	void addAll();
+
+	/**
+	 * Forget all the dirty areas.
+	 */
+	void clear();
+
+	/**
+	 * Return true if no area is dirty.
+	 */
+	bool isEmpty() const { return _bounds.isEmpty(); }
+
+	/**
+	 * Return the bounding box of all the dirty areas.
+	 */
+	const Common::Rect &getBounds() const { return _bounds; }
+
+	/**
+	 * Return the dirty areas as non-overlapping rectangles, replacing the
+	 * contents of @p rects.
+	 */
+	void getRects(Common::Array<Common::Rect> &rects) const;
+
+private:
+	void addTiles(const Common::Rect &r);
+	void switchToTiles();
+	bool isTileDirty(int col, int row) const;
+	int findTile(int col, int row, bool dirty) const;
+
+	int16 _width, _height;
+	int _tileSize;
+	int _columns, _rows;
+	uint _wordsPerRow;
+
+	Common::Rect _bounds;
+	Common::Array<Common::Rect> _rects;
+
+	/** One bit per tile, row by row, only used once _useTiles is set. */
+	Common::Array<uint32> _tiles;
+	bool _useTiles;
+};
+
+/** @} */
+
+} // End of namespace Graphics
+
+#endif
@@ -9,6 +9,7 @@ MODULE_OBJS := \
 	blit/blit-scale.o \
 	color_quantizer.o \
 	cursorman.o \
+	dirtyregion.o \
 	font.o \
 	fontman.o \
 	fonts/amigafont.o \
@@ -178,6 +179,15 @@ ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
 	scaler/hq.o
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	scaler/hq-neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	scaler/hq-sse2.o
+endif
+
 ifdef USE_NASM
 MODULE_OBJS += \
 	scaler/hq2x_i386.o \
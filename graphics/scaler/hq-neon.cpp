@@ -0,0 +1,165 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/scaler/hq.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace {
+
+/**
+ * The YUV values of 8 pixels, in 16-bit lanes. The constant offsets of the
+ * lookup table are left out, since only differences are compared.
+ */
+struct YUV {
+	int16x8_t y, u, v;
+};
+
+class ChannelsNEON {
+public:
+	ChannelsNEON(const HQScaler::YUVChannels &channels) {
+		setChannel(0, channels.rShift, channels.rBits);
+		setChannel(1, channels.gShift, channels.gBits);
+		setChannel(2, channels.bShift, channels.bBits);
+	}
+
+	YUV load(const uint16 *src) const {
+		const uint16x8_t pixels = vld1q_u16(src);
+		uint16x8_t c[3];
+		for (int i = 0; i < 3; i++)
+			c[i] = expand(i, vandq_u16(vshlq_u16(pixels, vdupq_n_s16(-_shift[i])), vdupq_n_u16(_mask[i])));
+		return toYUV(c[0], c[1], c[2]);
+	}
+
+	YUV load(const uint32 *src) const {
+		const uint32x4_t lo = vld1q_u32(src);
+		const uint32x4_t hi = vld1q_u32(src + 4);
+		uint16x8_t c[3];
+		for (int i = 0; i < 3; i++) {
+			const int32x4_t shift = vdupq_n_s32(-_shift[i]);
+			const uint32x4_t mask = vdupq_n_u32(_mask[i]);
+			c[i] = expand(i, vcombine_u16(vmovn_u32(vandq_u32(vshlq_u32(lo, shift), mask)),
+			                              vmovn_u32(vandq_u32(vshlq_u32(hi, shift), mask))));
+		}
+		return toYUV(c[0], c[1], c[2]);
+	}
+
+private:
+	void setChannel(int i, uint shift, uint bits) {
+		_shift[i] = shift;
+		_expandLeft[i] = 8 - bits;
+		_expandRight[i] = 2 * bits - 8;
+		_mask[i] = (1 << bits) - 1;
+	}
+
+	/** Expand a component to 8 bits like PixelFormat::colorToRGB(). */
+	uint16x8_t expand(int i, uint16x8_t value) const {
+		return vorrq_u16(vshlq_u16(value, vdupq_n_s16(_expandLeft[i])), vshlq_u16(value, vdupq_n_s16(-_expandRight[i])));
+	}
+
+	static YUV toYUV(uint16x8_t r, uint16x8_t g, uint16x8_t b) {
+		const int16x8_t sr = vreinterpretq_s16_u16(r);
+		const int16x8_t sg = vreinterpretq_s16_u16(g);
+		const int16x8_t sb = vreinterpretq_s16_u16(b);
+		YUV yuv;
+		yuv.y = vreinterpretq_s16_u16(vshrq_n_u16(vaddq_u16(vaddq_u16(r, g), b), 2));
+		yuv.u = vshrq_n_s16(vsubq_s16(sr, sb), 2);
+		yuv.v = vshrq_n_s16(vsubq_s16(vsubq_s16(vshlq_n_s16(sg, 1), sr), sb), 3);
+		return yuv;
+	}
+
+	int16 _shift[3], _expandLeft[3], _expandRight[3];
+	uint16 _mask[3];
+};
+
+/**
+ * Return @p bit in the lanes where the colors differ by more than the
+ * thresholds of diffYUV().
+ */
+FORCEINLINE uint16x8_t patternBit(const YUV &center, const YUV &other, uint16 bit) {
+	const uint16x8_t differs = vorrq_u16(
+		vorrq_u16(vcgtq_s16(vabdq_s16(center.y, other.y), vdupq_n_s16(0x30)),
+		          vcgtq_s16(vabdq_s16(center.u, other.u), vdupq_n_s16(0x07))),
+		vcgtq_s16(vabdq_s16(center.v, other.v), vdupq_n_s16(0x06)));
+	return vandq_u16(differs, vdupq_n_u16(bit));
+}
+
+template<typename Pixel>
+int computePatterns(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const HQScaler::YUVChannels &channels) {
+	const ChannelsNEON ch(channels);
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8, p += 8) {
+		const YUV w5 = ch.load(p);
+
+		uint16x8_t pattern = patternBit(w5, ch.load(p - 1 - nextlineSrc), 0x0001);
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p - nextlineSrc), 0x0002));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p + 1 - nextlineSrc), 0x0004));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p - 1), 0x0008));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p + 1), 0x0010));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p - 1 + nextlineSrc), 0x0020));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p + nextlineSrc), 0x0040));
+		pattern = vorrq_u16(pattern, patternBit(w5, ch.load(p + 1 + nextlineSrc), 0x0080));
+
+		vst1_u8(patterns + x, vmovn_u16(pattern));
+	}
+
+	return x;
+}
+
+} // End of anonymous namespace
+
+int HQScaler::patterns16NEON(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels) {
+	return computePatterns<uint16>(patterns, srcPtr, srcPitch, width, channels);
+}
+
+int HQScaler::patterns32NEON(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels) {
+	return computePatterns<uint32>(patterns, srcPtr, srcPitch, width, channels);
+}
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,167 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_SSE2
+
+#include "graphics/scaler/hq.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace {
+
+/**
+ * The YUV values of 8 pixels, in 16-bit lanes. The constant offsets of the
+ * lookup table are left out, since only differences are compared.
+ */
+struct YUV {
+	__m128i y, u, v;
+};
+
+class ChannelsSSE2 {
+public:
+	ChannelsSSE2(const HQScaler::YUVChannels &channels) {
+		setChannel(0, channels.rShift, channels.rBits);
+		setChannel(1, channels.gShift, channels.gBits);
+		setChannel(2, channels.bShift, channels.bBits);
+	}
+
+	YUV load(const uint16 *src) const {
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)src);
+		__m128i c[3];
+		for (int i = 0; i < 3; i++)
+			c[i] = expand(i, _mm_and_si128(_mm_srl_epi16(pixels, _shift[i]), _mask16[i]));
+		return toYUV(c[0], c[1], c[2]);
+	}
+
+	YUV load(const uint32 *src) const {
+		const __m128i lo = _mm_loadu_si128((const __m128i *)src);
+		const __m128i hi = _mm_loadu_si128((const __m128i *)(src + 4));
+		__m128i c[3];
+		for (int i = 0; i < 3; i++) {
+			// The components are at most 6 bits, so packing does not saturate
+			c[i] = expand(i, _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(lo, _shift[i]), _mask32[i]),
+			                                 _mm_and_si128(_mm_srl_epi32(hi, _shift[i]), _mask32[i])));
+		}
+		return toYUV(c[0], c[1], c[2]);
+	}
+
+private:
+	void setChannel(int i, uint shift, uint bits) {
+		_shift[i] = _mm_cvtsi32_si128(shift);
+		_expandLeft[i] = _mm_cvtsi32_si128(8 - bits);
+		_expandRight[i] = _mm_cvtsi32_si128(2 * bits - 8);
+		_mask16[i] = _mm_set1_epi16((1 << bits) - 1);
+		_mask32[i] = _mm_set1_epi32((1 << bits) - 1);
+	}
+
+	/** Expand a component to 8 bits like PixelFormat::colorToRGB(). */
+	__m128i expand(int i, __m128i value) const {
+		return _mm_or_si128(_mm_sll_epi16(value, _expandLeft[i]), _mm_srl_epi16(value, _expandRight[i]));
+	}
+
+	static YUV toYUV(__m128i r, __m128i g, __m128i b) {
+		YUV yuv;
+		yuv.y = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(r, g), b), 2);
+		yuv.u = _mm_srai_epi16(_mm_sub_epi16(r, b), 2);
+		yuv.v = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(_mm_slli_epi16(g, 1), r), b), 3);
+		return yuv;
+	}
+
+	__m128i _shift[3], _expandLeft[3], _expandRight[3];
+	__m128i _mask16[3], _mask32[3];
+};
+
+FORCEINLINE __m128i absDiff(__m128i a, __m128i b) {
+	const __m128i diff = _mm_sub_epi16(a, b);
+	return _mm_max_epi16(diff, _mm_sub_epi16(_mm_setzero_si128(), diff));
+}
+
+/**
+ * Return @p bit in the lanes where the colors differ by more than the
+ * thresholds of diffYUV().
+ */
+FORCEINLINE __m128i patternBit(const YUV &center, const YUV &other, int bit) {
+	const __m128i differs = _mm_or_si128(
+		_mm_or_si128(_mm_cmpgt_epi16(absDiff(center.y, other.y), _mm_set1_epi16(0x30)),
+		             _mm_cmpgt_epi16(absDiff(center.u, other.u), _mm_set1_epi16(0x07))),
+		_mm_cmpgt_epi16(absDiff(center.v, other.v), _mm_set1_epi16(0x06)));
+	return _mm_and_si128(differs, _mm_set1_epi16(bit));
+}
+
+template<typename Pixel>
+int computePatterns(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const HQScaler::YUVChannels &channels) {
+	const ChannelsSSE2 ch(channels);
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8, p += 8) {
+		const YUV w5 = ch.load(p);
+
+		__m128i pattern = patternBit(w5, ch.load(p - 1 - nextlineSrc), 0x0001);
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p - nextlineSrc), 0x0002));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p + 1 - nextlineSrc), 0x0004));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p - 1), 0x0008));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p + 1), 0x0010));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p - 1 + nextlineSrc), 0x0020));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p + nextlineSrc), 0x0040));
+		pattern = _mm_or_si128(pattern, patternBit(w5, ch.load(p + 1 + nextlineSrc), 0x0080));
+
+		_mm_storel_epi64((__m128i *)(patterns + x), _mm_packus_epi16(pattern, pattern));
+	}
+
+	return x;
+}
+
+} // End of anonymous namespace
+
+int HQScaler::patterns16SSE2(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels) {
+	return computePatterns<uint16>(patterns, srcPtr, srcPitch, width, channels);
+}
+
+int HQScaler::patterns32SSE2(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels) {
+	return computePatterns<uint32>(patterns, srcPtr, srcPitch, width, channels);
+}
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
+
+#endif // SCUMMVM_SSE2
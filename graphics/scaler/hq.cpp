@@ -21,6 +21,7 @@
 #include "graphics/scaler/hq.h"
 #include "graphics/scaler.h"
 #include "graphics/scaler/intern.h"
+#include "common/cpu.h"
 
 // RGB-to-YUV lookup table
 
@@ -193,15 +194,110 @@ static inline uint32 ConvertYUV(uint32 x, const uint32 *RGBtoYUV) {
 	return RGBtoYUV[r | g | b];
 }
 
+enum {
+	/** The number of pixels whose pattern is computed at once. */
+	kPatternChunk = 256
+};
+
+/**
+ * Compute the edge patterns of a row using the lookup table.
+ *
+ * @see HQScaler::PatternFunc
+ */
+template<typename ColorMask>
+static void computePatterns(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const uint32 *RGBtoYUV) {
+	typedef typename ColorMask::PixelType Pixel;
+
+	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
+
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
+
+	w1 = *(p - 1 - nextlineSrc);
+	w4 = *(p - 1);
+	w7 = *(p - 1 + nextlineSrc);
+
+	w2 = *(p - nextlineSrc);
+	w5 = *(p);
+	w8 = *(p + nextlineSrc);
+
+	for (int x = 0; x < width; x++) {
+		p++;
+
+		w3 = *(p - nextlineSrc);
+		w6 = *(p);
+		w9 = *(p + nextlineSrc);
+
+		int pattern = 0;
+		const int yuv5 = YUV(5);
+		if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
+		if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
+		if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
+		if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
+		if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
+		if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
+		if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
+		if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+		patterns[x] = pattern;
+
+		w1 = w2;
+		w4 = w5;
+		w7 = w8;
+
+		w2 = w3;
+		w5 = w6;
+		w8 = w9;
+	}
+}
+
+/**
+ * Compute the edge patterns of a row, with SIMD as far as possible.
+ */
+template<typename ColorMask>
+static inline void getPatterns(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const uint32 *RGBtoYUV,
+							   HQScaler::PatternFunc patternFunc, const HQScaler::YUVChannels &channels) {
+	const int done = patternFunc ? patternFunc(patterns, srcPtr, srcPitch, width, channels) : 0;
+	computePatterns<ColorMask>(patterns + done, srcPtr + done * sizeof(typename ColorMask::PixelType), srcPitch, width - done, RGBtoYUV);
+}
+
+/**
+ * Get the components used by the YUV conversion of the scalers.
+ */
+template<typename ColorMask>
+static HQScaler::YUVChannels getYUVChannels(const Graphics::PixelFormat &format) {
+	HQScaler::YUVChannels channels;
+	if (ColorMask::kBytesPerPixel == 2) {
+		// The lookup table is built from the format itself
+		channels.rShift = format.rShift;
+		channels.gShift = format.gShift;
+		channels.bShift = format.bShift;
+		channels.rBits = format.rBits();
+		channels.gBits = format.gBits();
+		channels.bBits = format.bBits();
+	} else {
+		// See ConvertYUV()
+		channels.rShift = ColorMask::kRedShift + 3;
+		channels.gShift = ColorMask::kGreenShift + 2;
+		channels.bShift = ColorMask::kBlueShift + 3;
+		channels.rBits = 5;
+		channels.gBits = 6;
+		channels.bBits = 5;
+	}
+	return channels;
+}
+
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (https://web.archive.org/web/20090204033742/http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV,
+								HQScaler::PatternFunc patternFunc, const HQScaler::YUVChannels &channels) {
 	typedef typename ColorMask::PixelType Pixel;
 
+	uint8 patterns[kPatternChunk];
+
 	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
 
 	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
@@ -230,24 +326,17 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
-		int tmpWidth = width;
-		while (tmpWidth--) {
+		for (int x = 0; x < width; x++) {
+			if (x % kPatternChunk == 0)
+				getPatterns<ColorMask>(patterns, (const uint8 *)p, srcPitch, MIN<int>(width - x, kPatternChunk), RGBtoYUV, patternFunc, channels);
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			const int pattern = patterns[x % kPatternChunk];
 
 			switch (pattern) {
 			case 0:
@@ -2116,9 +2205,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV,
+								HQScaler::PatternFunc patternFunc, const HQScaler::YUVChannels &channels) {
 	typedef typename ColorMask::PixelType Pixel;
 
+	uint8 patterns[kPatternChunk];
+
 	int  w1, w2, w3, w4, w5, w6, w7, w8, w9;
 
 	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
@@ -2148,24 +2240,17 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
-		int tmpWidth = width;
-		while (tmpWidth--) {
+		for (int x = 0; x < width; x++) {
+			if (x % kPatternChunk == 0)
+				getPatterns<ColorMask>(patterns, (const uint8 *)p, srcPitch, MIN<int>(width - x, kPatternChunk), RGBtoYUV, patternFunc, channels);
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			const int pattern = patterns[x % kPatternChunk];
 
 			switch (pattern) {
 			case 0:
@@ -4951,9 +5036,24 @@ HQScaler::HQScaler(const Graphics::PixelFormat &format) : Scaler(format),
 #ifdef USE_NASM
 	_hqx_params(nullptr),
 #endif
-	_RGBtoYUV(nullptr) {
+	_RGBtoYUV(nullptr), _patternFunc(nullptr) {
 	_factor = 2;
 
+	// The SIMD code expands the components the same way as PixelFormat
+	// only for components of at least 4 bits
+	const bool simdFormat = format.bytesPerPixel == 4 ||
+		(format.rBits() >= 4 && format.gBits() >= 4 && format.bBits() >= 4);
+	if (simdFormat) {
+#ifdef SCUMMVM_NEON
+		if (Common::hasNEON())
+			_patternFunc = (format.bytesPerPixel == 2) ? patterns16NEON : patterns32NEON;
+#endif
+#ifdef SCUMMVM_SSE2
+		if (Common::hasSSE2())
+			_patternFunc = (format.bytesPerPixel == 2) ? patterns16SSE2 : patterns32SSE2;
+#endif
+	}
+
 	if (format.bytesPerPixel == 2) {
 		initLUT(format);
 	} else {
@@ -4987,19 +5087,19 @@ void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 void HQScaler::HQ2x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<565> >(_format));
 	else
 		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<555> >(_format));
 }
 
 void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ3x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<565> >(_format));
 	else
 		HQ3x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<555> >(_format));
 }
 #endif
 
@@ -5007,15 +5107,15 @@ void HQScaler::HQ2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ2x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<-8888> >(_format));
 		} else {
 			HQ2x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<8888> >(_format));
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ2x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<888> >(_format));
 	}
 }
 
@@ -5023,15 +5123,15 @@ void HQScaler::HQ3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ3x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<-8888> >(_format));
 		} else {
 			HQ3x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<8888> >(_format));
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ3x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternFunc, getYUVChannels<Graphics::ColorMasks<888> >(_format));
 	}
 }
 
@@ -27,12 +27,32 @@
 struct hqx_parameters;
 #endif
 
+class HQScalerTestSuite;
+
 class HQScaler : public Scaler {
 public:
 	HQScaler(const Graphics::PixelFormat &format);
 	~HQScaler();
 	uint increaseFactor() override;
 	uint decreaseFactor() override;
+
+	/**
+	 * Position and size of the RGB components used to compute the YUV value
+	 * of a pixel. 32bpp pixels only use the top 5, 6 and 5 bits.
+	 */
+	struct YUVChannels {
+		uint rShift, gShift, bShift;
+		uint rBits, gBits, bBits;
+	};
+
+	/**
+	 * Compute the edge pattern of the pixels of a row: bit n is set when the
+	 * n-th neighbor differs enough from the pixel. The SIMD versions leave
+	 * out the last pixels not filling a whole vector, and return the number
+	 * of pixels done.
+	 */
+	typedef int (*PatternFunc)(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels);
+
 protected:
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch,
 							uint8 *dstPtr, uint32 dstPitch, int width, int height, int x, int y) override;
@@ -48,6 +68,20 @@ protected:
 	hqx_parameters *_hqx_params;
 #endif
 
+	/** The SIMD pattern function for the format, or nullptr to use the lookup table. */
+	PatternFunc _patternFunc;
+
+private:
+	friend class ::HQScalerTestSuite;
+
+#ifdef SCUMMVM_NEON
+	static int patterns16NEON(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels);
+	static int patterns32NEON(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels);
+#endif
+#ifdef SCUMMVM_SSE2
+	static int patterns16SSE2(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels);
+	static int patterns32SSE2(uint8 *patterns, const uint8 *srcPtr, uint32 srcPitch, int width, const YUVChannels &channels);
+#endif
 };
 
 
@@ -20,6 +20,8 @@
 
 #include "graphics/scalerplugin.h"
 
+#include "common/taskpool.h"
+
 namespace {
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
@@ -52,9 +54,24 @@ void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 		} else {
 			Normal1x<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 		}
+		return;
+	}
+
+	if (_taskPool && height >= 2 * kMinBandHeight) {
+		Bands bands = { this, srcPtr, srcPitch, dstPtr, dstPitch, width, x, y };
+		_taskPool->parallelFor(height, scaleBands, &bands, kMinBandHeight);
 	} else {
 		scaleIntern(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
 	}
+
+	scaleDone(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
+}
+
+void Scaler::scaleBands(uint begin, uint end, void *param) {
+	const Bands *bands = (const Bands *)param;
+	bands->scaler->scaleIntern(bands->srcPtr + begin * bands->srcPitch, bands->srcPitch,
+	                           bands->dstPtr + begin * bands->scaler->_factor * bands->dstPitch, bands->dstPitch,
+	                           bands->width, end - begin, bands->x, bands->y + begin);
 }
 
 SourceScaler::SourceScaler(const Graphics::PixelFormat &format) : Scaler(format), _width(0), _height(0), _oldSrc(NULL), _enable(false) {
@@ -111,6 +128,16 @@ void SourceScaler::scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstP
 	            _oldSrc + offset, srcPitch,
 	            width, height,
 	            (uint8 *)_bufferedOutput.getBasePtr(x * _factor, y * _factor), _bufferedOutput.pitch);
+}
+
+void SourceScaler::scaleDone(const uint8 *srcPtr, uint32 srcPitch, const uint8 *dstPtr,
+						 uint32 dstPitch, int width, int height, int x, int y) {
+	if (!_enable)
+		return;
+
+	// The old source and output are only updated once all bands are done,
+	// since the bands read the rows around them from the old source
+	int offset = (_padding + x) * _format.bytesPerPixel + (_padding + y) * srcPitch;
 
 	// Update the destination buffer
 	byte *buffer = (byte *)_bufferedOutput.getBasePtr(x * _factor, y * _factor);
@@ -25,14 +25,24 @@
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
+namespace Common {
+class TaskPool;
+}
+
 class Scaler {
 public:
-	Scaler(const Graphics::PixelFormat &format) : _format(format) {}
+	Scaler(const Graphics::PixelFormat &format) : _format(format), _taskPool(nullptr) {}
 	virtual ~Scaler() {}
 
 	/**
 	 * Scale a rect.
 	 *
+	 * If a task pool is set, rects of at least 2 * kMinBandHeight rows are
+	 * split into row bands, which are scaled concurrently. Each band reads
+	 * the rows around it (see ScalerPluginObject::extraPixels()) from the
+	 * source and only writes its own rows, so the result is the same as
+	 * when scaling the whole rect at once.
+	 *
 	 * @param srcPtr   Pointer to the source buffer.
 	 * @param srcPitch The number of bytes in a scanline of the source.
 	 * @param dstPtr   Pointer to the destination buffer.
@@ -59,6 +69,14 @@ public:
 
 	virtual uint getFactor() const { return _factor; }
 
+	/**
+	 * Set the pool used to scale large rects in row bands. By default, or
+	 * when passing nullptr, rects are scaled on the calling thread.
+	 */
+	void setTaskPool(Common::TaskPool *pool) { _taskPool = pool; }
+
+	Common::TaskPool *getTaskPool() const { return _taskPool; }
+
 	/**
 	 * Set the scaling factor.
 	 * Intended to be used with GUI to set a known valid factor.
@@ -95,14 +113,46 @@ public:
 	}
 
 protected:
+	enum {
+		/** The smallest number of source rows scaled by a task. */
+		kMinBandHeight = 16
+	};
+
 	/**
+	 * Scale a rect, or a band of rows of it. When a task pool is set, this
+	 * may be called from several threads at the same time for different
+	 * bands of the same rect, so it must not modify any member.
+	 *
 	 * @see scale
 	 */
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                         uint32 dstPitch, int width, int height, int x, int y) = 0;
 
+	/**
+	 * Called on the calling thread of scale(), once all bands of a rect are
+	 * scaled. Scalers keeping track of earlier frames can update their
+	 * state here.
+	 */
+	virtual void scaleDone(const uint8 *srcPtr, uint32 srcPitch, const uint8 *dstPtr,
+	                       uint32 dstPitch, int width, int height, int x, int y) {}
+
 	uint _factor;
 	Graphics::PixelFormat _format;
+
+private:
+	struct Bands {
+		Scaler *scaler;
+		const uint8 *srcPtr;
+		uint32 srcPitch;
+		uint8 *dstPtr;
+		uint32 dstPitch;
+		int width;
+		int x, y;
+	};
+
+	static void scaleBands(uint begin, uint end, void *param);
+
+	Common::TaskPool *_taskPool;
 };
 
 /**
@@ -127,8 +177,13 @@ protected:
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                         uint32 dstPitch, int width, int height, int x, int y) final;
 
+	virtual void scaleDone(const uint8 *srcPtr, uint32 srcPitch, const uint8 *dstPtr,
+	                       uint32 dstPitch, int width, int height, int x, int y) final;
+
 	/**
 	 * Scalers must implement this function. It will be called by oldSrcScale.
+	 * Like scaleIntern(), it may be called concurrently for different bands
+	 * of the same rect.
 	 * If by comparing the src and oldsrc images it is discovered that no change
 	 * is necessary, do not write a pixel.
 	 *
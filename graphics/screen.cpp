@@ -28,14 +28,17 @@ namespace Graphics {
 
 Screen::Screen(): ManagedSurface() {
 	create(g_system->getWidth(), g_system->getHeight(), g_system->getScreenFormat());
+	_dirtyRegion.setSize(w, h);
 }
 
 Screen::Screen(int width, int height): ManagedSurface() {
 	create(width, height);
+	_dirtyRegion.setSize(w, h);
 }
 
 Screen::Screen(int width, int height, PixelFormat pixelFormat): ManagedSurface() {
 	create(width, height, pixelFormat);
+	_dirtyRegion.setSize(w, h);
 }
 
 void Screen::update() {
@@ -76,8 +79,33 @@ void Screen::makeAllDirty() {
 }
 
 void Screen::mergeDirtyRects() {
+	if (_dirtyRects.size() < 2)
+		return;
+
 	Common::List<Common::Rect>::iterator rOuter, rInner;
 
+	Common::Rect bounds = _dirtyRects.front();
+	for (rOuter = _dirtyRects.begin(); rOuter != _dirtyRects.end(); ++rOuter)
+		bounds.extend(*rOuter);
+
+	if (bounds.left >= 0 && bounds.top >= 0) {
+		// Let the region merge the overlapping rects. When there are many
+		// of them, it also turns them into a few larger ones.
+		if (bounds.right > _dirtyRegion.getWidth() || bounds.bottom > _dirtyRegion.getHeight())
+			_dirtyRegion.setSize(MAX(_dirtyRegion.getWidth(), bounds.right), MAX(_dirtyRegion.getHeight(), bounds.bottom));
+
+		_dirtyRegion.clear();
+		for (rOuter = _dirtyRects.begin(); rOuter != _dirtyRects.end(); ++rOuter)
+			_dirtyRegion.addRect(*rOuter);
+
+		Common::Array<Common::Rect> rects;
+		_dirtyRegion.getRects(rects);
+		_dirtyRects.clear();
+		for (uint i = 0; i < rects.size(); i++)
+			_dirtyRects.push_back(rects[i]);
+		return;
+	}
+
 	// Process the dirty rect list to find any rects to merge
 	for (rOuter = _dirtyRects.begin(); rOuter != _dirtyRects.end(); ++rOuter) {
 		rInner = rOuter;
@@ -22,6 +22,7 @@
 #ifndef GRAPHICS_SCREEN_H
 #define GRAPHICS_SCREEN_H
 
+#include "graphics/dirtyregion.h"
 #include "graphics/managed_surface.h"
 #include "graphics/palette.h"
 #include "graphics/pixelformat.h"
@@ -51,9 +52,15 @@ protected:
 	 * List of affected areas of the screen
 	 */
 	Common::List<Common::Rect> _dirtyRects;
+private:
+	/**
+	 * Used by mergeDirtyRects() to coalesce the dirty areas
+	 */
+	DirtyRegion _dirtyRegion;
 protected:
 	/**
-	 * Merges together overlapping dirty areas of the screen
+	 * Merges together overlapping dirty areas of the screen. Many small
+	 * areas are also coalesced into a few larger ones
 	 */
 	void mergeDirtyRects();
 
@@ -36,6 +36,8 @@
 
 #include "engines/engine.h"
 
+#include "audio/mixer.h"
+
 #include "gui/debugger.h"
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 	#include "gui/console.h"
@@ -81,6 +83,8 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+
+	registerCmd("mixer_stats",		WRAP_METHOD(Debugger, cmdMixerStats));
 }
 
 Debugger::~Debugger() {
@@ -777,6 +781,30 @@ bool Debugger::cmdDebugLevel(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdMixerStats(int argc, const char **argv) {
+	Audio::Mixer *mixer = g_system->getMixer();
+
+	if (argc == 2 && !strcmp(argv[1], "on")) {
+		mixer->setProfiling(true);
+		debugPrintf("Mixer profiling enabled\n");
+	} else if (argc == 2 && !strcmp(argv[1], "off")) {
+		mixer->setProfiling(false);
+		debugPrintf("Mixer profiling disabled\n");
+	} else if (argc == 2 && !strcmp(argv[1], "reset")) {
+		// Enabling the profiling again resets the statistics
+		mixer->setProfiling(true);
+		debugPrintf("Mixer statistics reset\n");
+	} else if (argc == 1) {
+		debugPrintf("%s\n", mixer->getStatsReport().c_str());
+		if (!mixer->isProfiling())
+			debugPrintf("Usage: %s [on | off | reset]\n", argv[0]);
+	} else {
+		debugPrintf("Usage: %s [on | off | reset]\n", argv[0]);
+	}
+
+	return true;
+}
+
 bool Debugger::cmdDebugFlagsList(int argc, const char **argv) {
 	const Common::DebugManager::DebugChannelList &debugLevels = DebugMan.getDebugChannels();
 
@@ -25,6 +25,7 @@
 #include "common/debug.h"
 #include "common/system.h"
 #include "common/taskbar.h"
+#include "common/taskpool.h"
 #include "common/translation.h"
 
 #include "engines/advancedDetector.h"
@@ -68,7 +69,7 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	Common::U32StringArray l;
 
 	// The dir we start our scan at
-	_scanStack.push(startDir);
+	_scanStack.push(AdvancedDetectorCacheManager::ScannedDirectory(startDir));
 
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
@@ -158,6 +159,7 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 	} else if (cmd == kCancelCmd) {
 		// User cancelled, so we don't do anything and just leave.
 		_games.clear();
+		ADCacheMan.clearScannedDirectories();
 		close();
 	} else if (cmd == kListSelectionChangedCmd) {
 		// Select / unselect game from list
@@ -183,6 +185,21 @@ void MassAddDialog::updateGameList() {
 	}
 }
 
+void MassAddDialog::scanNextDirectories() {
+	// List a few of the next directories at once on the worker threads. They
+	// are left in place on the stack, so that they are still detected in the
+	// order of a sequential scan, whatever the number of threads.
+	const uint numThreads = g_system->getTaskPool()->getNumThreads();
+	const uint batchSize = (numThreads > 1) ? 2 * numThreads : 1;
+
+	Common::Array<AdvancedDetectorCacheManager::ScannedDirectory *> dirs;
+	for (uint i = _scanStack.size(); i > 0 && dirs.size() < batchSize; i--) {
+		if (!_scanStack[i - 1].scanned)
+			dirs.push_back(&_scanStack[i - 1]);
+	}
+	ADCacheMan.scanDirectories(dirs);
+}
+
 void MassAddDialog::handleTickle() {
 	if (_scanStack.empty())
 		return;	// We have finished scanning
@@ -191,15 +208,19 @@ void MassAddDialog::handleTickle() {
 
 	// Perform a breadth-first scan of the filesystem.
 	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+		if (!_scanStack.top().scanned)
+			scanNextDirectories();
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
+		const AdvancedDetectorCacheManager::ScannedDirectory scanned = _scanStack.pop();
+		const Common::FSNode &dir = scanned.dir;
+		const Common::FSList &files = scanned.files;
+		if (!scanned.listed) {
 			continue;
 		}
 
 		// Run the detector on the dir
 		DetectionResults detectionResults = EngineMan.detectGames(files, (ADGF_WARNING | ADGF_UNSUPPORTED | ADGF_ADDON), true);
+		ADCacheMan.releaseScannedDirectory(scanned);
 
 		if (detectionResults.foundUnknownGames()) {
 			Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
@@ -258,7 +279,7 @@ void MassAddDialog::handleTickle() {
 		// Recurse into all subdirs
 		for (const auto &file : files) {
 			if (file.isDirectory()) {
-				_scanStack.push(file);
+				_scanStack.push(AdvancedDetectorCacheManager::ScannedDirectory(file));
 
 				_dirTotal++;
 			}
@@ -277,6 +298,11 @@ void MassAddDialog::handleTickle() {
 	Common::U32String buf;
 
 	if (_scanStack.empty()) {
+		ADCacheMan.clearScannedDirectories();
+
+		// Remember the hashes computed during the scan for the next one
+		ADCacheMan.flushPersistentCache();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
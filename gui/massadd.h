@@ -24,6 +24,7 @@
 
 #include "gui/dialog.h"
 #include "gui/widgets/list.h"
+#include "engines/advancedDetector.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
 #include "common/stack.h"
@@ -49,10 +50,11 @@ public:
 	}
 
 private:
-	Common::Stack<Common::FSNode>  _scanStack;
+	Common::Stack<AdvancedDetectorCacheManager::ScannedDirectory>  _scanStack;
 	DetectedGames _games;
 
 	void updateGameList();
+	void scanNextDirectories();
 
 	/**
 	 * Map each path occurring in the config file to the target(s) using that path.
@@ -4,6 +4,8 @@
 
 #include "helper.h"
 
+#include "../system/null_osystem.h"
+
 class AudioStreamTestSuite : public CxxTest::TestSuite
 {
 public:
@@ -205,4 +207,43 @@ public:
 	void test_sub_looping_audio_stream_stereo_22050_end_fixed_iter() {
 		testSubLoopingAudioStreamFixedIter(22050, true, 2, 2);
 	}
+
+	void test_queuing_audio_stream() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// The stream needs g_system for its mutex
+		Common::install_null_g_system();
+
+		// Queue more streams than can wait to be picked up by the mixer
+		// thread, and check that they still play in order
+		const int numStreams = 200;
+		Audio::QueuingAudioStream *s = Audio::makeQueuingAudioStream(11025, false);
+		for (int i = 0; i < numStreams; i++) {
+			byte *data = (byte *)malloc(2);
+			data[0] = i;
+			data[1] = 0x80;
+			s->queueAudioStream(Audio::makeRawStream(data, 2, 11025, Audio::FLAG_UNSIGNED));
+		}
+		TS_ASSERT_EQUALS(s->numQueuedStreams(), (uint32)numStreams);
+		TS_ASSERT(!s->endOfData());
+
+		int16 buffer[numStreams * 2];
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, numStreams), numStreams);
+		for (int i = 0; i < numStreams / 2; i++) {
+			TS_ASSERT_EQUALS(buffer[i * 2], (int16)((i ^ 0x80) << 8));
+			TS_ASSERT_EQUALS(buffer[i * 2 + 1], 0);
+		}
+		TS_ASSERT_EQUALS(s->numQueuedStreams(), (uint32)numStreams / 2);
+		TS_ASSERT(!s->endOfStream());
+
+		s->finish();
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, numStreams * 2), numStreams);
+		TS_ASSERT_EQUALS(s->numQueuedStreams(), 0u);
+		TS_ASSERT(s->endOfData());
+		TS_ASSERT(s->endOfStream());
+
+		delete s;
+
+		Common::uninstall_null_g_system();
+#endif
+	}
 };
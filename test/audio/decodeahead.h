@@ -0,0 +1,232 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decodeahead.h"
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+
+#include "common/atomic.h"
+#include "common/taskpool.h"
+
+#include "../system/threaded_taskpool.h"
+
+class DecodeAheadTestSuite : public CxxTest::TestSuite {
+	/** Counts the samples read from a stream. */
+	class CountingStream : public Audio::SeekableAudioStream {
+	public:
+		CountingStream(Audio::SeekableAudioStream *parent) : _parent(parent), _numRead(0) {}
+		~CountingStream() { delete _parent; }
+
+		int readBuffer(int16 *buffer, const int numSamples) override {
+			const int numRead = _parent->readBuffer(buffer, numSamples);
+			_numRead.fetchAdd(MAX(numRead, 0));
+			return numRead;
+		}
+
+		bool isStereo() const override { return _parent->isStereo(); }
+		int getRate() const override { return _parent->getRate(); }
+		bool endOfData() const override { return _parent->endOfData(); }
+		bool seek(const Audio::Timestamp &where) override { return _parent->seek(where); }
+		Audio::Timestamp getLength() const override { return _parent->getLength(); }
+
+		/** Updated by the decoding tasks, so it is atomic. */
+		Common::Atomic<int> _numRead;
+
+	private:
+		Audio::SeekableAudioStream *_parent;
+	};
+
+	enum {
+		kRate = 11025,
+		kNumSamples = 2 * kRate * 3
+	};
+
+	static int16 expectedSample(int i) {
+		return (int16)(i * 7 - 32000);
+	}
+
+	static CountingStream *createStream() {
+		int16 *data = (int16 *)malloc(kNumSamples * sizeof(int16));
+		for (int i = 0; i < kNumSamples; i++)
+			data[i] = expectedSample(i);
+		return new CountingStream(Audio::makeRawStream((byte *)data, kNumSamples * sizeof(int16), kRate, Audio::FLAG_16BITS | Audio::FLAG_STEREO
+#ifdef SCUMM_LITTLE_ENDIAN
+			| Audio::FLAG_LITTLE_ENDIAN
+#endif
+			));
+	}
+
+	/**
+	 * Read @p count samples, which should start at sample @p pos. When the
+	 * decoding falls behind, reads may be short, like in the mixer.
+	 */
+	static void checkRead(Audio::AudioStream *stream, int pos, int count) {
+		int16 buffer[1000];
+		while (count > 0) {
+			const int numRead = stream->readBuffer(buffer, MIN<int>(count, ARRAYSIZE(buffer)));
+			TS_ASSERT_LESS_THAN_EQUALS(0, numRead);
+			TS_ASSERT_LESS_THAN_EQUALS(numRead, MIN<int>(count, ARRAYSIZE(buffer)));
+			if (numRead <= 0 && stream->endOfData()) {
+				TS_FAIL("Unexpected end of data");
+				return;
+			}
+			for (int i = 0; i < numRead; i++)
+				TS_ASSERT_EQUALS(buffer[i], expectedSample(pos + i));
+			pos += numRead;
+			count -= numRead;
+		}
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	struct Blocker {
+		Common::Atomic<bool> started;
+		Common::Atomic<bool> released;
+	};
+
+	// Keeps a worker busy until released
+	static void block(void *param) {
+		Blocker *blocker = (Blocker *)param;
+		blocker->started = true;
+		while (!blocker->released)
+			;
+	}
+#endif
+
+public:
+	void test_serial_passthrough() {
+		// Without worker threads, nothing is decoded ahead
+		Common::TaskPool pool;
+		CountingStream *parent = createStream();
+		Audio::SeekableAudioStream *stream = Audio::makeDecodeAheadStream(parent, DisposeAfterUse::YES, 500, &pool);
+
+		TS_ASSERT(stream->isStereo());
+		TS_ASSERT_EQUALS(stream->getRate(), (int)kRate);
+		TS_ASSERT_EQUALS((int)parent->_numRead, 0);
+		checkRead(stream, 0, 100);
+		TS_ASSERT_EQUALS((int)parent->_numRead, 100);
+		delete stream;
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	void test_decode_ahead() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(2);
+		CountingStream *parent = createStream();
+		Audio::SeekableAudioStream *stream = Audio::makeDecodeAheadStream(parent, DisposeAfterUse::YES, 500, pool);
+		TS_ASSERT_EQUALS(stream->getLength().msecs(), 3000);
+
+		// The lead time is decoded ahead, without reading
+		while (parent->_numRead < (int)kRate)
+			;
+
+		// All samples arrive in order, and the end is only reported once
+		// they have all been read
+		checkRead(stream, 0, kNumSamples);
+
+		int16 buffer[16];
+		TS_ASSERT_EQUALS(stream->readBuffer(buffer, ARRAYSIZE(buffer)), 0);
+		TS_ASSERT(stream->endOfData());
+		TS_ASSERT(stream->endOfStream());
+		TS_ASSERT_EQUALS((int)parent->_numRead, (int)kNumSamples);
+
+		delete stream;
+		delete pool;
+	}
+
+	void test_reader_never_waits() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(1);
+
+		// Keep the only worker busy, so that the first decoding task stays
+		// queued
+		Blocker blocker;
+		Common::TaskPool::TaskGroup group;
+		pool->submit(group, block, &blocker);
+		while (!blocker.started)
+			;
+
+		CountingStream *parent = createStream();
+		Audio::SeekableAudioStream *stream = Audio::makeDecodeAheadStream(parent, DisposeAfterUse::YES, 200, pool);
+
+		// Reading does not wait for the queued task, but claims it and
+		// reads the parent directly
+		checkRead(stream, 0, 100);
+		TS_ASSERT_EQUALS((int)parent->_numRead, 100);
+
+		blocker.released = true;
+		pool->wait(group);
+
+		// The claimed task did not decode anything, and decoding ahead
+		// starts again with the next read
+		TS_ASSERT_EQUALS((int)parent->_numRead, 100);
+		checkRead(stream, 100, kNumSamples - 100);
+		TS_ASSERT(stream->endOfStream());
+
+		delete stream;
+		delete pool;
+	}
+
+	void test_destroy_queued() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(1);
+
+		Blocker blocker;
+		Common::TaskPool::TaskGroup group;
+		pool->submit(group, block, &blocker);
+		while (!blocker.started)
+			;
+
+		// Deleting the wrapper cancels the queued task instead of running it
+		CountingStream *parent = createStream();
+		Audio::AudioStream *stream = Audio::makeDecodeAheadStream((Audio::AudioStream *)parent, DisposeAfterUse::NO, 200, pool);
+		delete stream;
+		TS_ASSERT_EQUALS((int)parent->_numRead, 0);
+
+		blocker.released = true;
+		pool->wait(group);
+		TS_ASSERT_EQUALS((int)parent->_numRead, 0);
+
+		delete pool;
+		delete parent;
+	}
+
+	void test_seek() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(2);
+		Audio::SeekableAudioStream *stream = Audio::makeDecodeAheadStream(createStream(), DisposeAfterUse::YES, 200, pool);
+		checkRead(stream, 0, 500);
+
+		TS_ASSERT(stream->seek(Audio::Timestamp(0, 1000, kRate)));
+		checkRead(stream, 2000, 3000);
+
+		// Seeking right after seeking, while a task may be running
+		TS_ASSERT(stream->seek(Audio::Timestamp(0, 5, kRate)));
+		TS_ASSERT(stream->seek(Audio::Timestamp(0, 3, kRate)));
+		checkRead(stream, 6, 500);
+
+		TS_ASSERT(stream->rewind());
+		checkRead(stream, 0, kNumSamples);
+		TS_ASSERT(stream->endOfStream());
+
+		// Playing again after the end
+		TS_ASSERT(stream->rewind());
+		TS_ASSERT(!stream->endOfStream());
+		checkRead(stream, 0, 10);
+
+		delete stream;
+		delete pool;
+	}
+
+	void test_dispose() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(2);
+		CountingStream *parent = createStream();
+		Audio::AudioStream *stream = Audio::makeDecodeAheadStream((Audio::AudioStream *)parent, DisposeAfterUse::NO, 100, pool);
+		checkRead(stream, 0, 10);
+
+		// Deleting the wrapper stops the decoding, but keeps the parent
+		delete stream;
+		const int numRead = parent->_numRead;
+		TS_ASSERT(!parent->endOfData());
+		TS_ASSERT_LESS_THAN(numRead, (int)kNumSamples);
+
+		delete pool;
+		TS_ASSERT_EQUALS((int)parent->_numRead, numRead);
+		delete parent;
+	}
+#endif
+};
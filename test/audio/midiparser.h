@@ -0,0 +1,145 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mididrv.h"
+#include "audio/midiparser_smf.h"
+#include "common/config-manager.h"
+
+class MidiParserTestSuite : public CxxTest::TestSuite {
+	class TestMidiDriver : public MidiDriver_BASE {
+	public:
+		void send(uint32 b) override {
+			_messages.push_back(b);
+		}
+
+		Common::Array<uint32> _messages;
+	};
+
+	class TestMidiParser : public MidiParser_SMF {
+	public:
+		uint32 getPlayTime() const { return _position._playTime; }
+		uint32 getTickLength() const { return _psecPerTick; }
+		bool isCompiled() const { return _trackCompiled; }
+
+		bool isNoteActive(byte channel, byte note) const {
+			return (_activeNotes[note] & (1 << channel)) != 0;
+		}
+	};
+
+	/**
+	 * A type 1 SMF file with two tracks, 96 ticks per quarter note and
+	 * three tempo changes, the last of them between two notes.
+	 */
+	static const byte *getSong(uint32 &size) {
+		static const byte song[] = {
+			'M', 'T', 'h', 'd', 0x00, 0x00, 0x00, 0x06, 0x00, 0x01, 0x00, 0x02, 0x00, 0x60,
+			'M', 'T', 'r', 'k', 0x00, 0x00, 0x00, 0x2C,
+			0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,	// 0: 500000 us per quarter note
+			0x00, 0x90, 0x3C, 0x64,						// 0: note 60 on
+			0x81, 0x40, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,	// 192: 250000 us per quarter note
+			0x81, 0x40, 0x80, 0x3C, 0x40,				// 384: note 60 off
+			0x60, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,	// 480: 1000000 us per quarter note
+			0x14, 0x90, 0x40, 0x64,						// 500: note 64 on
+			0x83, 0x4C, 0x80, 0x40, 0x40,				// 960: note 64 off
+			0x00, 0xFF, 0x2F, 0x00,						// 960: end of track
+			'M', 'T', 'r', 'k', 0x00, 0x00, 0x00, 0x17,
+			0x64, 0x91, 0x43, 0x64,						// 100: note 67 on
+			0x81, 0x48, 0x81, 0x43, 0x40,				// 300: note 67 off
+			0x82, 0x2C, 0x91, 0x48, 0x64,				// 600: note 72 on
+			0x82, 0x2C, 0x81, 0x48, 0x40,				// 900: note 72 off
+			0x64, 0xFF, 0x2F, 0x00						// 1000: end of track
+		};
+		size = sizeof(song);
+		return song;
+	}
+
+	static void loadSong(TestMidiParser &parser, TestMidiDriver &driver, bool compile, const byte *data, uint32 size) {
+		parser.property(MidiParser::mpCompileTracks, compile);
+		parser.setMidiDriver(&driver);
+		parser.setTimerRate(10000);
+		TS_ASSERT(parser.loadMusic(data, size));
+		TS_ASSERT_EQUALS(parser.isCompiled(), compile);
+	}
+
+	static void playFor(TestMidiParser &parser, int numTimers) {
+		for (int i = 0; i < numTimers; i++)
+			parser.onTimer();
+	}
+
+public:
+	void test_compiled_jump() {
+		ConfMan.registerDefault("dump_midi", false);
+
+		uint32 size;
+		const byte *song = getSong(size);
+		static const uint32 ticks[] = { 1, 50, 100, 192, 250, 384, 480, 499, 500, 700, 959, 999 };
+
+		for (uint i = 0; i < ARRAYSIZE(ticks); i++) {
+			TestMidiDriver driver, compiledDriver;
+			TestMidiParser parser, compiledParser;
+			loadSong(parser, driver, false, song, size);
+			loadSong(compiledParser, compiledDriver, true, song, size);
+
+			// Start from a different tempo than the one at the target
+			playFor(parser, 120);
+			playFor(compiledParser, 120);
+
+			TS_ASSERT(parser.jumpToTick(ticks[i]));
+			TS_ASSERT(compiledParser.jumpToTick(ticks[i]));
+			TS_ASSERT_EQUALS(compiledParser.getTick(), parser.getTick());
+			TS_ASSERT_EQUALS(compiledParser.getPlayTime(), parser.getPlayTime());
+			TS_ASSERT_EQUALS(compiledParser.getTickLength(), parser.getTickLength());
+
+			// Both parsers must play the rest of the song the same way
+			for (int j = 0; j < 8; j++) {
+				playFor(parser, 25);
+				playFor(compiledParser, 25);
+				TS_ASSERT_EQUALS(compiledParser.getTick(), parser.getTick());
+				TS_ASSERT_EQUALS(compiledParser.getTickLength(), parser.getTickLength());
+				for (byte note = 60; note <= 72; note++) {
+					TS_ASSERT_EQUALS(compiledParser.isNoteActive(0, note), parser.isNoteActive(0, note));
+					TS_ASSERT_EQUALS(compiledParser.isNoteActive(1, note), parser.isNoteActive(1, note));
+				}
+			}
+			TS_ASSERT_EQUALS(compiledDriver._messages.size(), driver._messages.size());
+			for (uint j = 0; j < driver._messages.size() && j < compiledDriver._messages.size(); j++)
+				TS_ASSERT_EQUALS(compiledDriver._messages[j], driver._messages[j]);
+		}
+
+		// Jumping past the end fails, and keeps the position
+		TestMidiDriver compiledDriver;
+		TestMidiParser compiledParser;
+		loadSong(compiledParser, compiledDriver, true, song, size);
+		playFor(compiledParser, 50);
+		const uint32 tick = compiledParser.getTick();
+		TS_ASSERT(!compiledParser.jumpToTick(1001));
+		TS_ASSERT_EQUALS(compiledParser.getTick(), tick);
+	}
+
+	void test_compile_truncated_track() {
+		ConfMan.registerDefault("dump_midi", false);
+
+		// The second track has no End of Track event, and is followed by
+		// data which must not be played
+		uint32 size;
+		const byte *song = getSong(size);
+		byte data[256];
+		memcpy(data, song, size);
+		// Remove the last event from the length of the second track
+		data[size - 0x17 - 1] -= 4;
+		static const byte trailing[] = {
+			0x00, 0x92, 0x30, 0x64,		// note 48 on, in the third channel
+			0x00, 0xFF, 0x2F, 0x00
+		};
+		memcpy(data + size - 4, trailing, sizeof(trailing));
+
+		TestMidiDriver driver;
+		TestMidiParser parser;
+		loadSong(parser, driver, true, data, size - 4);
+
+		TS_ASSERT(parser.jumpToTick(850));
+		playFor(parser, 200);
+		TS_ASSERT(!parser.isPlaying());
+		for (uint i = 0; i < driver._messages.size(); i++)
+			TS_ASSERT_DIFFERS(driver._messages[i] & 0xFF, 0x92u);
+	}
+};
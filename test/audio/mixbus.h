@@ -0,0 +1,157 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixbus.h"
+#include "audio/mixer_intern.h"
+#include "audio/decoders/raw.h"
+
+#include "../system/null_osystem.h"
+
+class MixBusTestSuite : public CxxTest::TestSuite {
+	enum {
+		kNumSamples = 1003 * 2
+	};
+
+	static void fillRandom(int16 *samples, uint count, uint32 seed) {
+		for (uint i = 0; i < count; i++) {
+			seed = seed * 1103515245 + 12345;
+			samples[i] = (int16)(seed >> 16);
+		}
+	}
+
+	void checkKernels(Audio::MixBus::MixFunc mixFunc, Audio::MixBus::OutputFunc outputFunc) {
+		int16 src[kNumSamples];
+		int32 expectedBus[kNumSamples], bus[kNumSamples];
+		int16 expected[kNumSamples], out[kNumSamples];
+
+		for (int round = 0; round < 4; round++) {
+			const bool stereo = (round & 1) == 0;
+			memset(expectedBus, 0, sizeof(expectedBus));
+			memset(bus, 0, sizeof(bus));
+
+			// Mix enough channels for some samples to clip
+			for (int channel = 0; channel < 3 + round; channel++) {
+				fillRandom(src, kNumSamples, round * 100 + channel);
+				const int volL = (channel * 97) % 257, volR = 256 - (channel * 31) % 257;
+				Audio::MixBus::mixGeneric(expectedBus, src, kNumSamples - round * 2, stereo, volL, volR);
+				mixFunc(bus, src, kNumSamples - round * 2, stereo, volL, volR);
+			}
+			TS_ASSERT_SAME_DATA(bus, expectedBus, sizeof(bus));
+
+			uint expectedPos = round * 123, pos = round * 123;
+			Audio::MixBus::outputGeneric(expected, expectedBus, kNumSamples - round, expectedPos);
+			outputFunc(out, bus, kNumSamples - round, pos);
+			TS_ASSERT_EQUALS(pos, expectedPos);
+			TS_ASSERT_SAME_DATA(out, expected, (kNumSamples - round) * sizeof(int16));
+		}
+	}
+
+public:
+	void test_mix() {
+		const int16 src[4] = { 1000, -1000, 32767, -32768 };
+		int32 bus[4] = { 1, 2, 3, 4 };
+
+		Audio::MixBus::mixGeneric(bus, src, 4, true, 256, 128);
+		TS_ASSERT_EQUALS(bus[0], 1 + 1000 * 256);
+		TS_ASSERT_EQUALS(bus[1], 2 - 1000 * 128);
+		TS_ASSERT_EQUALS(bus[2], 3 + 32767 * 256);
+		TS_ASSERT_EQUALS(bus[3], 4 - 32768 * 128);
+
+		Audio::MixBus::mixGeneric(bus, src, 1, false, 100, 200);
+		TS_ASSERT_EQUALS(bus[0], 1 + 1000 * 256 + 1000 * 150);
+	}
+
+	void test_output() {
+		int32 bus[7] = { 0, 1000 << 8, -(1000 << 8), 32767 << 8, -(32768 << 8), 1000000 << 8, -(1000000 << 8) };
+		int16 out[7];
+		uint pos = 0;
+
+		// Samples without extra precision which fit in 16 bits are left
+		// alone by the dithering and the clipping
+		Audio::MixBus::outputGeneric(out, bus, 7, pos);
+		TS_ASSERT_EQUALS(pos, 7u);
+		TS_ASSERT_EQUALS(out[0], 0);
+		TS_ASSERT_EQUALS(out[1], 1000);
+		TS_ASSERT_EQUALS(out[2], -1000);
+		TS_ASSERT_EQUALS(out[3], 32767);
+		TS_ASSERT_EQUALS(out[4], -32768);
+
+		// Only the samples which do not fit are clipped
+		TS_ASSERT_EQUALS(out[5], 32767);
+		TS_ASSERT_EQUALS(out[6], -32768);
+
+		for (int32 value = -40000; value < 40000; value += 7)
+			TS_ASSERT_EQUALS(Audio::MixBus::clipSample(value), (int16)CLIP<int32>(value, -32768, 32767));
+	}
+
+	void test_dither() {
+		const int32 *dither = Audio::MixBus::getDitherTable();
+		int32 min = 255, max = 0;
+		for (int i = 0; i < Audio::MixBus::kDitherSize; i++) {
+			min = MIN(min, dither[i]);
+			max = MAX(max, dither[i]);
+		}
+		TS_ASSERT_EQUALS(min, 0);
+		TS_ASSERT_EQUALS(max, (1 << Audio::MixBus::kFracBits) - 1);
+		for (int i = 0; i < 8; i++)
+			TS_ASSERT_EQUALS(dither[Audio::MixBus::kDitherSize + i], dither[i]);
+	}
+
+	void test_simd_kernels() {
+#ifdef SCUMMVM_SSE2
+		checkKernels(Audio::MixBus::mixSSE2, Audio::MixBus::outputSSE2);
+#endif
+#ifdef SCUMMVM_NEON
+		checkKernels(Audio::MixBus::mixNEON, Audio::MixBus::outputNEON);
+#endif
+	}
+
+	void test_mixer_sum() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		{
+			// The channels are summed before clipping, so loud channels
+			// which cancel each other out do not clip. The sum fits in 16
+			// bits, so it is output unchanged.
+			static const int16 levels[3] = { 30000, 30000, -30000 };
+			Audio::MixerImpl mixer(11025, false);
+			mixer.setReady(true);
+			for (int i = 0; i < 3; i++) {
+				int16 *data = (int16 *)malloc(64 * sizeof(int16));
+				for (int j = 0; j < 64; j++)
+					data[j] = (j & 1) ? levels[i] : -levels[i];
+				mixer.playStream(Audio::Mixer::kPlainSoundType, nullptr,
+					Audio::makeRawStream((byte *)data, 64 * sizeof(int16), 11025, Audio::FLAG_16BITS
+#ifdef SCUMM_LITTLE_ENDIAN
+					| Audio::FLAG_LITTLE_ENDIAN
+#endif
+					), -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::YES, false, false);
+			}
+
+			int16 out[64];
+			TS_ASSERT_EQUALS(mixer.mixCallback((byte *)out, sizeof(out)), 64);
+			for (int j = 0; j < 64; j++)
+				TS_ASSERT_EQUALS(out[j], (j & 1) ? 30000 : -30000);
+		}
+		{
+			// A callback larger than the bus is mixed in several parts
+			Audio::MixerImpl mixer(11025, true, 16);
+			mixer.setReady(true);
+			int16 *data = (int16 *)malloc(200 * sizeof(int16));
+			for (int j = 0; j < 200; j++)
+				data[j] = j * 100 - 10000;
+			mixer.playStream(Audio::Mixer::kPlainSoundType, nullptr,
+				Audio::makeRawStream((byte *)data, 200 * sizeof(int16), 11025, Audio::FLAG_16BITS | Audio::FLAG_STEREO
+#ifdef SCUMM_LITTLE_ENDIAN
+				| Audio::FLAG_LITTLE_ENDIAN
+#endif
+				), -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::YES, false, false);
+
+			int16 out[200];
+			TS_ASSERT_EQUALS(mixer.mixCallback((byte *)out, sizeof(out)), 100);
+			for (int j = 0; j < 200; j++)
+				TS_ASSERT_EQUALS(out[j], j * 100 - 10000);
+		}
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
@@ -0,0 +1,163 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_intern.h"
+#include "audio/decoders/raw.h"
+#include "common/memstream.h"
+
+#include "../system/null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#include "backends/mixer/null/null-mixer.h"
+#endif
+
+class MixerTestSuite : public CxxTest::TestSuite {
+	class TestMixer : public Audio::MixerImpl {
+	public:
+		TestMixer(uint sampleRate, bool stereo, uint outBufSize) : MixerImpl(sampleRate, stereo, outBufSize) {}
+
+		using MixerImpl::recordCallback;
+	};
+
+	enum {
+		kFrames = 64
+	};
+
+	static Audio::AudioStream *makeStream(uint numSamples, uint rate, int16 value = 0) {
+		int16 *data = (int16 *)malloc(numSamples * sizeof(int16));
+		for (uint i = 0; i < numSamples; i++)
+			data[i] = value;
+		return Audio::makeRawStream((byte *)data, numSamples * sizeof(int16), rate, Audio::FLAG_16BITS
+#ifdef SCUMM_LITTLE_ENDIAN
+			| Audio::FLAG_LITTLE_ENDIAN
+#endif
+			);
+	}
+
+public:
+	void test_profiling() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		{
+			TestMixer mixer(11025, true, kFrames);
+			mixer.setReady(true);
+			TS_ASSERT(!mixer.isProfiling());
+
+			Audio::SoundHandle handle;
+			mixer.playStream(Audio::Mixer::kSFXSoundType, &handle, makeStream(11025, 11025), -1,
+				Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::YES, false, false);
+
+			int16 out[kFrames * 2];
+
+			// Nothing is counted until profiling is enabled
+			mixer.mixCallback((byte *)out, sizeof(out));
+			TS_ASSERT_EQUALS(mixer.getStats().callbacks, 0u);
+
+			mixer.setProfiling(true);
+			TS_ASSERT(mixer.isProfiling());
+			for (int i = 0; i < 3; i++)
+				mixer.mixCallback((byte *)out, sizeof(out));
+
+			Audio::MixerImpl::Stats stats = mixer.getStats();
+			TS_ASSERT_EQUALS(stats.callbacks, 3u);
+			uint32 histogramTotal = 0;
+			for (int i = 0; i < Audio::MixerImpl::kStatsHistogramSize; i++)
+				histogramTotal += stats.histogram[i];
+			TS_ASSERT_EQUALS(histogramTotal, 3u);
+			TS_ASSERT_LESS_THAN_EQUALS(stats.overBudget, 3u);
+
+			Audio::MixerImpl::ChannelStats channelStats;
+			TS_ASSERT(mixer.getChannelStats(handle, channelStats));
+			TS_ASSERT_EQUALS(channelStats.mixCalls, 3u);
+			TS_ASSERT_EQUALS(channelStats.framesMixed, 3u * kFrames);
+			TS_ASSERT_LESS_THAN_EQUALS(channelStats.maxMixMicros, stats.maxCallbackMicros);
+
+			const Common::String report = mixer.getStatsReport();
+			TS_ASSERT(report.contains("3 callbacks"));
+			TS_ASSERT(report.contains("Channel"));
+			TS_ASSERT(report.contains("copy 11025 Hz -> 11025 Hz"));
+
+			// A callback coming much later than the buffer lasted means
+			// that the output ran dry
+			mixer.setProfiling(true);
+			const uint64 budget = 1000000 * kFrames / 11025;
+			mixer.recordCallback(0, budget / 2, kFrames);
+			mixer.recordCallback(budget, budget * 3 / 2, kFrames);
+			mixer.recordCallback(budget * 2 + budget / 4, budget * 3, kFrames);
+			stats = mixer.getStats();
+			TS_ASSERT_EQUALS(stats.underruns, 0u);
+			mixer.recordCallback(budget * 5, budget * 7, kFrames);
+			stats = mixer.getStats();
+			TS_ASSERT_EQUALS(stats.callbacks, 4u);
+			TS_ASSERT_EQUALS(stats.underruns, 1u);
+			TS_ASSERT_EQUALS(stats.overBudget, 1u);
+			TS_ASSERT_EQUALS(stats.maxCallbackMicros, 2 * budget);
+			TS_ASSERT_EQUALS(stats.histogram[2], 2u);
+			TS_ASSERT_EQUALS(stats.histogram[3], 1u);
+			TS_ASSERT_EQUALS(stats.histogram[5], 1u);
+
+			mixer.stopHandle(handle);
+			TS_ASSERT(!mixer.getChannelStats(handle, channelStats));
+
+			mixer.setProfiling(false);
+			TS_ASSERT_EQUALS(mixer.getStats().callbacks, 0u);
+		}
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_null_render() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		{
+			NullMixerManager manager;
+			manager.init();
+
+			// Half a second of sound, then silence
+			Audio::SoundHandle handle;
+			manager.getMixer()->playStream(Audio::Mixer::kPlainSoundType, &handle, makeStream(11025, 22050, 1000), -1,
+				Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::YES, false, false);
+
+			Common::MemoryWriteStreamDynamic wav(DisposeAfterUse::YES);
+			manager.startRendering(&wav, DisposeAfterUse::NO);
+			TS_ASSERT(manager.isRendering());
+
+			// The frames are counted from the total time, so short calls
+			// do not lose any to rounding
+			for (int i = 0; i < 3; i++)
+				manager.renderMillis(333);
+			manager.renderMillis(1);
+			TS_ASSERT_EQUALS(manager.getRenderedMillis(), 1000u);
+
+			manager.stopRendering();
+			TS_ASSERT(!manager.isRendering());
+
+			// A 16-bit stereo WAV file of one second at the 22050 Hz of the mixer
+			const uint32 dataSize = 22050 * 4;
+			TS_ASSERT_EQUALS(wav.size(), 44 + dataSize);
+			const byte *data = wav.getData();
+			TS_ASSERT_EQUALS(READ_BE_UINT32(data), MKTAG('R', 'I', 'F', 'F'));
+			TS_ASSERT_EQUALS(READ_LE_UINT32(data + 4), 36 + dataSize);
+			TS_ASSERT_EQUALS(READ_BE_UINT32(data + 8), MKTAG('W', 'A', 'V', 'E'));
+			TS_ASSERT_EQUALS(READ_BE_UINT32(data + 12), MKTAG('f', 'm', 't', ' '));
+			TS_ASSERT_EQUALS(READ_LE_UINT32(data + 16), 16u);
+			TS_ASSERT_EQUALS(READ_LE_UINT16(data + 20), 1u);
+			TS_ASSERT_EQUALS(READ_LE_UINT16(data + 22), 2u);
+			TS_ASSERT_EQUALS(READ_LE_UINT32(data + 24), 22050u);
+			TS_ASSERT_EQUALS(READ_LE_UINT32(data + 28), 22050u * 4);
+			TS_ASSERT_EQUALS(READ_LE_UINT16(data + 32), 4u);
+			TS_ASSERT_EQUALS(READ_LE_UINT16(data + 34), 16u);
+			TS_ASSERT_EQUALS(READ_BE_UINT32(data + 36), MKTAG('d', 'a', 't', 'a'));
+			TS_ASSERT_EQUALS(READ_LE_UINT32(data + 40), dataSize);
+
+#ifndef OUTPUT_UNSIGNED_AUDIO
+			const int16 silence = 0;
+#else
+			const int16 silence = -0x8000;
+#endif
+			TS_ASSERT_DIFFERS((int16)READ_LE_UINT16(data + 44 + 1000 * 4), silence);
+			TS_ASSERT_EQUALS((int16)READ_LE_UINT16(data + 44 + 20000 * 4), silence);
+		}
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
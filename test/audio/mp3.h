@@ -0,0 +1,161 @@
+#include <cxxtest/TestSuite.h>
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include "audio/audiostream.h"
+#include "audio/decoders/mp3.h"
+#include "common/memstream.h"
+
+class MP3TestSuite : public CxxTest::TestSuite {
+#ifdef USE_MAD
+	enum {
+		kHeaderFrameSize = 576,
+		kFrameSize = 144,
+		kNumFrames = 2000,
+		kSongSize = kHeaderFrameSize + kNumFrames * kFrameSize
+	};
+
+	/** Remembers where the decoder last jumped to. */
+	class SeekRecordingStream : public Common::MemoryReadStream {
+	public:
+		SeekRecordingStream(const byte *data, uint32 size) : MemoryReadStream(data, size), _lastSeek(0) {}
+
+		bool seek(int64 offset, int whence = SEEK_SET) override {
+			const bool ret = MemoryReadStream::seek(offset, whence);
+			_lastSeek = pos();
+			return ret;
+		}
+
+		int64 _lastSeek;
+	};
+
+	/**
+	 * A VBR song of 32 kHz mono MPEG-1 Layer III frames of silence. The
+	 * first frame is a 128 kbps frame with the Xing or VBRI header, the
+	 * others are 32 kbps frames, which last 36 ms each.
+	 */
+	static byte *makeSong(bool vbri) {
+		byte *song = (byte *)calloc(kSongSize, 1);
+
+		static const byte header[] = { 0xFF, 0xFB, 0x98, 0xC0 };
+		memcpy(song, header, sizeof(header));
+		for (uint i = 0; i < kNumFrames; i++) {
+			static const byte frameHeader[] = { 0xFF, 0xFB, 0x18, 0xC0 };
+			memcpy(song + kHeaderFrameSize + i * kFrameSize, frameHeader, sizeof(frameHeader));
+		}
+
+		if (vbri) {
+			// Each entry of the table covers 20 frames, the first one
+			// includes the header frame
+			byte *vbriHeader = song + 36;
+			memcpy(vbriHeader, "VBRI", 4);
+			WRITE_BE_UINT16(vbriHeader + 4, 1);
+			WRITE_BE_UINT16(vbriHeader + 8, 75);
+			WRITE_BE_UINT32(vbriHeader + 10, kSongSize);
+			WRITE_BE_UINT32(vbriHeader + 14, kNumFrames);
+			WRITE_BE_UINT16(vbriHeader + 18, 100);
+			WRITE_BE_UINT16(vbriHeader + 20, 1);
+			WRITE_BE_UINT16(vbriHeader + 22, 2);
+			WRITE_BE_UINT16(vbriHeader + 24, 20);
+			for (uint i = 0; i < 100; i++)
+				WRITE_BE_UINT16(vbriHeader + 26 + i * 2, i == 0 ? kHeaderFrameSize + 19 * kFrameSize : 20 * kFrameSize);
+		} else {
+			// The Xing header follows the 17 bytes of side information,
+			// with the frame count, the byte count and the table of contents
+			byte *xingHeader = song + 4 + 17;
+			memcpy(xingHeader, "Xing", 4);
+			WRITE_BE_UINT32(xingHeader + 4, 7);
+			WRITE_BE_UINT32(xingHeader + 8, kNumFrames);
+			WRITE_BE_UINT32(xingHeader + 12, kSongSize);
+			for (uint i = 0; i < 100; i++)
+				xingHeader[16 + i] = i * 256 / 100;
+		}
+
+		return song;
+	}
+
+	static bool seek(Audio::SeekableAudioStream *stream, uint32 msecs) {
+		if (!stream->seek(Audio::Timestamp(msecs, 1000)))
+			return false;
+
+		int16 buffer[1152];
+		return stream->readBuffer(buffer, ARRAYSIZE(buffer)) == ARRAYSIZE(buffer);
+	}
+#endif
+
+public:
+	void test_xing_seek() {
+#ifdef USE_MAD
+		byte *song = makeSong(false);
+		SeekRecordingStream file(song, kSongSize);
+		Audio::SeekableAudioStream *stream = Audio::makeMP3Stream(&file, DisposeAfterUse::NO);
+		TS_ASSERT(stream);
+
+		// The length comes from the frame count, plus the header frame
+		TS_ASSERT_EQUALS(stream->getLength().msecs(), 72036);
+
+		// Short seeks use the frame index, with an entry every 16 frames
+		TS_ASSERT(seek(stream, 10000));
+		TS_ASSERT_EQUALS(file._lastSeek, kHeaderFrameSize + 271 * kFrameSize);
+		TS_ASSERT(seek(stream, 1000));
+		TS_ASSERT_EQUALS(file._lastSeek, kHeaderFrameSize + 15 * kFrameSize);
+
+		// Longer ones use the table of contents. 60 s are between 83% and
+		// 84% of the song, and the 83% entry is 212 / 256 of the song.
+		TS_ASSERT(seek(stream, 60000));
+		TS_ASSERT_EQUALS(file._lastSeek, 212 * kSongSize / 256);
+
+		// The index was not extended by the previous seek
+		TS_ASSERT(seek(stream, 40000));
+		TS_ASSERT_EQUALS(file._lastSeek, kHeaderFrameSize + 1103 * kFrameSize);
+
+		// The last entry before the end of the song
+		TS_ASSERT(seek(stream, 71000));
+		TS_ASSERT_EQUALS(file._lastSeek, 250 * kSongSize / 256);
+
+		delete stream;
+		free(song);
+#endif
+	}
+
+	void test_vbri_seek() {
+#ifdef USE_MAD
+		byte *song = makeSong(true);
+		SeekRecordingStream file(song, kSongSize);
+		Audio::SeekableAudioStream *stream = Audio::makeMP3Stream(&file, DisposeAfterUse::NO);
+		TS_ASSERT(stream);
+
+		TS_ASSERT_EQUALS(stream->getLength().msecs(), 72036);
+
+		// Each entry lasts 20 frames, i.e. 720 ms
+		TS_ASSERT(seek(stream, 50000));
+		TS_ASSERT_EQUALS(file._lastSeek, kHeaderFrameSize + (69 * 20 - 1) * kFrameSize);
+
+		delete stream;
+		free(song);
+#endif
+	}
+
+	void test_truncated_length() {
+#ifdef USE_MAD
+		// The header still tells the size of the whole song, but only the
+		// 1037 whole frames after the header frame are in the file
+		byte *song = makeSong(false);
+		SeekRecordingStream file(song, 150000);
+		Audio::SeekableAudioStream *stream = Audio::makeMP3Stream(&file, DisposeAfterUse::NO);
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->getLength().msecs(), 1038 * 36);
+
+		// Seeking past the last frame fails, seeking to a frame of the file
+		// still works
+		TS_ASSERT(!stream->seek(Audio::Timestamp(60000, 1000)));
+		TS_ASSERT(seek(stream, 30000));
+
+		delete stream;
+		free(song);
+#endif
+	}
+
+};
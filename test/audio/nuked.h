@@ -0,0 +1,185 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/nuked.h"
+#include "common/debug.h"
+
+#include "../system/null_osystem.h"
+
+#ifndef DISABLE_NUKED_OPL
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class NukedOPLTestSuite : public CxxTest::TestSuite {
+	typedef OPL::NUKED::opl3_chip opl3_chip;
+
+	enum {
+		kNumFrames = 44100 * 2,
+		kChunkSize = 441
+	};
+
+	uint32 _seed;
+
+	uint32 nextRandom(uint32 max) {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) % max;
+	}
+
+	/** Write the same register to both chips. */
+	static void writeReg(opl3_chip *chip1, opl3_chip *chip2, uint16 reg, uint8 val) {
+		OPL::NUKED::OPL3_WriteRegBuffered(chip1, reg, val);
+		if (chip2)
+			OPL::NUKED::OPL3_WriteRegBuffered(chip2, reg, val);
+	}
+
+	/**
+	 * Play some random notes on random instruments, switching between the
+	 * OPL2 and OPL3 modes, the 4-operator channels and the rhythm mode.
+	 */
+	void writeEvents(opl3_chip *chip1, opl3_chip *chip2, uint chunk) {
+		if (chunk % 50 == 0) {
+			const uint8 newm = (chunk / 50) & 1;
+			writeReg(chip1, chip2, 0x105, newm);
+			writeReg(chip1, chip2, 0x104, newm ? nextRandom(64) : 0);
+			for (uint reg = 0x20; reg < 0xa0; reg++) {
+				writeReg(chip1, chip2, reg, nextRandom(256));
+				writeReg(chip1, chip2, reg + 0x100, nextRandom(256));
+			}
+			for (uint reg = 0xc0; reg < 0xc9; reg++) {
+				writeReg(chip1, chip2, reg, 0x30 | nextRandom(16));
+				writeReg(chip1, chip2, reg + 0x100, 0x30 | nextRandom(16));
+			}
+			for (uint reg = 0xe0; reg < 0xf6; reg++) {
+				writeReg(chip1, chip2, reg, nextRandom(8));
+				writeReg(chip1, chip2, reg + 0x100, nextRandom(8));
+			}
+		}
+
+		for (uint i = nextRandom(4); i > 0; i--) {
+			const uint16 channel = nextRandom(9) | (nextRandom(2) << 8);
+			writeReg(chip1, chip2, 0xa0 + channel, nextRandom(256));
+			writeReg(chip1, chip2, 0xb0 + channel, nextRandom(64));
+		}
+
+		if (chunk % 20 == 10)
+			writeReg(chip1, chip2, 0xbd, nextRandom(256));
+	}
+
+	static opl3_chip *createChip(uint32 rate) {
+		opl3_chip *chip = new opl3_chip();
+		OPL::NUKED::OPL3_Reset(chip, rate);
+		return chip;
+	}
+
+	/** Render with the single sample functions, which the streams must match. */
+	static void generateReference(opl3_chip *chip, int16 *buffer, uint numFrames) {
+		for (uint i = 0; i < numFrames; i++)
+			OPL::NUKED::OPL3_GenerateResampled(chip, buffer + i * 2);
+	}
+
+	static uint32 checksum(const int16 *buffer, uint numSamples) {
+		uint32 sum = 0;
+		for (uint i = 0; i < numSamples; i++)
+			sum = (sum * 31) ^ (uint16)buffer[i];
+		return sum;
+	}
+
+	void checkStream(uint32 rate) {
+		opl3_chip *reference = createChip(rate);
+		opl3_chip *chip = createChip(rate);
+		int16 expected[kChunkSize * 2], out[kChunkSize * 2];
+		bool same = true;
+
+		_seed = rate;
+		for (uint chunk = 0; chunk < kNumFrames / kChunkSize; chunk++) {
+			writeEvents(reference, chip, chunk);
+
+			// Split the chunks unevenly, to test the block boundaries
+			const uint split = nextRandom(kChunkSize);
+			generateReference(reference, expected, kChunkSize);
+			OPL::NUKED::OPL3_GenerateStream(chip, out, split);
+			OPL::NUKED::OPL3_GenerateStream(chip, out + split * 2, kChunkSize - split);
+			same &= (memcmp(out, expected, sizeof(out)) == 0);
+		}
+		TS_ASSERT(same);
+
+		delete reference;
+		delete chip;
+	}
+
+public:
+	void test_stream() {
+		checkStream(44100);
+		checkStream(49716);
+		checkStream(96000);
+		checkStream(8000);
+	}
+
+	void test_4ch_stream() {
+		opl3_chip *reference = createChip(22050);
+		opl3_chip *chip = createChip(22050);
+		int16 expected[kChunkSize * 4], out1[kChunkSize * 2], out2[kChunkSize * 2];
+		bool same = true;
+
+		_seed = 1;
+		for (uint chunk = 0; chunk < 20; chunk++) {
+			writeEvents(reference, chip, chunk);
+			for (uint i = 0; i < kChunkSize; i++)
+				OPL::NUKED::OPL3_Generate4ChResampled(reference, expected + i * 4);
+			OPL::NUKED::OPL3_Generate4ChStream(chip, out1, out2, kChunkSize);
+			for (uint i = 0; i < kChunkSize; i++) {
+				same &= (out1[i * 2] == expected[i * 4] && out1[i * 2 + 1] == expected[i * 4 + 1]);
+				same &= (out2[i * 2] == expected[i * 4 + 2] && out2[i * 2 + 1] == expected[i * 4 + 3]);
+			}
+		}
+		TS_ASSERT(same);
+
+		delete reference;
+		delete chip;
+	}
+
+	void test_output_unchanged() {
+		// The output of the emulator must stay the same as the original one
+		opl3_chip *chip = createChip(44100);
+		int16 *buffer = new int16[kNumFrames * 2];
+
+		_seed = 12345;
+		for (uint chunk = 0; chunk < kNumFrames / kChunkSize; chunk++) {
+			writeEvents(chip, nullptr, chunk);
+			generateReference(chip, buffer + chunk * kChunkSize * 2, kChunkSize);
+		}
+		TS_ASSERT_EQUALS(checksum(buffer, kNumFrames * 2), 0x78c70ba1u);
+
+		delete[] buffer;
+		delete chip;
+	}
+
+	void test_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		opl3_chip *chip = createChip(44100);
+		int16 *buffer = new int16[kNumFrames * 2];
+
+		_seed = 12345;
+		const uint32 start = g_system->getMillis();
+		for (int round = 0; round < 4; round++) {
+			for (uint chunk = 0; chunk < kNumFrames / kChunkSize; chunk++) {
+				writeEvents(chip, nullptr, chunk);
+				OPL::NUKED::OPL3_GenerateStream(chip, buffer + chunk * kChunkSize * 2, kChunkSize);
+			}
+		}
+		debug("Nuked OPL3: %d ms for 8 seconds of audio\n", g_system->getMillis() - start);
+
+		delete[] buffer;
+		delete chip;
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
+
+#endif // !DISABLE_NUKED_OPL
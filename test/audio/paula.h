@@ -0,0 +1,144 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mods/paula.h"
+#include "common/config-manager.h"
+
+#include "../system/null_osystem.h"
+
+/**
+ * A small four-voice song. The interrupts change the periods, the volumes,
+ * the samples and the LED filter, and the end of the samples changes the
+ * panning, so that every path of the renderer is used.
+ */
+class TestPaula : public Audio::Paula {
+public:
+	enum {
+		kSampleLen = 256
+	};
+
+	TestPaula(bool stereo, FilterMode filterMode) :
+			Paula(stereo, 44100, 0, filterMode), _ticks(0) {
+		uint32 seed = 1;
+		for (int i = 0; i < kSampleLen; i++) {
+			seed = seed * 1103515245 + 12345;
+			_noise[i] = (int8)(seed >> 16);
+			_square[i] = (i & 32) ? 100 : -100;
+			_saw[i] = (int8)(i - 128);
+		}
+
+		setTimerBaseValue(kPalCiaClock);
+		setInterruptFreqUnscaled(14187);
+
+		setChannelData(0, _square, _square, kSampleLen, kSampleLen);
+		setChannelData(1, _saw, _saw + 64, kSampleLen, kSampleLen - 64);
+		setChannelData(2, _noise, nullptr, kSampleLen, 0);
+		setChannelData(3, _saw, _square, kSampleLen, kSampleLen / 2, 17);
+		for (int voice = 0; voice < NUM_VOICES; voice++) {
+			setChannelPeriod(voice, 200 + voice * 150);
+			setChannelVolume(voice, 64 - voice * 8);
+		}
+		setChannelInterrupt(1, true);
+		setChannelInterrupt(3, true);
+
+		startPaula();
+	}
+
+	uint32 checksum(int numSamples) {
+		int16 buffer[1000];
+		uint32 sum = 0;
+		while (numSamples > 0) {
+			// Read in odd sized chunks, which do not match the interrupts
+			const int count = MIN(numSamples, 997) & ~1;
+			readBuffer(buffer, count);
+			for (int i = 0; i < count; i++)
+				sum = sum * 31 + (uint16)buffer[i];
+			numSamples -= count;
+		}
+		return sum;
+	}
+
+protected:
+	void interrupt() override {
+		_ticks++;
+		const byte voice = _ticks % NUM_VOICES;
+		setChannelPeriod(voice, 124 + (_ticks * 37) % 700);
+		setChannelVolume(voice, (_ticks * 13) % 65);
+		if (_ticks % 5 == 0) {
+			setChannelSampleStart(2, (_ticks & 1) ? _saw : _noise);
+			setChannelSampleLen(2, kSampleLen / 2 - (_ticks % 3) * 16);
+			enableChannel(2);
+		}
+		if (_ticks % 7 == 0)
+			setAudioFilter((_ticks & 8) != 0);
+	}
+
+	void interruptChannel(byte channel) override {
+		setChannelPanning(channel, (_ticks * 41 + channel * 64) & 255);
+	}
+
+private:
+	int8 _noise[kSampleLen];
+	int8 _square[kSampleLen];
+	int8 _saw[kSampleLen];
+	int _ticks;
+};
+
+class PaulaTestSuite : public CxxTest::TestSuite {
+	enum {
+		kNumSamples = 60000
+	};
+
+public:
+	void test_output() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// The setting is left unset, as Paula must not require it
+		Common::install_null_g_system();
+
+		// The checksums are taken from the output of the sample by sample
+		// renderer, which the block renderer has to match exactly
+		static const uint32 expected[3][2] = {
+			{ 2561618088u, 4116255784u },
+			{ 3762011753u, 4276245656u },
+			{ 1093890735u, 859464720u }
+		};
+
+		for (int mode = 0; mode < 3; mode++) {
+#if !((defined(__x86_64__) || defined(_M_X64)) && !defined(__FP_FAST_FMAF))
+			// The filters use floats, so their rounding depends on the platform
+			if (mode != Audio::Paula::kFilterModeNone)
+				continue;
+#endif
+			for (int stereo = 0; stereo < 2; stereo++) {
+				TestPaula paula(stereo != 0, (Audio::Paula::FilterMode)mode);
+				TS_ASSERT(!paula.isBandLimited());
+				TS_ASSERT_EQUALS(paula.checksum(kNumSamples), expected[mode][stereo]);
+			}
+		}
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_band_limited() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		ConfMan.setBool("amiga_band_limited", true, Common::ConfigManager::kTransientDomain);
+
+		static const int16 expected[] = {
+			-14444, 4383, -10893, -7943, 12239, -7362, 15445, -2467
+		};
+
+		TestPaula paula(true, Audio::Paula::kFilterModeNone);
+		TS_ASSERT(paula.isBandLimited());
+
+		int16 buffer[4000];
+		TS_ASSERT_EQUALS(paula.readBuffer(buffer, ARRAYSIZE(buffer)), (int)ARRAYSIZE(buffer));
+		// The steps are computed with floats, so allow for some rounding
+		for (uint i = 0; i < ARRAYSIZE(expected); i++)
+			TS_ASSERT_DELTA(buffer[500 * i + 123], expected[i], 2);
+
+		ConfMan.removeKey("amiga_band_limited", Common::ConfigManager::kTransientDomain);
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
@@ -0,0 +1,278 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "audio/rate.h"
+#include "audio/rate_sinc.h"
+#include "common/debug.h"
+
+#include "../system/null_osystem.h"
+
+#include <math.h>
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class RateTestSuite : public CxxTest::TestSuite {
+	/** A sine tone with a DC offset, the right channel is the opposite of the left one. */
+	class ToneStream : public Audio::AudioStream {
+	public:
+		ToneStream(int rate, bool stereo, int numFrames, double freq, int amplitude, int offset = 0) :
+			_rate(rate), _stereo(stereo), _numFrames(numFrames), _freq(freq), _amplitude(amplitude), _offset(offset), _pos(0) {}
+
+		int readBuffer(int16 *buffer, const int numSamples) override {
+			int numRead = 0;
+			for (; numRead < numSamples && _pos < _numFrames; _pos++) {
+				const int16 value = (int16)(_offset + lrint(_amplitude * sin(2 * M_PI * _freq * _pos / _rate)));
+				buffer[numRead++] = value;
+				if (_stereo)
+					buffer[numRead++] = -value;
+			}
+			return numRead;
+		}
+
+		bool isStereo() const override { return _stereo; }
+		int getRate() const override { return _rate; }
+		bool endOfData() const override { return _pos >= _numFrames; }
+
+	private:
+		int _rate;
+		bool _stereo;
+		int _numFrames;
+		double _freq;
+		int _amplitude, _offset;
+		int _pos;
+	};
+
+	/** Convert a whole mono stream, and return the number of output samples. */
+	static int convertAll(Audio::RateConverter *converter, Audio::AudioStream &stream, int16 *out, int maxSamples) {
+		memset(out, 0, maxSamples * sizeof(int16));
+		int total = 0;
+		while (total < maxSamples) {
+			const int converted = converter->convert(stream, out + total, MIN(maxSamples - total, 500), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			if (converted == 0)
+				break;
+			total += converted;
+		}
+		return total;
+	}
+
+	/** Amplitude of the given frequency in @p samples, with a Hann window. */
+	static double measureAmplitude(const int16 *samples, int numSamples, int rate, double freq) {
+		double sinSum = 0.0, cosSum = 0.0, windowSum = 0.0;
+		for (int i = 0; i < numSamples; i++) {
+			const double window = 0.5 - 0.5 * cos(2 * M_PI * i / numSamples);
+			sinSum += samples[i] * window * sin(2 * M_PI * freq * i / rate);
+			cosSum += samples[i] * window * cos(2 * M_PI * freq * i / rate);
+			windowSum += window;
+		}
+		return 2.0 * sqrt(sinSum * sinSum + cosSum * cosSum) / windowSum;
+	}
+
+	/** Amplitude of @p measuredFreq after converting a tone of @p toneFreq. */
+	static double convertTone(Audio::RateConverterQuality quality, int inRate, int outRate, double toneFreq, double measuredFreq) {
+		const int numSamples = 8192;
+		int16 *out = new int16[numSamples];
+
+		ToneStream stream(inRate, false, inRate, toneFreq, 10000);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, false, quality);
+		TS_ASSERT_EQUALS(convertAll(converter, stream, out, numSamples), numSamples);
+		delete converter;
+
+		// Skip the start, where the filter is still filling up
+		const double amplitude = measureAmplitude(out + 256, numSamples - 256, outRate, measuredFreq);
+		delete[] out;
+		return amplitude;
+	}
+
+#if BENCHMARK_TIME
+	static uint32 benchmarkConverter(Audio::RateConverterQuality quality, int inRate, int outRate, int seconds) {
+		int16 out[1024];
+		ToneStream stream(inRate, false, inRate * seconds, 440.0, 10000);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, false, quality);
+
+		const uint32 start = g_system->getMillis();
+		while (converter->convert(stream, out, ARRAYSIZE(out), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume) > 0)
+			;
+		const uint32 time = g_system->getMillis() - start;
+
+		delete converter;
+		return time;
+	}
+#endif
+
+public:
+	void test_sinc_dc() {
+		static const Audio::RateConverterQuality qualities[] = { Audio::kRateConverterSincLow, Audio::kRateConverterSincMedium, Audio::kRateConverterSincHigh };
+		const int inFrames = 2000;
+		int16 out[8192];
+
+		for (int i = 0; i < ARRAYSIZE(qualities); i++) {
+			for (int inRate = 11025; inRate <= 88200; inRate *= 2) {
+				ToneStream stream(inRate, false, inFrames, 0.0, 0, 10000);
+				Audio::RateConverter *converter = Audio::makeRateConverter(inRate, 44100, false, false, false, qualities[i]);
+
+				// The whole input comes out, including the end of the stream
+				const int expected = inFrames * 44100 / inRate;
+				const int total = convertAll(converter, stream, out, ARRAYSIZE(out));
+				TS_ASSERT_LESS_THAN_EQUALS(expected - 1, total);
+				TS_ASSERT_LESS_THAN_EQUALS(total, expected + 1);
+				TS_ASSERT(!converter->needsDraining());
+
+				// Once the filter is past the leading silence, DC goes through
+				// unchanged
+				for (int j = 300; j < expected - 300; j++)
+					TS_ASSERT_EQUALS(out[j], 10000);
+
+				delete converter;
+			}
+		}
+	}
+
+	void test_sinc_stereo() {
+		for (int variant = 0; variant < 4; variant++) {
+			const bool outStereo = variant != 3;
+			const bool reverseStereo = variant == 1;
+			const bool inStereo = variant != 2;
+			int16 out[2000 * 2];
+			memset(out, 0, sizeof(out));
+
+			ToneStream stream(22050, inStereo, 1000, 0.0, 0, 8000);
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, inStereo, outStereo, reverseStereo, Audio::kRateConverterSincMedium);
+			TS_ASSERT_EQUALS(converter->convert(stream, out, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume / 2), 1000);
+			delete converter;
+
+			if (!outStereo) {
+				TS_ASSERT_EQUALS(out[500], (8000 - 4000) / 2);
+			} else if (!inStereo) {
+				TS_ASSERT_EQUALS(out[1000], 8000);
+				TS_ASSERT_EQUALS(out[1001], 4000);
+			} else {
+				TS_ASSERT_EQUALS(out[1000 + reverseStereo], 8000);
+				TS_ASSERT_EQUALS(out[1001 - reverseStereo], -4000);
+			}
+		}
+	}
+
+	void test_sinc_upsampling_images() {
+		// Upsampling a 3 kHz tone from 11025 Hz leaves an image at 8025 Hz
+		const double linearTone = convertTone(Audio::kRateConverterLinear, 11025, 44100, 3000, 3000);
+		const double linearImage = convertTone(Audio::kRateConverterLinear, 11025, 44100, 3000, 8025);
+		const double lowImage = convertTone(Audio::kRateConverterSincLow, 11025, 44100, 3000, 8025);
+		TS_ASSERT_LESS_THAN(lowImage, linearImage / 4);
+
+		static const Audio::RateConverterQuality qualities[] = { Audio::kRateConverterSincMedium, Audio::kRateConverterSincHigh };
+		for (int i = 0; i < ARRAYSIZE(qualities); i++) {
+			const double tone = convertTone(qualities[i], 11025, 44100, 3000, 3000);
+			const double image = convertTone(qualities[i], 11025, 44100, 3000, 8025);
+			TS_ASSERT_DELTA(tone, 10000.0, 1200.0);
+			TS_ASSERT_LESS_THAN(image, tone / 100);
+			TS_ASSERT_LESS_THAN(image, linearImage / 20);
+		}
+		TS_ASSERT_LESS_THAN(linearImage, linearTone);
+	}
+
+	void test_sinc_downsampling_aliases() {
+		// Downsampling a 8 kHz tone to 11025 Hz aliases it to 3025 Hz
+		const double linearAlias = convertTone(Audio::kRateConverterLinear, 44100, 11025, 8000, 3025);
+		TS_ASSERT_LESS_THAN(5000.0, linearAlias);
+
+		static const Audio::RateConverterQuality qualities[] = { Audio::kRateConverterSincMedium, Audio::kRateConverterSincHigh };
+		for (int i = 0; i < ARRAYSIZE(qualities); i++) {
+			TS_ASSERT_LESS_THAN(convertTone(qualities[i], 44100, 11025, 8000, 3025), 100.0);
+			TS_ASSERT_DELTA(convertTone(qualities[i], 44100, 11025, 2000, 2000), 10000.0, 1200.0);
+		}
+	}
+
+	void test_sinc_rate_change() {
+		// Changing the rate in the middle of a stream keeps it going
+		int16 out[4000];
+		memset(out, 0, sizeof(out));
+		ToneStream stream(22050, false, 4000, 0.0, 0, 5000);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, false, false, false, Audio::kRateConverterSincHigh);
+		TS_ASSERT_EQUALS(converter->convert(stream, out, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+		converter->setInputRate(88200);
+		TS_ASSERT_EQUALS(converter->getInputRate(), 88200u);
+		TS_ASSERT_EQUALS(converter->convert(stream, out + 1000, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+		for (int i = 1500; i < 2000; i++)
+			TS_ASSERT_EQUALS(out[i], 5000);
+		delete converter;
+	}
+
+	void test_dot_product_kernels() {
+		int16 samples[Audio::PolyphaseFilter::kMaxTaps], coeffs[Audio::PolyphaseFilter::kMaxTaps];
+		uint32 seed = 1;
+		for (int i = 0; i < Audio::PolyphaseFilter::kMaxTaps; i++) {
+			seed = seed * 1103515245 + 12345;
+			samples[i] = (int16)(seed >> 16);
+			seed = seed * 1103515245 + 12345;
+			coeffs[i] = (int16)(seed >> 16) >> 4;
+		}
+
+		for (uint numTaps = 8; numTaps <= Audio::PolyphaseFilter::kMaxTaps; numTaps += 8) {
+			const int32 expected = Audio::PolyphaseFilter::dotProductGeneric(samples, coeffs, numTaps);
+#ifdef SCUMMVM_SSE2
+			TS_ASSERT_EQUALS(Audio::PolyphaseFilter::dotProductSSE2(samples, coeffs, numTaps), expected);
+#endif
+#ifdef SCUMMVM_NEON
+			TS_ASSERT_EQUALS(Audio::PolyphaseFilter::dotProductNEON(samples, coeffs, numTaps), expected);
+#endif
+			(void)expected;
+		}
+	}
+
+	void test_mixer_resampler() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		{
+			// A sinc channel plays until the end of its stream has been
+			// pushed through the filter
+			Audio::MixerImpl mixer(44100, false);
+			mixer.setReady(true);
+			mixer.setRateConverterQuality(Audio::kRateConverterSincMedium);
+
+			Audio::SoundHandle handle;
+			mixer.playStream(Audio::Mixer::kPlainSoundType, &handle, new ToneStream(11025, false, 100, 0.0, 0, 1000),
+				-1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::YES, false, false);
+
+			int16 out[100];
+			int numFrames = 0;
+			while (mixer.isSoundHandleActive(handle) && numFrames < 1000) {
+				mixer.mixCallback((byte *)out, sizeof(out));
+				numFrames += ARRAYSIZE(out);
+			}
+			TS_ASSERT(!mixer.isSoundHandleActive(handle));
+			TS_ASSERT_LESS_THAN_EQUALS(400, numFrames);
+		}
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_speed() {
+#if BENCHMARK_TIME
+		static const struct {
+			Audio::RateConverterQuality quality;
+			const char *name;
+		} converters[] = {
+			{ Audio::kRateConverterLinear, "linear" },
+			{ Audio::kRateConverterSincLow, "sinc_low" },
+			{ Audio::kRateConverterSincMedium, "sinc_medium" },
+			{ Audio::kRateConverterSincHigh, "sinc_high" }
+		};
+		static const int rates[][2] = { { 11025, 44100 }, { 22050, 48000 }, { 44100, 22050 } };
+		const int seconds = 10;
+
+		Common::install_null_g_system();
+		for (int i = 0; i < ARRAYSIZE(rates); i++) {
+			for (int j = 0; j < ARRAYSIZE(converters); j++) {
+				const uint32 time = benchmarkConverter(converters[j].quality, rates[i][0], rates[i][1], seconds);
+				debug("%s %d -> %d Hz: %d ms per channel for %d seconds of audio\n", converters[j].name, rates[i][0], rates[i][1], time, seconds);
+			}
+		}
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
@@ -0,0 +1,134 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/samplecache.h"
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+
+class SampleCacheTestSuite : public CxxTest::TestSuite {
+	/** Create a stream of @p numSamples 16-bit samples counting from @p first. */
+	static Audio::SeekableAudioStream *makeStream(uint numSamples, int16 first, bool stereo = false) {
+		int16 *data = (int16 *)malloc(numSamples * sizeof(int16));
+		for (uint i = 0; i < numSamples; i++)
+			data[i] = first + i;
+
+		byte flags = Audio::FLAG_16BITS;
+#ifdef SCUMM_LITTLE_ENDIAN
+		flags |= Audio::FLAG_LITTLE_ENDIAN;
+#endif
+		if (stereo)
+			flags |= Audio::FLAG_STEREO;
+		return Audio::makeRawStream((byte *)data, numSamples * sizeof(int16), 22050, flags);
+	}
+
+	/** Read all of @p stream, check its samples count from @p first, and delete it. */
+	static void checkStream(Audio::SeekableAudioStream *stream, uint numSamples, int16 first) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		int16 buffer[1024];
+		uint total = 0;
+		bool same = true;
+		int read;
+		while ((read = stream->readBuffer(buffer, ARRAYSIZE(buffer))) > 0) {
+			for (int i = 0; i < read; i++)
+				same &= (buffer[i] == (int16)(first + total + i));
+			total += read;
+		}
+		TS_ASSERT(same);
+		TS_ASSERT_EQUALS(total, numSamples);
+		TS_ASSERT(stream->endOfData());
+		delete stream;
+	}
+
+public:
+	void test_hit_and_miss() {
+		Audio::SampleCache cache(100000);
+
+		TS_ASSERT(!cache.get("sound.res", 0));
+		checkStream(cache.add("sound.res", 0, makeStream(1000, 5)), 1000, 5);
+		TS_ASSERT_EQUALS(cache.getSize(), 2000u);
+
+		checkStream(cache.get("sound.res", 0), 1000, 5);
+		checkStream(cache.get("SOUND.RES", 0), 1000, 5);
+		TS_ASSERT(!cache.get("sound.res", 2000));
+		TS_ASSERT(!cache.get("other.res", 0));
+
+		TS_ASSERT_EQUALS(cache.getStats().hits, 2u);
+		TS_ASSERT_EQUALS(cache.getStats().misses, 3u);
+	}
+
+	void test_stream_format() {
+		Audio::SampleCache cache(100000);
+
+		Audio::SeekableAudioStream *stream = cache.add("sound.res", 0, makeStream(1000, 0, true));
+		TS_ASSERT(stream->isStereo());
+		TS_ASSERT_EQUALS(stream->getRate(), 22050);
+		TS_ASSERT_EQUALS(stream->getLength().totalNumberOfFrames(), 500);
+		delete stream;
+
+		stream = cache.get("sound.res", 0);
+		TS_ASSERT(stream->isStereo());
+		TS_ASSERT_EQUALS(stream->getRate(), 22050);
+
+		// Streams can be sought and rewound independently
+		TS_ASSERT(stream->seek(Audio::Timestamp(0, 100, 22050)));
+		int16 sample[2];
+		TS_ASSERT_EQUALS(stream->readBuffer(sample, 2), 2);
+		TS_ASSERT_EQUALS(sample[0], 200);
+		stream->rewind();
+		checkStream(stream, 1000, 0);
+	}
+
+	void test_eviction() {
+		Audio::SampleCache cache(8000);
+
+		for (int i = 0; i < 4; i++)
+			delete cache.add("sound.res", i * 100, makeStream(1000, i));
+		TS_ASSERT_EQUALS(cache.getSize(), 8000u);
+		TS_ASSERT_EQUALS(cache.getStats().evictions, 0u);
+
+		// Make the first sound the most recently used one
+		delete cache.get("sound.res", 0);
+
+		delete cache.add("sound.res", 400, makeStream(1000, 4));
+		TS_ASSERT_EQUALS(cache.getSize(), 8000u);
+		TS_ASSERT_EQUALS(cache.getStats().evictions, 1u);
+
+		Audio::SeekableAudioStream *stream = cache.get("sound.res", 100);
+		TS_ASSERT(!stream);
+		delete stream;
+		checkStream(cache.get("sound.res", 0), 1000, 0);
+		checkStream(cache.get("sound.res", 400), 1000, 4);
+
+		cache.setMaxSize(4000);
+		TS_ASSERT_EQUALS(cache.getSize(), 4000u);
+		checkStream(cache.get("sound.res", 0), 1000, 0);
+		checkStream(cache.get("sound.res", 400), 1000, 4);
+		TS_ASSERT(!cache.get("sound.res", 200));
+	}
+
+	void test_too_large() {
+		Audio::SampleCache cache(8000);
+
+		// Sounds larger than a quarter of the cache are not kept
+		checkStream(cache.add("music.res", 0, makeStream(1001, 7)), 1001, 7);
+		TS_ASSERT_EQUALS(cache.getSize(), 0u);
+		TS_ASSERT(!cache.get("music.res", 0));
+	}
+
+	void test_stream_outlives_entry() {
+		Audio::SeekableAudioStream *stream1, *stream2;
+		{
+			Audio::SampleCache cache(100000);
+			stream1 = cache.add("sound.res", 0, makeStream(1000, 3));
+			stream2 = cache.get("sound.res", 0);
+			cache.remove("sound.res", 0);
+			TS_ASSERT_EQUALS(cache.getSize(), 0u);
+			TS_ASSERT(!cache.get("sound.res", 0));
+		}
+
+		checkStream(stream1, 1000, 3);
+		checkStream(stream2, 1000, 3);
+	}
+};
@@ -0,0 +1,128 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/arena.h"
+
+class ArenaTestSuite : public CxxTest::TestSuite {
+	struct Tracked {
+		Tracked(int value, Common::Array<int> &destroyed) : _value(value), _destroyed(destroyed) {}
+		~Tracked() { _destroyed.push_back(_value); }
+
+		int _value;
+		Common::Array<int> &_destroyed;
+	};
+
+public:
+	void test_allocate() {
+		Common::Arena arena(1024);
+		TS_ASSERT_EQUALS(arena.getStats().numBlocks, 0u);
+
+		byte *prev = nullptr;
+		for (int i = 0; i < 1000; i++) {
+			byte *ptr = (byte *)arena.allocate(i % 37 + 1, (size_t)1 << (i % 6));
+			TS_ASSERT(ptr);
+			TS_ASSERT_EQUALS((uintptr)ptr & (((uintptr)1 << (i % 6)) - 1), 0u);
+			TS_ASSERT_DIFFERS(ptr, prev);
+			memset(ptr, i, i % 37 + 1);
+			prev = ptr;
+		}
+		TS_ASSERT_EQUALS(arena.getStats().numAllocations, 1000u);
+		TS_ASSERT_LESS_THAN(1u, arena.getStats().numBlocks);
+
+		// Allocations larger than a block get one of their own
+		byte *big = (byte *)arena.allocate(5000);
+		memset(big, 0, 5000);
+		TS_ASSERT_LESS_THAN_EQUALS(5000u, arena.getStats().bytesReserved - arena.getStats().numBlocks / 2 * 1024);
+	}
+
+	void test_reset() {
+		Common::Arena arena(256);
+		void *first = arena.allocate(16);
+		for (int i = 0; i < 100; i++)
+			arena.allocate(16);
+		const uint numBlocks = arena.getStats().numBlocks;
+		const size_t peak = arena.getStats().peakBytesUsed;
+		TS_ASSERT_LESS_THAN_EQUALS(101 * 16u, peak);
+
+		// The blocks are reused after a reset
+		arena.reset();
+		TS_ASSERT_EQUALS(arena.getStats().bytesUsed, 0u);
+		TS_ASSERT_EQUALS(arena.allocate(16), first);
+		for (int i = 0; i < 100; i++)
+			arena.allocate(16);
+		TS_ASSERT_EQUALS(arena.getStats().numBlocks, numBlocks);
+		TS_ASSERT_EQUALS(arena.getStats().peakBytesUsed, peak);
+
+		arena.reset();
+		arena.allocate(16);
+		arena.freeUnusedBlocks();
+		TS_ASSERT_EQUALS(arena.getStats().numBlocks, 1u);
+		TS_ASSERT_EQUALS(arena.getStats().bytesReserved, 256u);
+	}
+
+	void test_scope() {
+		Common::Arena arena(128);
+		Common::Array<int> destroyed;
+
+		arena.create<Tracked>(1, destroyed);
+		const size_t used = arena.getStats().bytesUsed;
+		void *next;
+		{
+			Common::ArenaScope scope(arena);
+			next = arena.allocate(8);
+			arena.create<Tracked>(2, destroyed);
+			for (int i = 0; i < 20; i++)
+				arena.allocate(24);
+			arena.create<Tracked>(3, destroyed);
+		}
+		// Only the objects created in the scope are destroyed, last one first
+		TS_ASSERT_EQUALS(destroyed.size(), 2u);
+		TS_ASSERT_EQUALS(destroyed[0], 3);
+		TS_ASSERT_EQUALS(destroyed[1], 2);
+		TS_ASSERT_EQUALS(arena.getStats().bytesUsed, used);
+		TS_ASSERT_EQUALS(arena.allocate(8), next);
+
+		arena.reset();
+		TS_ASSERT_EQUALS(destroyed.size(), 3u);
+		TS_ASSERT_EQUALS(destroyed[2], 1);
+	}
+
+	void test_deallocate() {
+		Common::Arena arena;
+		void *a = arena.allocate(100);
+		void *b = arena.allocate(100);
+
+		// Only the most recent allocation can be given back
+		const size_t used = arena.getStats().bytesUsed;
+		arena.deallocate(a, 100);
+		TS_ASSERT_EQUALS(arena.getStats().bytesUsed, used);
+		arena.deallocate(b, 100);
+		TS_ASSERT_EQUALS(arena.allocate(100), b);
+	}
+
+	void test_destructor() {
+		Common::Array<int> destroyed;
+		{
+			Common::Arena arena;
+			arena.create<Tracked>(1, destroyed);
+			arena.create<Tracked>(2, destroyed);
+		}
+		TS_ASSERT_EQUALS(destroyed.size(), 2u);
+	}
+
+	void test_array() {
+		Common::Arena arena(4096);
+		Common::ArenaArray<int> array(arena);
+		for (int i = 0; i < 500; i++)
+			array.push_back(i);
+		for (int i = 0; i < 500; i++)
+			TS_ASSERT_EQUALS(array[i], i);
+
+		// The old storage is only released with the arena, but as the
+		// capacity doubles each time, this is less than twice the final one
+		TS_ASSERT_LESS_THAN(arena.getStats().bytesUsed, 2 * 512 * sizeof(int));
+		TS_ASSERT_EQUALS(&array.getAllocator().getArena(), &arena);
+
+		Common::ArenaArray<int> copy(array);
+		TS_ASSERT(copy == array);
+	}
+};
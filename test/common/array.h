@@ -5,6 +5,31 @@
 #include "common/str.h"
 
 
+struct ArrayTestAllocatorStats {
+	int numAllocations;
+	int numDeallocations;
+	size_t bytesAllocated;
+};
+
+template<class T>
+struct ArrayTestAllocator {
+	ArrayTestAllocator(ArrayTestAllocatorStats &stats) : _stats(&stats) {}
+
+	T *allocate(size_t count) {
+		_stats->numAllocations++;
+		_stats->bytesAllocated += sizeof(T) * count;
+		return (T *)malloc(sizeof(T) * count);
+	}
+
+	void deallocate(T *ptr, size_t count) {
+		_stats->numDeallocations++;
+		_stats->bytesAllocated -= sizeof(T) * count;
+		free(ptr);
+	}
+
+	ArrayTestAllocatorStats *_stats;
+};
+
 struct ArrayTestMovable {
 	ArrayTestMovable() : _value(0), _wasMoveConstructed(false), _wasMovedFrom(false) {}
 
@@ -614,4 +639,49 @@ public:
 		TS_ASSERT_EQUALS(movableArray[0]._value, 3);
 		TS_ASSERT(movableArray[0]._wasMoveConstructed);
 	}
+
+	void test_custom_allocator() {
+		typedef Common::Array<int, ArrayTestAllocator<int> > TestArray;
+
+		// The default allocator must not make arrays any bigger
+		TS_ASSERT_EQUALS(sizeof(Common::Array<int>), 2 * sizeof(uint) + sizeof(int *));
+
+		ArrayTestAllocatorStats stats1 = { 0, 0, 0 };
+		ArrayTestAllocatorStats stats2 = { 0, 0, 0 };
+		{
+			TestArray array1((ArrayTestAllocator<int>(stats1)));
+			for (int i = 0; i < 100; i++)
+				array1.push_back(i);
+			array1.insert_at(50, 42);
+			array1.reserve(1000);
+			TS_ASSERT_EQUALS(array1.size(), 101u);
+			TS_ASSERT_EQUALS(array1[50], 42);
+			TS_ASSERT_EQUALS(array1[100], 99);
+			TS_ASSERT_EQUALS(stats1.bytesAllocated, 1000 * sizeof(int));
+
+			// Copies use a copy of the allocator
+			TestArray array2(array1);
+			TS_ASSERT_EQUALS(stats1.bytesAllocated, 1101 * sizeof(int));
+
+			// Assignments keep the allocator of the target
+			TestArray array3((ArrayTestAllocator<int>(stats2)));
+			array3.push_back(1);
+			array3 = array1;
+			TS_ASSERT_EQUALS(array3.size(), 101u);
+			TS_ASSERT_EQUALS(stats2.bytesAllocated, 101 * sizeof(int));
+
+			// Moves take the allocator along
+			TestArray array4((ArrayTestAllocator<int>(stats2)));
+			array4 = Common::move(array2);
+			TS_ASSERT_EQUALS(array4.getAllocator()._stats, &stats1);
+
+			array3.swap(array4);
+			TS_ASSERT_EQUALS(array3.getAllocator()._stats, &stats1);
+			TS_ASSERT_EQUALS(array4.getAllocator()._stats, &stats2);
+		}
+		TS_ASSERT_EQUALS(stats1.bytesAllocated, 0u);
+		TS_ASSERT_EQUALS(stats1.numAllocations, stats1.numDeallocations);
+		TS_ASSERT_EQUALS(stats2.bytesAllocated, 0u);
+		TS_ASSERT_EQUALS(stats2.numAllocations, stats2.numDeallocations);
+	}
 };
@@ -0,0 +1,78 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/compression/deflate.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+
+/**
+ * Test suite for the seek checkpoints of the streams returned by
+ * Common::wrapCompressedReadStream.
+ */
+class DeflateTestSuite : public CxxTest::TestSuite {
+	static const uint32 kDataSize = 512 * 1024;
+
+	byte *_data;
+	byte *_compressed;
+	uint32 _compressedSize;
+
+	Common::SeekableReadStream *openCompressed(uint32 checkpointInterval) {
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(_compressed, _compressedSize);
+		return Common::wrapCompressedReadStream(stream, DisposeAfterUse::YES, kDataSize, checkpointInterval);
+	}
+
+	void checkRead(Common::SeekableReadStream *stream, uint32 pos, uint32 len) {
+		byte buf[256];
+		TS_ASSERT(stream->seek(pos));
+		TS_ASSERT_EQUALS(stream->pos(), (int64)pos);
+		TS_ASSERT_EQUALS(stream->read(buf, len), len);
+		TS_ASSERT_EQUALS(memcmp(buf, _data + pos, len), 0);
+	}
+
+	void checkSeeks(uint32 checkpointInterval) {
+		Common::ScopedPtr<Common::SeekableReadStream> stream(openCompressed(checkpointInterval));
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), (int64)kDataSize);
+
+		checkRead(stream.get(), 0, 256);
+		checkRead(stream.get(), kDataSize - 256, 256);
+		checkRead(stream.get(), 1000, 256);
+		checkRead(stream.get(), kDataSize / 2, 256);
+		checkRead(stream.get(), 100, 256);
+		checkRead(stream.get(), kDataSize - 256, 256);
+		checkRead(stream.get(), kDataSize / 3, 256);
+		checkRead(stream.get(), kDataSize / 2 + 77, 256);
+		checkRead(stream.get(), 0, 256);
+	}
+
+public:
+	void setUp() {
+		// Data which compresses somewhat, so it spans many deflate blocks
+		_data = new byte[kDataSize];
+		uint32 seed = 0x1234567;
+		for (uint32 i = 0; i < kDataSize; i++) {
+			seed = seed * 1103515245 + 12345;
+			_data[i] = (seed >> 16) & 0x0F;
+		}
+
+		Common::MemoryWriteStreamDynamic *compressed = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(compressed);
+		gzip->write(_data, kDataSize);
+		gzip->finalize();
+		_compressed = compressed->getData();
+		_compressedSize = compressed->size();
+		delete gzip;
+	}
+
+	void tearDown() {
+		delete[] _data;
+		free(_compressed);
+	}
+
+	void test_seek_without_checkpoints() {
+		checkSeeks(0);
+	}
+
+	void test_seek_with_checkpoints() {
+		checkSeeks(16 * 1024);
+	}
+};
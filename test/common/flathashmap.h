@@ -0,0 +1,207 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/debug.h"
+
+#include "../system/null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite {
+	/**
+	 * Run a mix of inserts, hits, misses and erases, and return what was
+	 * found.
+	 */
+	template<class Map>
+	static Common::Array<uint> runWorkload(const Common::Array<Common::String> &keys) {
+		Common::Array<uint> found;
+		Map map;
+		for (uint i = 0; i < keys.size(); i++)
+			map[keys[i]] = i + 1;
+		// Every other lookup misses
+		for (uint i = 0; i < keys.size(); i++) {
+			found.push_back(map.contains(keys[i]));
+			found.push_back(map.contains(keys[i] + "?"));
+		}
+		for (uint i = 0; i < keys.size(); i += 2)
+			map.erase(keys[i]);
+		for (uint i = 0; i < keys.size(); i++)
+			found.push_back(map.getValOrDefault(keys[i], 0));
+		found.push_back(map.size());
+		return found;
+	}
+
+#if BENCHMARK_TIME
+	template<class Map>
+	static uint32 benchmarkMap(const Common::Array<Common::String> &keys, int rounds) {
+		const uint32 start = g_system->getMillis();
+		for (int round = 0; round < rounds; round++)
+			runWorkload<Map>(keys);
+		return g_system->getMillis() - start;
+	}
+#endif
+
+public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container.clear();
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; i++)
+			container[i] = i * 10;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		TS_ASSERT(!container.contains(0));
+		TS_ASSERT_EQUALS(container.size(), 4u);
+		for (int i = 1; i < 5; i++)
+			container.erase(i);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(1), -1);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+
+		int out = 0;
+		TS_ASSERT(containerRef.tryGetVal(0, out));
+		TS_ASSERT_EQUALS(out, 17);
+		TS_ASSERT(!containerRef.tryGetVal(2, out));
+	}
+
+	void test_grow_and_tombstones() {
+		// Identity hashes with a common stride collide a lot in HashMap;
+		// make sure both growing and reusing deleted slots work.
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 1000; i++)
+			container.setVal(i * 64, i);
+		TS_ASSERT_EQUALS(container.size(), 1000u);
+		for (int i = 0; i < 1000; i += 2)
+			container.erase(i * 64);
+		TS_ASSERT_EQUALS(container.size(), 500u);
+
+		for (int round = 0; round < 10; round++) {
+			for (int i = 0; i < 1000; i += 2)
+				container[i * 64 + round + 1] = -i;
+			for (int i = 0; i < 1000; i += 2)
+				container.erase(i * 64 + round + 1);
+		}
+
+		TS_ASSERT_EQUALS(container.size(), 500u);
+		for (int i = 0; i < 1000; i++) {
+			TS_ASSERT_EQUALS(container.contains(i * 64), (i & 1) != 0);
+			if (i & 1)
+				TS_ASSERT_EQUALS(container[i * 64], i);
+		}
+	}
+
+	void test_iterator_erase() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 100; i++)
+			container[i] = i;
+
+		// Erasing never moves nodes, so iterating on is fine
+		int sum = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			sum += i->_value;
+			if (i->_key % 3)
+				container.erase(i);
+		}
+		TS_ASSERT_EQUALS(sum, 4950);
+		TS_ASSERT_EQUALS(container.size(), 34u);
+
+		for (auto &i : container)
+			TS_ASSERT_EQUALS(i._key % 3, 0);
+	}
+
+	void test_string_map() {
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container;
+		container["foo"] = "bar";
+		container["Quux"] = "blub";
+		TS_ASSERT(container.contains("FOO"));
+		TS_ASSERT_EQUALS(container["quux"], "blub");
+		container["FOO"] = "baz";
+		TS_ASSERT_EQUALS(container.size(), 2u);
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> copy(container);
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(copy["foo"], "baz");
+
+		container = copy;
+		copy.erase("foo");
+		TS_ASSERT_EQUALS(container.getValOrDefault("foo"), "baz");
+		TS_ASSERT(!copy.contains("foo"));
+	}
+
+	void test_same_results_as_hashmap() {
+		Common::Array<Common::String> keys;
+		for (int i = 0; i < 5000; i++)
+			keys.push_back(Common::String::format("data/file%04d.dat", i));
+
+		Common::Array<uint> expected = runWorkload<Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(keys);
+		Common::Array<uint> found = runWorkload<Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(keys);
+		TS_ASSERT(found == expected);
+	}
+
+	void test_insert_own_value() {
+		// Inserting a key or value stored in the map itself must still work
+		// when the insert grows the storage and moves the nodes
+		Common::FlatHashMap<Common::String, Common::String> container;
+		container["first"] = "a value that is too long for the internal storage of String";
+		for (int i = 0; i < 200; i++)
+			container.setVal(Common::String::format("key%d", i), container["first"]);
+		for (int i = 0; i < 200; i++)
+			TS_ASSERT_EQUALS(container[Common::String::format("key%d", i)], container["first"]);
+
+		Common::FlatHashMap<Common::String, Common::String> keys;
+		keys["0"] = "1";
+		for (int i = 1; i < 200; i++)
+			keys[keys[Common::String::format("%d", i - 1)]] = Common::String::format("%d", i + 1);
+		TS_ASSERT_EQUALS(keys.size(), 200u);
+		TS_ASSERT_EQUALS(keys["199"], "200");
+	}
+
+	void test_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		Common::Array<Common::String> keys;
+		for (int i = 0; i < 5000; i++)
+			keys.push_back(Common::String::format("data/file%04d.dat", i));
+
+		const int rounds = 20;
+		const uint32 hashTime = benchmarkMap<Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(keys, rounds);
+		const uint32 flatTime = benchmarkMap<Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(keys, rounds);
+		debug("HashMap: %d ms, FlatHashMap: %d ms for %d rounds\n", hashTime, flatTime, rounds);
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
@@ -0,0 +1,76 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/file.h"
+#include "common/fs.h"
+#include "common/ptr.h"
+
+#include "../system/null_osystem.h"
+
+class MappedReadStreamTestSuite : public CxxTest::TestSuite {
+#if NULL_OSYSTEM_IS_AVAILABLE
+	// Compare the whole contents of both streams, from their current positions
+	static void checkSameContents(Common::SeekableReadStream &mapped, Common::SeekableReadStream &regular) {
+		byte mappedBuf[256], regularBuf[256];
+		for (;;) {
+			const uint32 mappedSize = mapped.read(mappedBuf, sizeof(mappedBuf));
+			const uint32 regularSize = regular.read(regularBuf, sizeof(regularBuf));
+			TS_ASSERT_EQUALS(mappedSize, regularSize);
+			if (mappedSize != regularSize || mappedSize == 0)
+				break;
+			TS_ASSERT_SAME_DATA(mappedBuf, regularBuf, mappedSize);
+		}
+		TS_ASSERT(mapped.eos());
+		TS_ASSERT(!mapped.err());
+	}
+#endif
+
+public:
+	void test_mapped_stream() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		// Map this very file, which is there when the runner is built
+		Common::FSNode node(Common::Path(__FILE__, Common::Path::kNativeSeparator));
+		if (node.exists()) {
+			Common::ScopedPtr<Common::SeekableReadStream> mapped(node.createMappedReadStream());
+			Common::ScopedPtr<Common::SeekableReadStream> regular(node.createReadStream());
+			TS_ASSERT(mapped && regular);
+			if (mapped && regular) {
+				TS_ASSERT_EQUALS(mapped->size(), regular->size());
+				checkSameContents(*mapped, *regular);
+
+				TS_ASSERT(mapped->seek(-100, SEEK_END));
+				TS_ASSERT(regular->seek(-100, SEEK_END));
+				checkSameContents(*mapped, *regular);
+
+				TS_ASSERT(mapped->seek(10));
+				TS_ASSERT_EQUALS(mapped->pos(), 10);
+				TS_ASSERT(!mapped->eos());
+			}
+		}
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_open_mapped() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		Common::FSNode node(Common::Path(__FILE__, Common::Path::kNativeSeparator));
+		if (node.exists()) {
+			Common::File file;
+			TS_ASSERT(file.openMapped(node));
+			TS_ASSERT(file.isOpen());
+			TS_ASSERT_EQUALS(file.readLine(), "#include <cxxtest/TestSuite.h>");
+			file.close();
+
+			// Directories cannot be mapped
+			TS_ASSERT(!file.openMapped(node.getParent()));
+			TS_ASSERT(!file.isOpen());
+		}
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+};
@@ -431,6 +431,33 @@ class PathTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(map.size(), 2u);
 	}
 
+	void test_caseinsensitive_mac() {
+		// Unescaped paths are hashed and compared in place, make sure this
+		// matches what is done with the escaped ones
+		Common::Path p("PARENT/dir/xn--Sound Manager 3.1  SoundLib-lba84k/SOUND");
+		Common::Path p2("parent:dir:Sound Manager 3.1 / SoundLib:Sound", ':');
+		Common::Path p3("parent/Dir/Sound Manager 3.1 : SoundLib/sound");
+		Common::Path p4("parent/dir/Sound Manager 3.1 : SoundLib/");
+		Common::Path p5("parent/dir/Sound Manager 3.1 : SoundLib/Sound/");
+
+		Common::Path::IgnoreCaseAndMac_Hash hash;
+		Common::Path::IgnoreCaseAndMac_EqualTo equal;
+
+		TS_ASSERT(equal(p, p2));
+		TS_ASSERT(equal(p, p3));
+		TS_ASSERT(equal(p2, p3));
+		TS_ASSERT_EQUALS(hash(p), hash(p2));
+		TS_ASSERT_EQUALS(hash(p), hash(p3));
+
+		TS_ASSERT(!equal(p, p4));
+		TS_ASSERT(!equal(p3, p4));
+		TS_ASSERT(!equal(p3, p5));
+		TS_ASSERT(!equal(p5, p3));
+		TS_ASSERT(!equal(p, Common::Path()));
+		TS_ASSERT(equal(Common::Path(), Common::Path()));
+		TS_ASSERT(equal(p4, Common::Path("Parent/Dir/SOUND MANAGER 3.1 : SOUNDLIB/")));
+	}
+
 	void test_lowerupper() {
 		Common::Path p2(TEST_PATH);
 		p2.toUppercase();
@@ -0,0 +1,149 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/ringbuffer.h"
+
+#include "../system/threaded_taskpool.h"
+
+class RingBufferTestSuite : public CxxTest::TestSuite {
+	template<class Buffer>
+	void checkFifo(Buffer &buffer) {
+		int value = -1;
+		TS_ASSERT(!buffer.pop(value));
+		TS_ASSERT(buffer.empty());
+
+		// Fill and drain several times, so that the positions wrap around
+		int next = 0, expected = 0;
+		for (int round = 0; round < 10; round++) {
+			for (uint i = 0; i < buffer.capacity(); i++)
+				TS_ASSERT(buffer.push(next++));
+			TS_ASSERT(!buffer.push(next));
+			TS_ASSERT(!buffer.empty());
+
+			for (uint i = 0; i < buffer.capacity() / 2 + round % 3; i++) {
+				TS_ASSERT(buffer.pop(value));
+				TS_ASSERT_EQUALS(value, expected++);
+			}
+			while (buffer.push(next))
+				next++;
+			while (buffer.pop(value))
+				TS_ASSERT_EQUALS(value, expected++);
+			TS_ASSERT(buffer.empty());
+		}
+		TS_ASSERT_EQUALS(next, expected);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	enum {
+		kItemsPerProducer = 20000
+	};
+
+	template<class Buffer>
+	struct Producer {
+		Buffer *buffer;
+		uint id;
+	};
+
+	// Pushes increasing values tagged with the producer id, waiting while full
+	template<class Buffer>
+	static void produce(void *param) {
+		Producer<Buffer> *producer = (Producer<Buffer> *)param;
+		for (uint i = 0; i < kItemsPerProducer; i++) {
+			while (!producer->buffer->push((producer->id << 16) | i))
+				;
+		}
+	}
+
+	template<class Buffer>
+	void checkThreaded(uint numProducers) {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(numProducers);
+		Buffer buffer(64);
+
+		Producer<Buffer> producers[4];
+		Common::TaskPool::TaskGroup group;
+		for (uint i = 0; i < numProducers; i++) {
+			producers[i].buffer = &buffer;
+			producers[i].id = i;
+			pool->submit(group, produce<Buffer>, &producers[i]);
+		}
+
+		// Consume on this thread. The items of each producer must arrive
+		// complete and in order.
+		uint next[4] = { 0, 0, 0, 0 };
+		uint received = 0;
+		uint errors = 0;
+		while (received < numProducers * kItemsPerProducer) {
+			uint item;
+			if (!buffer.pop(item))
+				continue;
+
+			const uint id = item >> 16;
+			if (id >= numProducers || (item & 0xFFFF) != next[id])
+				errors++;
+			else
+				next[id]++;
+			received++;
+		}
+		pool->wait(group);
+
+		TS_ASSERT_EQUALS(errors, 0u);
+		for (uint i = 0; i < numProducers; i++)
+			TS_ASSERT_EQUALS(next[i], (uint)kItemsPerProducer);
+		TS_ASSERT(buffer.empty());
+
+		delete pool;
+	}
+#endif
+
+public:
+	void test_capacity() {
+		Common::SPSCRingBuffer<int> a(5);
+		TS_ASSERT_EQUALS(a.capacity(), 8u);
+		Common::MPSCRingBuffer<int> b(16);
+		TS_ASSERT_EQUALS(b.capacity(), 16u);
+		Common::MPSCRingBuffer<int> c(0);
+		TS_ASSERT_EQUALS(c.capacity(), 2u);
+	}
+
+	void test_spsc_fifo() {
+		Common::SPSCRingBuffer<int> buffer(8);
+		checkFifo(buffer);
+		TS_ASSERT(buffer.push(42));
+		TS_ASSERT_EQUALS(buffer.size(), 1u);
+	}
+
+	void test_spsc_bulk() {
+		Common::SPSCRingBuffer<int> buffer(8);
+		int items[10], out[10];
+		for (int i = 0; i < ARRAYSIZE(items); i++)
+			items[i] = i;
+
+		// Start near the end of the storage, so that copies wrap around
+		TS_ASSERT_EQUALS(buffer.push(items, 6), 6u);
+		TS_ASSERT_EQUALS(buffer.pop(out, 5), 5u);
+		TS_ASSERT_EQUALS(buffer.push(items, 10), 7u);
+		TS_ASSERT_EQUALS(buffer.size(), 8u);
+		TS_ASSERT_EQUALS(buffer.push(items, 1), 0u);
+
+		TS_ASSERT_EQUALS(buffer.pop(out, 10), 8u);
+		TS_ASSERT_EQUALS(out[0], 5);
+		for (int i = 0; i < 7; i++)
+			TS_ASSERT_EQUALS(out[i + 1], i);
+		TS_ASSERT_EQUALS(buffer.pop(out, 10), 0u);
+		TS_ASSERT(buffer.empty());
+	}
+
+	void test_mpsc_fifo() {
+		Common::MPSCRingBuffer<int> buffer(8);
+		checkFifo(buffer);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	void test_spsc_threaded() {
+		checkThreaded<Common::SPSCRingBuffer<uint> >(1);
+	}
+
+	void test_mpsc_threaded() {
+		checkThreaded<Common::MPSCRingBuffer<uint> >(4);
+	}
+#endif
+};
@@ -0,0 +1,152 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/atomic.h"
+#include "common/memstream.h"
+
+#include "../system/threaded_taskpool.h"
+
+/**
+ * An archive made of empty files. The size of each stream is the id of the archive,
+ * which allows telling which archive served the request.
+ */
+class TestSearchSetArchive : public Common::Archive {
+public:
+	TestSearchSetArchive(uint32 id) : _id(id) {}
+
+	void addFile(const char *name) { _files.push_back(Common::Path(name)); }
+
+	bool hasFile(const Common::Path &path) const override {
+		for (const auto &file : _files) {
+			if (file.equalsIgnoreCase(path))
+				return true;
+		}
+		return false;
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const override {
+		for (const auto &file : _files)
+			list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(file, *this)));
+		return _files.size();
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+		if (!hasFile(path))
+			return Common::ArchiveMemberPtr();
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path, *this));
+	}
+
+	Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override {
+		if (!hasFile(path))
+			return nullptr;
+		return new Common::MemoryReadStream(_data, _id);
+	}
+
+private:
+	uint32 _id;
+	byte _data[16] = {};
+	Common::Array<Common::Path> _files;
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite {
+	static uint32 streamId(const Common::SearchSet &set, const char *name) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(Common::Path(name));
+		if (!stream)
+			return 0;
+		uint32 id = stream->size();
+		delete stream;
+		return id;
+	}
+
+	static void fill(Common::SearchSet &set) {
+		TestSearchSetArchive *a = new TestSearchSetArchive(1);
+		a->addFile("shared.dat");
+		a->addFile("a.dat");
+		TestSearchSetArchive *b = new TestSearchSetArchive(2);
+		b->addFile("SHARED.DAT");
+		b->addFile("dir/b.dat");
+		set.add("a", a, 0);
+		set.add("b", b, 1);
+	}
+
+	void checkLookups(Common::SearchSet &set) {
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT(set.hasFile("DIR/B.DAT"));
+		TS_ASSERT(!set.hasFile("missing.dat"));
+
+		TS_ASSERT_EQUALS(streamId(set, "shared.dat"), 2u);
+		TS_ASSERT_EQUALS(streamId(set, "a.dat"), 1u);
+		TS_ASSERT_EQUALS(streamId(set, "missing.dat"), 0u);
+
+		Common::Archive *container = nullptr;
+		TS_ASSERT(set.getMember("shared.dat", &container));
+		TS_ASSERT_EQUALS(container, set.getArchive("b"));
+
+		set.setPriority("a", 2);
+		TS_ASSERT_EQUALS(streamId(set, "shared.dat"), 1u);
+
+		set.remove("a");
+		TS_ASSERT_EQUALS(streamId(set, "shared.dat"), 2u);
+		TS_ASSERT(!set.hasFile("a.dat"));
+
+		TestSearchSetArchive *c = new TestSearchSetArchive(3);
+		c->addFile("a.dat");
+		set.add("c", c, -1);
+		TS_ASSERT_EQUALS(streamId(set, "a.dat"), 3u);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	struct LookupData {
+		const Common::SearchSet *set;
+		Common::Atomic<int> failures;
+	};
+
+	static void lookupRange(uint begin, uint end, void *param) {
+		LookupData *data = (LookupData *)param;
+		for (uint i = begin; i < end; i++) {
+			if (!data->set->hasFile("dir/b.dat") || streamId(*data->set, "shared.dat") != 2)
+				data->failures++;
+		}
+	}
+#endif
+
+public:
+	void test_linear_lookup() {
+		Common::SearchSet set;
+		fill(set);
+		checkLookups(set);
+	}
+
+	void test_indexed_lookup() {
+		Common::SearchSet set;
+		set.setUseIndex(true);
+		fill(set);
+		checkLookups(set);
+	}
+
+	void test_index_enabled_after_fill() {
+		Common::SearchSet set;
+		fill(set);
+		set.setUseIndex(true);
+		checkLookups(set);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	void test_threaded_indexed_lookup() {
+		Common::SearchSet set;
+		fill(set);
+		set.setUseIndex(true);
+
+		// Lookups only read the index, so the workers can share the set
+		LookupData data;
+		data.set = &set;
+		data.failures = 0;
+
+		Common::TaskPool *pool = Common::createThreadedTaskPool(3);
+		pool->parallelFor(1000, lookupRange, &data);
+		delete pool;
+
+		TS_ASSERT_EQUALS((int)data.failures, 0);
+	}
+#endif
+};
@@ -0,0 +1,226 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atomic.h"
+#include "common/taskpool.h"
+
+#include "../system/threaded_taskpool.h"
+
+class TaskPoolTestSuite : public CxxTest::TestSuite {
+	struct RangeData {
+		int hits[1000];
+		uint ends[1000]; ///< End of the range starting at each index
+	};
+
+	// Ranges do not overlap, so this is safe on several threads
+	static void countRange(uint begin, uint end, void *param) {
+		RangeData *data = (RangeData *)param;
+		for (uint i = begin; i < end; i++)
+			data->hits[i]++;
+		data->ends[begin] = end;
+	}
+
+	static void increment(void *param) {
+		(*(int *)param)++;
+	}
+
+	// Pretends to have several threads, to exercise the splitting in parallelFor()
+	class FakeThreadedPool : public Common::TaskPool {
+	public:
+		FakeThreadedPool(uint numThreads) : _numThreads(numThreads) {}
+		uint getNumThreads() const override { return _numThreads; }
+
+	private:
+		uint _numThreads;
+	};
+
+	void checkParallelFor(Common::TaskPool &pool, uint count, uint minRangeSize, uint expectedRanges) {
+		RangeData data;
+		memset(data.hits, 0, sizeof(data.hits));
+		memset(data.ends, 0, sizeof(data.ends));
+
+		pool.parallelFor(count, countRange, &data, minRangeSize);
+
+		for (uint i = 0; i < count; i++)
+			TS_ASSERT_EQUALS(data.hits[i], 1);
+		for (uint i = count; i < ARRAYSIZE(data.hits); i++)
+			TS_ASSERT_EQUALS(data.hits[i], 0);
+
+		// Walk the ranges, which must follow each other
+		uint numRanges = 0;
+		uint shortestRange = count;
+		for (uint begin = 0; begin < count && data.ends[begin] > begin; begin = data.ends[begin]) {
+			numRanges++;
+			shortestRange = MIN(shortestRange, data.ends[begin] - begin);
+		}
+		TS_ASSERT_EQUALS(numRanges, expectedRanges);
+		if (expectedRanges > 1)
+			TS_ASSERT_LESS_THAN_EQUALS(minRangeSize, shortestRange);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	static void atomicIncrement(void *param) {
+		(*(Common::Atomic<int> *)param)++;
+	}
+
+	struct Blocker {
+		Common::Atomic<bool> started;
+		Common::Atomic<bool> released;
+	};
+
+	// Keeps a worker busy until released
+	static void block(void *param) {
+		Blocker *blocker = (Blocker *)param;
+		blocker->started = true;
+		while (!blocker->released)
+			;
+	}
+#endif
+
+public:
+	void test_serial_submit() {
+		Common::TaskPool pool;
+		TS_ASSERT_EQUALS(pool.getNumThreads(), 1u);
+
+		int counter = 0;
+		Common::TaskPool::TaskGroup group;
+		for (int i = 0; i < 10; i++)
+			pool.submit(group, increment, &counter);
+		pool.wait(group);
+		TS_ASSERT_EQUALS(counter, 10);
+	}
+
+	void test_serial_parallel_for() {
+		Common::TaskPool pool;
+		checkParallelFor(pool, 0, 1, 0);
+		checkParallelFor(pool, 1, 1, 1);
+		checkParallelFor(pool, 1000, 1, 1);
+	}
+
+	void test_parallel_for_ranges() {
+		FakeThreadedPool pool(4);
+		checkParallelFor(pool, 1000, 1, 4);
+		checkParallelFor(pool, 3, 1, 3);
+		checkParallelFor(pool, 1000, 250, 4);
+		checkParallelFor(pool, 1000, 300, 3);
+		checkParallelFor(pool, 1000, 400, 2);
+		checkParallelFor(pool, 100, 400, 1);
+		checkParallelFor(pool, 1000, 1000, 1);
+		checkParallelFor(pool, 10, 0, 4);
+
+		FakeThreadedPool bigPool(100);
+		checkParallelFor(bigPool, 1000, 1, Common::TaskPool::kMaxThreads);
+	}
+
+#if THREADED_TASKPOOL_IS_AVAILABLE
+	void test_threaded_submit() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(3);
+		TS_ASSERT_EQUALS(pool->getNumThreads(), 4u);
+
+		Common::Atomic<int> counter(0);
+		Common::TaskPool::TaskGroup group;
+		for (int round = 0; round < 10; round++) {
+			for (int i = 0; i < 100; i++)
+				pool->submit(group, atomicIncrement, &counter);
+			pool->wait(group);
+			TS_ASSERT_EQUALS((int)counter, (round + 1) * 100);
+		}
+
+		delete pool;
+	}
+
+	void test_threaded_wait_isolation() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(1);
+
+		// Keep the only worker busy with a task of group A
+		Blocker blocker;
+		Common::TaskPool::TaskGroup groupA, groupB;
+		pool->submit(groupA, block, &blocker);
+		while (!blocker.started)
+			;
+
+		// Waiting for B runs its tasks on this thread, but not the ones of A
+		Common::Atomic<int> counterA(0), counterB(0);
+		pool->submit(groupA, atomicIncrement, &counterA);
+		for (int i = 0; i < 5; i++)
+			pool->submit(groupB, atomicIncrement, &counterB);
+		pool->wait(groupB);
+		TS_ASSERT_EQUALS((int)counterB, 5);
+		TS_ASSERT_EQUALS((int)counterA, 0);
+
+		blocker.released = true;
+		pool->wait(groupA);
+		TS_ASSERT_EQUALS((int)counterA, 1);
+
+		delete pool;
+	}
+
+	void test_threaded_try_submit() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(1);
+
+		Blocker blocker;
+		Common::TaskPool::TaskGroup group;
+		pool->submit(group, block, &blocker);
+		while (!blocker.started)
+			;
+
+		// trySubmit() gives up once the preallocated tasks are all queued,
+		// instead of allocating memory. submit() still queues more tasks.
+		Common::Atomic<int> counter(0);
+		int queued = 0;
+		while (queued < 1000 && pool->trySubmit(group, atomicIncrement, &counter))
+			queued++;
+		TS_ASSERT_LESS_THAN(0, queued);
+		TS_ASSERT_LESS_THAN(queued, 1000);
+		for (int i = 0; i < 10; i++)
+			pool->submit(group, atomicIncrement, &counter);
+
+		blocker.released = true;
+		pool->wait(group);
+		TS_ASSERT_EQUALS((int)counter, queued + 10);
+
+		// The tasks are available again
+		TS_ASSERT(pool->trySubmit(group, atomicIncrement, &counter));
+		pool->wait(group);
+
+		delete pool;
+	}
+
+	void test_threaded_cancel() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(1);
+
+		Blocker blocker;
+		Common::TaskPool::TaskGroup blockGroup;
+		pool->submit(blockGroup, block, &blocker);
+		while (!blocker.started)
+			;
+
+		// Only the queued tasks of the group are dropped
+		Common::Atomic<int> counter(0), otherCounter(0);
+		Common::TaskPool::TaskGroup group, otherGroup;
+		for (int i = 0; i < 5; i++) {
+			pool->submit(group, atomicIncrement, &counter);
+			pool->submit(otherGroup, atomicIncrement, &otherCounter);
+		}
+		pool->cancel(group);
+		pool->wait(group);
+
+		blocker.released = true;
+		pool->wait(blockGroup);
+		pool->wait(otherGroup);
+		TS_ASSERT_EQUALS((int)counter, 0);
+		TS_ASSERT_EQUALS((int)otherCounter, 5);
+
+		delete pool;
+	}
+
+	void test_threaded_parallel_for() {
+		Common::TaskPool *pool = Common::createThreadedTaskPool(3);
+		for (int round = 0; round < 10; round++) {
+			checkParallelFor(*pool, 1000, 1, 4);
+			checkParallelFor(*pool, 1000, 400, 2);
+			checkParallelFor(*pool, 3, 1, 3);
+		}
+		delete pool;
+	}
+#endif
+};
@@ -0,0 +1,85 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+
+#include "engines/detectionCache.h"
+
+class DetectionCacheTestSuite : public CxxTest::TestSuite {
+	// Save the cache, and load it back into @p loaded
+	static bool roundTrip(const DetectionCache &cache, DetectionCache &loaded) {
+		Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+		cache.save(stream);
+
+		Common::MemoryReadStream file(stream.getData(), stream.size());
+		return loaded.load(file);
+	}
+
+public:
+	void test_round_trip() {
+		DetectionCache cache;
+		cache.store("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000000, "8776caed014c321272af407c1502a2df");
+		// Paths may contain any character, including the separators of the file
+		cache.store("md5:5000:/games/odd\tname\nwith\\escapes\\n\r", 1234, -1, "0123456789abcdef0123456789abcdef");
+		TS_ASSERT_EQUALS(cache.getNumChanges(), 2u);
+
+		DetectionCache loaded;
+		TS_ASSERT(roundTrip(cache, loaded));
+		TS_ASSERT_EQUALS(loaded.size(), 2u);
+		TS_ASSERT_EQUALS(loaded.getNumChanges(), 0u);
+
+		Common::String md5;
+		TS_ASSERT(loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000000, md5));
+		TS_ASSERT_EQUALS(md5, "8776caed014c321272af407c1502a2df");
+		TS_ASSERT(loaded.lookup("md5:5000:/games/odd\tname\nwith\\escapes\\n\r", 1234, -1, md5));
+		TS_ASSERT_EQUALS(md5, "0123456789abcdef0123456789abcdef");
+		TS_ASSERT(!loaded.lookup("md5:5000:/games/odd", 1234, -1, md5));
+		TS_ASSERT(!loaded.lookup("md5:1024:/games/monkey/MONKEY.000", 8357, 1700000000, md5));
+	}
+
+	void test_invalidation() {
+		DetectionCache cache;
+		cache.store("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000000, "8776caed014c321272af407c1502a2df");
+
+		DetectionCache loaded;
+		TS_ASSERT(roundTrip(cache, loaded));
+
+		// The entry is not used once the file changed
+		Common::String md5;
+		TS_ASSERT(!loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000001, md5));
+		TS_ASSERT(!loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8358, 1700000000, md5));
+		TS_ASSERT(loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000000, md5));
+
+		// Hashing the new file replaces the entry
+		loaded.store("md5:5000:/games/monkey/MONKEY.000", 8358, 1700000001, "00000000000000000000000000000000");
+		TS_ASSERT_EQUALS(loaded.size(), 1u);
+		TS_ASSERT(!loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8357, 1700000000, md5));
+		TS_ASSERT(loaded.lookup("md5:5000:/games/monkey/MONKEY.000", 8358, 1700000001, md5));
+		TS_ASSERT_EQUALS(md5, "00000000000000000000000000000000");
+	}
+
+	void test_prune() {
+		DetectionCache cache;
+		cache.store("old", 1, 1, "00000000000000000000000000000000");
+
+		// Each load starts a new generation, and the entries which are used
+		// in it are kept over the others
+		DetectionCache loaded;
+		TS_ASSERT(roundTrip(cache, loaded));
+		loaded.store("new", 2, 2, "11111111111111111111111111111111");
+		loaded.prune(1);
+		TS_ASSERT_EQUALS(loaded.size(), 1u);
+
+		Common::String md5;
+		TS_ASSERT(!loaded.lookup("old", 1, 1, md5));
+		TS_ASSERT(loaded.lookup("new", 2, 2, md5));
+	}
+
+	void test_unknown_format() {
+		static const char data[] = "SCUMMVM_DETECTION_CACHE 1\n0\n0\t1\t1\tmd5\tpath\n";
+		Common::MemoryReadStream file((const byte *)data, sizeof(data) - 1);
+
+		DetectionCache cache;
+		TS_ASSERT(!cache.load(file));
+		TS_ASSERT_EQUALS(cache.size(), 0u);
+	}
+};
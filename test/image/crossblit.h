@@ -0,0 +1,187 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "graphics/blit.h"
+#include "graphics/pixelformat.h"
+
+class CrossBlitTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 37,
+		kHeight = 5,
+		kPadding = 3,
+		kMaxPitch = kWidth * 4 + kPadding
+	};
+
+	static void fillRandom(byte *data, uint size, uint32 seed) {
+		for (uint i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (byte)(seed >> 16);
+		}
+	}
+
+	static uint32 readColor(const byte *src, uint bytesPerPixel) {
+		if (bytesPerPixel == 2)
+			return *(const uint16 *)src;
+		if (bytesPerPixel == 4)
+			return *(const uint32 *)src;
+		return READ_UINT24(src);
+	}
+
+	static void writeColor(byte *dst, uint bytesPerPixel, uint32 color) {
+		if (bytesPerPixel == 2)
+			*(uint16 *)dst = color;
+		else if (bytesPerPixel == 4)
+			*(uint32 *)dst = color;
+		else
+			WRITE_UINT24(dst, color);
+	}
+
+	void checkConvert(const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+		const uint srcPitch = kWidth * srcFmt.bytesPerPixel + kPadding;
+		const uint dstPitch = kWidth * dstFmt.bytesPerPixel + kPadding;
+		byte src[kHeight * kMaxPitch], expected[kHeight * kMaxPitch], dst[kHeight * kMaxPitch];
+
+		fillRandom(src, sizeof(src), srcFmt.bytesPerPixel * 1000 + srcFmt.rShift);
+		memset(expected, 0, sizeof(expected));
+		for (uint y = 0; y < kHeight; y++) {
+			for (uint x = 0; x < kWidth; x++) {
+				byte a, r, g, b;
+				srcFmt.colorToARGB(readColor(src + y * srcPitch + x * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), a, r, g, b);
+				writeColor(expected + y * dstPitch + x * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel, dstFmt.ARGBToColor(a, r, g, b));
+			}
+		}
+
+		memset(dst, 0, sizeof(dst));
+		TS_ASSERT(Graphics::crossBlit(dst, src, dstPitch, srcPitch, kWidth, kHeight, dstFmt, srcFmt));
+		TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+
+		// Convert in place, with the destination lines twice as long when
+		// the pixels get larger
+		const uint inPlacePitch = (dstFmt.bytesPerPixel > srcFmt.bytesPerPixel) ? dstPitch * 2 : dstPitch;
+		byte buffer[kHeight * kMaxPitch * 2];
+		memset(buffer, 0, sizeof(buffer));
+		for (uint y = 0; y < kHeight; y++)
+			memcpy(buffer + y * srcPitch, src + y * srcPitch, srcPitch);
+		TS_ASSERT(Graphics::crossBlit(buffer, buffer, inPlacePitch, srcPitch, kWidth, kHeight, dstFmt, srcFmt));
+		for (uint y = 0; y < kHeight; y++)
+			TS_ASSERT_SAME_DATA(buffer + y * inPlacePitch, expected + y * dstPitch, kWidth * dstFmt.bytesPerPixel);
+	}
+
+	void checkMap(uint bytesPerPixel) {
+		const uint srcPitch = kWidth + kPadding;
+		const uint dstPitch = kWidth * bytesPerPixel + kPadding;
+		byte src[kHeight * kMaxPitch], expected[kHeight * kMaxPitch], dst[kHeight * kMaxPitch];
+		uint32 map[256];
+
+		fillRandom(src, sizeof(src), bytesPerPixel);
+		fillRandom((byte *)map, sizeof(map), 42);
+		memset(expected, 0, sizeof(expected));
+		for (uint y = 0; y < kHeight; y++) {
+			for (uint x = 0; x < kWidth; x++) {
+				const uint32 color = map[src[y * srcPitch + x]];
+				if (bytesPerPixel == 2)
+					*(uint16 *)(expected + y * dstPitch + x * 2) = color;
+				else
+					*(uint32 *)(expected + y * dstPitch + x * 4) = color;
+			}
+		}
+
+		memset(dst, 0, sizeof(dst));
+		TS_ASSERT(Graphics::crossBlitMap(dst, src, dstPitch, srcPitch, kWidth, kHeight, bytesPerPixel, map));
+		TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+
+		byte buffer[kHeight * kMaxPitch * 4];
+		memset(buffer, 0, sizeof(buffer));
+		for (uint y = 0; y < kHeight; y++)
+			memcpy(buffer + y * srcPitch, src + y * srcPitch, srcPitch);
+		TS_ASSERT(Graphics::crossBlitMap(buffer, buffer, dstPitch * 4, srcPitch, kWidth, kHeight, bytesPerPixel, map));
+		for (uint y = 0; y < kHeight; y++)
+			TS_ASSERT_SAME_DATA(buffer + y * dstPitch * 4, expected + y * dstPitch, kWidth * bytesPerPixel);
+	}
+
+	void checkFuncs() {
+		// The conversions from 16bpp and 24bpp to 32bpp, and back
+		const Graphics::PixelFormat smallFormats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0),
+			Graphics::PixelFormat(2, 3, 3, 2, 0, 5, 2, 0, 0),
+			Graphics::PixelFormat(2, 4, 4, 4, 0, 8, 4, 0, 0),
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 16, 8, 0, 0),
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 0, 8, 16, 0),
+			Graphics::PixelFormat(3, 6, 6, 6, 6, 18, 12, 6, 0)
+		};
+		const Graphics::PixelFormat largeFormats[] = {
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 8, 16, 24, 0)
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(smallFormats); i++) {
+			for (uint j = 0; j < ARRAYSIZE(largeFormats); j++) {
+				checkConvert(largeFormats[j], smallFormats[i]);
+				checkConvert(smallFormats[i], largeFormats[j]);
+			}
+		}
+		checkMap(2);
+		checkMap(4);
+	}
+
+	void setFuncs(Graphics::CrossBlit::ConvertFunc convert16To32, Graphics::CrossBlit::ConvertFunc convert24To32,
+				  Graphics::CrossBlit::ConvertFunc convert32To16, Graphics::CrossBlit::ConvertFunc convert32To24,
+				  Graphics::CrossBlit::MapFunc map8To16, Graphics::CrossBlit::MapFunc map8To32) {
+		Graphics::CrossBlit::convert16To32Func = convert16To32;
+		Graphics::CrossBlit::convert24To32Func = convert24To32;
+		Graphics::CrossBlit::convert32To16Func = convert32To16;
+		Graphics::CrossBlit::convert32To24Func = convert32To24;
+		Graphics::CrossBlit::map8To16Func = map8To16;
+		Graphics::CrossBlit::map8To32Func = map8To32;
+	}
+
+public:
+	void test_generic() {
+		setFuncs(Graphics::CrossBlit::convert16To32Generic, Graphics::CrossBlit::convert24To32Generic,
+			Graphics::CrossBlit::convert32To16Generic, Graphics::CrossBlit::convert32To24Generic,
+			Graphics::CrossBlit::map8To16Generic, Graphics::CrossBlit::map8To32Generic);
+		checkFuncs();
+	}
+
+	void test_simd() {
+#ifdef SCUMMVM_NEON
+		setFuncs(Graphics::CrossBlit::convert16To32NEON, Graphics::CrossBlit::convert24To32NEON,
+			Graphics::CrossBlit::convert32To16NEON, Graphics::CrossBlit::convert32To24NEON,
+			Graphics::CrossBlit::map8To16NEON, Graphics::CrossBlit::map8To32NEON);
+		checkFuncs();
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2) {
+			setFuncs(Graphics::CrossBlit::convert16To32SSE2, Graphics::CrossBlit::convert24To32SSE2,
+				Graphics::CrossBlit::convert32To16SSE2, Graphics::CrossBlit::convert32To24SSE2,
+				Graphics::CrossBlit::map8To16SSE2, Graphics::CrossBlit::map8To32SSE2);
+			checkFuncs();
+		}
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8) {
+			setFuncs(Graphics::CrossBlit::convert16To32AVX2, Graphics::CrossBlit::convert24To32AVX2,
+				Graphics::CrossBlit::convert32To16AVX2, Graphics::CrossBlit::convert32To24AVX2,
+				Graphics::CrossBlit::map8To16AVX2, Graphics::CrossBlit::map8To32AVX2);
+			checkFuncs();
+		}
+#endif
+	}
+
+	void test_unsupported() {
+		// Formats with more than 8 bits per component are left to the
+		// generic code
+		const Graphics::PixelFormat dstFmt(4, 10, 10, 10, 2, 20, 10, 0, 30);
+		const Graphics::PixelFormat srcFmt(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		byte buffer[8] = {};
+		TS_ASSERT(!Graphics::CrossBlit::convert(buffer, buffer, 4, 2, 1, 1, dstFmt, srcFmt));
+		TS_ASSERT(!Graphics::CrossBlit::convert(buffer, buffer, 2, 4, 1, 1, srcFmt, dstFmt));
+		TS_ASSERT(!Graphics::CrossBlit::convertMap(buffer, buffer, 3, 1, 1, 1, 3, nullptr));
+	}
+};
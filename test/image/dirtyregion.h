@@ -0,0 +1,214 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyregion.h"
+#include "graphics/screen.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 100,
+		kHeight = 70
+	};
+
+	typedef bool Coverage[kHeight][kWidth];
+
+	static void clearCoverage(Coverage &coverage) {
+		memset(coverage, 0, sizeof(Coverage));
+	}
+
+	static void cover(Coverage &coverage, const Common::Rect &r) {
+		const Common::Rect rect = Common::Rect(kWidth, kHeight).findIntersectingRect(r);
+		for (int y = rect.top; y < rect.bottom; y++) {
+			for (int x = rect.left; x < rect.right; x++)
+				coverage[y][x] = true;
+		}
+	}
+
+	/**
+	 * Check that the rects of the region do not overlap and cover all of
+	 * @p marked. If @p exactTiles is set, they must also not cover tiles
+	 * not touched by it.
+	 */
+	void checkRects(const Graphics::DirtyRegion &region, const Coverage &marked, bool exactTiles) {
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+
+		Coverage covered;
+		clearCoverage(covered);
+		for (uint i = 0; i < rects.size(); i++) {
+			TS_ASSERT(!rects[i].isEmpty());
+			TS_ASSERT(region.getBounds().contains(rects[i]));
+			for (uint j = 0; j < i; j++)
+				TS_ASSERT(!rects[i].intersects(rects[j]));
+			cover(covered, rects[i]);
+		}
+
+		const int tileSize = region.getTileSize();
+		for (int y = 0; y < kHeight; y++) {
+			for (int x = 0; x < kWidth; x++) {
+				if (marked[y][x])
+					TS_ASSERT(covered[y][x]);
+				if (!exactTiles || !covered[y][x])
+					continue;
+
+				bool tileMarked = false;
+				for (int ty = y - y % tileSize; ty < MIN<int>(y - y % tileSize + tileSize, kHeight); ty++) {
+					for (int tx = x - x % tileSize; tx < MIN<int>(x - x % tileSize + tileSize, kWidth); tx++)
+						tileMarked |= marked[ty][tx];
+				}
+				TS_ASSERT(tileMarked);
+			}
+		}
+	}
+
+	/** Gives access to the dirty rects, like the engine subclasses use them. */
+	class TestScreen : public Graphics::Screen {
+	public:
+		TestScreen() : Graphics::Screen(kWidth, kHeight) {}
+
+		const Common::List<Common::Rect> &getDirtyRects() const { return _dirtyRects; }
+		using Graphics::Screen::mergeDirtyRects;
+	};
+
+public:
+	void test_few_rects() {
+		Graphics::DirtyRegion region(kWidth, kHeight);
+		TS_ASSERT(region.isEmpty());
+
+		// A few rects are kept exactly, overlapping ones are merged
+		region.addRect(Common::Rect(3, 4, 10, 12));
+		region.addRect(Common::Rect(50, 50, 60, 55));
+		region.addRect(Common::Rect(8, 10, 20, 14));
+		region.addRect(Common::Rect(52, 51, 53, 52));
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 2U);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(50, 50, 60, 55));
+		TS_ASSERT_EQUALS(rects[1], Common::Rect(3, 4, 20, 14));
+		TS_ASSERT_EQUALS(region.getBounds(), Common::Rect(3, 4, 60, 55));
+
+		// Rects are clipped to the tracked area
+		region.clear();
+		TS_ASSERT(region.isEmpty());
+		region.addRect(Common::Rect(-5, 60, 200, 100));
+		region.addRect(Common::Rect(200, 0, 300, 10));
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 1U);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 60, kWidth, kHeight));
+	}
+
+	void test_tiles() {
+		Graphics::DirtyRegion region(kWidth, kHeight, 8);
+		Coverage marked;
+		clearCoverage(marked);
+
+		// Many small rects switch the region to tiles
+		uint32 seed = 1;
+		for (int i = 0; i < 60; i++) {
+			seed = seed * 1103515245 + 12345;
+			const int x = (seed >> 8) % kWidth;
+			const int y = (seed >> 16) % kHeight;
+			const Common::Rect r(x, y, x + 1 + (seed >> 24) % 12, y + 1 + (seed >> 28));
+			region.addRect(r);
+			cover(marked, r);
+		}
+		// The rects merged before the switch may span unmarked tiles
+		checkRects(region, marked, false);
+
+		// Resizing keeps the dirty areas
+		region.setSize(kWidth + 50, kHeight + 20);
+		checkRects(region, marked, false);
+	}
+
+	void test_coalesce_tiles() {
+		Graphics::DirtyRegion region(kWidth, kHeight, 10);
+		Coverage marked;
+		clearCoverage(marked);
+
+		// One dot per tile of a block of 6x3 tiles is coalesced into one
+		// rect, clipped to the bounding box of the dots
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 6; x++) {
+				const Common::Rect r(21 + x * 10, 32 + y * 10, 23 + x * 10, 33 + y * 10);
+				region.addRect(r);
+				cover(marked, r);
+			}
+		}
+		checkRects(region, marked, true);
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 1U);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(21, 32, 73, 53));
+
+		// Tiles in other columns start rects of their own
+		const Common::Rect others[] = {
+			Common::Rect(85, 45, 86, 46), Common::Rect(85, 55, 86, 56),
+			Common::Rect(85, 65, 86, 66), Common::Rect(5, 65, 6, 66)
+		};
+		for (uint i = 0; i < ARRAYSIZE(others); i++) {
+			region.addRect(others[i]);
+			cover(marked, others[i]);
+		}
+		checkRects(region, marked, true);
+	}
+
+	void test_add_all() {
+		Graphics::DirtyRegion region(kWidth, kHeight);
+		region.addRect(Common::Rect(5, 5, 6, 6));
+		region.addAll();
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 1U);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(kWidth, kHeight));
+	}
+
+	void test_screen_dirty_rects() {
+		// Creating the screen marks it all as dirty
+		TestScreen screen;
+		TS_ASSERT(screen.isDirty());
+		screen.clearDirtyRects();
+		TS_ASSERT(!screen.isDirty());
+
+		// Added rects are visible to subclasses right away, clipped to the
+		// screen
+		screen.addDirtyRect(Common::Rect(90, 60, 120, 80));
+		TS_ASSERT(screen.isDirty());
+		TS_ASSERT_EQUALS(screen.getDirtyRects().size(), 1U);
+		TS_ASSERT_EQUALS(screen.getDirtyRects().front(), Common::Rect(90, 60, kWidth, kHeight));
+
+		screen.addDirtyRect(Common::Rect(85, 55, 95, 65));
+		screen.addDirtyRect(Common::Rect(10, 10, 20, 20));
+		TS_ASSERT_EQUALS(screen.getDirtyRects().size(), 3U);
+
+		// Merging joins the overlapping ones
+		screen.mergeDirtyRects();
+		TS_ASSERT_EQUALS(screen.getDirtyRects().size(), 2U);
+		Coverage marked, covered;
+		clearCoverage(marked);
+		clearCoverage(covered);
+		cover(marked, Common::Rect(90, 60, kWidth, kHeight));
+		cover(marked, Common::Rect(85, 55, 95, 65));
+		cover(marked, Common::Rect(10, 10, 20, 20));
+		for (Common::List<Common::Rect>::const_iterator i = screen.getDirtyRects().begin(); i != screen.getDirtyRects().end(); ++i)
+			cover(covered, *i);
+		for (int y = 0; y < kHeight; y++) {
+			for (int x = 0; x < kWidth; x++) {
+				if (marked[y][x])
+					TS_ASSERT(covered[y][x]);
+			}
+		}
+
+		// Many small rects are coalesced
+		screen.clearDirtyRects();
+		TS_ASSERT(!screen.isDirty());
+		for (int y = 0; y < kHeight; y += 2) {
+			for (int x = 0; x < kWidth; x += 2)
+				screen.addDirtyRect(Common::Rect(x, y, x + 1, y + 1));
+		}
+		screen.mergeDirtyRects();
+		TS_ASSERT_LESS_THAN_EQUALS(screen.getDirtyRects().size(), 4U);
+		TS_ASSERT(screen.isDirty());
+	}
+};
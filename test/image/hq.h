@@ -0,0 +1,149 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/ptr.h"
+#include "graphics/pixelformat.h"
+#ifdef USE_HQ_SCALERS
+#include "graphics/scaler/hq.h"
+#include "graphics/scaler/intern.h"
+#endif
+
+class HQScalerTestSuite : public CxxTest::TestSuite {
+#ifdef USE_HQ_SCALERS
+	enum {
+		kWidth = 45,
+		kHeight = 9,
+		kPadding = 1,
+		kSrcPitch = (kWidth + kPadding * 2) * 4,
+		kMaxFactor = 3,
+		kDstPitch = kWidth * kMaxFactor * 4
+	};
+
+	byte _src[(kHeight + kPadding * 2) * kSrcPitch];
+
+	void fillSource(const Graphics::PixelFormat &format, uint32 seed) {
+		// Mostly small changes from the left neighbor, so that all the
+		// thresholds of diffYUV() are exercised
+		uint8 r = 0, g = 0, b = 0;
+		for (uint i = 0; i < sizeof(_src) / format.bytesPerPixel; i++) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 random = seed >> 8;
+			if ((random & 7) == 0) {
+				r = random >> 3;
+				g = random >> 9;
+				b = random >> 15;
+			} else {
+				r = CLIP<int>(r + (int)((random >> 3) & 63) - 32, 0, 255);
+				g = CLIP<int>(g + (int)((random >> 9) & 63) - 32, 0, 255);
+				b = CLIP<int>(b + (int)((random >> 15) & 63) - 32, 0, 255);
+			}
+			const uint32 color = format.RGBToColor(r, g, b);
+			if (format.bytesPerPixel == 2)
+				((uint16 *)_src)[i] = color;
+			else
+				((uint32 *)_src)[i] = color;
+		}
+	}
+
+	const uint8 *sourcePixel(const Graphics::PixelFormat &format, int x, int y) const {
+		return _src + (y + kPadding) * kSrcPitch + (x + kPadding) * format.bytesPerPixel;
+	}
+
+	uint32 getColor(const Graphics::PixelFormat &format, int x, int y) const {
+		const uint8 *pixel = sourcePixel(format, x, y);
+		return format.bytesPerPixel == 2 ? *(const uint16 *)pixel : *(const uint32 *)pixel;
+	}
+
+	int getYUV(const HQScaler &scaler, const Graphics::PixelFormat &format, uint32 color) const {
+		if (format.bytesPerPixel == 2)
+			return scaler._RGBtoYUV[color];
+
+		// 32bpp colors are looked up with their top 5, 6 and 5 bits
+		uint8 r, g, b;
+		format.colorToRGB(color, r, g, b);
+		return scaler._RGBtoYUV[Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0).RGBToColor(r, g, b)];
+	}
+
+	void checkPatterns(HQScaler &scaler, const Graphics::PixelFormat &format) {
+		HQScaler::YUVChannels channels;
+		if (format.bytesPerPixel == 2) {
+			channels.rShift = format.rShift;
+			channels.gShift = format.gShift;
+			channels.bShift = format.bShift;
+			channels.rBits = format.rBits();
+			channels.gBits = format.gBits();
+			channels.bBits = format.bBits();
+		} else {
+			channels.rShift = format.rShift + 3;
+			channels.gShift = format.gShift + 2;
+			channels.bShift = format.bShift + 3;
+			channels.rBits = 5;
+			channels.gBits = 6;
+			channels.bBits = 5;
+		}
+
+		static const int offsets[8][2] = {
+			{ -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }
+		};
+		for (int y = 0; y < kHeight; y++) {
+			uint8 patterns[kWidth];
+			const int done = scaler._patternFunc(patterns, sourcePixel(format, 0, y), kSrcPitch, kWidth, channels);
+			TS_ASSERT_EQUALS(done, kWidth & ~7);
+
+			for (int x = 0; x < done; x++) {
+				const int yuv = getYUV(scaler, format, getColor(format, x, y));
+				int expected = 0;
+				for (int i = 0; i < 8; i++) {
+					if (diffYUV(yuv, getYUV(scaler, format, getColor(format, x + offsets[i][0], y + offsets[i][1]))))
+						expected |= 1 << i;
+				}
+				TS_ASSERT_EQUALS(patterns[x], expected);
+			}
+		}
+	}
+
+	void checkFormat(HQScaler::PatternFunc patterns16, HQScaler::PatternFunc patterns32, const Graphics::PixelFormat &format) {
+		Common::ScopedPtr<HQScaler> scaler(new HQScaler(format));
+		HQScaler::PatternFunc patternFunc = (format.bytesPerPixel == 2) ? patterns16 : patterns32;
+
+		for (uint factor = 2; factor <= kMaxFactor; factor++) {
+			fillSource(format, factor);
+			scaler->setFactor(factor);
+			scaler->_patternFunc = patternFunc;
+			checkPatterns(*scaler, format);
+
+			// The whole output must match the one using the lookup table
+			static byte expected[kHeight * kMaxFactor * kDstPitch], dst[kHeight * kMaxFactor * kDstPitch];
+			memset(dst, 0, sizeof(dst));
+			scaler->scale(sourcePixel(format, 0, 0), kSrcPitch, dst, kDstPitch, kWidth, kHeight, 0, 0);
+			scaler->_patternFunc = nullptr;
+			memset(expected, 0, sizeof(expected));
+			scaler->scale(sourcePixel(format, 0, 0), kSrcPitch, expected, kDstPitch, kWidth, kHeight, 0, 0);
+			TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+		}
+	}
+
+	void checkFuncs(HQScaler::PatternFunc patterns16, HQScaler::PatternFunc patterns32) {
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(2, 5, 6, 5, 0, 0, 5, 11, 0));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0));
+		checkFormat(patterns16, patterns32, Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+	}
+#endif
+
+public:
+	void test_simd_patterns() {
+#ifdef USE_HQ_SCALERS
+#ifdef SCUMMVM_NEON
+		checkFuncs(HQScaler::patterns16NEON, HQScaler::patterns32NEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			checkFuncs(HQScaler::patterns16SSE2, HQScaler::patterns32SSE2);
+#endif
+#endif
+	}
+};
@@ -0,0 +1,122 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/ptr.h"
+#include "common/taskpool.h"
+#include "graphics/scalerplugin.h"
+#include "graphics/scaler/dotmatrix.h"
+#include "graphics/scaler/sai.h"
+#ifdef USE_HQ_SCALERS
+#include "graphics/scaler/hq.h"
+#endif
+#ifdef USE_EDGE_SCALERS
+#include "graphics/scaler/edge.h"
+#endif
+
+class ScalerTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 45,
+		kHeight = 70,
+		kPadding = 4,
+		kSrcPitch = (kWidth + kPadding * 2) * 2,
+		kMaxFactor = 4,
+		kDstPitch = kWidth * kMaxFactor * 2
+	};
+
+	// Pretends to have several threads, so that scale() splits rects
+	class FakeThreadedPool : public Common::TaskPool {
+	public:
+		uint getNumThreads() const override { return 3; }
+	};
+
+	uint16 _src[(kHeight + kPadding * 2) * kSrcPitch / 2];
+
+	void fillSource(uint32 seed) {
+		// Few colors in small blocks, so that the scalers find some edges
+		static const uint16 colors[4] = { 0x0000, 0xFFFF, 0xF800, 0x07E0 };
+		for (uint i = 0; i < ARRAYSIZE(_src); i++) {
+			seed = seed * 1103515245 + 12345;
+			if ((seed >> 16) & 1)
+				_src[i] = colors[(seed >> 20) & 3];
+			else
+				_src[i] = i > 0 ? _src[i - 1] : 0;
+		}
+	}
+
+	const uint8 *sourceRect(int x, int y) const {
+		return (const uint8 *)_src + (y + kPadding) * kSrcPitch + (x + kPadding) * 2;
+	}
+
+	/**
+	 * Scale the same rects with a serial scaler and one using the task pool,
+	 * and check that both write the same pixels.
+	 */
+	void checkScale(Scaler &serial, Scaler &banded, uint factor, int x, int y, int w, int h) {
+		FakeThreadedPool pool;
+		serial.setFactor(factor);
+		banded.setFactor(factor);
+		banded.setTaskPool(&pool);
+
+		static uint8 expected[kHeight * kMaxFactor * kDstPitch], dst[kHeight * kMaxFactor * kDstPitch];
+		memset(expected, 0xAA, sizeof(expected));
+		memset(dst, 0xAA, sizeof(dst));
+		serial.scale(sourceRect(x, y), kSrcPitch, expected, kDstPitch, w, h, x, y);
+		banded.scale(sourceRect(x, y), kSrcPitch, dst, kDstPitch, w, h, x, y);
+		TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+
+		banded.setTaskPool(nullptr);
+	}
+
+	void checkScaler(Scaler &serial, Scaler &banded, uint factor) {
+		fillSource(factor);
+		checkScale(serial, banded, factor, 0, 0, kWidth, kHeight);
+		checkScale(serial, banded, factor, 3, 5, kWidth - 7, kHeight - 9);
+		// Too small to be split
+		checkScale(serial, banded, factor, 1, 2, 10, 20);
+	}
+
+public:
+	void test_band_split() {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+
+		SuperEagleScaler superEagle(format), superEagleBanded(format);
+		checkScaler(superEagle, superEagleBanded, 2);
+
+		SAIScaler sai(format), saiBanded(format);
+		checkScaler(sai, saiBanded, 2);
+
+		// The dot pattern depends on the position of the rows
+		DotMatrixScaler dotMatrix(format), dotMatrixBanded(format);
+		checkScaler(dotMatrix, dotMatrixBanded, 2);
+
+#ifdef USE_HQ_SCALERS
+		HQScaler hq(format), hqBanded(format);
+		checkScaler(hq, hqBanded, 2);
+		checkScaler(hq, hqBanded, 3);
+#endif
+	}
+
+	void test_band_split_old_source() {
+#ifdef USE_EDGE_SCALERS
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+
+		// The edge scalers have large tables, keep them off the stack
+		Common::ScopedPtr<EdgeScaler> edge(new EdgeScaler(format)), edgeBanded(new EdgeScaler(format));
+		for (uint factor = 2; factor <= 3; factor++) {
+			edge->setFactor(factor);
+			edgeBanded->setFactor(factor);
+			edge->setSource((const byte *)_src, kSrcPitch, kWidth, kHeight, kPadding);
+			edgeBanded->setSource((const byte *)_src, kSrcPitch, kWidth, kHeight, kPadding);
+			edge->enableSource(true);
+			edgeBanded->enableSource(true);
+
+			// The second frame only redraws the changed pixels, using the
+			// old source and output of the first one
+			fillSource(factor);
+			checkScale(*edge, *edgeBanded, factor, 0, 0, kWidth, kHeight);
+			for (uint i = 0; i < ARRAYSIZE(_src); i += 7)
+				_src[i] = ~_src[i];
+			checkScale(*edge, *edgeBanded, factor, 0, 0, kWidth, kHeight);
+		}
+#endif
+	}
+};
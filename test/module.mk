@@ -10,16 +10,21 @@ TESTS        := $(srcdir)/test/common/*.h \
 	$(srcdir)/test/common/formats/*.h \
 	$(srcdir)/test/audio/*.h \
 	$(srcdir)/test/math/*.h \
-	$(srcdir)/test/image/*.h
+	$(srcdir)/test/image/*.h \
+	$(srcdir)/test/engines/*.h
 TEST_LIBS    :=
 
 ifdef POSIX
 TEST_LIBS += test/system/null_osystem.o \
+	test/system/threaded_taskpool.o \
+	backends/taskpool/threaded-taskpool.o \
+	backends/taskpool/pthread/pthread-taskpool.o \
 	backends/fs/posix/posix-fs-factory.o \
 	backends/fs/posix/posix-fs.o \
 	backends/fs/posix/posix-iostream.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
+	backends/mixer/null/null-mixer.o \
 	backends/modular-backend.o
 endif
 
@@ -29,6 +34,7 @@ TEST_LIBS += test/system/null_osystem.o \
 	backends/fs/windows/windows-fs.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
+	backends/mixer/null/null-mixer.o \
 	backends/modular-backend.o \
 	backends/platform/sdl/win32/win32_wrapper.o
 endif
@@ -37,7 +43,7 @@ ifdef USE_TINYGL
 TESTS += $(srcdir)/test/graphics/tinygl*.h
 endif
 
-TEST_LIBS +=	audio/libaudio.a math/libmath.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
+TEST_LIBS +=	engines/libengines.a audio/libaudio.a math/libmath.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
@@ -63,6 +69,10 @@ TEST_LDFLAGS := $(LDFLAGS) $(LIBS)
 TEST_CXXFLAGS  := $(filter-out -Wglobal-constructors,$(CXXFLAGS))
 TEST_CXXFLAGS += -Wno-self-assign-overloaded
 
+ifdef POSIX
+TEST_LDFLAGS += -lpthread
+endif
+
 ifdef WIN32
 TEST_LDFLAGS := $(filter-out -mwindows,$(TEST_LDFLAGS))
 endif
@@ -92,7 +102,7 @@ test/runner.cpp: $(TESTS) $(srcdir)/test/module.mk
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/system/null_osystem.o
+	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/system/null_osystem.o test/system/threaded_taskpool.o
 	-rmdir test/engine-data
 
 test/engine-data/encoding.dat: $(srcdir)/dists/engine-data/encoding.dat
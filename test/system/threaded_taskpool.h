@@ -0,0 +1,12 @@
+#ifndef TEST_THREADED_TASKPOOL
+#define TEST_THREADED_TASKPOOL 1
+#include "common/taskpool.h"
+namespace Common {
+#if defined(POSIX) && !defined(NO_CXX11_ATOMIC)
+TaskPool *createThreadedTaskPool(uint numWorkers);
+#define THREADED_TASKPOOL_IS_AVAILABLE 1
+#else
+#define THREADED_TASKPOOL_IS_AVAILABLE 0
+#endif
+}
+#endif